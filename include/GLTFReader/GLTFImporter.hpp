@@ -0,0 +1,29 @@
+#pragma once
+#ifndef GLTFIMPORTER_H
+#define GLTFIMPORTER_H
+#include "Renderer/SceneAsset.h"
+#include <future>
+#include <span>
+namespace tinygltf {
+	class Model;
+	class Node;
+}
+namespace nyan {
+	//First import stage, turns glTF files into a SceneAsset without touching the GPU
+	//Decoding, optimization, lod generation and quantization run on the job system
+	class GLTFImporter {
+	public:
+		//Loads .gltf and .glb files, returns nothing if the file can't be parsed
+		//With a cache directory the result is kept in a SceneAssetCache keyed by the path, the file and its buffers
+		static std::optional<SceneAsset> import_file(const std::filesystem::path& path, const std::filesystem::path& cacheDirectory = {});
+		//Same as import_file with the file already in memory, e.g. mapped by the AssetStreamer, external files are still resolved relative to path
+		static std::optional<SceneAsset> import_memory(const std::filesystem::path& path, std::span<const std::byte> data, const std::filesystem::path& cacheDirectory = {});
+		//Runs import_file as a job, e.g. while the previous level is still rendering
+		[[nodiscard]] static std::future<std::optional<SceneAsset>> import_file_async(const std::filesystem::path& path, const std::filesystem::path& cacheDirectory = {});
+		//External images are referenced relative to directory
+		static SceneAsset import_model(const tinygltf::Model& model, const std::filesystem::path& directory = {}, const std::string& name = "");
+		//Either from translation, rotation and scale or from the matrix
+		static Transform import_transform(const tinygltf::Node& node);
+	};
+}
+#endif //!GLTFIMPORTER_H
@@ -0,0 +1,32 @@
+#pragma once
+#ifndef GLTFPRIMITIVEDECODER_H
+#define GLTFPRIMITIVEDECODER_H
+#include "Renderer/Mesh.h"
+namespace tinygltf {
+	class Model;
+	struct Accessor;
+	struct Primitive;
+}
+namespace nyan {
+	struct GLTFPrimitive {
+		nyan::Mesh mesh;
+		size_t meshIdx{ 0 };
+		size_t primitiveIdx{ 0 };
+	};
+	//Decodes glTF accessors into the engine mesh streams
+	//Each accessor is converted with one typed strided loop, tightly packed matching layouts are copied in bulk
+	class GLTFPrimitiveDecoder {
+	public:
+		static void decode_indices(const tinygltf::Model& model, const tinygltf::Accessor& accessor, std::vector<uint32_t>& indices);
+		//float and double components, normalized integer components where KHR_mesh_quantization allows them
+		static void decode_positions(const tinygltf::Model& model, const tinygltf::Accessor& accessor, std::vector<Math::vec3>& positions);
+		static void decode_normals(const tinygltf::Model& model, const tinygltf::Accessor& accessor, std::vector<Math::hvec3>& normals);
+		static void decode_tangents(const tinygltf::Model& model, const tinygltf::Accessor& accessor, std::vector<Math::hvec4>& tangents);
+		static void decode_uvs(const tinygltf::Model& model, const tinygltf::Accessor& accessor, std::vector<Math::hvec2>& uvs);
+		//Material dependent state is left to the caller
+		static nyan::Mesh decode_primitive(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const std::string& name);
+		//Decodes all primitives of all meshes in parallel on the job system, ordered by mesh and then primitive
+		static std::vector<GLTFPrimitive> decode_meshes(const tinygltf::Model& model);
+	};
+}
+#endif //!GLTFPRIMITIVEDECODER_H
@@ -2,13 +2,20 @@
 #ifndef GLTFREADER_H
 #define GLTFREADER_H
 #include "Renderer/RenderManager.h"
+#include "Renderer/SceneAsset.h"
 namespace nyan {
 	class GLTFReader {
 	public:
-		GLTFReader(nyan::RenderManager& renderManager);
-		void load_file(const std::filesystem::path& path);
+		//With a cache directory the imports are kept in a SceneAssetCache
+		GLTFReader(nyan::RenderManager& renderManager, const std::filesystem::path& cacheDirectory = {});
+		//Asynchronous, the AssetStreamer maps the file, GLTFImporter imports it on the job system and the result is committed within the frame budget
+		//External textures are streamed the same way and show a placeholder until they arrive, the reader has to outlive the commit
+		AssetRequestId load_file(const std::filesystem::path& path, const Math::vec3& position = Math::vec3{ 0.f }, float priorityBias = 0.f);
+		//Second import stage, uploads textures, materials and meshes of the asset in one pass and creates its entities
+		void commit(const nyan::SceneAsset& asset);
 	private:
 		nyan::RenderManager& r_renderManager;
+		std::filesystem::path m_cacheDirectory;
 	};
 }
 #endif //!GLTFREADER_H
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <type_traits>
 #include <cmath>
 #include <algorithm>
+#include <limits>
 
 namespace Math {
 
@@ -207,11 +208,11 @@ namespace Math {
 		constexpr snorm() : data(0) {
 		}
 		constexpr snorm(float f) {
-			static constexpr auto max = static_cast<float>(static_cast<T>(-1) >> 1);
+			static constexpr auto max = static_cast<float>(std::numeric_limits<T>::max());
 			data = static_cast<T>(std::round(Math::clamp(f , -1.0f, 1.0f) * max));
 		}
 		operator float() const {
-			static constexpr auto max = 1.f / static_cast<float>(static_cast<T>(-1) >> 1);
+			static constexpr auto max = 1.f / static_cast<float>(std::numeric_limits<T>::max());
 			return std::max(static_cast<float>(data) * max, -1.0f);
 		}
 		T data;
@@ -0,0 +1,135 @@
+#pragma once
+#ifndef RDASSETSTREAMER_H
+#define RDASSETSTREAMER_H
+#include "LinAlg.h"
+#include "SceneAsset.h"
+#include "TextureCache.h"
+#include "Utility/JobSystem.h"
+#include "Utility/MappedFile.h"
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <unordered_map>
+namespace nyan {
+	using AssetRequestId = uint64_t;
+	//Decoded asset waiting for its upload, only the upload sink knows the concrete type
+	class AssetPayload {
+	public:
+		virtual ~AssetPayload() = default;
+		//Bytes charged against the per frame upload budget
+		virtual size_t upload_size() const = 0;
+	};
+	//Decoded image, uploaded by the render manager into the texture manager
+	class StreamedTexture : public AssetPayload {
+	public:
+		size_t upload_size() const override {
+			return texture.is_embedded() ? texture.data.size() : fileSize;
+		}
+		//Decoded pixels, or the file for .dds and cooked sources which are created straight from the file on upload
+		SceneTextureAsset texture;
+		size_t fileSize{ 0 };
+		//Keeps the cooked file from being evicted until the payload is gone
+		TextureCache::Lease cooked;
+		//Decodes png, jpg, tga and hdr files to 8 bit rgba
+		static std::unique_ptr<AssetPayload> decode(const std::filesystem::path& path, std::span<const std::byte> data);
+	};
+	//Imported scene, the upload sink hands it to the commit of whoever requested it, e.g. GLTFReader
+	class StreamedScene : public AssetPayload {
+	public:
+		size_t upload_size() const override;
+		SceneAsset asset;
+		std::function<void(const SceneAsset&)> commit;
+	};
+	//Runs on the job system, returns nullptr or throws on failure
+	//data is the mapped file and only valid during the call
+	using AssetDecoder = std::function<std::unique_ptr<AssetPayload>(const std::filesystem::path& path, std::span<const std::byte> data)>;
+	//Consumes decoded assets on the thread calling AssetStreamer::commit, implemented by the render manager and by mocks in the tests
+	class AssetUploadSink {
+	public:
+		virtual ~AssetUploadSink() = default;
+		virtual void upload(AssetRequestId id, AssetPayload& payload) = 0;
+	};
+	//Three stage loader: dedicated I/O threads map whole files and fault them in with sequential readahead,
+	//the job system decodes them and commit uploads the results within a per frame budget
+	//Requests closest to the camera are read and committed first
+	//Finished requests are forgotten once get_state returned Committed, Cancelled or Failed, later calls return Unknown
+	class AssetStreamer {
+	public:
+		enum class State : uint32_t {
+			Queued,
+			Reading,
+			Decoding,
+			Ready,
+			Committed,
+			Cancelled,
+			Failed,
+			Unknown,
+		};
+		struct Settings {
+			uint32_t ioThreadCount{ 2 };
+			//Limits of a single commit call, the first asset of a frame is always committed so large assets can't starve
+			size_t frameByteBudget{ 32ull << 20 };
+			std::chrono::microseconds frameTimeBudget{ 2000 };
+		};
+		struct Request {
+			std::filesystem::path path;
+			AssetDecoder decoder;
+			//World position the priority is derived from
+			Math::vec3 position{ 0.f };
+			//Subtracted from the camera distance, e.g. the bounding sphere radius
+			float priorityBias{ 0.f };
+		};
+		struct Statistics {
+			size_t committedAssets{ 0 };
+			size_t committedBytes{ 0 };
+			//Decoded assets left for the next frame because the budget ran out
+			size_t deferredAssets{ 0 };
+		};
+		AssetStreamer();
+		explicit AssetStreamer(const Settings& settings, Utility::JobSystem& jobSystem = Utility::JobSystem::get());
+		~AssetStreamer();
+		AssetStreamer(const AssetStreamer&) = delete;
+		AssetStreamer& operator=(const AssetStreamer&) = delete;
+		AssetRequestId request(Request request);
+		//Returns false if the request already finished, a cancelled asset never reaches the sink
+		bool cancel(AssetRequestId id);
+		State get_state(AssetRequestId id);
+		void set_camera_position(const Math::vec3& position);
+		//Call once per frame from the thread owning the sink
+		Statistics commit(AssetUploadSink& sink);
+		//Blocks until nothing is queued, read or decoded anymore, e.g. for loading screens
+		void wait_idle();
+	private:
+		struct Entry {
+			Request request;
+			State state{ State::Queued };
+			std::unique_ptr<AssetPayload> payload;
+			//Held by an I/O thread or a decode job, which still look the entry up
+			bool busy{ false };
+			//The final state was returned by get_state while busy, erased once released
+			bool observed{ false };
+		};
+		float priority(AssetRequestId id) const;
+		void io_loop();
+		void decode(AssetRequestId id, AssetDecoder decoder, std::filesystem::path path, Utility::MappedFile file);
+		void finish_in_flight(AssetRequestId id);
+
+		Settings m_settings;
+		Utility::JobSystem& r_jobSystem;
+		mutable std::mutex m_mutex;
+		std::condition_variable m_ioCondition;
+		std::condition_variable m_idleCondition;
+		std::unordered_map<AssetRequestId, Entry> m_entries;
+		//Min heap by priority, cancelled entries are skipped when popped
+		std::vector<AssetRequestId> m_ioQueue;
+		std::vector<AssetRequestId> m_ready;
+		Math::vec3 m_cameraPosition{ 0.f };
+		AssetRequestId m_nextId{ 1 };
+		size_t m_inFlight{ 0 };
+		bool m_shutdown{ false };
+		std::vector<std::thread> m_ioThreads;
+	};
+}
+
+#endif !RDASSETSTREAMER_H
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef RDBOUNDS_H
+#define RDBOUNDS_H
+#include "LinAlg.h"
+#include <limits>
+#include <span>
+#include <vector>
+namespace nyan {
+	struct Mesh;
+	struct BoundingBox {
+		Math::vec3 min{ std::numeric_limits<float>::max() };
+		Math::vec3 max{ -std::numeric_limits<float>::max() };
+		bool valid() const {
+			return min[0] <= max[0] && min[1] <= max[1] && min[2] <= max[2];
+		}
+		Math::vec3 center() const {
+			return (min + max) * 0.5f;
+		}
+		Math::vec3 extent() const {
+			return (max - min) * 0.5f;
+		}
+	};
+	struct BoundingSphere {
+		Math::vec3 center{ 0.f };
+		float radius{ -1.f };
+		bool valid() const {
+			return radius >= 0.f;
+		}
+	};
+	//Object space bounds of a mesh or a range of its triangles
+	struct MeshBounds {
+		BoundingBox box;
+		BoundingSphere sphere;
+		bool valid() const {
+			return box.valid() && sphere.valid();
+		}
+	};
+	class BoundsCalculator {
+	public:
+		//Four positions per step with three unaligned 16 byte loads, no gathers
+		static BoundingBox compute_box(std::span<const Math::vec3> positions);
+		static BoundingBox compute_box(std::span<const Math::vec3> positions, std::span<const uint32_t> indices);
+		//Larsson 2008 "Fast and Tight Fitting Bounding Spheres", EPOS-14 extremal points followed by one Ritter growing pass
+		static BoundingSphere compute_sphere(std::span<const Math::vec3> positions);
+		static BoundingSphere compute_sphere(std::span<const Math::vec3> positions, std::span<const uint32_t> indices);
+		static MeshBounds compute(std::span<const Math::vec3> positions);
+		//Fills the bounds of the mesh and of all its submeshes
+		static void compute(nyan::Mesh& mesh);
+		//Box after Arvo 1990 "Transforming Axis-Aligned Bounding Boxes", the sphere radius scales with the longest axis
+		static MeshBounds transform(const MeshBounds& bounds, const Math::Mat<float, 3, 4, false>& transform);
+	};
+}
+
+#endif !RDBOUNDS_H
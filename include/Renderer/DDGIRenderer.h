@@ -270,7 +270,7 @@ namespace nyan {
 		void visualize_volume(vulkan::GraphicsPipelineBind& bind, uint32_t volumeId);
 		void create_pipeline();
 
-		vulkan::PipelineId m_pipeline;
+		vulkan::PipelineId m_pipeline{ vulkan::invalidPipelineId };
 		bool m_enabled;
 		Lighting m_lighting;
 		nyan::RenderResource::Id m_depth;
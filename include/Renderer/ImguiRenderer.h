@@ -30,7 +30,7 @@ namespace nyan {
 		entt::registry& r_registry;
 		MM::EntityEditor<entt::entity> m_editor;
 		entt::entity m_entity;
-		vulkan::PipelineId m_pipeline;
+		vulkan::PipelineId m_pipeline{ vulkan::invalidPipelineId };
 		glfww::Window* ptr_window;
 		std::chrono::high_resolution_clock::time_point start;
 
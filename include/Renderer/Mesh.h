@@ -2,12 +2,19 @@
 #ifndef RDMESH_H
 #define RDMESH_H
 #include "LinAlg.h"
+#include "Bounds.h"
 #include <vector>
 #include <string>
 #include "Material.h"
 #include "ShaderInterface.h"
 namespace nyan {
 
+	//Contiguous triangle range with its own bounds, e.g. a part of a merged mesh
+	struct Submesh {
+		uint32_t firstIndex{ 0 };
+		uint32_t indexCount{ 0 };
+		MeshBounds bounds;
+	};
 	struct Mesh {
 		enum class RenderType : uint32_t {
 			Opaque = 0,
@@ -28,6 +35,9 @@ namespace nyan {
 		std::vector<Math::hvec3> normals;
 		std::vector<Math::hvec4> tangents;
 		std::vector<Math::unorm8> colors0;
+		//Object space, computed during import, see BoundsCalculator
+		MeshBounds bounds;
+		std::vector<Submesh> submeshes;
 	};
 }
 
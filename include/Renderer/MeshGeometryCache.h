@@ -0,0 +1,55 @@
+#pragma once
+#ifndef RDMESHGEOMETRYCACHE_H
+#define RDMESHGEOMETRYCACHE_H
+#include "MeshQuantizer.h"
+#include "Utility/StreamHasher.h"
+#include <array>
+#include <unordered_map>
+namespace nyan {
+	using MeshGeometryID = uint32_t;
+	//Everything the device geometry depends on, name and material are excluded
+	struct MeshGeometryKey {
+		uint64_t hash{ 0 };
+		uint64_t byteSize{ 0 };
+		bool operator==(const MeshGeometryKey& other) const = default;
+	};
+	struct MeshGeometryKeyHash {
+		size_t operator()(const MeshGeometryKey& key) const {
+			return static_cast<size_t>(key.hash);
+		}
+	};
+	//Creates the device side geometry, implemented by the MeshManager and by mocks in the tests
+	class MeshUploadBackend {
+	public:
+		virtual ~MeshUploadBackend() = default;
+		virtual MeshGeometryID upload_geometry(const QuantizedMesh& mesh) = 0;
+	};
+	//Identical index and vertex streams are uploaded once and shared by all meshes using them
+	class MeshGeometryCache {
+	public:
+		struct Statistics {
+			size_t uploads{ 0 };
+			size_t sharedMeshes{ 0 };
+			size_t uploadedBytes{ 0 };
+			//Index and vertex bytes of all meshes that reused existing geometry
+			size_t savedBytes{ 0 };
+		};
+		struct Result {
+			MeshGeometryID geometry;
+			//The geometry already existed
+			bool shared;
+		};
+		MeshGeometryCache(MeshUploadBackend& backend);
+		Result acquire(const QuantizedMesh& mesh);
+		const Statistics& get_statistics() const {
+			return m_statistics;
+		}
+		static MeshGeometryKey compute_key(const QuantizedMesh& mesh);
+	private:
+		MeshUploadBackend& r_backend;
+		std::unordered_map<MeshGeometryKey, MeshGeometryID, MeshGeometryKeyHash> m_geometries;
+		Statistics m_statistics;
+	};
+}
+
+#endif !RDMESHGEOMETRYCACHE_H
@@ -6,9 +6,18 @@
 #include "DataManager.h"
 #include "MaterialManager.h"
 #include "Mesh.h"
+#include "MeshQuantizer.h"
+#include "MeshGeometryCache.h"
 #include "ShaderInterface.h"
 #include "Transform.h"
 #include "AccelerationStructure.h"
+#include "Utility/OffsetAllocator.h"
+namespace vulkan {
+	template< >
+	constexpr VkFormat get_format<nyan::PackedTangent>() {
+		return VK_FORMAT_A2B10G10R10_SNORM_PACK32;
+	}
+}
 namespace nyan {
 
 	template<typename T>
@@ -27,7 +36,17 @@ namespace nyan {
 	constexpr uint16_t get_num_formats<nyan::Mesh>() {
 		return { 4u };
 	}
+	template<>
+	constexpr uint16_t get_num_formats<nyan::QuantizedMesh>() {
+		return { 4u };
+	}
 	using MeshID = uint32_t;
+	//Entities with a lod chain get their MeshID replaced by the level selected for the primary camera
+	struct MeshLodChain {
+		std::vector<MeshID> meshes;
+		//Object space error of each level, ascending, starting with 0 for the full resolution mesh
+		std::vector<float> errors;
+	};
 
 	struct StaticTangentVulkanMesh {
 		uint32_t indexCount;
@@ -65,18 +84,43 @@ namespace nyan {
 		} vertexOffsets;
 		
 	};
-	class MeshManager : public DataManager<nyan::shaders::Mesh>{
+	//Meshes with identical geometry share one allocation and acceleration structure, see MeshGeometryCache
+	//Geometry is sub-allocated from a few large arenas, meshes of one arena share all index and vertex bindings
+	class MeshManager : public DataManager<nyan::shaders::Mesh>, private MeshUploadBackend {
 	private:
+		//Arena capacities in vertices and 4 byte index words, larger meshes get a dedicated arena
+		static constexpr uint32_t arenaVertexCapacity{ 1u << 22 };
+		static constexpr uint32_t arenaIndexCapacity{ 1u << 23 };
+		static constexpr uint32_t arenaTransformCapacity{ 1u << 14 };
+		//Arenas are never resized, pending acceleration structure builds already hold their device addresses
+		struct GeometryArena {
+			vulkan::BufferHandle indexBuffer;
+			vulkan::BufferHandle positionBuffer;
+			vulkan::BufferHandle texCoordBuffer;
+			vulkan::BufferHandle normalBuffer;
+			vulkan::BufferHandle tangentBuffer;
+			//Dequantization transforms of the acceleration structure geometries
+			std::optional<vulkan::BufferHandle> transformBuffer;
+			Utility::OffsetAllocator indexAllocator;
+			Utility::OffsetAllocator vertexAllocator;
+			Utility::OffsetAllocator transformAllocator;
+		};
 		struct Mesh {
-			vulkan::BufferHandle buffer;
-			VkDeviceSize offset;
+			uint32_t arena;
+			Utility::OffsetAllocator::Allocation indices;
+			Utility::OffsetAllocator::Allocation vertices;
+			Utility::OffsetAllocator::Allocation transform;
 			std::optional<vulkan::AccelerationStructureHandle> accStructure;
 			StaticTangentVulkanMesh mesh;
 		};
 	public:
 		MeshManager(vulkan::LogicalDevice& device, nyan::MaterialManager& materialManager, bool buildAccelerationStructures = false);
 		~MeshManager();
+		//Quantizes the mesh first, all meshes are stored in the QuantizedMesh vertex formats
 		MeshID add_mesh(const nyan::Mesh& data);
+		MeshID add_mesh(const nyan::QuantizedMesh& data);
+		//Overrides data.materialBinding, lets shared mesh data be bound to materials created later
+		MeshID add_mesh(const nyan::QuantizedMesh& data, nyan::MaterialId materialBinding);
 		MeshID get_mesh(const std::string& name);
 		void build();
 		const nyan::shaders::Mesh& get_shader_mesh(MeshID idx) const;
@@ -84,13 +128,25 @@ namespace nyan {
 		const StaticTangentVulkanMesh& get_static_tangent_mesh(const std::string& name) const;
 		std::optional<vulkan::AccelerationStructureHandle> get_acceleration_structure(MeshID idx);
 		std::optional<vulkan::AccelerationStructureHandle> get_acceleration_structure(const std::string& name);
+		//Object space bounds, also stored in the shader mesh
+		MeshBounds get_bounds(MeshID idx) const;
+		const MeshGeometryCache::Statistics& get_geometry_statistics() const;
 	private:
+		MeshGeometryID upload_geometry(const nyan::QuantizedMesh& data) override;
+		uint32_t create_arena(uint32_t vertexCapacity, uint32_t indexCapacity);
+		//Finds an arena with room for the mesh, creates a new one if all are full
+		MeshManager::Mesh allocate_geometry(uint32_t vertexCount, uint32_t indexWords);
+		const MeshManager::Mesh& get_geometry(MeshID idx) const;
+		MeshManager::Mesh& get_geometry(MeshID idx);
 		nyan::MaterialManager& r_materialManager;
 		std::unique_ptr<vulkan::AccelerationStructureBuilder> m_builder;
 		bool m_buildAccs;
-		std::unordered_map<MeshID, MeshManager::Mesh> m_staticTangentMeshes;
+		std::vector<MeshManager::GeometryArena> m_arenas;
+		std::vector<MeshManager::Mesh> m_geometries;
+		std::unordered_map<MeshID, MeshGeometryID> m_meshGeometries;
+		MeshGeometryCache m_geometryCache;
 		std::unordered_map<std::string, MeshID> m_meshIndex;
-		std::vector<std::pair<size_t, MeshID>> m_pendingAccBuildIndex;
+		std::vector<std::pair<size_t, MeshGeometryID>> m_pendingAccBuildIndex;
 	};
 	union InstanceData {
 		VkAccelerationStructureInstanceKHR instance;
@@ -117,6 +173,9 @@ namespace nyan {
 		void set_instance(InstanceId id, const InstanceData& instance);
 		const InstanceData& get_instance(InstanceId id) const;
 		InstanceId add_instance(const InstanceData& instanceData = { .transform {.transformMatrix = Math::Mat<float, 3, 4, false>::identity()} });
+		//World space bounds of the instance, updated together with its transform
+		void set_world_bounds(InstanceId id, const MeshBounds& bounds);
+		const MeshBounds& get_world_bounds(InstanceId id) const;
 		void build();
 		std::optional<vulkan::AccelerationStructureHandle> get_tlas();
 		std::optional<uint32_t> get_tlas_bind();
@@ -125,6 +184,8 @@ namespace nyan {
 		bool m_buildAccs;
 		std::optional<vulkan::AccelerationStructureHandle> m_tlas;
 		uint32_t m_tlasBind;
+		//CPU side only, the instance buffer layout is fixed by VkAccelerationStructureInstanceKHR
+		std::vector<MeshBounds> m_worldBounds;
 	};
 
 
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef RDMESHOPTIMIZER_H
+#define RDMESHOPTIMIZER_H
+#include "Mesh.h"
+#include <span>
+namespace nyan {
+	struct VertexCacheStatistics {
+		uint32_t triangleCount{ 0 };
+		uint32_t vertexCount{ 0 };
+		uint32_t transformedVertices{ 0 };
+		//Average cache miss ratio, transformed vertices per triangle, optimum ~0.5, worst 3
+		float acmr{ 0.f };
+		//Average transform to vertex ratio, optimum 1
+		float atvr{ 0.f };
+	};
+	struct VertexFetchStatistics {
+		size_t bytesFetched{ 0 };
+		//bytesFetched divided by the size of all referenced vertices, optimum 1
+		float overfetch{ 0.f };
+	};
+	class MeshOptimizer {
+	public:
+		struct Settings {
+			//Size of the simulated FIFO post transform cache
+			uint32_t cacheSize{ 16 };
+			//Allowed ACMR degradation when splitting clusters for overdraw sorting
+			float overdrawThreshold{ 1.05f };
+			bool optimizeVertexCache{ true };
+			bool optimizeOverdraw{ true };
+			bool optimizeVertexFetch{ true };
+		};
+		struct Statistics {
+			VertexCacheStatistics cacheBefore;
+			VertexCacheStatistics cacheAfter;
+			VertexFetchStatistics fetchBefore;
+			VertexFetchStatistics fetchAfter;
+		};
+		static Statistics optimize(nyan::Mesh& mesh, const Settings& settings);
+		static Statistics optimize(nyan::Mesh& mesh);
+		//Optimizes all meshes in parallel on the job system
+		static std::vector<Statistics> optimize(std::span<nyan::Mesh> meshes, const Settings& settings);
+		static std::vector<Statistics> optimize(std::span<nyan::Mesh> meshes);
+
+		//Tipsify, Sander et al. 2007 "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+		static void optimize_vertex_cache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize = 16);
+		//Splits the cache optimized index buffer into clusters and sorts them front to back with respect to their facing
+		static void optimize_overdraw(std::span<uint32_t> indices, std::span<const Math::vec3> positions, uint32_t cacheSize = 16, float threshold = 1.05f);
+		//Reorders all vertex streams in order of first use and drops unreferenced vertices, returns the new vertex count
+		static size_t optimize_vertex_fetch(nyan::Mesh& mesh);
+		//Returns remap[oldVertex] = newVertex or ~0u for unreferenced vertices
+		static std::vector<uint32_t> generate_fetch_remap(std::span<const uint32_t> indices, size_t vertexCount, size_t& uniqueVertexCount);
+
+		static VertexCacheStatistics analyze_vertex_cache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = 16);
+		static VertexFetchStatistics analyze_vertex_fetch(const nyan::Mesh& mesh);
+		static size_t vertex_byte_size(const nyan::Mesh& mesh);
+	};
+}
+
+#endif !RDMESHOPTIMIZER_H
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef RDMESHQUANTIZER_H
+#define RDMESHQUANTIZER_H
+#include "Mesh.h"
+#include <span>
+namespace nyan {
+	//A2B10G10R10_SNORM_PACK32, octahedral tangent direction in x and y, bitangent sign in w
+	struct PackedTangent {
+		uint32_t data{ 0 };
+	};
+	//GPU vertex format, roughly 20 instead of 30 bytes per vertex
+	struct QuantizedMesh {
+		nyan::Mesh::RenderType type{ nyan::Mesh::RenderType::Opaque };
+		std::string name;
+		std::string material;
+		nyan::MaterialId materialBinding{ nyan::shaders::INVALID_BINDING };
+		//Object space bounds of the source mesh
+		MeshBounds bounds;
+		//Dequantization: position = positionOffset + positionScale * snorm(positions)
+		Math::vec3 positionOffset{ 0.f };
+		Math::vec3 positionScale{ 1.f };
+		//Only one of both is used, shortIndices whenever all vertices are addressable with 16 bit
+		std::vector<uint16_t> shortIndices;
+		std::vector<uint32_t> indices;
+		//w is unused padding, three component 16 bit formats are barely supported
+		std::vector<Math::sn16vec4> positions;
+		std::vector<Math::hvec2> uvs0;
+		//Octahedral
+		std::vector<Math::sn16vec2> normals;
+		std::vector<PackedTangent> tangents;
+		bool uses_short_indices() const {
+			return !shortIndices.empty();
+		}
+		size_t index_count() const {
+			return uses_short_indices() ? shortIndices.size() : indices.size();
+		}
+		uint32_t get_index(size_t i) const {
+			return uses_short_indices() ? shortIndices[i] : indices[i];
+		}
+	};
+	struct QuantizationStatistics {
+		//Index and vertex streams consumed by the renderer
+		size_t sourceBytes{ 0 };
+		size_t quantizedBytes{ 0 };
+		//quantizedBytes divided by sourceBytes
+		float ratio{ 0.f };
+	};
+	class MeshQuantizer {
+	public:
+		static QuantizedMesh quantize(const nyan::Mesh& mesh);
+		//Quantizes all meshes in parallel on the job system
+		static std::vector<QuantizedMesh> quantize(std::span<const nyan::Mesh> meshes);
+		//Reconstructs the full precision streams, mainly for tools and validation
+		static nyan::Mesh dequantize(const QuantizedMesh& mesh);
+		static QuantizationStatistics analyze(const nyan::Mesh& mesh, const QuantizedMesh& quantized);
+		static size_t index_byte_size(const nyan::Mesh& mesh);
+		static size_t index_byte_size(const QuantizedMesh& mesh);
+		static size_t vertex_byte_size(const nyan::Mesh& mesh);
+		static size_t vertex_byte_size(const QuantizedMesh& mesh);
+
+		//Octahedral mapping of unit vectors onto [-1, 1]^2, Cigolle et al. 2014 "A Survey of Efficient Representations for Independent Unit Vectors"
+		static Math::vec2 encode_octahedral(const Math::vec3& direction);
+		static Math::vec3 decode_octahedral(const Math::vec2& encoded);
+		static Math::sn16vec2 encode_normal(const Math::vec3& normal);
+		static Math::vec3 decode_normal(const Math::sn16vec2& normal);
+		static PackedTangent encode_tangent(const Math::vec4& tangent);
+		static Math::vec4 decode_tangent(PackedTangent tangent);
+	};
+}
+
+#endif !RDMESHQUANTIZER_H
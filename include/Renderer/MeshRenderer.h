@@ -41,11 +41,20 @@ namespace nyan {
 		void render(vulkan::GraphicsPipelineBind& bind, const MeshID& meshId, const PushConstants& instance);
 		
 	private:
+		struct Draw {
+			MeshID meshId;
+			InstanceId instanceId;
+		};
+		static constexpr size_t minDrawsPerChunk = 512;
 		void create_pipeline();
+		//Records the draws [begin, end) of the current frame's draw list
+		void render(vulkan::CommandBuffer& cmd, size_t begin, size_t end);
 
 		vulkan::PipelineId m_staticTangentPipeline;
 		vulkan::PipelineId m_staticTangentAlphaDiscardPipeline;
 		GBuffer m_gbuffer;
+		std::vector<Draw> m_draws;
+		std::array<size_t, 5> m_drawGroupOffsets{};
 	};
 	class ForwardMeshRenderer : Renderer {
 	private:
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef RDMESHSIMPLIFIER_H
+#define RDMESHSIMPLIFIER_H
+#include "Mesh.h"
+#include "Camera.h"
+#include <span>
+namespace nyan {
+	struct MeshLod {
+		nyan::Mesh mesh;
+		//Object space geometric error with respect to the source mesh
+		float error{ 0.f };
+	};
+	struct MeshDistance {
+		//Symmetric Hausdorff distance
+		float hausdorff{ 0.f };
+		float mean{ 0.f };
+	};
+	class MeshSimplifier {
+	public:
+		struct Settings {
+			//Weights of uv and normal differences, relative to distances normalized to the mesh extent
+			float uvWeight{ 0.5f };
+			float normalWeight{ 0.25f };
+			//Weight of the planes keeping open borders and attribute seams in place
+			float borderWeight{ 10.f };
+			bool lockBorder{ false };
+			//Largest allowed geometric error relative to the mesh extent
+			float maxError{ 1.f };
+		};
+		struct Result {
+			//Triangles referencing the vertices of the source mesh
+			std::vector<uint32_t> indices;
+			//Object space geometric error
+			float error{ 0.f };
+		};
+		struct LodSettings {
+			//Target triangle count of each level relative to the source mesh
+			std::vector<float> ratios{ 0.5f, 0.25f, 0.125f };
+			Settings simplification{};
+			//Stop the chain once a level removes less than this fraction of the previous level
+			float minReduction{ 0.1f };
+			bool optimize{ true };
+		};
+		//Quadric error edge collapse onto existing vertices, Garland and Heckbert 1997 with attribute quadrics after Hoppe 1999
+		//Collapses preserve open borders and uv/normal seams
+		static Result simplify(const nyan::Mesh& mesh, std::span<const uint32_t> indices, size_t targetIndexCount, const Settings& settings);
+		static Result simplify(const nyan::Mesh& mesh, size_t targetIndexCount, const Settings& settings);
+		static Result simplify(const nyan::Mesh& mesh, size_t targetIndexCount);
+		//Returns successively coarser and compacted levels, the source mesh itself is level 0 and not included
+		static std::vector<MeshLod> generate_lods(const nyan::Mesh& mesh, const LodSettings& settings);
+		static std::vector<MeshLod> generate_lods(const nyan::Mesh& mesh);
+		//Generates the chains of all meshes in parallel on the job system
+		static std::vector<std::vector<MeshLod>> generate_lods(std::span<const nyan::Mesh> meshes, const LodSettings& settings);
+		static std::vector<std::vector<MeshLod>> generate_lods(std::span<const nyan::Mesh> meshes);
+		//Point to surface distances sampled at vertices, edge midpoints and triangle centroids of both meshes
+		static MeshDistance measure_distance(const nyan::Mesh& reference, const nyan::Mesh& simplified);
+	};
+	class LodSelector {
+	public:
+		//Size of an object space error in pixels at the given view distance
+		static float projected_error(float error, float distance, const PerspectiveCamera& camera, float screenWidth);
+		//Returns the coarsest level whose projected error stays within threshold pixels, errors have to be ascending
+		static uint32_t select(std::span<const float> errors, float distance, const PerspectiveCamera& camera, float screenWidth, float threshold = 1.f);
+	};
+}
+
+#endif !RDMESHSIMPLIFIER_H
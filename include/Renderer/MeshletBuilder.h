@@ -0,0 +1,51 @@
+#pragma once
+#ifndef RDMESHLETBUILDER_H
+#define RDMESHLETBUILDER_H
+#include "Mesh.h"
+#include <array>
+#include <span>
+namespace nyan {
+	//GPU ready cluster representation of a mesh
+	//vertices maps meshlet local vertices to mesh vertices, triangles stores three local uint8 indices per triangle
+	struct MeshletData {
+		std::vector<nyan::shaders::Meshlet> meshlets;
+		std::vector<nyan::shaders::MeshletBounds> bounds;
+		std::vector<uint32_t> vertices;
+		std::vector<uint8_t> triangles;
+		size_t byte_size() const {
+			return meshlets.size() * sizeof(decltype(meshlets)::value_type) +
+				bounds.size() * sizeof(decltype(bounds)::value_type) +
+				vertices.size() * sizeof(decltype(vertices)::value_type) +
+				triangles.size() * sizeof(decltype(triangles)::value_type);
+		}
+	};
+	class MeshletBuilder {
+	public:
+		struct Settings {
+			uint32_t maxVertices{ nyan::shaders::MESHLET_MAX_VERTICES };
+			uint32_t maxTriangles{ nyan::shaders::MESHLET_MAX_TRIANGLES };
+			//Penalty for adding triangles which widen the normal cone, 0 optimizes purely for locality
+			float coneWeight{ 0.25f };
+		};
+		static MeshletData build(const nyan::Mesh& mesh, const Settings& settings);
+		static MeshletData build(const nyan::Mesh& mesh);
+		//Builds meshlets for all meshes in parallel on the job system
+		static std::vector<MeshletData> build(std::span<const nyan::Mesh> meshes, const Settings& settings);
+		static std::vector<MeshletData> build(std::span<const nyan::Mesh> meshes);
+		static nyan::shaders::MeshletBounds compute_bounds(std::span<const uint32_t> vertices, std::span<const uint8_t> triangles, std::span<const Math::vec3> positions);
+	};
+	//CPU reference of the cluster culling, all inputs are in the object space of the mesh
+	class MeshletCuller {
+	public:
+		//Normalized planes, a point is inside if dot(plane.xyz, p) + plane.w >= 0
+		using Frustum = std::array<Math::vec4, 6>;
+		static Frustum extract_frustum(const Math::Mat<float, 4, 4, true>& viewProj);
+		static bool frustum_visible(const nyan::shaders::MeshletBounds& bounds, const Frustum& frustum);
+		static bool cone_visible(const nyan::shaders::MeshletBounds& bounds, const Math::vec3& cameraPosition);
+		static bool visible(const nyan::shaders::MeshletBounds& bounds, const Frustum& frustum, const Math::vec3& cameraPosition);
+		//Returns the indices of all visible meshlets
+		static std::vector<uint32_t> cull(const MeshletData& data, const Frustum& frustum, const Math::vec3& cameraPosition);
+	};
+}
+
+#endif !RDMESHLETBUILDER_H
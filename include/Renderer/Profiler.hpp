@@ -4,6 +4,7 @@
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <optional>
 #include <VulkanForwards.h>
 
 namespace nyan {
@@ -17,6 +18,12 @@ namespace nyan {
 		void end_profile(vulkan::CommandBuffer& cmd);
 		void begin_profile(const std::string& name);
 		void end_profile();
+		//Work of the named profile done outside of begin_profile and end_profile, e.g. on worker threads, counts towards its CPU time of this frame
+		void add_cpu_time(const std::string& name, std::chrono::steady_clock::duration duration);
+		//Average GPU time in milliseconds of the profiles with the name, e.g. Rendergraph passes
+		std::optional<float> get_gpu_time(const std::string& name) const;
+		//Average CPU time in milliseconds between begin_profile and end_profile, for Rendergraph passes the time recording them
+		std::optional<float> get_cpu_time(const std::string& name) const;
 	private:
 		template<size_t N>
 		struct Average {
@@ -66,6 +73,7 @@ namespace nyan {
 		float m_timestampPeriod;
 		std::unordered_map<std::thread::id, ThreadData> m_profiles;
 		std::unordered_map<std::thread::id, GPUThreadData> m_GPUprofiles;
+		std::unordered_map<std::string, std::chrono::steady_clock::duration> m_addedCPUTimes;
 		std::unordered_map<std::string, Average<1000> > m_averages;
 	};
 }
\ No newline at end of file
@@ -2,10 +2,17 @@
 #ifndef RDRENDERGRAPH_H
 #define RDRENDERGRAPH_H
 #include "VkWrapper.h"
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <optional>
 #include <variant>
 #include <set>
 #include "entt/core/hashed_string.hpp"
 #include "PipelineConfig.h"
+#include "Pipeline.h"
+#include "RenderGraphCompiler.h"
+#include "TransientMemoryPacker.h"
 namespace nyan {
 
 	//Interfaces
@@ -80,6 +87,8 @@ namespace nyan {
 		//Utility::bitset<static_cast<size_t>(ImageUse::Size), ImageUse> totalUses;
 		Attachment attachment;
 		vulkan::Image* handle = nullptr;
+		//Read outside of the graph, passes writing it are never culled
+		bool exported = false;
 	};
 	static constexpr RenderResource::Id InvalidResourceId{ invalidValue };
 	static constexpr uint32_t InvalidBinding{ invalidValue };
@@ -161,13 +170,24 @@ namespace nyan {
 		void add_swapchain_write(Math::vec4 clearColor = Math::vec4{}, Renderpass::Write::Type writeType = Write::Type::Graphics, bool clear = false);
 			//void add_read_dependency(const std::string& name, bool storageImage = false);
 		void add_renderfunction(const std::function<void(vulkan::CommandBuffer&, Renderpass&) > & functor, bool renderpass) {
-			m_renderFunctions.push_back(functor);
-			m_useRendering.push_back(renderpass);
+			m_renderFunctions.push_back(RenderFunction{ .record {functor}, .rendering {renderpass} });
+		}
+		//Recorded on worker threads into secondary command buffers before the passes are recorded in order
+		//prepare runs on the calling thread and returns the number of items, e.g. draws, record is called for chunks [begin, end) of them
+		//record may only read state which doesn't change while the graph executes, it must set all state it relies on
+		void add_parallel_renderfunction(const std::function<size_t()>& prepare,
+				const std::function<void(vulkan::CommandBuffer&, Renderpass&, size_t begin, size_t end)>& record, bool renderpass, size_t minChunkSize) {
+			m_renderFunctions.push_back(RenderFunction{ .prepare {prepare}, .recordChunk {record}, .minChunkSize {minChunkSize}, .rendering {renderpass} });
 		}
 		//void remove_read(RenderResource::Id id, Renderpass::Read::Type readType);
 		//void remove_write(RenderResource::Id id, Renderpass::Write::Type writeType);
 		//void remove_swapchain_write(Renderpass::Write::Type writeType);
 		void copy(RenderResource::Id source, RenderResource::Id target); 
+		//The pass only dispatches and traces rays, the Rendergraph moves it to the compute queue
+		//whenever the profiled pass timings predict that it overlaps independent graphics work
+		void allow_async_compute() noexcept {
+			m_asyncCompute = true;
+		}
 
 		Renderpass::Id get_id() const noexcept {
 			return m_id;
@@ -189,16 +209,21 @@ namespace nyan {
 		void add_post_barrier(const VkMemoryBarrier2& barrier);
 
 
-		void add_pipeline(vulkan::GraphicsPipelineConfig config, vulkan::PipelineId* id);
-		void begin_rendering(vulkan::CommandBuffer& cmd);
+		//Pipelines added after the graph was built compile in the background, id holds the placeholder until they are ready
+		void add_pipeline(vulkan::GraphicsPipelineConfig config, vulkan::PipelineId* id, vulkan::PipelineId placeholder = vulkan::invalidPipelineId);
+		void begin_rendering(vulkan::CommandBuffer& cmd, VkRenderingFlags flags = 0);
 		void end_rendering(vulkan::CommandBuffer& cmd);
 		uint32_t get_write_bind(uint32_t idx);
 		uint32_t get_read_bind(uint32_t idx);
 		uint32_t get_write_bind(RenderResource::Id id, Write::Type type = Write::Type::Graphics);
 		uint32_t get_read_bind(RenderResource::Id id, Read::Type type = Read::Type::ImageColor);
-		void add_wait(VkSemaphore wait, VkPipelineStageFlags2 stage);
+		void add_wait(VkSemaphore wait, VkPipelineStageFlags2 stage, uint64_t value);
 		void add_signal(Renderpass::Id passId, VkPipelineStageFlags2 stage);
 		void build();
+		//Blocks until the pipelines queued by build are compiled, returns their count
+		uint32_t wait_for_pipelines();
+		//Swaps finished background compiles in for their placeholders, never blocks
+		void update_pipelines();
 		void clear_dependencies();
 		void clear_resource_references(RenderResource::Id id);
 	private:
@@ -206,6 +231,8 @@ namespace nyan {
 		void build_pipelines();
 		void update_binds();
 		void update_image_barriers();
+		bool has_pre_barriers() const noexcept;
+		bool has_post_barriers() const noexcept;
 		void update_rendering_info();
 		void update_views();
 		bool is_read(RenderResource::Id id) const;
@@ -221,9 +248,20 @@ namespace nyan {
 		std::string m_name;
 		Type m_type;
 		Renderpass::Id m_id;
-		std::vector<std::function<void(vulkan::CommandBuffer&, Renderpass&)>> m_renderFunctions;
-		std::vector<bool> m_useRendering;
+		struct RenderFunction {
+			std::function<void(vulkan::CommandBuffer&, Renderpass&)> record;
+			//Only set for parallel render functions
+			std::function<size_t()> prepare;
+			std::function<void(vulkan::CommandBuffer&, Renderpass&, size_t, size_t)> recordChunk;
+			size_t minChunkSize{ 1 };
+			bool rendering{ false };
+			//Secondary command buffers of the current frame, in chunk order
+			std::vector<VkCommandBuffer> chunks;
+		};
+		std::vector<RenderFunction> m_renderFunctions;
 		bool m_rendersSwap = false;
+		//m_type alternates between Generic and AsyncCompute with the placement chosen by the compiler
+		bool m_asyncCompute = false;
 		//Order Renderpass ressources as Reads first, then writes, i.e. [R] 1, [R] 5, [W] 2, [W] 3
 		std::vector<Copy> m_copies;
 		std::vector<Read> m_reads;
@@ -236,9 +274,12 @@ namespace nyan {
 		{
 			vulkan::GraphicsPipelineConfig config;
 			vulkan::PipelineId* id;
+			vulkan::PipelineFuture future {};
+			vulkan::PipelineId placeholder {vulkan::invalidPipelineId};
 		};
 
 		std::vector< PipelineBuild> m_queuedPipelineBuilds;
+		std::vector< PipelineBuild> m_pendingPipelineBuilds;
 
 
 		struct Signal {
@@ -292,6 +333,20 @@ namespace nyan {
 			}
 		} m_imageBarriers2{};
 
+		//Transitions to a later pass of the same batch, released by an event set after this pass
+		struct EventBarriers {
+			Renderpass::Id consumer;
+			std::vector<RenderResource::Id> images{};
+			std::vector<VkImageMemoryBarrier2> barriers{};
+			//Requested each frame, only valid until the consumer waited for it
+			VkEvent event{ VK_NULL_HANDLE };
+		};
+		std::vector<EventBarriers> m_eventBarriers{};
+		struct EventWait {
+			Renderpass::Id producer;
+			uint32_t index;
+		};
+		std::vector<EventWait> m_eventWaits{};
 
 
 		VkRenderingInfo m_renderInfo
@@ -350,7 +405,7 @@ namespace nyan {
 		nyan::RenderResource::Id specular;
 	};
 
-	class Rendergraph {
+	class Rendergraph : public RenderGraphBackend {
 		friend class Renderpass;
 	private:
 		enum class State : uint8_t{
@@ -361,6 +416,7 @@ namespace nyan {
 		};
 	public:
 		Rendergraph(vulkan::LogicalDevice& device);
+		~Rendergraph();
 		Renderpass::Id add_pass(const std::string& name, Renderpass::Type type);
 		Renderpass& get_pass(Renderpass::Id id);
 		void build();
@@ -379,7 +435,39 @@ namespace nyan {
 		RenderResource& get_resource(RenderResource::Id id);
 		void remove_resource(RenderResource::Id id);
 		bool resource_exists(RenderResource::Id id);
+		void export_resource(RenderResource::Id id);
+		const RenderGraphPlan& get_plan() const noexcept {
+			return m_plan;
+		}
+		//Placement of the transient attachments, indexed like get_transient_resources()
+		const TransientMemoryPacker::Packing& get_transient_packing() const noexcept {
+			return m_transientPacking;
+		}
+		const std::vector<RenderResource::Id>& get_transient_resources() const noexcept {
+			return m_transientResources;
+		}
+		//Writes rendergraph.dot and rendergraph.json of the current plan into the directory, with the timings of the profiler
+		void export_graph(const std::filesystem::path& directory) const;
+		//Exports at the end of every interval-th frame, 0 disables it
+		void set_export(const std::filesystem::path& directory, uint32_t interval);
 	private:
+		RenderGraphDescription build_description() const;
+		void compile();
+		bool schedule_changed() const;
+		Utility::HashValue compute_plan_key() const;
+		void set_up_barriers();
+		void schedule_transitions();
+		//Records the post barriers of the previous pass of a batch and the pre barriers of the next one as one pipeline barrier
+		void record_barriers(vulkan::CommandBuffer& cmd, Renderpass* post, Renderpass* pre);
+		void begin_plan(const RenderGraphPlan& plan) override;
+		void record_parallel_renderfunctions(const RenderGraphPlan& plan);
+		void begin_batch(uint32_t batchIndex) override;
+		void execute_pass(uint32_t passIndex) override;
+		void end_batch(uint32_t batchIndex) override;
+		bool is_transient(const RenderResource& resource) const;
+		std::optional<vulkan::ImageInfo> get_image_info(const RenderResource& resource) const;
+		bool update_transient_resources();
+		void set_up_aliasing_barrier(const RenderResource& resource, VkImageMemoryBarrier2& barrier) const;
 		void swapchain_present_transition(Renderpass::Id src_const);
 		void set_up_transition(Renderpass::Id from, Renderpass::Id to, const RenderResource& resource);
 		void set_up_first_transition(Renderpass::Id dst, const RenderResource& resource);
@@ -390,6 +478,22 @@ namespace nyan {
 		void clear_dependencies();
 		void remove_queued_resources();
 
+		//Barriers and signals set up for a plan, indexed by pass id
+		struct CachedDependencies {
+			decltype(Renderpass::m_globalBarriers2) globalBarriers;
+			decltype(Renderpass::m_imageBarriers2) imageBarriers;
+			decltype(Renderpass::m_bufferBarriers2) bufferBarriers;
+			std::vector<Renderpass::Signal> signals;
+			decltype(Renderpass::m_eventBarriers) eventBarriers;
+			decltype(Renderpass::m_eventWaits) eventWaits;
+		};
+		struct Transition {
+			Renderpass::Id from;
+			Renderpass::Id to;
+			RenderResource::Id image;
+			VkImageMemoryBarrier2 barrier;
+		};
+
 		State m_state = State::Setup;
 		vulkan::LogicalDevice& r_device;
 		nyan::Profiler* p_profiler{ nullptr };
@@ -403,7 +507,49 @@ namespace nyan {
 		RenderResource::Id::Type m_resourceCount{ 0 };
 		Renderpass::Id m_lastCompute {};
 		Renderpass::Id m_lastGeneric {};
+		uint32_t m_framesSinceSchedule {0};
+		std::filesystem::path m_exportDirectory {};
+		uint32_t m_exportInterval {0};
+		uint32_t m_framesSinceExport {0};
+		//Toggled passes and resizes switch between a few plans, setting up their barriers again is the expensive part
+		RenderGraphPlanCache<std::vector<CachedDependencies>> m_dependencyCache {8};
+		VkExtent2D m_swapchainExtent {};
+		//Only the acquired swapchain image changes between frames of an unchanged graph
+		std::vector<Renderpass::Id> m_swapchainPasses {};
+		//Transitions between passes without queue ownership transfer, placed by RenderGraphCompiler::schedule_barriers
+		std::vector<Transition> m_transitions {};
+		//Pass of the current batch whose post barriers aren't recorded yet
+		Renderpass* p_pendingPostBarriers {nullptr};
+		std::vector<VkMemoryBarrier2> m_mergedGlobalBarriers {};
+		std::vector<VkBufferMemoryBarrier2> m_mergedBufferBarriers {};
+		std::vector<VkImageMemoryBarrier2> m_mergedImageBarriers {};
+		std::vector<VkEvent> m_waitEvents {};
+		std::vector<VkDependencyInfo> m_waitDependencies {};
 		std::vector<RenderResource::Id> m_queuedResourceDeletion {};
+		RenderGraphPlan m_plan {};
+		Utility::HashValue m_transientKey {0};
+		std::vector<RenderResource::Id> m_transientResources {};
+		TransientMemoryPacker::Packing m_transientPacking {};
+		std::vector<vulkan::AllocationHandle> m_transientHeaps {};
+		std::unordered_map<RenderResource::Id, vulkan::ImageHandle> m_transientImages {};
+		//Passes of a batch share one command buffer
+		std::optional<vulkan::CommandBufferHandle> m_batchCommandBuffer {};
+		struct ParallelChunk {
+			Renderpass* pass;
+			uint32_t function;
+			uint32_t chunk;
+			size_t begin;
+			size_t end;
+			std::chrono::steady_clock::duration cpuTime;
+		};
+		std::vector<ParallelChunk> m_parallelChunks {};
+		//Time spent in prepare and chunk recording per pass id, added to the CPU time of the pass
+		std::vector<std::chrono::steady_clock::duration> m_parallelCpuTimes {};
+		//One timeline per queue, indexed by RenderGraphDescription::Queue, signaled once per batch other queues wait for
+		std::array<VkSemaphore, 3> m_timelineSemaphores {};
+		std::array<uint64_t, 3> m_timelineValues {};
+		//Timeline value signaled by each batch of the current plan, 0 if it doesn't signal
+		std::vector<uint64_t> m_batchValues {};
 
 		//RenderpassId m_lastPass { invalidRenderpassId };
 	};
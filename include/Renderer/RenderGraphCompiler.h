@@ -0,0 +1,319 @@
+#pragma once
+#ifndef RDRENDERGRAPHCOMPILER_H
+#define RDRENDERGRAPHCOMPILER_H
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+namespace nyan {
+	//Device independent view of a frame, passes and resources are referenced by their index
+	//The Rendergraph builds it from add_read/add_write/add_attachment/copy, tests build it by hand
+	struct RenderGraphDescription {
+		enum class Queue : uint8_t {
+			Graphics,
+			Compute,
+			Transfer,
+		};
+		struct Access {
+			enum class Type : uint8_t {
+				Read,
+				//Overwrites every texel, e.g. clears and copy targets, the previous contents are dead
+				Write,
+				//Partial writes and attachments which load their previous contents
+				ReadWrite,
+			};
+			uint32_t resource;
+			Type type;
+		};
+		struct Pass {
+			std::string name;
+			Queue queue{ Queue::Graphics };
+			std::vector<Access> accesses;
+			//Relative GPU cost, used to prioritize the critical path
+			float cost{ 1.f };
+			//Never culled, passes without any write are treated the same since their effects are unknown
+			bool sideEffects{ false };
+			//Waits on a semaphore from outside of the graph, e.g. the swapchain image acquisition
+			//Starts a new batch so the passes before it don't wait as well
+			bool externalWait{ false };
+			//Only dispatches and copies, the compiler may move it between the graphics and the compute queue
+			bool asyncCompute{ false };
+		};
+		struct Resource {
+			std::string name;
+			//Consumed outside of the graph, e.g. the swapchain, passes producing it are never culled
+			bool exported{ false };
+		};
+		std::vector<Pass> passes;
+		std::vector<Resource> resources;
+	};
+
+	//Result of compiling a RenderGraphDescription, immutable once created
+	class RenderGraphPlan {
+		friend class RenderGraphCompiler;
+	public:
+		static constexpr uint32_t invalidIndex{ std::numeric_limits<uint32_t>::max() };
+		//Positions in the execution order of the first and last pass accessing a resource
+		struct Lifetime {
+			uint32_t first{ invalidIndex };
+			uint32_t last{ invalidIndex };
+			bool used() const noexcept {
+				return first != invalidIndex;
+			}
+		};
+		//Consecutive passes of one queue which are recorded into one command buffer and submitted together
+		struct Batch {
+			RenderGraphDescription::Queue queue;
+			//Range of positions in the execution order
+			uint32_t begin;
+			uint32_t end;
+			//Earlier batches of other queues which have to finish first, only the latest one per queue
+			std::vector<uint32_t> waits;
+			//A later batch of another queue waits for this batch
+			bool signals{ false };
+		};
+		//Pass indices of all passes which are not culled, in execution order
+		const std::vector<uint32_t>& get_order() const noexcept {
+			return m_order;
+		}
+		bool is_culled(uint32_t pass) const noexcept {
+			return m_position[pass] == invalidIndex;
+		}
+		//Position of the pass in the execution order, invalidIndex for culled passes
+		uint32_t get_position(uint32_t pass) const noexcept {
+			return m_position[pass];
+		}
+		//Passes which have to execute before the pass, culled passes have none
+		const std::vector<uint32_t>& get_dependencies(uint32_t pass) const noexcept {
+			return m_dependencies[pass];
+		}
+		const Lifetime& get_lifetime(uint32_t resource) const noexcept {
+			return m_lifetimes[resource];
+		}
+		//Batches in submission order
+		const std::vector<Batch>& get_batches() const noexcept {
+			return m_batches;
+		}
+		//Index of the batch containing the pass, invalidIndex for culled passes
+		uint32_t get_batch(uint32_t pass) const noexcept {
+			return m_batch[pass];
+		}
+		//Queue the pass executes on, differs from the description only for asyncCompute passes
+		RenderGraphDescription::Queue get_queue(uint32_t pass) const noexcept {
+			return m_queues[pass];
+		}
+		//Predicted GPU time of the plan in units of the pass costs, including the cost of cross-queue waits
+		float get_estimated_time() const noexcept {
+			return m_estimatedTime;
+		}
+		size_t get_pass_count() const noexcept {
+			return m_position.size();
+		}
+		size_t get_resource_count() const noexcept {
+			return m_lifetimes.size();
+		}
+	private:
+		std::vector<uint32_t> m_order;
+		std::vector<uint32_t> m_position;
+		std::vector<std::vector<uint32_t>> m_dependencies;
+		std::vector<Lifetime> m_lifetimes;
+		std::vector<Batch> m_batches;
+		std::vector<uint32_t> m_batch;
+		std::vector<RenderGraphDescription::Queue> m_queues;
+		float m_estimatedTime{ 0.f };
+	};
+
+	//Where the halves of the image transitions between passes are recorded
+	//A transition either becomes part of the one pipeline barrier recorded right before its consumer,
+	//or a split barrier: an event set right after the producer and waited right before the consumer
+	class RenderGraphBarrierSchedule {
+		friend class RenderGraphCompiler;
+	public:
+		enum class Type : uint8_t {
+			Barrier,
+			Event,
+		};
+		struct Transition {
+			//invalidIndex if the producer executed in the previous frame
+			uint32_t producer;
+			uint32_t consumer;
+		};
+		//Transitions between the same two passes share one event
+		struct Event {
+			uint32_t producer;
+			uint32_t consumer;
+		};
+		Type get_type(uint32_t transition) const noexcept {
+			return m_types[transition];
+		}
+		//Event of a split transition, invalidIndex for transitions in a pipeline barrier
+		uint32_t get_event(uint32_t transition) const noexcept {
+			return m_transitionEvents[transition];
+		}
+		const std::vector<Event>& get_events() const noexcept {
+			return m_events;
+		}
+		//Transitions merged into the pipeline barrier recorded before the pass
+		const std::vector<uint32_t>& get_barriers(uint32_t pass) const noexcept {
+			return m_barriers[pass];
+		}
+		//Events waited for before the pass, all in one wait
+		const std::vector<uint32_t>& get_waits(uint32_t pass) const noexcept {
+			return m_waits[pass];
+		}
+		//Events set after the pass
+		const std::vector<uint32_t>& get_sets(uint32_t pass) const noexcept {
+			return m_sets[pass];
+		}
+	private:
+		std::vector<Type> m_types;
+		std::vector<uint32_t> m_transitionEvents;
+		std::vector<Event> m_events;
+		std::vector<std::vector<uint32_t>> m_barriers;
+		std::vector<std::vector<uint32_t>> m_waits;
+		std::vector<std::vector<uint32_t>> m_sets;
+	};
+
+	class RenderGraphCompiler {
+	public:
+		struct Settings {
+			//Keeps every access to a resource in declaration order, even reads which could be reordered freely
+			//The Rendergraph needs this since its barriers are derived from consecutive uses in declaration order
+			bool orderResourceUses{ false };
+			bool cullPasses{ true };
+			//Moves asyncCompute passes to the queue which minimizes the estimated time
+			bool scheduleAsyncCompute{ false };
+			//Cost of a pass waiting on another queue, the semaphore round trip and the split of the batches
+			float queueSyncCost{ 0.05f };
+		};
+		//Declaration order defines the meaning of the graph: a read sees the latest preceding write,
+		//reads before the first write see the contents of the previous frame
+		//Passes that neither produce an exported resource nor have side effects, directly or through their consumers, are culled
+		//The remaining passes are topologically sorted, ready passes with the longest remaining critical path go first
+		//so producers run as early as possible and their latency is hidden behind independent work
+		//With scheduleAsyncCompute the asyncCompute passes are hoisted onto the compute queue where they overlap graphics work,
+		//the queues are simulated in execution order with the pass costs and a pass is only moved if the estimate improves
+		//Consecutive passes of a queue are grouped into batches, batches only end where another queue has to wait
+		//and only start where a pass waits on another queue, so cross-queue synchronization keeps the granularity of passes
+		static RenderGraphPlan compile(const RenderGraphDescription& description);
+		static RenderGraphPlan compile(const RenderGraphDescription& description, const Settings& settings);
+		//Hash of everything state derived from the plan depends on: accesses, flags, culling, execution order and queues
+		//Names and costs only matter through the order and queues they lead to
+		static uint64_t hash(const RenderGraphDescription& description, const RenderGraphPlan& plan);
+		//Transitions whose producer ran directly before the consumer in the same batch, or in an earlier batch, go into the pipeline barrier
+		//before the consumer, so the transitions of consecutive passes are recorded together
+		//If other passes of the batch run in between, the transition is split so they don't wait for the producer
+		//Events don't cross command buffers, queue ownership transfers aren't transitions for the schedule
+		static RenderGraphBarrierSchedule schedule_barriers(const RenderGraphPlan& plan, std::span<const RenderGraphBarrierSchedule::Transition> transitions);
+	};
+
+	//Recently used values keyed by a plan hash, e.g. the barriers of both variants of a graph whose debug pass is toggled
+	template<typename T>
+	class RenderGraphPlanCache {
+	public:
+		explicit RenderGraphPlanCache(size_t capacity) :
+			m_capacity(capacity)
+		{
+			assert(capacity);
+		}
+		//Marks the entry as most recently used, nullptr on a miss
+		T* find(uint64_t key) {
+			auto it = std::find_if(m_entries.begin(), m_entries.end(), [key](const auto& entry) { return entry.first == key; });
+			if (it == m_entries.end()) {
+				m_misses++;
+				return nullptr;
+			}
+			m_hits++;
+			std::rotate(m_entries.begin(), it, it + 1);
+			return &m_entries.front().second;
+		}
+		//Evicts the least recently used entry once the cache is full
+		T& insert(uint64_t key, T value) {
+			assert(std::none_of(m_entries.begin(), m_entries.end(), [key](const auto& entry) { return entry.first == key; }));
+			if (m_entries.size() == m_capacity)
+				m_entries.pop_back();
+			m_entries.emplace(m_entries.begin(), key, std::move(value));
+			return m_entries.front().second;
+		}
+		void clear() noexcept {
+			m_entries.clear();
+		}
+		size_t size() const noexcept {
+			return m_entries.size();
+		}
+		size_t get_hits() const noexcept {
+			return m_hits;
+		}
+		size_t get_misses() const noexcept {
+			return m_misses;
+		}
+	private:
+		//Most recently used first, plans are few and the linear search beats hashing
+		std::vector<std::pair<uint64_t, T>> m_entries;
+		size_t m_capacity;
+		size_t m_hits{ 0 };
+		size_t m_misses{ 0 };
+	};
+
+	//Executes a plan, implemented by the Rendergraph for Vulkan and by the NullRenderGraphBackend
+	class RenderGraphBackend {
+	public:
+		virtual ~RenderGraphBackend() = default;
+		virtual void begin_plan(const RenderGraphPlan&) {}
+		virtual void begin_batch(uint32_t) {}
+		virtual void execute_pass(uint32_t pass) = 0;
+		//Submits the passes of the batch
+		virtual void end_batch(uint32_t) {}
+		virtual void end_plan() {}
+		void execute(const RenderGraphPlan& plan);
+	};
+
+	//Records the executed passes instead of touching a device, for tests and CPU benchmarks of the compiler
+	class NullRenderGraphBackend : public RenderGraphBackend {
+	public:
+		void begin_plan(const RenderGraphPlan&) override {
+			m_executedPasses.clear();
+			m_submittedBatches.clear();
+			m_barrierCounts = {};
+		}
+		void execute_pass(uint32_t pass) override {
+			m_executedPasses.push_back(pass);
+			if (!p_barrierSchedule)
+				return;
+			m_barrierCounts.pipelineBarriers += !p_barrierSchedule->get_barriers(pass).empty();
+			m_barrierCounts.eventWaits += !p_barrierSchedule->get_waits(pass).empty();
+			m_barrierCounts.eventSets += static_cast<uint32_t>(p_barrierSchedule->get_sets(pass).size());
+		}
+		void end_batch(uint32_t batch) override {
+			m_submittedBatches.push_back(batch);
+		}
+		const std::vector<uint32_t>& get_executed_passes() const noexcept {
+			return m_executedPasses;
+		}
+		const std::vector<uint32_t>& get_submitted_batches() const noexcept {
+			return m_submittedBatches;
+		}
+		//Counts the synchronization commands the schedule records while executing, the schedule has to outlive the execution
+		void set_barrier_schedule(const RenderGraphBarrierSchedule* schedule) noexcept {
+			p_barrierSchedule = schedule;
+		}
+		struct BarrierCounts {
+			uint32_t pipelineBarriers{ 0 };
+			uint32_t eventSets{ 0 };
+			uint32_t eventWaits{ 0 };
+		};
+		const BarrierCounts& get_barrier_counts() const noexcept {
+			return m_barrierCounts;
+		}
+	private:
+		std::vector<uint32_t> m_executedPasses;
+		std::vector<uint32_t> m_submittedBatches;
+		const RenderGraphBarrierSchedule* p_barrierSchedule{ nullptr };
+		BarrierCounts m_barrierCounts;
+	};
+}
+#endif !RDRENDERGRAPHCOMPILER_H
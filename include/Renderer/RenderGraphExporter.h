@@ -0,0 +1,41 @@
+#pragma once
+#ifndef RDRENDERGRAPHEXPORTER_H
+#define RDRENDERGRAPHEXPORTER_H
+#include "RenderGraphCompiler.h"
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+namespace nyan {
+	//Writes a compiled render graph as DOT or JSON for frame analysis
+	//Passes and resources are written in index order, one per line, so exports of two builds diff line by line
+	class RenderGraphExporter {
+	public:
+		struct PassStats {
+			//Averages in milliseconds, unknown if the pass wasn't profiled
+			std::optional<float> cpuTime;
+			std::optional<float> gpuTime;
+			//Transitions recorded in the pipeline barrier before the pass
+			uint32_t barriers{ 0 };
+			//Split transitions, waited for before and set after the pass
+			uint32_t eventWaits{ 0 };
+			uint32_t eventSets{ 0 };
+		};
+		struct ResourceStats {
+			//Bytes of transient memory, 0 for resources with a dedicated allocation
+			uint64_t transientSize{ 0 };
+			uint32_t heap{ RenderGraphPlan::invalidIndex };
+			uint64_t offset{ 0 };
+		};
+		//Indexed like the passes and resources of the description, missing entries are written as defaults
+		struct Stats {
+			std::vector<PassStats> passes;
+			std::vector<ResourceStats> resources;
+		};
+		//Culled passes are dashed, batches are clusters, edges go from writers to resources and from resources to readers
+		static std::string to_dot(const RenderGraphDescription& description, const RenderGraphPlan& plan, const Stats& stats);
+		static std::string to_json(const RenderGraphDescription& description, const RenderGraphPlan& plan, const Stats& stats);
+		static void write(const std::filesystem::path& path, std::string_view contents);
+	};
+}
+#endif !RDRENDERGRAPHEXPORTER_H
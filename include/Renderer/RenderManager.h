@@ -9,6 +9,7 @@
 #include "MaterialManager.h"
 #include "DDGIManager.h"
 #include "TextureManager.h"
+#include "AssetStreamer.h"
 #include "Camera.h"
 #include "Profiler.hpp"
 #include "entt/entt.hpp"
@@ -18,7 +19,7 @@ namespace nyan {
 	struct Parent {
 		entt::entity parent{ entt::null };
 	};
-	class RenderManager {
+	class RenderManager : private AssetUploadSink {
 	public:
 		RenderManager(vulkan::LogicalDevice& device, bool useRaytracing = false, const std::filesystem::path& directory = std::filesystem::current_path());
 		nyan::Rendergraph& get_render_graph();
@@ -43,6 +44,7 @@ namespace nyan {
 		const entt::registry& get_registry() const;
 		nyan::Profiler& get_profiler();
 		const nyan::Profiler& get_profiler() const;
+		nyan::AssetStreamer& get_asset_streamer();
 
 		void add_materials(const std::vector<nyan::MaterialData>& materials);
 		void set_primary_camera(entt::entity entity);
@@ -51,6 +53,7 @@ namespace nyan {
 		void begin_frame();
 		void end_frame();
 	private:
+		void upload(AssetRequestId id, AssetPayload& payload) override;
 		vulkan::LogicalDevice& r_device;
 		entt::registry m_registry;
 		nyan::Rendergraph m_rendergraph;
@@ -63,6 +66,7 @@ namespace nyan {
 		nyan::DDGIManager m_ddgiManager;
 		nyan::DDGIReSTIRManager m_ddgiReSTIRManager;
 		nyan::Profiler m_profiler;
+		nyan::AssetStreamer m_assetStreamer;
 
 		bool m_useRayTracing;
 		entt::entity m_primaryCamera;
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef RDSCENEASSET_H
+#define RDSCENEASSET_H
+#include "MeshQuantizer.h"
+#include "Material.h"
+#include "Light.h"
+#include "Transform.h"
+#include <filesystem>
+#include <optional>
+namespace nyan {
+	//Plain description of an imported scene, independent of any device or registry
+	//Produced by importers on any thread and committed into the managers in one pass afterwards
+	struct SceneTextureAsset {
+		//Name materials refer to the texture by
+		std::string name;
+		//Image file, empty for embedded images
+		std::filesystem::path file;
+		//Decoded embedded image
+		uint32_t width{ 0 };
+		uint32_t height{ 0 };
+		uint32_t components{ 0 };
+		uint32_t bitsPerChannel{ 0 };
+		std::vector<unsigned char> data;
+		bool is_embedded() const {
+			return file.empty();
+		}
+	};
+	struct ScenePrimitiveAsset {
+		//materialBinding is left unset, it only exists after committing
+		QuantizedMesh mesh;
+		//Index into SceneAsset::materials, -1 for primitives without material
+		int32_t material{ -1 };
+		//Simplified levels of detail, coarsest last, lodErrors holds the object space error of each
+		std::vector<QuantizedMesh> lods;
+		std::vector<float> lodErrors;
+	};
+	struct SceneMeshAsset {
+		std::string name;
+		//Indices into SceneAsset::primitives
+		std::vector<uint32_t> primitives;
+	};
+	struct SceneNodeAsset {
+		std::string name;
+		//Relative to the parent node
+		Transform transform{};
+		//Index into SceneAsset::meshes, -1 for nodes without mesh
+		int32_t mesh{ -1 };
+		std::optional<Pointlight> light;
+		//Indices into SceneAsset::nodes
+		std::vector<uint32_t> children;
+	};
+	struct SceneRootAsset {
+		std::string name;
+		//Indices into SceneAsset::nodes
+		std::vector<uint32_t> nodes;
+	};
+	struct SceneAsset {
+		//Usually the source file
+		std::string name;
+		std::vector<SceneTextureAsset> textures;
+		std::vector<PBRMaterialData> materials;
+		std::vector<ScenePrimitiveAsset> primitives;
+		std::vector<SceneMeshAsset> meshes;
+		std::vector<SceneNodeAsset> nodes;
+		std::vector<SceneRootAsset> scenes;
+		//Full resolution primitives only
+		QuantizationStatistics quantizationStatistics{};
+	};
+}
+
+#endif !RDSCENEASSET_H
@@ -0,0 +1,26 @@
+#pragma once
+#ifndef RDSCENEASSETCACHE_H
+#define RDSCENEASSETCACHE_H
+#include "SceneAsset.h"
+#include <cstddef>
+#include <span>
+#include <vector>
+namespace nyan {
+	//On disk copy of the first import stage, one file per source keyed by a hash of the source
+	//Decoding, optimization, lod generation and quantization are skipped for unchanged sources
+	class SceneAssetCache {
+	public:
+		static constexpr uint32_t magic = 0x4153594eu; //"NYSA"
+		//Bump whenever the importer output or the layout changes, old files then miss
+		static constexpr uint32_t version = 1;
+		//Empty if there is no usable file for the key
+		static std::optional<SceneAsset> load(const std::filesystem::path& directory, uint64_t sourceKey);
+		//Throws std::runtime_error if the file can't be written
+		static void store(const std::filesystem::path& directory, uint64_t sourceKey, const SceneAsset& asset);
+		static std::filesystem::path get_path(const std::filesystem::path& directory, uint64_t sourceKey);
+		static std::vector<std::byte> serialize(const SceneAsset& asset, uint64_t sourceKey);
+		//Empty if the data isn't a complete file of this version for the key
+		static std::optional<SceneAsset> deserialize(std::span<const std::byte> data, uint64_t sourceKey);
+	};
+}
+#endif !RDSCENEASSETCACHE_H
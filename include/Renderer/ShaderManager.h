@@ -9,7 +9,8 @@ namespace vulkan {
 	class ShaderManager {
 	public:
 	public:
-		ShaderManager(LogicalDevice& device, const std::filesystem::path& shaderDirectory = (std::filesystem::current_path() / "shaders"));
+		ShaderManager(LogicalDevice& device, const std::filesystem::path& shaderDirectory = (std::filesystem::current_path() / "shaders"),
+			const std::filesystem::path& reflectionCachePath = (std::filesystem::current_path() / "shader_reflection.cache"));
 		//template<typename ...Args>
 		//Program* request_program(Args&&... args) {
 		//	ShaderLayout layout{};
@@ -84,6 +85,7 @@ namespace vulkan {
 		void load_shaders(const std::filesystem::path& shaderDirectory);
 		//Shader* request_shader(const std::string& filename);
 		LogicalDevice& r_device;
+		Utility::ShaderReflectionCache m_reflectionCache;
 		//Utility::HashMap<Program*> m_cachedPrograms;
 		//Utility::NonInvalidatingMap<Utility::HashValue, Program> m_cachedPrograms;
 		//Utility::NonInvalidatingMap<std::string, Shader> m_cachedShaders;
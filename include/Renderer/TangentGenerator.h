@@ -0,0 +1,29 @@
+#pragma once
+#ifndef RDTANGENTGENERATOR_H
+#define RDTANGENTGENERATOR_H
+#include "Mesh.h"
+#include <span>
+namespace nyan {
+	//Per vertex tangent frames following the MikkTSpace conventions, Mikkelsen 2008 "Simulation of Wrinkled Surfaces Revisited"
+	//Tangents are the angle weighted average of the triangle tangents projected onto the vertex normal plane,
+	//w is the bitangent sign with bitangent = w * cross(normal, tangent) as in glTF
+	class TangentGenerator {
+	public:
+		struct Statistics {
+			//Triangles without uv area, they don't contribute to any tangent
+			size_t degenerateTriangles{ 0 };
+			//Vertices duplicated because triangles with mirrored uvs share them
+			size_t splitVertices{ 0 };
+		};
+		//Overwrites mesh.tangents, vertices shared across a mirrored uv seam are split and the indices rewritten
+		//Vertices with equal position, normal and uv are welded and end up with the same tangent
+		//Without uvs or normals the tangents are only an orthonormal basis and don't match any texture
+		static Statistics generate(nyan::Mesh& mesh);
+		//Generates tangents of all meshes in parallel on the job system
+		static std::vector<Statistics> generate(std::span<nyan::Mesh> meshes);
+		//Unit vector orthogonal to normal, used where no uv derived tangent exists
+		static Math::vec3 orthogonal(const Math::vec3& normal);
+	};
+}
+
+#endif !RDTANGENTGENERATOR_H
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef RDTEXTURECACHE_H
+#define RDTEXTURECACHE_H
+#include "Utility/TextureCooker.h"
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+namespace nyan {
+	//Content addressed directory of cooked .dds files, keyed by the source bytes and the cook settings
+	//Edited sources hash to a new key, their stale entries age out of the LRU like any unused texture
+	//Recency is the last write time of the entries so it survives restarts
+	class TextureCache {
+	public:
+		struct Statistics {
+			size_t hits{ 0 };
+			size_t misses{ 0 };
+			size_t evictions{ 0 };
+		};
+		//Keeps the cooked .dds from being evicted until it is destroyed, map the file before letting go of it
+		class Lease {
+		public:
+			Lease() = default;
+			Lease(TextureCache& cache, uint64_t key, std::filesystem::path path);
+			~Lease();
+			Lease(const Lease&) = delete;
+			Lease(Lease&& other) noexcept;
+			Lease& operator=(const Lease&) = delete;
+			Lease& operator=(Lease&& other) noexcept;
+			const std::filesystem::path& get_path() const noexcept;
+		private:
+			void release();
+
+			TextureCache* p_cache{ nullptr };
+			uint64_t m_key{ 0 };
+			std::filesystem::path m_path;
+		};
+		//Existing entries are picked up, the cache is trimmed to maxSize bytes right away
+		TextureCache(const std::filesystem::path& directory, uint64_t maxSize);
+		//Lease of the cooked .dds, cooks the source on a miss
+		//Throws std::runtime_error if the source can't be read or cooked
+		Lease acquire(const std::filesystem::path& source, const Utility::TextureCooker::Settings& settings);
+		//Evicts least recently used entries until the cache fits into maxSize bytes, leased entries are skipped
+		void trim();
+		uint64_t get_size() const;
+		Statistics get_statistics() const;
+		static uint64_t compute_key(std::span<const std::byte> source, const Utility::TextureCooker::Settings& settings);
+	private:
+		struct Entry {
+			uint64_t size;
+			std::filesystem::file_time_type lastUse;
+			//Outstanding leases, the entry isn't evicted while there are any
+			uint32_t users{ 0 };
+		};
+		std::filesystem::path get_entry_path(uint64_t key) const;
+		void trim_locked();
+
+		std::filesystem::path m_directory;
+		uint64_t m_maxSize;
+		uint64_t m_size{ 0 };
+		std::unordered_map<uint64_t, Entry> m_entries;
+		Statistics m_statistics;
+		mutable std::mutex m_mutex;
+	};
+}
+#endif !RDTEXTURECACHE_H
@@ -7,6 +7,8 @@
 #include "LogicalDevice.h"
 #include "Image.h"
 #include "Utility/DDSReader.h"
+#include "TextureCache.h"
+#include "AssetStreamer.h"
 #include <Util>
 namespace nyan {
 	class TextureManager {
@@ -14,6 +16,11 @@ namespace nyan {
 		struct Texture {
 			vulkan::ImageHandle handle;
 			Utility::TextureInfo info;
+			//Streamed texture whose slot still samples the placeholder
+			bool pending{ false };
+			//Reloaded from for mip changes, empty for textures created from memory
+			std::filesystem::path source;
+			Utility::TextureCooker::Settings settings;
 		};
 	public:
 		struct TextureInfo {
@@ -25,8 +32,9 @@ namespace nyan {
 			bool sRGB;
 		};
 		TextureManager(vulkan::LogicalDevice& device, bool streaming = false, const std::filesystem::path& folder = std::filesystem::current_path());
-		vulkan::Image* request_texture(const std::string& name);
-		vulkan::Image* request_texture(const std::filesystem::path& file);
+		//settings select the block format and color space, also for textures which aren't cooked
+		vulkan::Image* request_texture(const std::string& name, const Utility::TextureCooker::Settings& settings = {});
+		vulkan::Image* request_texture(const std::filesystem::path& file, const Utility::TextureCooker::Settings& settings = {});
 		vulkan::Image* request_texture(const TextureInfo& info, const std::vector<unsigned char>& data);
 		uint32_t get_texture_idx(const std::string& name, const std::string& defaultTex);
 		uint32_t get_texture_idx(const std::string& name);
@@ -34,10 +42,24 @@ namespace nyan {
 		void set_minimum_mip_level(uint32_t mipLevel) {
 			m_minimumMipLevel = mipLevel;
 		}
+		//Reserves the bindless slot of the file right away, it samples the placeholder until the streamer delivered the texture
+		//Reading, decoding and cooking run in the streamer, does nothing if the texture is already loaded or requested
+		void stream_texture(AssetStreamer& streamer, const std::filesystem::path& file, const std::string& placeholder,
+			const Utility::TextureCooker::Settings& settings = {}, const Math::vec3& position = Math::vec3{ 0.f }, float priorityBias = 0.f);
+		//Called by the upload sink of the streamer
+		void upload_streamed(const StreamedTexture& texture);
+		//Non DDS textures are cooked once and loaded from the cache directory on later requests and launches
+		//Call before streaming textures, the decode jobs use the cache
+		void enable_texture_cache(const std::filesystem::path& directory, uint64_t maxSize);
 	private:
 		vulkan::ImageHandle create_image(const TextureInfo& info, const std::vector<unsigned char>& data);
-		vulkan::ImageHandle create_image(const std::filesystem::path& file, uint32_t mipLevel = 0);
-		vulkan::ImageHandle create_dds_image(const std::filesystem::path& file, uint32_t mipLevel = 0);
+		vulkan::ImageHandle create_image(const std::filesystem::path& file, uint32_t mipLevel, const Utility::TextureCooker::Settings& settings);
+		//name is the key of the texture index, which differs from the file for cached textures, source is the file it was cooked from
+		vulkan::ImageHandle create_dds_image(const std::filesystem::path& file, const std::string& name, uint32_t mipLevel,
+			const std::filesystem::path& source, const Utility::TextureCooker::Settings& settings);
+		//Fills the slot reserved by stream_texture or takes a new one
+		void add_texture(const std::string& name, const vulkan::ImageHandle& image, const Utility::TextureInfo& info,
+			const std::filesystem::path& source = {}, const Utility::TextureCooker::Settings& settings = {});
 
 		vulkan::LogicalDevice& r_device;
 		std::filesystem::path m_directory;
@@ -46,6 +68,7 @@ namespace nyan {
 		bool m_streaming;
 		bool m_useSparse = false;
 		uint32_t m_minimumMipLevel = 0;
+		std::unique_ptr<TextureCache> m_textureCache;
 		//std::vector<vulkan::ImageHandle> m_usedTextures;
 	};
 }
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef RDTRANSIENTMEMORYPACKER_H
+#define RDTRANSIENTMEMORYPACKER_H
+#include "RenderGraphCompiler.h"
+#include <span>
+namespace nyan {
+	//Places transient resources into shared heaps, resources whose lifetimes don't overlap may share memory
+	//Device independent, the Rendergraph feeds it the memory requirements of its attachments
+	class TransientMemoryPacker {
+	public:
+		struct Resource {
+			//Positions in the execution order, unused resources aren't placed
+			RenderGraphPlan::Lifetime lifetime;
+			uint64_t size{ 0 };
+			uint64_t alignment{ 1 };
+			uint32_t memoryTypeBits{ ~0u };
+		};
+		struct Placement {
+			uint32_t heap{ RenderGraphPlan::invalidIndex };
+			uint64_t offset{ 0 };
+			uint64_t size{ 0 };
+			bool placed() const noexcept {
+				return heap != RenderGraphPlan::invalidIndex;
+			}
+		};
+		struct Heap {
+			uint64_t size{ 0 };
+			uint64_t alignment{ 1 };
+			uint32_t memoryTypeBits{ 0 };
+		};
+		struct Packing {
+			std::vector<Placement> placements;
+			std::vector<Heap> heaps;
+			//Resources sharing memory with the resource, their lifetimes are disjoint from its lifetime
+			//The first use of a resource has to wait for the accesses of its aliases
+			std::vector<std::vector<uint32_t>> aliases;
+			//Memory needed if every used resource had its own allocation
+			uint64_t unaliasedSize{ 0 };
+			uint64_t get_size() const noexcept {
+				uint64_t size{ 0 };
+				for (const auto& heap : heaps)
+					size += heap.size;
+				return size;
+			}
+		};
+		//Weighted interval graph coloring: resources are the intervals, byte ranges of a heap the colors
+		//Largest resources are placed first at the lowest offset not used by any resource with an overlapping lifetime
+		//Resources are only packed together with resources of identical memoryTypeBits
+		static Packing pack(std::span<const Resource> resources);
+	};
+}
+#endif !RDTRANSIENTMEMORYPACKER_H
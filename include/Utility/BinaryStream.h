@@ -0,0 +1,92 @@
+#pragma once
+#ifndef UTBINARYSTREAM_H
+#define UTBINARYSTREAM_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+namespace Utility {
+	//Flat native endian blobs for the on disk caches, values are copied as is, strings and vectors get a 32 bit count
+	class BinaryWriter {
+	public:
+		template<typename T> requires std::is_trivially_copyable_v<T>
+		void write(const T& value) {
+			write_bytes(std::as_bytes(std::span(&value, 1)));
+		}
+		void write(const std::string& string) {
+			write(static_cast<uint32_t>(string.size()));
+			write_bytes(std::as_bytes(std::span(string)));
+		}
+		template<typename T> requires std::is_trivially_copyable_v<T>
+		void write(const std::vector<T>& values) {
+			write(static_cast<uint32_t>(values.size()));
+			write_bytes(std::as_bytes(std::span(values)));
+		}
+		void write_bytes(std::span<const std::byte> bytes) {
+			m_data.insert(m_data.end(), bytes.begin(), bytes.end());
+		}
+		void reserve(size_t size) {
+			m_data.reserve(size);
+		}
+		const std::vector<std::byte>& get_data() const noexcept {
+			return m_data;
+		}
+		std::vector<std::byte> take_data() noexcept {
+			return std::move(m_data);
+		}
+	private:
+		std::vector<std::byte> m_data;
+	};
+
+	//Every read fails instead of reading past the end, counts are checked against the remaining bytes before anything is allocated
+	class BinaryReader {
+	public:
+		explicit BinaryReader(std::span<const std::byte> data) :
+			m_data(data)
+		{
+		}
+		template<typename T> requires std::is_trivially_copyable_v<T>
+		bool read(T& value) {
+			if (remaining() < sizeof(T))
+				return false;
+			std::memcpy(&value, m_data.data() + m_offset, sizeof(T));
+			m_offset += sizeof(T);
+			return true;
+		}
+		bool read(std::string& string) {
+			uint32_t size;
+			if (!read_count(size, 1))
+				return false;
+			string.assign(reinterpret_cast<const char*>(m_data.data() + m_offset), size);
+			m_offset += size;
+			return true;
+		}
+		template<typename T> requires std::is_trivially_copyable_v<T>
+		bool read(std::vector<T>& values) {
+			uint32_t count;
+			if (!read_count(count, sizeof(T)))
+				return false;
+			values.resize(count);
+			std::memcpy(values.data(), m_data.data() + m_offset, count * sizeof(T));
+			m_offset += count * sizeof(T);
+			return true;
+		}
+		//For elements read one by one, minElementSize is the smallest number of bytes a single element takes
+		bool read_count(uint32_t& count, size_t minElementSize) {
+			return read(count) && count <= remaining() / minElementSize;
+		}
+		size_t remaining() const noexcept {
+			return m_data.size() - m_offset;
+		}
+		bool done() const noexcept {
+			return m_offset == m_data.size();
+		}
+	private:
+		std::span<const std::byte> m_data;
+		size_t m_offset{ 0 };
+	};
+}
+#endif !UTBINARYSTREAM_H
@@ -0,0 +1,49 @@
+#pragma once
+#ifndef UTBLOCKCOMPRESSOR_H
+#define UTBLOCKCOMPRESSOR_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "DDSFormat.h"
+namespace Utility {
+	enum class BlockFormat : uint8_t {
+		BC1,	//RGB, 8 bytes per block
+		BC3,	//RGBA, BC1 color and BC4 alpha
+		BC4,	//R, 8 bytes per block
+		BC5,	//RG, two BC4 blocks
+		BC6H,	//Unsigned half float RGB, single region mode only
+		BC7,	//RGBA, mode 6 only, single subset with 7.7.7.7 endpoints and 4 bit indices
+	};
+	//CPU encoder and reference decoder for the BCn formats
+	//Endpoints are fit along the principal axis of each block and refined with least squares,
+	//texels are projected onto the endpoint line four at a time with SSE
+	//Images are compressed in parallel over rows of 4x4 blocks, texels outside the image repeat the border
+	class BlockCompressor {
+	public:
+		static constexpr uint32_t blockDimension{ 4 };
+		//RGBA8 texels of one block, row major
+		using Block = std::array<uint8_t, 64>;
+		//RGBA32F texels of one block, row major
+		using HdrBlock = std::array<float, 64>;
+
+		static size_t block_size(BlockFormat format);
+		static size_t compressed_size(BlockFormat format, uint32_t width, uint32_t height);
+		static DXGI_FORMAT get_dxgi_format(BlockFormat format, bool sRGB);
+
+		//rgba holds width * height RGBA8 texels, BC4 reads red, BC5 red and green, BC6H is not supported
+		static std::vector<std::byte> compress(BlockFormat format, std::span<const uint8_t> rgba, uint32_t width, uint32_t height);
+		//BC6H, rgba holds width * height RGBA32F texels, alpha is ignored and negative values are clamped to 0
+		static std::vector<std::byte> compress_hdr(std::span<const float> rgba, uint32_t width, uint32_t height);
+		//Channels not stored in the format decode to 0, alpha to 255
+		static std::vector<uint8_t> decompress(BlockFormat format, std::span<const std::byte> data, uint32_t width, uint32_t height);
+		static std::vector<float> decompress_hdr(std::span<const std::byte> data, uint32_t width, uint32_t height);
+
+		static void compress_block(BlockFormat format, const Block& block, std::byte* output);
+		static void compress_block_hdr(const HdrBlock& block, std::byte* output);
+		static void decompress_block(BlockFormat format, const std::byte* input, Block& block);
+		static void decompress_block_hdr(const std::byte* input, HdrBlock& block);
+	};
+}
+#endif !UTBLOCKCOMPRESSOR_H
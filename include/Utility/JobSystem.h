@@ -0,0 +1,116 @@
+#ifndef UTJOBSYSTEM_H
+#define UTJOBSYSTEM_H
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Utility {
+	//Simple FIFO thread pool, the calling thread of parallel_for participates in the work
+	//so nested parallel_for calls from inside a job cannot deadlock
+	class JobSystem {
+	public:
+		explicit JobSystem(uint32_t threadCount = default_thread_count());
+		~JobSystem();
+		JobSystem(const JobSystem&) = delete;
+		JobSystem(JobSystem&&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+		JobSystem& operator=(JobSystem&&) = delete;
+
+		template<typename Functor>
+		[[nodiscard]] auto submit(Functor&& functor) -> std::future<std::invoke_result_t<Functor>> {
+			using Result = std::invoke_result_t<Functor>;
+			auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Functor>(functor));
+			auto future = task->get_future();
+			//Without workers nothing would ever pick the job up, run it like parallel_for does
+			if (m_threads.empty())
+				(*task)();
+			else
+				enqueue([task]() { (*task)(); });
+			return future;
+		}
+		//Calls functor(i) for every i in [0, count), blocks until all calls returned
+		//The first exception thrown by any invocation is rethrown on the calling thread
+		template<typename Functor>
+		void parallel_for(size_t count, Functor&& functor, size_t batchSize = 1) {
+			if (!count)
+				return;
+			if (batchSize == 0)
+				batchSize = 1;
+			const size_t batchCount = (count + batchSize - 1) / batchSize;
+			if (batchCount == 1 || m_threads.empty()) {
+				for (size_t i{ 0 }; i < count; ++i)
+					functor(i);
+				return;
+			}
+			auto state = std::make_shared<ForState>();
+			auto work = [state, count, batchSize, batchCount, &functor]() {
+				for (size_t batch = state->next.fetch_add(1); batch < batchCount; batch = state->next.fetch_add(1)) {
+					if (!state->failed.load(std::memory_order_relaxed)) {
+						try {
+							const size_t end = std::min(count, (batch + 1) * batchSize);
+							for (size_t i{ batch * batchSize }; i < end; ++i)
+								functor(i);
+						}
+						catch (...) {
+							std::scoped_lock lock{ state->mutex };
+							if (!state->failed.exchange(true))
+								state->exception = std::current_exception();
+						}
+					}
+					if (state->finished.fetch_add(1) + 1 == batchCount) {
+						std::scoped_lock lock{ state->mutex };
+						state->condition.notify_all();
+					}
+				}
+			};
+			const size_t helpers = std::min(batchCount - 1, m_threads.size());
+			for (size_t i{ 0 }; i < helpers; ++i)
+				enqueue(work);
+			work();
+			{
+				std::unique_lock lock{ state->mutex };
+				state->condition.wait(lock, [&]() { return state->finished.load() == batchCount; });
+			}
+			if (state->exception)
+				std::rethrow_exception(state->exception);
+		}
+		uint32_t get_thread_count() const noexcept {
+			return static_cast<uint32_t>(m_threads.size());
+		}
+		//0 for threads which aren't workers of this pool, e.g. the thread calling parallel_for, worker i gets i + 1
+		//Lets callers keep per-thread resources without locking, such as command pools
+		uint32_t get_thread_index() const noexcept;
+		static uint32_t default_thread_count() noexcept;
+		//Process wide pool used by import and cooking code which doesn't get one passed in
+		static JobSystem& get();
+	private:
+		struct ForState {
+			std::atomic<size_t> next{ 0 };
+			std::atomic<size_t> finished{ 0 };
+			std::atomic<bool> failed{ false };
+			std::exception_ptr exception{};
+			std::mutex mutex;
+			std::condition_variable condition;
+		};
+		void enqueue(std::function<void()> job);
+		void worker_loop(uint32_t index);
+
+		std::vector<std::thread> m_threads;
+		std::deque<std::function<void()>> m_jobs;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_shutdown{ false };
+	};
+}
+
+#endif !UTJOBSYSTEM_H
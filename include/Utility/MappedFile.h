@@ -0,0 +1,38 @@
+#pragma once
+#ifndef UTMAPPEDFILE_H
+#define UTMAPPEDFILE_H
+#include <cstddef>
+#include <filesystem>
+#include <span>
+namespace Utility {
+	//Read only memory mapping of a whole file, pages are faulted in on first access
+	//The file handle is closed right after mapping, the mapping stays valid until destruction
+	//Empty files are not mapped, data() is nullptr and size() 0
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		//Throws std::runtime_error if the file can't be opened or mapped
+		explicit MappedFile(const std::filesystem::path& path);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		~MappedFile();
+		const std::byte* data() const {
+			return m_data;
+		}
+		size_t size() const {
+			return m_size;
+		}
+		std::span<const std::byte> span() const {
+			return { m_data, m_size };
+		}
+		//Hints the OS to read the range ahead, e.g. only the mips that are actually uploaded
+		void prefetch(size_t offset, size_t size) const;
+	private:
+		void unmap();
+		const std::byte* m_data{ nullptr };
+		size_t m_size{ 0 };
+	};
+}
+#endif !UTMAPPEDFILE_H
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef UTMIPGENERATOR_H
+#define UTMIPGENERATOR_H
+#include <cstdint>
+#include <span>
+#include <vector>
+namespace Utility {
+	enum class MipFilter : uint8_t {
+		Box,		//Area average, cheapest and softest
+		Kaiser,		//Kaiser windowed sinc, sharp with little ringing
+		Lanczos,	//Lanczos3, sharpest, rings at hard edges
+	};
+	//CPU mip chain generation for cooking and streaming, levels halve with rounding down like Vulkan mips
+	//Filtering happens on linear RGBA32F in two separable passes, one SSE register per texel,
+	//rows of every pass run in parallel, levels are filtered from their predecessor and thus in order
+	class MipGenerator {
+	public:
+		struct Settings {
+			MipFilter filter{ MipFilter::Kaiser };
+			//Color channels are sRGB encoded and filtered in linear space, alpha is always linear
+			bool sRGB{ true };
+			//Filter across the borders like a tiling texture instead of clamping
+			bool wrap{ false };
+			//Scales the alpha of every level so the fraction of texels passing the alpha test matches level 0
+			bool preserveAlphaCoverage{ false };
+			float alphaCutoff{ 0.5f };
+		};
+		template<typename Texel>
+		struct Level {
+			uint32_t width;
+			uint32_t height;
+			//RGBA, width * height * 4 values
+			std::vector<Texel> texels;
+		};
+		static uint32_t level_count(uint32_t width, uint32_t height);
+		//Complete chain down to 1x1, level 0 is a copy of the input
+		static std::vector<Level<uint8_t>> generate(std::span<const uint8_t> rgba, uint32_t width, uint32_t height, const Settings& settings);
+		//Linear RGBA32F input, sRGB and alpha coverage are ignored
+		static std::vector<Level<float>> generate_hdr(std::span<const float> rgba, uint32_t width, uint32_t height, const Settings& settings);
+		//Fraction of texels with an alpha above the cutoff after scaling alpha by scale
+		static float alpha_coverage(std::span<const uint8_t> rgba, float cutoff, float scale = 1.f);
+	};
+}
+#endif !UTMIPGENERATOR_H
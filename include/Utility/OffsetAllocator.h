@@ -0,0 +1,82 @@
+#pragma once
+#ifndef UTOFFSETALLOCATOR_H
+#define UTOFFSETALLOCATOR_H
+#include <array>
+#include <cstdint>
+#include <vector>
+namespace Utility {
+	//Two level segregated fit allocator for ranges of an externally owned resource, e.g. GPU buffers
+	//Masset et al. 2004 "TLSF: a New Dynamic Memory Allocator for Real-Time Systems"
+	//Sizes are binned by a small float with 3 mantissa bits, 32 top level bins of 8 second level bins each
+	//Allocation and free are O(1), free regions are merged with their neighbors immediately
+	class OffsetAllocator {
+	public:
+		static constexpr uint32_t invalidOffset{ ~0u };
+		static constexpr uint32_t binCount{ 256 };
+		struct Allocation {
+			uint32_t offset{ invalidOffset };
+			uint32_t node{ invalidOffset };
+			bool valid() const {
+				return offset != invalidOffset;
+			}
+		};
+		struct Move {
+			//Allocation with the updated offset
+			Allocation allocation;
+			uint32_t sourceOffset;
+			uint32_t size;
+		};
+		struct Statistics {
+			uint32_t freeSize{ 0 };
+			uint32_t largestFreeRegion{ 0 };
+			uint32_t freeRegions{ 0 };
+			uint32_t allocations{ 0 };
+		};
+		explicit OffsetAllocator(uint32_t size);
+		//Returns an invalid allocation if no free region is large enough
+		Allocation allocate(uint32_t size);
+		void free(Allocation allocation);
+		uint32_t get_allocation_size(Allocation allocation) const;
+		uint32_t get_size() const {
+			return m_size;
+		}
+		Statistics get_statistics() const;
+		//Packs all allocations towards offset 0, leaving a single free region at the end
+		//Allocations stay valid with new offsets, the moves are ordered by offset and never move data upwards,
+		//source and destination of a move may overlap
+		std::vector<Move> defragment();
+		void reset();
+
+		//Small float size classes, round up for allocations and down for free regions
+		static uint32_t size_to_bin_round_up(uint32_t size);
+		static uint32_t size_to_bin_round_down(uint32_t size);
+		static uint32_t bin_to_size(uint32_t bin);
+	private:
+		struct Node {
+			uint32_t offset{ 0 };
+			uint32_t size{ 0 };
+			//Free list of the bin
+			uint32_t binPrev{ invalidOffset };
+			uint32_t binNext{ invalidOffset };
+			//Address order
+			uint32_t neighborPrev{ invalidOffset };
+			uint32_t neighborNext{ invalidOffset };
+			bool used{ false };
+		};
+		uint32_t create_node(uint32_t offset, uint32_t size);
+		void release_node(uint32_t node);
+		void insert_free(uint32_t node);
+		void remove_free(uint32_t node);
+
+		uint32_t m_size;
+		uint32_t m_freeSize{ 0 };
+		uint32_t m_freeRegions{ 0 };
+		uint32_t m_allocations{ 0 };
+		uint32_t m_topMask{ 0 };
+		std::array<uint8_t, binCount / 8> m_leafMasks{};
+		std::array<uint32_t, binCount> m_binHeads;
+		std::vector<Node> m_nodes;
+		std::vector<uint32_t> m_unusedNodes;
+	};
+}
+#endif !UTOFFSETALLOCATOR_H
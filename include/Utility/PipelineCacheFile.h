@@ -0,0 +1,58 @@
+#pragma once
+#ifndef UTPIPELINECACHEFILE_H
+#define UTPIPELINECACHEFILE_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+namespace Utility {
+	//On disk format of pipeline cache data, a header identifying device and driver followed by the data returned by vkGetPipelineCacheData
+	//Drivers are not required to reject foreign or truncated data, everything is validated before it's handed to vkCreatePipelineCache
+	class PipelineCacheFile {
+	public:
+		static constexpr uint32_t magic = 0x4350594eu; //"NYPC"
+		static constexpr uint32_t version = 2;
+		//Matches VkPhysicalDeviceProperties, the data of another device or driver is discarded
+		struct Identity {
+			uint32_t vendorID{ 0 };
+			uint32_t deviceID{ 0 };
+			uint32_t driverVersion{ 0 };
+			std::array<uint8_t, 16> pipelineCacheUUID{};
+			friend bool operator==(const Identity&, const Identity&) = default;
+		};
+		struct Header {
+			uint32_t magic;
+			uint32_t version;
+			Identity identity;
+			uint32_t reserved;
+			uint64_t dataSize;
+			//StreamHasher of the data
+			uint64_t checksum;
+		};
+		enum class Status : uint8_t {
+			Loaded,
+			Missing,
+			//Not a pipeline cache file, from another version or truncated
+			Invalid,
+			//Written for another device or driver
+			Mismatch,
+			Corrupt,
+		};
+		struct Contents {
+			Status status{ Status::Missing };
+			//Only filled if the status is Loaded
+			std::vector<std::byte> data;
+		};
+		//Never throws for unusable files, a cold cache is always a valid fallback
+		static Contents read(const std::filesystem::path& path, const Identity& identity);
+		//Written to a temporary file first, an interrupted write leaves the previous file intact
+		//Throws std::runtime_error if the file can't be written
+		static void write(const std::filesystem::path& path, const Identity& identity, std::span<const std::byte> data);
+		//Checks the header Vulkan puts in front of its data, VkPipelineCacheHeaderVersionOne
+		static bool is_valid_vulkan_data(std::span<const std::byte> data, const Identity& identity);
+		static uint64_t checksum(std::span<const std::byte> data);
+	};
+}
+#endif !UTPIPELINECACHEFILE_H
@@ -0,0 +1,81 @@
+#pragma once
+#ifndef UTSHADERREFLECTIONCACHE_H
+#define UTSHADERREFLECTIONCACHE_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+namespace Utility {
+	//Everything the renderer needs to know about a SPIR-V module, without depending on the Vulkan headers
+	struct ShaderReflection {
+		struct Binding {
+			uint32_t set{ 0 };
+			uint32_t binding{ 0 };
+			//VkDescriptorType
+			uint32_t descriptorType{ 0 };
+			//0 for runtime sized arrays
+			uint32_t count{ 1 };
+			friend bool operator==(const Binding&, const Binding&) = default;
+		};
+		struct SpecializationConstant {
+			std::string name;
+			uint32_t id{ 0 };
+			//vulkan::Shader::SpecializationConstantId::Type
+			uint32_t type{ 0 };
+			friend bool operator==(const SpecializationConstant&, const SpecializationConstant&) = default;
+		};
+		//Bit position of the stage, vulkan::ShaderStage
+		uint32_t stage{ 0 };
+		uint32_t pushConstantSize{ 0 };
+		//Literal local size of compute shaders, specialized sizes are listed as constants
+		std::array<uint32_t, 3> workgroupSize{};
+		std::vector<Binding> bindings;
+		std::vector<SpecializationConstant> specializationConstants;
+		friend bool operator==(const ShaderReflection&, const ShaderReflection&) = default;
+	};
+	//Reflection results keyed by a hash of the SPIR-V, persisted so unchanged shaders skip reflection at startup
+	//Lookups and inserts are thread safe, shaders can be reflected in parallel
+	class ShaderReflectionCache {
+	public:
+		static constexpr uint32_t magic = 0x5253594eu; //"NYSR"
+		//Bump whenever the reflection changes, old files are then discarded as a whole
+		static constexpr uint32_t version = 2;
+		struct Statistics {
+			size_t hits{ 0 };
+			size_t misses{ 0 };
+		};
+		using Reflector = std::function<ShaderReflection(std::span<const uint32_t> code)>;
+		//Entries of a valid file are loaded, missing or unusable files start empty
+		explicit ShaderReflectionCache(const std::filesystem::path& path);
+		//Reflection of the code, calls reflect on a miss only
+		//reflect runs outside of the lock, exceptions are passed on and nothing is cached
+		ShaderReflection get(std::span<const uint32_t> code, uint64_t key, const Reflector& reflect);
+		ShaderReflection get(std::span<const uint32_t> code, const Reflector& reflect);
+		std::optional<ShaderReflection> find(uint64_t key) const;
+		void insert(uint64_t key, ShaderReflection reflection);
+		//Writes the file if entries were added since it was read, throws std::runtime_error if it can't be written
+		void save();
+		Statistics get_statistics() const;
+		size_t size() const;
+		const std::filesystem::path& get_path() const noexcept;
+		//StreamHasher of the code, also the hash of vulkan::Shader
+		static uint64_t compute_key(std::span<const uint32_t> code);
+		static std::vector<std::byte> serialize(const std::unordered_map<uint64_t, ShaderReflection>& entries);
+		//Empty if the data isn't a complete cache file of this version
+		static std::optional<std::unordered_map<uint64_t, ShaderReflection>> deserialize(std::span<const std::byte> data);
+	private:
+		std::filesystem::path m_path;
+		std::unordered_map<uint64_t, ShaderReflection> m_entries;
+		Statistics m_statistics;
+		bool m_dirty{ false };
+		mutable std::mutex m_mutex;
+	};
+}
+#endif !UTSHADERREFLECTIONCACHE_H
@@ -0,0 +1,32 @@
+#pragma once
+#ifndef UTSTREAMHASHER_H
+#define UTSTREAMHASHER_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace Utility {
+	//Streaming 64 bit hash over arbitrarily split byte ranges, four independent lanes of 8 byte words
+	//The result only depends on the concatenated bytes, not on how they were split across update calls
+	//Used for content keys of large blobs, Hasher is the cheaper choice for small structs
+	class StreamHasher {
+	public:
+		StreamHasher(uint64_t seed = 0);
+		void update(const void* data, size_t size);
+		template<typename T>
+		void update(const std::vector<T>& stream) {
+			const uint64_t size = stream.size() * sizeof(T);
+			update(&size, sizeof(size));
+			update(stream.data(), size);
+		}
+		uint64_t finish() const;
+	private:
+		void consume(const std::byte* stripe);
+		std::array<uint64_t, 4> m_lanes;
+		std::array<std::byte, 32> m_pending{};
+		size_t m_pendingSize{ 0 };
+		uint64_t m_totalSize{ 0 };
+		uint64_t m_seed;
+	};
+}
+#endif !UTSTREAMHASHER_H
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef UTTEXTURECOOKER_H
+#define UTTEXTURECOOKER_H
+#include <filesystem>
+#include <span>
+#include <vector>
+#include "BlockCompressor.h"
+#include "MipGenerator.h"
+namespace Utility {
+	enum class TextureUsage : uint8_t {
+		Color,		//BC1, BC7 in high quality
+		ColorAlpha,	//BC3, BC7 in high quality
+		Mask,		//BC4 of the red channel
+		Normal,		//BC5 of the red and green channels, z has to be reconstructed
+		HDR,		//BC6H
+	};
+	//Offline conversion of PNG/JPG/TGA/HDR images into block compressed .dds files the DDSReader can load
+	class TextureCooker {
+	public:
+		struct Settings {
+			TextureUsage usage{ TextureUsage::Color };
+			//Only selects the DXGI format of color textures, the texels are compressed as stored
+			bool sRGB{ true };
+			bool highQuality{ false };
+			//Full chain down to 1x1, color usages are filtered in linear space if sRGB is set
+			bool generateMips{ true };
+			MipFilter mipFilter{ MipFilter::Kaiser };
+			//For alpha tested foliage, keeps the alpha of smaller mips from eroding
+			bool preserveAlphaCoverage{ false };
+			float alphaCutoff{ 0.5f };
+		};
+		static BlockFormat select_format(const Settings& settings);
+		static MipGenerator::Settings get_mip_settings(const Settings& settings);
+		//Throws std::runtime_error if the source can't be loaded or the destination can't be written
+		static void cook(const std::filesystem::path& source, const std::filesystem::path& destination, const Settings& settings);
+		//2D texture with a DX10 header, mips[i] holds the compressed level i
+		static void write_dds(const std::filesystem::path& destination, BlockFormat format, bool sRGB, uint32_t width, uint32_t height, std::span<const std::vector<std::byte>> mips);
+	};
+}
+#endif !UTTEXTURECOOKER_H
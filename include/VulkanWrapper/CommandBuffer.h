@@ -9,7 +9,7 @@
 namespace vulkan {
 	class CommandBuffer : public VulkanObject<VkCommandBuffer> {
 	public:
-		CommandBuffer(LogicalDevice& parent, VkCommandBuffer handle, CommandBufferType type = CommandBufferType::Generic, uint32_t threadIdx = 0);
+		CommandBuffer(LogicalDevice& parent, VkCommandBuffer handle, CommandBufferType type = CommandBufferType::Generic, uint32_t threadIdx = 0, bool secondary = false);
 
 
 		//void begin_rendering()
@@ -68,12 +68,15 @@ namespace vulkan {
 			VkPipelineStageFlags dstStages,VkAccessFlags dstAccessFlags);
 		void clear_color_image(const Image& image, VkImageLayout layout, const VkClearColorValue* clearColor);
 		void clear_depth_image(const Image& image, VkImageLayout layout, const VkClearDepthStencilValue* clearColor);
+		//Inside of dynamic rendering the rendering has to be begun with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT
+		void execute_commands(std::span<const VkCommandBuffer> commandBuffers);
 		bool swapchain_touched() const noexcept;
 		void touch_swapchain() noexcept;
 		void end();
 		void begin_region(const char* name, const float* color = nullptr);
 		void end_region();
 		CommandBufferType get_type() const noexcept;
+		bool is_secondary() const noexcept;
 	private:
 		/// *******************************************************************
 		/// Private functions
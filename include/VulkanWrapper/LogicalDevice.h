@@ -96,6 +96,7 @@ namespace vulkan {
 			FrameResource(LogicalDevice& device);
 			~FrameResource();
 			void recycle_semaphore(VkSemaphore sempahore);
+			void recycle_event(VkEvent event);
 			std::vector<CommandBufferHandle>& get_submissions(CommandBufferType type) noexcept;
 			vulkan::CommandPool& get_pool(CommandBufferType type) noexcept;
 			vulkan::TimestampQueryPool& get_timestamps() noexcept;
@@ -148,6 +149,7 @@ namespace vulkan {
 			std::vector<VkFramebuffer> deletedFramebuffer;
 			std::vector<VkSemaphore> deletedSemaphores;
 			std::vector<VkSemaphore> recycledSemaphores;
+			std::vector<VkEvent> recycledEvents;
 
 			std::vector<VkSemaphore> signalSemaphores;
 			std::vector<FenceHandle> waitForFences;
@@ -176,13 +178,26 @@ namespace vulkan {
 		ImageViewHandle create_image_view(const ImageViewCreateInfo& info);
 		ImageHandle create_image(const ImageInfo& info, InitialImageData* initialData = nullptr, vulkan::FenceHandle* fence = nullptr);
 		ImageHandle create_sparse_image(const ImageInfo& info, InitialImageData* initialData = nullptr, vulkan::FenceHandle* fence = nullptr);
+		//Memory requirements of an image without creating it
+		VkMemoryRequirements get_image_memory_requirements(const ImageInfo& info) const;
+		AllocationHandle allocate_memory(const VkMemoryRequirements& requirements);
+		//Places the image at offset into memory which may be shared with other images, the initial layout is undefined
+		//The caller has to synchronize accesses of images aliasing the same memory
+		ImageHandle create_aliased_image(const ImageInfo& info, const AllocationHandle& memory, VkDeviceSize offset);
 		void downsize_sparse_image(Image& handle, uint32_t targetMipLevel);
 		bool upsize_sparse_image(Image& handle, InitialImageData* initialData, uint32_t targetMipLevel);
 
 		FenceHandle request_empty_fence();
 		void destroy_semaphore(VkSemaphore semaphore);
 		VkSemaphore request_semaphore();
+		//Only valid for the current frame, recycled once the frame is reused
+		VkEvent request_event();
+		//Not recycled, the owner destroys it with destroy_semaphore once the device is idle
+		VkSemaphore create_timeline_semaphore(uint64_t initialValue = 0);
 		CommandBufferHandle request_command_buffer(CommandBufferType type);
+		//Allocated from the pool of the calling thread and already begun, safe to call from worker threads of Utility::JobSystem::get()
+		//Continues the dynamic rendering of a primary command buffer if rendering is set, valid until the frame is reused
+		CommandBuffer request_secondary_command_buffer(CommandBufferType type, const RenderingCreateInfo* rendering = nullptr);
 		Image* request_render_target(uint32_t width, uint32_t height, VkFormat format, uint32_t index = 0, VkImageUsageFlags usage = 0, VkImageLayout initialLayout = VK_IMAGE_LAYOUT_GENERAL, VkSampleCountFlagBits sampleCount = VK_SAMPLE_COUNT_1_BIT, uint32_t arrayLayers = 1);
 		void resize_buffer(Buffer& buffer, VkDeviceSize newSize, bool copyData = false);
 
@@ -255,6 +270,9 @@ namespace vulkan {
 		uint32_t get_compute_family() const noexcept;
 		uint32_t get_graphics_family() const noexcept;
 		VkPipelineCache get_pipeline_cache() const noexcept;
+		//Cache of the calling job system thread, pipelines compiled on different threads don't contend for one cache
+		VkPipelineCache get_thread_pipeline_cache() const noexcept;
+		bool is_pipeline_cache_warm() const noexcept;
 		Sampler* get_default_sampler(DefaultSampler samplerType) const noexcept;
 
 		void wait_on_idle_queue(CommandBufferType type);
@@ -301,6 +319,7 @@ namespace vulkan {
 
 		FenceManager m_fenceManager;
 		SemaphoreManager m_semaphoreManager;
+		EventManager m_eventManager;
 
 		std::vector<std::unique_ptr<FrameResource>> m_frameResources;
 
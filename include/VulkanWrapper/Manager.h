@@ -92,5 +92,21 @@ namespace vulkan {
 		LogicalDevice& r_device;
 		std::unordered_set<VkSemaphore> m_semaphores;
 	};
+	class EventManager {
+	public:
+		EventManager(LogicalDevice& device) : r_device(device) {
+
+		}
+		~EventManager()noexcept;
+		EventManager(EventManager&) = delete;
+		EventManager(EventManager&& other) = delete;
+		VkEvent request_event();
+		//Only recycle events the device is done with, they are reset on the host
+		void recycle_event(VkEvent event);
+		void clear();
+	private:
+		LogicalDevice& r_device;
+		std::vector<VkEvent> m_events;
+	};
 }
 #endif //VKMANAGER_H!
\ No newline at end of file
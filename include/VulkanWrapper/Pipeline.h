@@ -5,6 +5,7 @@
 #include <Util>
 #include "VulkanForwards.h"
 #include "PipelineConfig.h"
+#include <future>
 
 namespace vulkan {
 
@@ -104,6 +105,8 @@ namespace vulkan {
 	private:
 	};
 
+	//The file is validated against the device before its data is used, see Utility::PipelineCacheFile
+	//Every job system thread compiles into its own cache, they are merged into the main cache when saving
 	class PipelineCache: public VulkanObject<VkPipelineCache>   {
 	public:
 		PipelineCache(LogicalDevice& device, const std::string& path);
@@ -112,14 +115,30 @@ namespace vulkan {
 		PipelineCache& operator=(PipelineCache&) = delete;
 		PipelineCache& operator=(PipelineCache&&) = delete;
 		~PipelineCache() noexcept;
+		//Index 0 is the main cache, shared with threads outside of the job system
+		VkPipelineCache get_thread_cache(uint32_t threadIndex) const noexcept;
+		//True if the cache was initialized with valid data from disk
+		bool is_warm() const noexcept;
+		//Merges the thread caches and writes the main cache, no compiles may be in flight
+		//Throws std::runtime_error if the file can't be written
+		void save();
 	private:
+		std::vector<std::byte> get_data() const;
+
 		std::string m_path;
+		bool m_warm{ false };
+		std::vector<VkPipelineCache> m_threadCaches;
 	};
 	class Pipeline2 : public VulkanObject<VkPipeline> {
 	public:
 		Pipeline2(LogicalDevice& parent, const GraphicsPipelineConfig& config);
 		Pipeline2(LogicalDevice& parent, const ComputePipelineConfig& config);
 		Pipeline2(LogicalDevice& parent, const RaytracingPipelineConfig& config);
+		//Reserves the pipeline without a handle, filled in by compile
+		Pipeline2(LogicalDevice& parent, VkPipelineLayout layout, VkPipelineBindPoint type, const DynamicGraphicsPipelineState& dynamicState = {});
+		void compile(const GraphicsPipelineConfig& config, VkPipelineCache cache);
+		void compile(const ComputePipelineConfig& config, VkPipelineCache cache);
+		void compile(const RaytracingPipelineConfig& config, VkPipelineCache cache);
 		VkPipelineLayout get_layout() const noexcept;
 		const DynamicGraphicsPipelineState& get_dynamic_state() const noexcept;
 	private:
@@ -128,6 +147,23 @@ namespace vulkan {
 		DynamicGraphicsPipelineState m_initialDynamicState {};
 	};
 
+	//Id of a pipeline which may still be compiling, the id itself is valid immediately
+	class PipelineFuture {
+	public:
+		PipelineFuture() = default;
+		PipelineFuture(PipelineId id, std::shared_future<void> future);
+		PipelineId get_id() const noexcept;
+		bool valid() const noexcept;
+		bool ready() const;
+		//Blocks until the pipeline is compiled, rethrows compile errors
+		PipelineId get() const;
+		//Doesn't block, returns the placeholder until the pipeline is compiled
+		PipelineId get_or(PipelineId placeholder) const;
+	private:
+		PipelineId m_id{ invalidPipelineId };
+		std::shared_future<void> m_future;
+	};
+
 	class PipelineStorage2 {
 	public:
 		PipelineStorage2(LogicalDevice& device);
@@ -137,9 +173,21 @@ namespace vulkan {
 		PipelineId add_pipeline(const ComputePipelineConfig& config);
 		PipelineId add_pipeline(const GraphicsPipelineConfig& config);
 		PipelineId add_pipeline(const RaytracingPipelineConfig& config);
+		//Compiles on the job system into the cache of the worker thread, like add_pipeline only called from one thread
+		//Configs which were already requested return the future of the first request instead of compiling again
+		//Workers only look up shader instances, which ShaderStorage guards, the shaders themselves must outlive the compile
+		PipelineFuture compile_pipeline(const GraphicsPipelineConfig& config);
+		PipelineFuture compile_pipeline(const RaytracingPipelineConfig& config);
+		void wait_for_compiles();
+		static Utility::HashValue hash(const GraphicsPipelineConfig& config);
+		static Utility::HashValue hash(const RaytracingPipelineConfig& config);
 	private:
+		template<typename Config>
+		PipelineFuture compile_pipeline(const Config& config, Utility::HashValue hash, VkPipelineBindPoint type, const DynamicGraphicsPipelineState& dynamicState);
+
 		LogicalDevice& r_device;
 		Utility::LinkedBucketList<Pipeline2> m_pipelines;
+		std::unordered_map<Utility::HashValue, PipelineFuture> m_compiles;
 	};
 
 	class PipelineBind {
@@ -193,7 +241,12 @@ namespace vulkan {
 		//
 		//void set_something_dynamic();
 	private:
-
+		//Meshes sub-allocated from one geometry arena share their bindings, redundant binds are skipped
+		VkBuffer m_indexBuffer{ VK_NULL_HANDLE };
+		VkDeviceSize m_indexOffset{ 0 };
+		VkIndexType m_indexType{ VK_INDEX_TYPE_MAX_ENUM };
+		std::array<VkBuffer, MAX_VERTEX_BINDINGS> m_vertexBuffers{};
+		std::array<VkDeviceSize, MAX_VERTEX_BINDINGS> m_vertexOffsets{};
 	};
 	class ComputePipelineBind : public PipelineBind {
 	public:
@@ -4,25 +4,29 @@
 
 #include "VkWrapper.h"
 #include "Pipeline.h"
+#include <optional>
 
 
 namespace vulkan {
+	//Compiles in the background, the shader binding table needs the group handles of the finished pipeline
 	class RTPipeline {
 	public:
 		RTPipeline(vulkan::LogicalDevice& device, const vulkan::RaytracingPipelineConfig& config);
 		operator vulkan::PipelineId() const;
+		//Creates the shader binding table once the compile finished, false while it is still compiling, never blocks
+		bool update();
+		bool ready() const noexcept;
 		const VkStridedDeviceAddressRegionKHR* rgen_region() const;
 		const VkStridedDeviceAddressRegionKHR* miss_region() const;
 		const VkStridedDeviceAddressRegionKHR* hit_region() const;
 		const VkStridedDeviceAddressRegionKHR* callable_region() const;
 	private:
-		vulkan::PipelineId create_pipeline(const vulkan::RaytracingPipelineConfig& rayConfig);
 		vulkan::BufferHandle create_sbt(const vulkan::RaytracingPipelineConfig& rayConfig);
 
 		vulkan::LogicalDevice& r_device;
 		vulkan::RaytracingPipelineConfig m_config;
-		vulkan::PipelineId m_rtPipeline;
-		vulkan::BufferHandle m_sbt;
+		vulkan::PipelineFuture m_rtPipeline;
+		std::optional<vulkan::BufferHandle> m_sbt;
 		VkStridedDeviceAddressRegionKHR m_rgenRegion;
 		VkStridedDeviceAddressRegionKHR m_missRegion;
 		VkStridedDeviceAddressRegionKHR m_hitRegion;
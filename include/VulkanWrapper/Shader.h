@@ -4,8 +4,10 @@
 #include "VulkanIncludes.h"
 #include "VulkanForwards.h"
 #include <Util>
+#include "Utility/ShaderReflectionCache.h"
 #include "LinAlg.h"
 #include "MaxVals.h"
+#include <span>
 #include <typeinfo>
 
 namespace vulkan {
@@ -161,9 +163,14 @@ namespace vulkan {
 		};
 	public:
 		Shader(LogicalDevice& parent, const std::vector<uint32_t>& shaderCode);
+		//Skips reflection, e.g. for results of the Utility::ShaderReflectionCache
+		Shader(LogicalDevice& parent, std::span<const uint32_t> shaderCode, Utility::HashValue hash, const Utility::ShaderReflection& reflection);
 		~Shader();
 		ShaderStage get_stage();
 		void parse_shader(const std::vector<uint32_t>& shaderCode);
+		//Doesn't touch the device, safe to call from any thread
+		static Utility::ShaderReflection reflect(std::span<const uint32_t> shaderCode);
+		const Utility::ShaderReflection& get_reflection() const noexcept;
 		//const ShaderLayout& get_layout() const {
 		//	return m_layout;
 		//}
@@ -171,11 +178,13 @@ namespace vulkan {
 		Utility::HashValue get_hash();
 		SpecializationConstantId get_specialization_constant_id(const std::string& name) const;
 	private:
-		VkShaderModule create_module(LogicalDevice& device, const std::vector<uint32_t>& shaderCode);
+		VkShaderModule create_module(LogicalDevice& device, std::span<const uint32_t> shaderCode);
+		void apply_reflection();
 
 		ShaderStage m_stage;
 		//ShaderLayout m_layout;
 		Utility::HashValue m_hashValue;
+		Utility::ShaderReflection m_reflection;
 		std::unordered_map<std::string, SpecializationConstantId> m_specilizationConstants;
 	}; 
 
@@ -254,10 +263,13 @@ namespace vulkan {
 			auto instance = ShaderInstance{ m_currentShader->get_handle()
 				, static_cast<VkShaderStageFlagBits>(1ull << static_cast<uint32_t>(m_currentShader->get_stage()))
 				, handle_constant(args)... };
+			std::unique_lock lock(m_instanceMutex);
 			return static_cast<ShaderId>(m_instanceStorage.emplace_intrusive(std::move(instance)) );
 		}
 		ShaderId add_shader(const std::vector<uint32_t>& shaderCode);
+		ShaderId add_shader(std::span<const uint32_t> shaderCode, Utility::HashValue hash, const Utility::ShaderReflection& reflection);
 		Shader* get_shader(ShaderId shaderId);
+		//Safe from the pipeline compile workers while the main thread adds instances, elements never move
 		ShaderInstance* get_instance(ShaderId instanceId);
 		void clear();
 	private:
@@ -311,6 +323,8 @@ namespace vulkan {
 
 		LogicalDevice& r_device;
 		Utility::LinkedBucketList<ShaderInstance> m_instanceStorage;
+		//Guards the bucket list itself, not the instances which are immutable once added
+		std::shared_mutex m_instanceMutex;
 		Utility::LinkedBucketList<Shader> m_shaderStorage;
 		Shader* m_currentShader = nullptr;
 	};
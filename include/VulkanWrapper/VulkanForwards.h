@@ -103,4 +103,5 @@ namespace vulkan {
 	using ImageHandle = Utility::ObjectHandle<Image, Utility::LinkedBucketList<Image>>;
 	using ImageViewHandle = Utility::ObjectHandle<ImageView, Utility::LinkedBucketList<ImageView>>;
 	using PipelineId = uint32_t;
+	constexpr PipelineId invalidPipelineId = ~PipelineId{ 0 };
 }
\ No newline at end of file
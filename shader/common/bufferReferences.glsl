@@ -1,6 +1,7 @@
 #extension GL_EXT_buffer_reference2 : require
 #extension GL_EXT_scalar_block_layout : require
 #extension GL_ARB_gpu_shader_int64 : require
+#include "common.glsl"
 
 layout(buffer_reference, scalar, buffer_reference_align = 8) readonly buffer Indices {
 	ivec3 i[];
@@ -29,55 +30,77 @@ layout(buffer_reference, scalar, buffer_reference_align = 8) readonly buffer Nor
 layout(buffer_reference, scalar, buffer_reference_align = 8) readonly buffer TangentsHalf {
 	uint t[]; 
 };
+
+layout(buffer_reference, scalar, buffer_reference_align = 4) readonly buffer ShortIndices {
+	uint i[];
+};
+layout(buffer_reference, scalar, buffer_reference_align = 8) readonly buffer QuantizedPositions {
+	uvec2 p[];
+};
+layout(buffer_reference, scalar, buffer_reference_align = 4) readonly buffer QuantizedNormals {
+	uint n[];
+};
+layout(buffer_reference, scalar, buffer_reference_align = 4) readonly buffer QuantizedTangents {
+	uint t[];
+};
 layout(buffer_reference, scalar, buffer_reference_align = 8) readonly buffer TraceRaysIndirect {
 	uint width; 
 	uint height;
 	uint depth;
 };
 
-ivec3 get_indices(uint64_t indicesAddress, uint idx) {
+ivec3 get_indices(uint64_t indicesAddress, uint idx, bool shortIndices) {
+	if(shortIndices) {
+		//Two 16 bit indices per uint, the triangle starts in the low or high half of the first word
+		ShortIndices indices = ShortIndices(indicesAddress);
+		uint first = idx * 3;
+		uint low = indices.i[first / 2];
+		uint high = indices.i[first / 2 + 1];
+		if((first % 2) == 1)
+			return ivec3(low >> 16, high & 0xFFFF, high >> 16);
+		else
+			return ivec3(low & 0xFFFF, low >> 16, high & 0xFFFF);
+	}
 	Indices indices = Indices(indicesAddress);
 	return indices.i[idx];
 }
 
-vec3 get_position(uint64_t positionAddress, uint idx) {
-	Positions positions = Positions(positionAddress);
-	return positions.p[idx];
+vec3 dequantize_position(vec3 position, vec3 positionOffset, vec3 positionScale) {
+	return fma(position, positionScale, positionOffset);
+}
+
+vec3 get_position(uint64_t positionAddress, uint idx, vec3 positionOffset, vec3 positionScale) {
+	QuantizedPositions positions = QuantizedPositions(positionAddress);
+	uvec2 encoded = positions.p[idx];
+	vec3 position = vec3(unpackSnorm2x16(encoded.x), unpackSnorm2x16(encoded.y).x);
+	return dequantize_position(position, positionOffset, positionScale);
+}
+
+vec3 decode_normal(vec2 normal) {
+	return get_octahedral_direction(normal);
+}
+
+//A2B10G10R10_SNORM_PACK32, the vertex input unpacks it to the same vec4
+vec4 decode_tangent(vec4 tangent) {
+	return vec4(get_octahedral_direction(tangent.xy), tangent.w);
+}
+
+vec4 unpack_snorm_1010102(uint encoded) {
+	ivec4 components = ivec4(bitfieldExtract(int(encoded), 0, 10),
+		bitfieldExtract(int(encoded), 10, 10),
+		bitfieldExtract(int(encoded), 20, 10),
+		bitfieldExtract(int(encoded), 30, 2));
+	return max(vec4(components) / vec4(511.0, 511.0, 511.0, 1.0), vec4(-1.0));
 }
 
 vec3 get_normal(uint64_t normalsAddress, uint idx) {
-	#define NORMALSHALF
-	#ifdef NORMALSHALF
-	NormalsHalf normalsHalf = NormalsHalf(normalsAddress);
-	uint low = normalsHalf.n[idx * 3 / 2 ];
-	uint high = normalsHalf.n[idx * 3 / 2  + 1];
-	vec2 lowVec = unpackHalf2x16(low);
-	vec2 highVec = unpackHalf2x16(high);
-	if((idx % 2) == 1)
-		return vec3(lowVec.y, highVec.xy);
-	else
-		return vec3(lowVec.xy, highVec.x);
-	#else
-	Normals normals = Normals(normalsAddress);
-	return normals.n[idx];
-	#endif
-	#undef NORMALSHALF
+	QuantizedNormals normals = QuantizedNormals(normalsAddress);
+	return decode_normal(unpackSnorm2x16(normals.n[idx]));
 }
 
 vec4 get_tangent(uint64_t tangentsAddress, uint idx) {
-	#define TANGENTSSHALF
-	#ifdef TANGENTSSHALF
-	TangentsHalf tangentsHalf = TangentsHalf(tangentsAddress);
-	uint low = tangentsHalf.t[idx * 2 ];
-	uint high = tangentsHalf.t[idx * 2  + 1];
-	vec2 lowVec = unpackHalf2x16(low);
-	vec2 highVec = unpackHalf2x16(high);
-	return vec4(lowVec, highVec);
-	#else
-	Tangents tangents = Tangents(tangentsAddress);
-	return tangents.t[idx];
-	#endif
-	#undef TANGENTSSHALF
+	QuantizedTangents tangents = QuantizedTangents(tangentsAddress);
+	return decode_tangent(unpack_snorm_1010102(tangents.t[idx]));
 }
 
 vec2 get_uv(uint64_t uvsAddress, uint idx) {
@@ -16,6 +16,15 @@ mat4x3 fetchTransformMatrix(Instance instance) {
                         instance.modelRow3);
 }
 
+ivec3 get_mesh_indices(in Mesh mesh, in uint primitiveId)
+{
+    return get_indices(mesh.indicesAddress, primitiveId, (mesh.flags & MESH_SHORT_INDICES_FLAG) != 0);
+}
+
+vec3 get_mesh_position(in Mesh mesh, in uint idx)
+{
+    return get_position(mesh.positionsAddress, idx, mesh.positionOffset, mesh.positionScale);
+}
 
 void flip_backfacing_normal(inout VertexData vertexData, in bool backFacing) 
 {
@@ -35,11 +44,11 @@ VertexData get_vertex_data(in Mesh mesh, in vec2 barycentricCoords, in uint prim
     const vec3 barycentrics = vec3(1.0 - barycentricCoords.x - barycentricCoords.y, barycentricCoords.xy);
     
 
-    ivec3 ind = get_indices(mesh.indicesAddress, primitiveId);
+    ivec3 ind = get_mesh_indices(mesh, primitiveId);
 
-    vec3 pos = get_position(mesh.positionsAddress, ind.x) * barycentrics.x 
-        + get_position(mesh.positionsAddress, ind.y) * barycentrics.y 
-        + get_position(mesh.positionsAddress, ind.z) * barycentrics.z;
+    vec3 pos = get_mesh_position(mesh, ind.x) * barycentrics.x 
+        + get_mesh_position(mesh, ind.y) * barycentrics.y 
+        + get_mesh_position(mesh, ind.z) * barycentrics.z;
 
     vec4 tangent = get_tangent(mesh.tangentsAddress, ind.x) * barycentrics.x 
                 + get_tangent(mesh.tangentsAddress, ind.y) * barycentrics.y 
@@ -71,11 +80,11 @@ VertexData get_vertex_data_simple(in Mesh mesh, in vec2 barycentricCoords, in ui
     const vec3 barycentrics = vec3(1.0 - barycentricCoords.x - barycentricCoords.y, barycentricCoords.x, barycentricCoords.y);
     
 
-    ivec3 ind = get_indices(mesh.indicesAddress, primitiveId);
+    ivec3 ind = get_mesh_indices(mesh, primitiveId);
 
-    vec3 pos = get_position(mesh.positionsAddress, ind.x) * barycentrics.x 
-        + get_position(mesh.positionsAddress, ind.y) * barycentrics.y 
-        + get_position(mesh.positionsAddress, ind.z) * barycentrics.z;
+    vec3 pos = get_mesh_position(mesh, ind.x) * barycentrics.x 
+        + get_mesh_position(mesh, ind.y) * barycentrics.y 
+        + get_mesh_position(mesh, ind.z) * barycentrics.z;
 
     vertexData.normal = normalize(mat3(objectToWorld) * 
         (get_normal(mesh.normalsAddress, ind.x) * barycentrics.x
@@ -100,7 +109,7 @@ VertexData get_uv_data(in Mesh mesh, in vec2 barycentricCoords, in uint primitiv
     const vec3 barycentrics = vec3(1.0 - barycentricCoords.x - barycentricCoords.y, barycentricCoords.x, barycentricCoords.y);
     
 
-    ivec3 ind = get_indices(mesh.indicesAddress, primitiveId);
+    ivec3 ind = get_mesh_indices(mesh, primitiveId);
     
     vertexData.uv = get_uv(mesh.uvsAddress, ind.x) * barycentrics.x 
         + get_uv(mesh.uvsAddress, ind.y) * barycentrics.y 
@@ -123,7 +132,7 @@ MaterialData get_material_data(in Material material, in VertexData vertexData)
     
     vec4 pbrData = vec4(0.f, 1.f, 1.f, 0.f);
     if(material.pbrTexId != INVALID_BINDING)
-        pbrData = pow(texture(sampler2D(textures2D[nonuniformEXT(material.pbrTexId)], samplers[nonuniformEXT(material.pbrSampler)]), vertexData.uv), vec4(1.f /2.2));
+        pbrData = texture(sampler2D(textures2D[nonuniformEXT(material.pbrTexId)], samplers[nonuniformEXT(material.pbrSampler)]), vertexData.uv);
         //pbrData = pow(textureLod(sampler2D(textures2D[nonuniformEXT(material.pbrTexId)], samplers[nonuniformEXT(material.pbrSampler)]), vertexData.uv, 0), vec4(1.f /2.2));
     materialData.roughness = pbrData.g * material.roughness;
     materialData.metalness = pbrData.b * material.metalness;
@@ -131,10 +140,11 @@ MaterialData get_material_data(in Material material, in VertexData vertexData)
     materialData.shadingNormal = vertexData.normal;
     vec2 normalSample = vec2(0.5f);
     if(material.normalTexId != INVALID_BINDING) {
-        normalSample =  pow(texture(sampler2D(textures2D[nonuniformEXT(material.normalTexId)], samplers[nonuniformEXT(material.normalSampler)]), vertexData.uv).xy, vec2(1.f /2.2f)); 
+        //Linear like the pbr data, the texture manager loads both without sRGB
+        normalSample = texture(sampler2D(textures2D[nonuniformEXT(material.normalTexId)], samplers[nonuniformEXT(material.normalSampler)]), vertexData.uv).xy;
         //normalSample =  pow(textureLod(sampler2D(textures2D[nonuniformEXT(material.normalTexId)], samplers[nonuniformEXT(material.normalSampler)]), vertexData.uv, 0).xy, vec2(1.f /1.0)); 
         materialData.shadingNormal = tangentSpaceNormal(normalSample, vertexData.normal, vertexData.tangent, vertexData.bitangent);
-    }//Temporary fix for wrong sampling of linear textures
+    }
 
     vec3 emissive = vec3(1.f);
     if(material.emissiveTexId != INVALID_BINDING)
@@ -2,6 +2,10 @@
 #define STRUCTS_H
 
 const uint INVALID_BINDING = 4294967295u;
+const uint MESH_SHORT_INDICES_FLAG = 0x1u << 0;
+
+//Positions are snorm16x4, position = positionOffset + positionScale * p.xyz
+//Normals are octahedral snorm16x2, tangents octahedral A2B10G10R10_SNORM with the bitangent sign in w
 struct Mesh {
 	uint materialBinding;
 	uint materialId;
@@ -10,6 +14,38 @@ struct Mesh {
 	uint64_t uvsAddress;
 	uint64_t normalsAddress;
 	uint64_t tangentsAddress;
+	vec3 positionOffset;
+	uint flags;
+	vec3 positionScale;
+	float boundsRadius;
+	//Object space bounding sphere center and axis aligned box
+	vec3 boundsCenter;
+	float pad0;
+	vec3 boundsMin;
+	float pad1;
+	vec3 boundsMax;
+	float pad2;
+};
+
+const uint MESHLET_MAX_VERTICES = 64;
+const uint MESHLET_MAX_TRIANGLES = 124;
+
+//triangleOffset is a byte offset into the packed uint8 triangle buffer, always a multiple of four
+struct Meshlet {
+	uint vertexOffset;
+	uint triangleOffset;
+	uint vertexCount;
+	uint triangleCount;
+};
+
+//Backface cone culling: reject if dot(normalize(coneApex - cameraPos), coneAxis) >= coneCutoff
+struct MeshletBounds {
+	vec3 center;
+	float radius;
+	vec3 coneApex;
+	float coneCutoff;
+	vec3 coneAxis;
+	float pad;
 };
 
 const uint MATERIAL_DOUBLE_SIDED_FLAG = 0x1u << 0;
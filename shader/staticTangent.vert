@@ -14,9 +14,10 @@ layout(std430, push_constant) uniform PushConstants
     uint sceneBinding;
 } constants;
 
-layout(location = 0) in vec3 inPosition;
+//Quantized vertex formats, see nyan::QuantizedMesh
+layout(location = 0) in vec4 inPosition;
 layout(location = 1) in vec2 inTexCoord;
-layout(location = 2) in vec3 inNormal;
+layout(location = 2) in vec2 inNormal;
 layout(location = 3) in vec4 inTangent;
 
 layout(location = 0) out vec2 fragTexCoord;
@@ -32,13 +33,15 @@ void main() {
 	mat4x3 model = fetchTransformMatrix(instance);
     //Cancel out translations before other transformations
     mat3 modelS = mat3(model);
+    vec3 position = dequantize_position(inPosition.xyz, mesh.positionOffset, mesh.positionScale);
+    vec4 vertexTangent = decode_tangent(inTangent);
     //model[3] -=  get_viewer_pos(scene);
 	//gl_Position = scene.proj * vec4(mat3(scene.view) * fragWorldPos , 1.0);
-    fragWorldPos = model * vec4( inPosition, 1.0);
+    fragWorldPos = model * vec4( position, 1.0);
 	gl_Position = scene.proj * scene.view * vec4(fragWorldPos, 1.0);
-    fragWorldPos = modelS * inPosition;
-    vec3 tangent =  modelS * inTangent.xyz;
-    vec3 normal = modelS *  inNormal.xyz;
+    fragWorldPos = modelS * position;
+    vec3 tangent =  modelS * vertexTangent.xyz;
+    vec3 normal = modelS *  decode_normal(inNormal);
     //tangent = normalize(tangent - dot(tangent, normal) * normal);
 //    Uvs uvs = Uvs(mesh.uvs);
    // Normals normals = Normals(mesh.normalsAddress);
@@ -52,7 +55,7 @@ void main() {
     //fragTexCoord = get_uv(mesh.uvsAddress, gl_VertexIndex);
 
     fragTexCoord = inTexCoord;
-    fragTangent = vec4(tangent, inTangent.w);
+    fragTangent = vec4(tangent, vertexTangent.w);
     //fragTangent = inTangent;
     fragNormal = normal;
     //fragBitangent = bitangent;
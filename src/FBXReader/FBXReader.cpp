@@ -1,4 +1,5 @@
 #include "FBXReader/FBXReader.h"
+#include "Renderer/MeshOptimizer.h"
 #include <iostream>
 #include <assert.h>
 
@@ -131,7 +132,9 @@ void Utility::FBXReader::parse_meshes(const std::filesystem::path& fbxFile, std:
 		}
 	}
 	//std::cout << rootNode->GetChildCount() << '\n';
+	auto firstMesh = retMeshes.size();
 	parse_meshes(rootNode, retMeshes, retLights);
+	nyan::MeshOptimizer::optimize(std::span<nyan::Mesh>{ retMeshes.begin() + firstMesh, retMeshes.end() });
 
 	scene->Destroy(true);
 }
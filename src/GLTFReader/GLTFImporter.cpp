@@ -0,0 +1,311 @@
+#include "GLTFReader/GLTFImporter.hpp"
+#include "tiny_gltf.h"
+#include "GLTFReader/GLTFPrimitiveDecoder.hpp"
+#include "Renderer/MeshOptimizer.h"
+#include "Renderer/MeshSimplifier.h"
+#include "Renderer/SceneAssetCache.h"
+#include "Renderer/TangentGenerator.h"
+#include "Utility/JobSystem.h"
+#include "Utility/Log.h"
+#include "Utility/MappedFile.h"
+#include "Utility/StreamHasher.h"
+#include <cassert>
+#include <stdexcept>
+
+//Primitives below this triangle count are drawn at full resolution at any distance
+static constexpr size_t gltfLodMinTriangleCount{ 2048 };
+
+static nyan::AlphaMode gltf_alpha_mode(const std::string& mode)
+{
+	if (mode == "OPAQUE") return nyan::AlphaMode::Opaque;
+	if (mode == "MASK") return nyan::AlphaMode::AlphaTest;
+	if (mode == "BLEND") return nyan::AlphaMode::AlphaBlend;
+	assert(false);
+	return nyan::AlphaMode::Opaque;
+}
+
+static nyan::Mesh::RenderType gltf_render_type(nyan::AlphaMode mode)
+{
+	switch (mode) {
+	case nyan::AlphaMode::AlphaTest:
+		return nyan::Mesh::RenderType::AlphaTest;
+	case nyan::AlphaMode::AlphaBlend:
+		return nyan::Mesh::RenderType::AlphaBlend;
+	default:
+		return nyan::Mesh::RenderType::Opaque;
+	}
+}
+
+std::optional<nyan::SceneAsset> nyan::GLTFImporter::import_file(const std::filesystem::path& path, const std::filesystem::path& cacheDirectory)
+{
+	if (path.extension() != ".glb" && path.extension() != ".gltf")
+		return std::nullopt;
+	Utility::MappedFile file;
+	try {
+		file = Utility::MappedFile(path);
+	}
+	catch (const std::runtime_error& e) {
+		Utility::log_warning(e.what());
+		return std::nullopt;
+	}
+	return import_memory(path, file.span(), cacheDirectory);
+}
+
+std::optional<nyan::SceneAsset> nyan::GLTFImporter::import_memory(const std::filesystem::path& path, std::span<const std::byte> data, const std::filesystem::path& cacheDirectory)
+{
+	tinygltf::TinyGLTF loader;
+	tinygltf::Model model;
+	std::string err;
+	std::string warn;
+	bool ret = false;
+
+	const auto baseDirectory = path.parent_path().string();
+	if (path.extension() == ".glb")
+		ret = loader.LoadBinaryFromMemory(&model, &err, &warn, reinterpret_cast<const unsigned char*>(data.data()), static_cast<unsigned int>(data.size()), baseDirectory);
+	else if (path.extension() == ".gltf")
+		ret = loader.LoadASCIIFromString(&model, &err, &warn, reinterpret_cast<const char*>(data.data()), static_cast<unsigned int>(data.size()), baseDirectory);
+
+	if (!warn.empty())
+		Utility::log_warning(warn);
+
+	if (!err.empty())
+		Utility::log_warning(err);
+	if (!ret)
+		return std::nullopt;
+	if (cacheDirectory.empty())
+		return import_model(model, path.parent_path(), path.string());
+
+	//External .bin files only show up after parsing, images are referenced by path and aren't part of the asset
+	//The path is part of the key as well, texture files are resolved relative to it
+	Utility::StreamHasher hasher(SceneAssetCache::version);
+	const auto pathString = path.generic_string();
+	hasher.update(pathString.data(), pathString.size());
+	hasher.update(data.data(), data.size());
+	for (const auto& buffer : model.buffers)
+		hasher.update(buffer.data);
+	const auto key = hasher.finish();
+	if (auto cached = SceneAssetCache::load(cacheDirectory, key))
+		return cached;
+	auto asset = import_model(model, path.parent_path(), path.string());
+	try {
+		SceneAssetCache::store(cacheDirectory, key, asset);
+	}
+	catch (const std::exception& e) {
+		Utility::log_warning().format("GLTFImporter: Couldn't cache \"{}\": {}", path.string(), e.what());
+	}
+	return asset;
+}
+
+std::future<std::optional<nyan::SceneAsset>> nyan::GLTFImporter::import_file_async(const std::filesystem::path& path, const std::filesystem::path& cacheDirectory)
+{
+	return Utility::JobSystem::get().submit([path, cacheDirectory]() { return import_file(path, cacheDirectory); });
+}
+
+nyan::SceneAsset nyan::GLTFImporter::import_model(const tinygltf::Model& model, const std::filesystem::path& directory, const std::string& name)
+{
+	SceneAsset asset{
+		.name {name},
+	};
+	for (const auto& material : model.materials) {
+		assert(material.pbrMetallicRoughness.baseColorTexture.texCoord == 0);
+		assert(material.emissiveTexture.texCoord == 0);
+		assert(material.pbrMetallicRoughness.metallicRoughnessTexture.texCoord == 0);
+		assert(material.normalTexture.texCoord == 0);
+		assert(!material.pbrMetallicRoughness.baseColorTexture.extras.Size());
+		assert(material.pbrMetallicRoughness.baseColorTexture.extensions.empty());
+		if (material.pbrMetallicRoughness.baseColorTexture.index != -1) {
+			assert(!model.textures[material.pbrMetallicRoughness.baseColorTexture.index].extras.Size());
+			assert(model.textures[material.pbrMetallicRoughness.baseColorTexture.index].extensions.empty());
+		}
+	}
+
+	std::vector<std::string> textureMap(model.textures.size());
+	for (size_t texIdx{ 0 }; texIdx < model.textures.size(); ++texIdx) {
+		const auto& texture = model.textures[texIdx];
+		if (texture.source == -1)
+			continue;
+		const auto& image = model.images[texture.source];
+		if (!image.uri.empty()) {
+			asset.textures.push_back(SceneTextureAsset{
+				.name {image.uri},
+				.file {directory / image.uri},
+				});
+		}
+		else {
+			assert(image.width > 0);
+			assert(image.height > 0);
+			assert(image.component > 0);
+			assert(image.bits > 0);
+			asset.textures.push_back(SceneTextureAsset{
+				.name {image.name},
+				.width {static_cast<uint32_t>(image.width)},
+				.height {static_cast<uint32_t>(image.height)},
+				.components {static_cast<uint32_t>(image.component)},
+				.bitsPerChannel {static_cast<uint32_t>(image.bits)},
+				.data {image.image},
+				});
+		}
+		textureMap[texIdx] = asset.textures.back().name;
+	}
+	auto texResolve = [&](int idx) {return (idx != -1) ? textureMap[idx] : ""; };
+	asset.materials.reserve(model.materials.size());
+	for (size_t matIdx{ 0 }; matIdx < model.materials.size(); ++matIdx) {
+		const auto& material = model.materials[matIdx];
+		std::string materialName = material.name;
+		if (materialName.empty())
+			materialName = "Material_" + std::to_string(matIdx);
+		asset.materials.push_back(nyan::PBRMaterialData{
+			.name{materialName},
+			.albedoTex{texResolve(material.pbrMetallicRoughness.baseColorTexture.index)},
+			.emissiveTex {texResolve(material.emissiveTexture.index)},
+			.roughnessMetalnessTex {texResolve(material.pbrMetallicRoughness.metallicRoughnessTexture.index)},
+			.normalTex {texResolve(material.normalTexture.index)},
+			.albedoFactor{Math::vec4{material.pbrMetallicRoughness.baseColorFactor}},
+			.emissiveFactor {Math::vec3{material.emissiveFactor}},
+			.alphaMode {gltf_alpha_mode(material.alphaMode)},
+			.alphaCutoff {static_cast<float>(material.alphaCutoff)},
+			.doubleSided {material.doubleSided},
+			.metallicFactor {static_cast<float>(material.pbrMetallicRoughness.metallicFactor)},
+			.roughnessFactor {static_cast<float>(material.pbrMetallicRoughness.roughnessFactor)}
+			});
+	}
+
+	asset.meshes.resize(model.meshes.size());
+	for (size_t meshIdx{ 0 }; meshIdx < model.meshes.size(); ++meshIdx) {
+		asset.meshes[meshIdx].name = model.meshes[meshIdx].name;
+		if (asset.meshes[meshIdx].name.empty())
+			asset.meshes[meshIdx].name = "Mesh_" + std::to_string(meshIdx);
+	}
+
+	auto decodedPrimitives = nyan::GLTFPrimitiveDecoder::decode_meshes(model);
+	std::vector<nyan::Mesh> primitives;
+	primitives.reserve(decodedPrimitives.size());
+	asset.primitives.resize(decodedPrimitives.size());
+	std::vector<size_t> tangentPrimitives;
+	for (size_t primitiveIdx{ 0 }; primitiveIdx < decodedPrimitives.size(); ++primitiveIdx) {
+		auto& decodedPrimitive = decodedPrimitives[primitiveIdx];
+		const auto& primitive = model.meshes[decodedPrimitive.meshIdx].primitives[decodedPrimitive.primitiveIdx];
+		auto& nMesh = decodedPrimitive.mesh;
+		if (!nMesh.uvs1.empty())
+			Utility::log_warning().format("Mesh: {}, TEXCOORD_1 unsupported attribute", nMesh.name);
+		if (!nMesh.uvs2.empty())
+			Utility::log_warning().format("Mesh: {}, TEXCOORD_2 unsupported attribute", nMesh.name);
+		if (primitive.attributes.contains("COLOR_0"))
+			Utility::log_warning().format("Mesh: {}, COLOR_0 unsupported attribute", nMesh.name);
+		if (nMesh.tangents.empty()) {
+			Utility::log_warning().format("{}: has no tangents, generating tangents", nMesh.name);
+			tangentPrimitives.push_back(primitiveIdx);
+		}
+		if (nMesh.uvs0.empty()) {
+			Utility::log_warning().format("{}: has no uvs, skipping mesh", nMesh.name);
+			//continue;
+		}
+		if (nMesh.normals.empty()) {
+			Utility::log_warning().format("{}: has no normals, skipping mesh", nMesh.name);
+			//continue;
+		}
+		if (nMesh.positions.empty()) {
+			Utility::log_warning().format("{}: has no positions, skipping mesh", nMesh.name);
+			//continue;
+		}
+		assert(nMesh.normals.size() == nMesh.uvs0.size() || nMesh.uvs0.size() == 0);
+		assert(nMesh.positions.size() == nMesh.uvs0.size() || nMesh.uvs0.size() == 0);
+
+		if (primitive.material != -1) {
+			asset.primitives[primitiveIdx].material = primitive.material;
+			nMesh.type = gltf_render_type(asset.materials[primitive.material].alphaMode);
+		}
+
+		primitives.push_back(std::move(nMesh));
+		asset.meshes[decodedPrimitive.meshIdx].primitives.push_back(static_cast<uint32_t>(primitiveIdx));
+	}
+	Utility::JobSystem::get().parallel_for(tangentPrimitives.size(), [&](size_t i) {
+		nyan::TangentGenerator::generate(primitives[tangentPrimitives[i]]);
+	});
+	nyan::MeshOptimizer::optimize(primitives);
+	Utility::JobSystem::get().parallel_for(primitives.size(), [&](size_t i) {
+		nyan::BoundsCalculator::compute(primitives[i]);
+	});
+
+	std::vector<size_t> lodPrimitives;
+	for (size_t primitiveIdx{ 0 }; primitiveIdx < primitives.size(); ++primitiveIdx)
+		if (primitives[primitiveIdx].indices.size() / 3 >= gltfLodMinTriangleCount && primitives[primitiveIdx].type != nyan::Mesh::RenderType::AlphaBlend)
+			lodPrimitives.push_back(primitiveIdx);
+	Utility::JobSystem::get().parallel_for(lodPrimitives.size(), [&](size_t lodIdx) {
+		auto& primitive = asset.primitives[lodPrimitives[lodIdx]];
+		for (const auto& lod : nyan::MeshSimplifier::generate_lods(primitives[lodPrimitives[lodIdx]])) {
+			primitive.lods.push_back(nyan::MeshQuantizer::quantize(lod.mesh));
+			primitive.lodErrors.push_back(lod.error);
+		}
+	});
+
+	auto quantizedPrimitives = nyan::MeshQuantizer::quantize(primitives);
+	for (size_t primitiveIdx{ 0 }; primitiveIdx < primitives.size(); ++primitiveIdx) {
+		auto statistics = nyan::MeshQuantizer::analyze(primitives[primitiveIdx], quantizedPrimitives[primitiveIdx]);
+		asset.quantizationStatistics.sourceBytes += statistics.sourceBytes;
+		asset.quantizationStatistics.quantizedBytes += statistics.quantizedBytes;
+		asset.primitives[primitiveIdx].mesh = std::move(quantizedPrimitives[primitiveIdx]);
+	}
+	if (asset.quantizationStatistics.sourceBytes) {
+		asset.quantizationStatistics.ratio = static_cast<float>(asset.quantizationStatistics.quantizedBytes) / static_cast<float>(asset.quantizationStatistics.sourceBytes);
+		Utility::log().format("{}: quantized mesh data from {} to {} bytes", asset.name, asset.quantizationStatistics.sourceBytes, asset.quantizationStatistics.quantizedBytes);
+	}
+
+	asset.nodes.resize(model.nodes.size());
+	for (size_t nodeIdx{ 0 }; nodeIdx < model.nodes.size(); ++nodeIdx) {
+		const auto& node = model.nodes[nodeIdx];
+		auto& nodeAsset = asset.nodes[nodeIdx];
+		nodeAsset.name = node.name;
+		nodeAsset.transform = import_transform(node);
+		nodeAsset.mesh = node.mesh;
+		for (auto child : node.children)
+			nodeAsset.children.push_back(static_cast<uint32_t>(child));
+		if (auto light = node.extensions.find("KHR_lights_punctual"); light != node.extensions.end()) {
+			const auto& lightData = model.lights[light->second.Get("light").GetNumberAsInt()];
+			float range = static_cast<float>(lightData.range);
+			if (range == 0)
+				range = 1e8;
+			nodeAsset.light = Pointlight{
+				.shadows{ true },
+				.color {Math::vec3{lightData.color}},
+				.intensity {static_cast<float>(lightData.intensity)},
+				.attenuation {range}
+			};
+		}
+	}
+
+	asset.scenes.reserve(model.scenes.size());
+	for (const auto& scene : model.scenes) {
+		auto& sceneAsset = asset.scenes.emplace_back(SceneRootAsset{ .name {scene.name} });
+		for (auto nodeId : scene.nodes)
+			sceneAsset.nodes.push_back(static_cast<uint32_t>(nodeId));
+	}
+	return asset;
+}
+
+nyan::Transform nyan::GLTFImporter::import_transform(const tinygltf::Node& node)
+{
+	Transform transform{};
+	if (!node.translation.empty())
+		transform.position = Math::vec3{ node.translation };
+	if (!node.scale.empty())
+		transform.scale = Math::vec3{ node.scale };
+	if (!node.rotation.empty())
+		transform.orientation = Math::Mat<float, 3, 3, true>(Math::quat(Math::vec4(node.rotation[1], node.rotation[2], node.rotation[3], node.rotation[0]))).euler();
+	if (!node.matrix.empty()) {
+		Math::mat44 mat{ node.matrix };
+		transform.position = Math::vec3{ mat.col(3) };
+		Math::vec3 tmpX{ mat.col(0) };
+		Math::vec3 tmpY{ mat.col(1) };
+		Math::vec3 tmpZ{ mat.col(2) };
+		transform.scale = Math::vec3{ tmpX.L2_norm(), tmpY.L2_norm(), tmpZ.L2_norm() };
+		tmpX *= 1.f / transform.scale.x();
+		tmpY *= 1.f / transform.scale.y();
+		tmpZ *= 1.f / transform.scale.z();
+		mat.set_col(tmpX, 0);
+		mat.set_col(tmpY, 1);
+		mat.set_col(tmpZ, 2);
+		transform.orientation = mat.euler();
+	}
+	return transform;
+}
@@ -0,0 +1,214 @@
+#include "GLTFReader/GLTFPrimitiveDecoder.hpp"
+#include "tiny_gltf.h"
+#include "Utility/JobSystem.h"
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <cassert>
+
+struct GLTFAccessorView {
+	const std::byte* data{ nullptr };
+	size_t stride{ 0 };
+	size_t count{ 0 };
+	int componentType{ 0 };
+	size_t numComponents{ 0 };
+	bool normalized{ false };
+};
+
+static GLTFAccessorView gltf_accessor_view(const tinygltf::Model& model, const tinygltf::Accessor& accessor)
+{
+	assert(!accessor.sparse.isSparse);
+	assert(accessor.bufferView != -1);
+	const auto& bufferView = model.bufferViews[accessor.bufferView];
+	assert(bufferView.buffer != -1);
+	assert(bufferView.byteLength);
+	const auto& buffer = model.buffers[bufferView.buffer];
+	GLTFAccessorView view{
+		.data {reinterpret_cast<const std::byte*>(buffer.data.data() + bufferView.byteOffset + accessor.byteOffset)},
+		.stride {bufferView.byteStride},
+		.count {accessor.count},
+		.componentType {accessor.componentType},
+		.numComponents {static_cast<size_t>(tinygltf::GetNumComponentsInType(accessor.type))},
+		.normalized {accessor.normalized},
+	};
+	const auto elementSize = view.numComponents * tinygltf::GetComponentSizeInBytes(accessor.componentType);
+	if (!view.stride)
+		view.stride = elementSize;
+	assert(!view.count || bufferView.byteOffset + accessor.byteOffset + (view.count - 1) * view.stride + elementSize <= buffer.data.size());
+	return view;
+}
+
+//One loop per source type, the element conversion itself is branchless so it vectorizes
+//Normalized integers follow the glTF/Vulkan rules, signed values are clamped to -1
+template<typename Source, typename Scalar, size_t Size>
+static void gltf_convert(const GLTFAccessorView& view, std::vector<Math::Vec<Scalar, Size>>& destination)
+{
+	destination.resize(view.count);
+	if constexpr (std::is_same_v<Source, Scalar>) {
+		static_assert(sizeof(Math::Vec<Scalar, Size>) == sizeof(Scalar) * Size);
+		if (view.stride == sizeof(Scalar) * Size) {
+			std::memcpy(destination.data(), view.data, view.count * view.stride);
+			return;
+		}
+	}
+	float scale{ 1.f };
+	float lower{ -std::numeric_limits<float>::max() };
+	if constexpr (std::is_integral_v<Source>) {
+		if (view.normalized) {
+			scale = 1.f / static_cast<float>(std::numeric_limits<Source>::max());
+			if constexpr (std::is_signed_v<Source>)
+				lower = -1.f;
+		}
+	}
+	for (size_t i{ 0 }; i < view.count; ++i) {
+		std::array<Source, Size> components;
+		std::memcpy(components.data(), view.data + i * view.stride, sizeof(components));
+		auto& element = destination[i];
+		for (size_t j{ 0 }; j < Size; ++j)
+			element[j] = static_cast<Scalar>(std::max(static_cast<float>(components[j]) * scale, lower));
+	}
+}
+
+template<typename Scalar, size_t Size>
+static void gltf_decode(const GLTFAccessorView& view, std::vector<Math::Vec<Scalar, Size>>& destination)
+{
+	assert(view.numComponents == Size);
+	switch (view.componentType) {
+	case TINYGLTF_COMPONENT_TYPE_FLOAT:
+		gltf_convert<float>(view, destination);
+		break;
+	case TINYGLTF_COMPONENT_TYPE_DOUBLE:
+		gltf_convert<double>(view, destination);
+		break;
+	case TINYGLTF_COMPONENT_TYPE_BYTE:
+		gltf_convert<int8_t>(view, destination);
+		break;
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+		gltf_convert<uint8_t>(view, destination);
+		break;
+	case TINYGLTF_COMPONENT_TYPE_SHORT:
+		gltf_convert<int16_t>(view, destination);
+		break;
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		gltf_convert<uint16_t>(view, destination);
+		break;
+	default:
+		assert(false);
+	}
+}
+
+template<typename Source>
+static void gltf_convert_indices(const GLTFAccessorView& view, std::vector<uint32_t>& indices)
+{
+	indices.resize(view.count);
+	if constexpr (std::is_same_v<Source, uint32_t>) {
+		if (view.stride == sizeof(uint32_t)) {
+			std::memcpy(indices.data(), view.data, view.count * sizeof(uint32_t));
+			return;
+		}
+	}
+	for (size_t i{ 0 }; i < view.count; ++i) {
+		Source index;
+		std::memcpy(&index, view.data + i * view.stride, sizeof(Source));
+		indices[i] = index;
+	}
+}
+
+void nyan::GLTFPrimitiveDecoder::decode_indices(const tinygltf::Model& model, const tinygltf::Accessor& accessor, std::vector<uint32_t>& indices)
+{
+	assert(accessor.type == TINYGLTF_TYPE_SCALAR);
+	auto view = gltf_accessor_view(model, accessor);
+	switch (view.componentType) {
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+		gltf_convert_indices<uint8_t>(view, indices);
+		break;
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		gltf_convert_indices<uint16_t>(view, indices);
+		break;
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+		gltf_convert_indices<uint32_t>(view, indices);
+		break;
+	default:
+		assert(false);
+	}
+}
+
+void nyan::GLTFPrimitiveDecoder::decode_positions(const tinygltf::Model& model, const tinygltf::Accessor& accessor, std::vector<Math::vec3>& positions)
+{
+	gltf_decode(gltf_accessor_view(model, accessor), positions);
+}
+
+void nyan::GLTFPrimitiveDecoder::decode_normals(const tinygltf::Model& model, const tinygltf::Accessor& accessor, std::vector<Math::hvec3>& normals)
+{
+	gltf_decode(gltf_accessor_view(model, accessor), normals);
+}
+
+void nyan::GLTFPrimitiveDecoder::decode_tangents(const tinygltf::Model& model, const tinygltf::Accessor& accessor, std::vector<Math::hvec4>& tangents)
+{
+	gltf_decode(gltf_accessor_view(model, accessor), tangents);
+}
+
+void nyan::GLTFPrimitiveDecoder::decode_uvs(const tinygltf::Model& model, const tinygltf::Accessor& accessor, std::vector<Math::hvec2>& uvs)
+{
+	gltf_decode(gltf_accessor_view(model, accessor), uvs);
+}
+
+nyan::Mesh nyan::GLTFPrimitiveDecoder::decode_primitive(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const std::string& name)
+{
+	assert(primitive.mode == TINYGLTF_MODE_TRIANGLES || primitive.mode == -1);
+	nyan::Mesh mesh{
+		.type {nyan::Mesh::RenderType::Opaque},
+		.name {name},
+	};
+	for (const auto& [attribute, accessorId] : primitive.attributes) {
+		const auto& accessor = model.accessors[accessorId];
+		if (attribute == "POSITION")
+			decode_positions(model, accessor, mesh.positions);
+		else if (attribute == "NORMAL")
+			decode_normals(model, accessor, mesh.normals);
+		else if (attribute == "TANGENT")
+			decode_tangents(model, accessor, mesh.tangents);
+		else if (attribute == "TEXCOORD_0")
+			decode_uvs(model, accessor, mesh.uvs0);
+		else if (attribute == "TEXCOORD_1")
+			decode_uvs(model, accessor, mesh.uvs1);
+		else if (attribute == "TEXCOORD_2")
+			decode_uvs(model, accessor, mesh.uvs2);
+		else if (attribute == "COLOR_0")
+			continue;
+		else
+			assert(false && "unsupported attribute");
+	}
+	if (primitive.indices != -1) {
+		decode_indices(model, model.accessors[primitive.indices], mesh.indices);
+	}
+	else {
+		//Non indexed geometry
+		mesh.indices.resize(mesh.positions.size());
+		std::iota(mesh.indices.begin(), mesh.indices.end(), 0u);
+	}
+	return mesh;
+}
+
+std::vector<nyan::GLTFPrimitive> nyan::GLTFPrimitiveDecoder::decode_meshes(const tinygltf::Model& model)
+{
+	std::vector<GLTFPrimitive> primitives;
+	for (size_t meshIdx{ 0 }; meshIdx < model.meshes.size(); ++meshIdx) {
+		const auto& mesh = model.meshes[meshIdx];
+		std::string meshName = mesh.name;
+		if (meshName.empty())
+			meshName = "Mesh_" + std::to_string(meshIdx);
+		for (size_t primitiveIdx{ 0 }; primitiveIdx < mesh.primitives.size(); ++primitiveIdx) {
+			primitives.push_back(GLTFPrimitive{
+				.mesh {.name {meshName + "_Primitive_" + std::to_string(primitiveIdx)}},
+				.meshIdx {meshIdx},
+				.primitiveIdx {primitiveIdx},
+				});
+		}
+	}
+	Utility::JobSystem::get().parallel_for(primitives.size(), [&](size_t i) {
+		auto& primitive = primitives[i];
+		primitive.mesh = decode_primitive(model, model.meshes[primitive.meshIdx].primitives[primitive.primitiveIdx], primitive.mesh.name);
+	});
+	return primitives;
+}
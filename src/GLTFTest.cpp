@@ -42,6 +42,9 @@ int main(const int argc, char const * const * const argv)
 	auto directory = getenv("USERPROFILE") / std::filesystem::path{ "Assets" };
 
 	nyan::RenderManager renderManager(device, true, directory);
+	//Cooked textures and imported scenes are reused across launches
+	const auto cacheDirectory = directory / "Cache";
+	renderManager.get_texture_manager().enable_texture_cache(cacheDirectory / "Textures", 4ull << 30);
 	nyan::CameraController cameraController(renderManager, input);
 	auto& registry = renderManager.get_registry();
 	
@@ -290,7 +293,7 @@ int main(const int argc, char const * const * const argv)
 	//file = "cornellFixed.gltf";
 	std::filesystem::path path = directory / file;
 	//path = directory / file;
-	nyan::GLTFReader reader{ renderManager };
+	nyan::GLTFReader reader{ renderManager, cacheDirectory / "Scenes" };
 	reader.load_file(path);
 
 
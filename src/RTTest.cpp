@@ -28,6 +28,9 @@ int main() {
 	auto directory = getenv("USERPROFILE") / std::filesystem::path{ "Assets" };
 
 	nyan::RenderManager renderManager(device, true, directory);
+	//Cooked textures and imported scenes are reused across launches
+	const auto cacheDirectory = directory / "Cache";
+	renderManager.get_texture_manager().enable_texture_cache(cacheDirectory / "Textures", 4ull << 30);
 	nyan::CameraController cameraController(renderManager, input);
 	auto& registry = renderManager.get_registry();
 	std::filesystem::path file;
@@ -135,7 +138,7 @@ int main() {
 
 	std::filesystem::path path = directory  / file;
 	//path = directory / file;
-	nyan::GLTFReader reader{ renderManager };
+	nyan::GLTFReader reader{ renderManager, cacheDirectory / "Scenes" };
 	reader.load_file(path);
 
 
@@ -0,0 +1,317 @@
+#include "Renderer/AssetStreamer.h"
+#include "Utility/Log.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <cassert>
+#include <span>
+#include <stdexcept>
+
+//Smallest page size of the supported platforms, touching more often than once per page is harmless
+static constexpr size_t streamerPageSize{ 4096 };
+
+//Faults the pages in on the I/O thread, the decode jobs then never stall on the disk
+static bool streamer_map_file(const std::filesystem::path& path, Utility::MappedFile& file)
+{
+	try {
+		file = Utility::MappedFile(path);
+	}
+	catch (const std::runtime_error&) {
+		return false;
+	}
+	file.prefetch(0, file.size());
+	for (size_t offset{ 0 }; offset < file.size(); offset += streamerPageSize)
+		static_cast<void>(*static_cast<const volatile std::byte*>(file.data() + offset));
+	return true;
+}
+
+template<typename T>
+static size_t streamer_byte_size(const std::vector<T>& values)
+{
+	return std::span(values).size_bytes();
+}
+
+static size_t streamer_mesh_size(const nyan::QuantizedMesh& mesh)
+{
+	return streamer_byte_size(mesh.shortIndices) + streamer_byte_size(mesh.indices) + streamer_byte_size(mesh.positions) +
+		streamer_byte_size(mesh.uvs0) + streamer_byte_size(mesh.normals) + streamer_byte_size(mesh.tangents);
+}
+
+std::unique_ptr<nyan::AssetPayload> nyan::StreamedTexture::decode(const std::filesystem::path& path, std::span<const std::byte> data)
+{
+	int width, height, channels;
+	auto* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(data.data()), static_cast<int>(data.size()), &width, &height, &channels, 4);
+	if (!pixels)
+		return nullptr;
+	auto texture = std::make_unique<StreamedTexture>();
+	texture->texture = SceneTextureAsset{
+		.name {path.filename().string()},
+		.width {static_cast<uint32_t>(width)},
+		.height {static_cast<uint32_t>(height)},
+		.components {4},
+		.bitsPerChannel {8},
+		.data {pixels, pixels + static_cast<size_t>(width) * static_cast<size_t>(height) * 4},
+	};
+	stbi_image_free(pixels);
+	return texture;
+}
+
+size_t nyan::StreamedScene::upload_size() const
+{
+	size_t size{ 0 };
+	for (const auto& texture : asset.textures)
+		size += texture.data.size();
+	for (const auto& primitive : asset.primitives) {
+		size += streamer_mesh_size(primitive.mesh);
+		for (const auto& lod : primitive.lods)
+			size += streamer_mesh_size(lod);
+	}
+	return size;
+}
+
+nyan::AssetStreamer::AssetStreamer() :
+	AssetStreamer(Settings{})
+{
+}
+
+nyan::AssetStreamer::AssetStreamer(const Settings& settings, Utility::JobSystem& jobSystem) :
+	m_settings(settings),
+	r_jobSystem(jobSystem)
+{
+	assert(m_settings.ioThreadCount > 0);
+	for (uint32_t i{ 0 }; i < std::max(m_settings.ioThreadCount, 1u); ++i)
+		m_ioThreads.emplace_back([this]() { io_loop(); });
+}
+
+nyan::AssetStreamer::~AssetStreamer()
+{
+	{
+		std::scoped_lock lock{ m_mutex };
+		m_shutdown = true;
+		for (auto& [id, entry] : m_entries)
+			if (entry.state == State::Queued || entry.state == State::Reading || entry.state == State::Decoding)
+				entry.state = State::Cancelled;
+		m_ioQueue.clear();
+	}
+	m_ioCondition.notify_all();
+	for (auto& thread : m_ioThreads)
+		thread.join();
+	//Decode jobs still reference the streamer
+	std::unique_lock lock{ m_mutex };
+	m_idleCondition.wait(lock, [&]() { return m_inFlight == 0; });
+}
+
+nyan::AssetRequestId nyan::AssetStreamer::request(Request request)
+{
+	assert(request.decoder);
+	AssetRequestId id;
+	{
+		std::scoped_lock lock{ m_mutex };
+		id = m_nextId++;
+		m_entries.emplace(id, Entry{ .request {std::move(request)} });
+		m_ioQueue.push_back(id);
+		std::push_heap(m_ioQueue.begin(), m_ioQueue.end(), [&](auto lhs, auto rhs) { return priority(lhs) > priority(rhs); });
+	}
+	m_ioCondition.notify_one();
+	return id;
+}
+
+bool nyan::AssetStreamer::cancel(AssetRequestId id)
+{
+	std::scoped_lock lock{ m_mutex };
+	auto it = m_entries.find(id);
+	if (it == m_entries.end())
+		return false;
+	auto& entry = it->second;
+	switch (entry.state) {
+	case State::Ready:
+		m_ready.erase(std::find(m_ready.begin(), m_ready.end(), id));
+		entry.payload.reset();
+		entry.state = State::Cancelled;
+		entry.request.decoder = nullptr;
+		return true;
+	case State::Queued:
+		//Out of the heap right away, it compares by the entry which may be erased before an I/O thread pops it
+		m_ioQueue.erase(std::find(m_ioQueue.begin(), m_ioQueue.end(), id));
+		std::make_heap(m_ioQueue.begin(), m_ioQueue.end(), [&](auto lhs, auto rhs) { return priority(lhs) > priority(rhs); });
+		if (m_ioQueue.empty() && m_inFlight == 0)
+			m_idleCondition.notify_all();
+		[[fallthrough]];
+	case State::Reading:
+	case State::Decoding:
+		entry.state = State::Cancelled;
+		entry.request.decoder = nullptr;
+		return true;
+	default:
+		return false;
+	}
+}
+
+nyan::AssetStreamer::State nyan::AssetStreamer::get_state(AssetRequestId id)
+{
+	std::scoped_lock lock{ m_mutex };
+	auto it = m_entries.find(id);
+	if (it == m_entries.end())
+		return State::Unknown;
+	const auto state = it->second.state;
+	if (state == State::Committed || state == State::Cancelled || state == State::Failed) {
+		if (it->second.busy)
+			it->second.observed = true;
+		else
+			m_entries.erase(it);
+	}
+	return state;
+}
+
+void nyan::AssetStreamer::set_camera_position(const Math::vec3& position)
+{
+	std::scoped_lock lock{ m_mutex };
+	m_cameraPosition = position;
+	std::make_heap(m_ioQueue.begin(), m_ioQueue.end(), [&](auto lhs, auto rhs) { return priority(lhs) > priority(rhs); });
+}
+
+nyan::AssetStreamer::Statistics nyan::AssetStreamer::commit(AssetUploadSink& sink)
+{
+	Statistics statistics{};
+	const auto start = std::chrono::steady_clock::now();
+	{
+		//Best candidate last
+		std::scoped_lock lock{ m_mutex };
+		std::sort(m_ready.begin(), m_ready.end(), [&](auto lhs, auto rhs) { return priority(lhs) > priority(rhs); });
+	}
+	while (true) {
+		AssetRequestId id;
+		std::unique_ptr<AssetPayload> payload;
+		{
+			std::scoped_lock lock{ m_mutex };
+			if (m_ready.empty())
+				break;
+			id = m_ready.back();
+			auto& entry = m_entries.at(id);
+			const auto size = entry.payload->upload_size();
+			if (statistics.committedAssets && statistics.committedBytes + size > m_settings.frameByteBudget)
+				break;
+			m_ready.pop_back();
+			payload = std::move(entry.payload);
+			entry.state = State::Committed;
+			entry.request.decoder = nullptr;
+		}
+		sink.upload(id, *payload);
+		statistics.committedAssets++;
+		statistics.committedBytes += payload->upload_size();
+		if (std::chrono::steady_clock::now() - start >= m_settings.frameTimeBudget)
+			break;
+	}
+	std::scoped_lock lock{ m_mutex };
+	statistics.deferredAssets = m_ready.size();
+	return statistics;
+}
+
+void nyan::AssetStreamer::wait_idle()
+{
+	std::unique_lock lock{ m_mutex };
+	m_idleCondition.wait(lock, [&]() { return m_inFlight == 0 && m_ioQueue.empty(); });
+}
+
+float nyan::AssetStreamer::priority(AssetRequestId id) const
+{
+	const auto& request = m_entries.at(id).request;
+	return (request.position - m_cameraPosition).L2_norm() - request.priorityBias;
+}
+
+void nyan::AssetStreamer::io_loop()
+{
+	while (true) {
+		AssetRequestId id;
+		std::filesystem::path path;
+		{
+			std::unique_lock lock{ m_mutex };
+			m_ioCondition.wait(lock, [&]() { return m_shutdown || !m_ioQueue.empty(); });
+			if (m_shutdown)
+				return;
+			std::pop_heap(m_ioQueue.begin(), m_ioQueue.end(), [&](auto lhs, auto rhs) { return priority(lhs) > priority(rhs); });
+			id = m_ioQueue.back();
+			m_ioQueue.pop_back();
+			auto& entry = m_entries.at(id);
+			assert(entry.state == State::Queued);
+			entry.state = State::Reading;
+			entry.busy = true;
+			path = entry.request.path;
+			m_inFlight++;
+		}
+		Utility::MappedFile file;
+		const auto read = streamer_map_file(path, file);
+		AssetDecoder decoder;
+		{
+			std::scoped_lock lock{ m_mutex };
+			auto& entry = m_entries.at(id);
+			if (entry.state == State::Reading) {
+				if (read) {
+					entry.state = State::Decoding;
+					decoder = entry.request.decoder;
+				}
+				else {
+					Utility::log_warning().format("AssetStreamer: Couldn't read \"{}\"", path.string());
+					entry.state = State::Failed;
+				}
+			}
+		}
+		if (!decoder) {
+			finish_in_flight(id);
+			continue;
+		}
+		static_cast<void>(r_jobSystem.submit([this, id, decoder = std::move(decoder), path = std::move(path), file = std::move(file)]() mutable {
+			decode(id, std::move(decoder), std::move(path), std::move(file));
+		}));
+	}
+}
+
+void nyan::AssetStreamer::decode(AssetRequestId id, AssetDecoder decoder, std::filesystem::path path, Utility::MappedFile file)
+{
+	std::unique_ptr<AssetPayload> payload;
+	bool cancelled;
+	{
+		std::scoped_lock lock{ m_mutex };
+		cancelled = m_entries.at(id).state != State::Decoding;
+	}
+	if (!cancelled) {
+		try {
+			payload = decoder(path, file.span());
+			if (!payload)
+				Utility::log_warning().format("AssetStreamer: Couldn't decode \"{}\"", path.string());
+		}
+		catch (const std::exception& e) {
+			Utility::log_warning().format("AssetStreamer: Couldn't decode \"{}\": {}", path.string(), e.what());
+		}
+	}
+	{
+		std::scoped_lock lock{ m_mutex };
+		auto& entry = m_entries.at(id);
+		if (entry.state == State::Decoding) {
+			if (payload) {
+				entry.state = State::Ready;
+				entry.payload = std::move(payload);
+				m_ready.push_back(id);
+			}
+			else {
+				entry.state = State::Failed;
+			}
+		}
+	}
+	//Unmapped before the entry is released
+	file = Utility::MappedFile{};
+	finish_in_flight(id);
+}
+
+void nyan::AssetStreamer::finish_in_flight(AssetRequestId id)
+{
+	std::scoped_lock lock{ m_mutex };
+	auto it = m_entries.find(id);
+	assert(it != m_entries.end());
+	it->second.busy = false;
+	if (it->second.observed)
+		m_entries.erase(it);
+	assert(m_inFlight);
+	m_inFlight--;
+	if (m_inFlight == 0)
+		m_idleCondition.notify_all();
+}
@@ -0,0 +1,226 @@
+#include "Renderer/Bounds.h"
+#include "Renderer/Mesh.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#define BOUNDS_SSE
+#include <xmmintrin.h>
+#endif
+
+static_assert(sizeof(Math::vec3) == 3 * sizeof(float), "The box reduction reads positions as a flat float array");
+
+//Four positions are twelve floats, float j of a block always belongs to axis j % 3
+static constexpr size_t boundsBlockFloats{ 12 };
+
+//EPOS-14 directions, the three axes and the four cube diagonals, normalization is not needed for finding extremal points
+static const std::array<Math::vec3, 7> boundsDirections{
+	Math::vec3{ 1.f, 0.f, 0.f },
+	Math::vec3{ 0.f, 1.f, 0.f },
+	Math::vec3{ 0.f, 0.f, 1.f },
+	Math::vec3{ 1.f, 1.f, 1.f },
+	Math::vec3{ 1.f, 1.f, -1.f },
+	Math::vec3{ 1.f, -1.f, 1.f },
+	Math::vec3{ 1.f, -1.f, -1.f },
+};
+
+static void bounds_grow(nyan::BoundingSphere& sphere, const Math::vec3& point)
+{
+	const auto offset = point - sphere.center;
+	const auto distanceSquare = offset.L2_square();
+	if (distanceSquare <= sphere.radius * sphere.radius)
+		return;
+	const auto distance = std::sqrt(distanceSquare);
+	const auto radius = (sphere.radius + distance) * 0.5f;
+	sphere.center += offset * ((radius - sphere.radius) / distance);
+	sphere.radius = radius;
+}
+
+nyan::BoundingBox nyan::BoundsCalculator::compute_box(std::span<const Math::vec3> positions)
+{
+	BoundingBox box;
+	const auto count = positions.size();
+	if (!count)
+		return box;
+	const float* data = &positions[0][0];
+	size_t i{ 0 };
+	if (count >= 4) {
+		std::array<float, boundsBlockFloats> mins;
+		std::array<float, boundsBlockFloats> maxs;
+#ifdef BOUNDS_SSE
+		auto minA = _mm_loadu_ps(data);
+		auto minB = _mm_loadu_ps(data + 4);
+		auto minC = _mm_loadu_ps(data + 8);
+		auto maxA = minA;
+		auto maxB = minB;
+		auto maxC = minC;
+		for (i = 4; i + 4 <= count; i += 4) {
+			const auto* block = data + i * 3;
+			const auto a = _mm_loadu_ps(block);
+			const auto b = _mm_loadu_ps(block + 4);
+			const auto c = _mm_loadu_ps(block + 8);
+			minA = _mm_min_ps(minA, a);
+			minB = _mm_min_ps(minB, b);
+			minC = _mm_min_ps(minC, c);
+			maxA = _mm_max_ps(maxA, a);
+			maxB = _mm_max_ps(maxB, b);
+			maxC = _mm_max_ps(maxC, c);
+		}
+		_mm_storeu_ps(mins.data(), minA);
+		_mm_storeu_ps(mins.data() + 4, minB);
+		_mm_storeu_ps(mins.data() + 8, minC);
+		_mm_storeu_ps(maxs.data(), maxA);
+		_mm_storeu_ps(maxs.data() + 4, maxB);
+		_mm_storeu_ps(maxs.data() + 8, maxC);
+#else
+		std::copy(data, data + boundsBlockFloats, mins.begin());
+		std::copy(data, data + boundsBlockFloats, maxs.begin());
+		for (i = 4; i + 4 <= count; i += 4) {
+			const auto* block = data + i * 3;
+			for (size_t j{ 0 }; j < boundsBlockFloats; ++j) {
+				mins[j] = std::min(mins[j], block[j]);
+				maxs[j] = std::max(maxs[j], block[j]);
+			}
+		}
+#endif
+		for (size_t j{ 0 }; j < boundsBlockFloats; ++j) {
+			box.min[j % 3] = std::min(box.min[j % 3], mins[j]);
+			box.max[j % 3] = std::max(box.max[j % 3], maxs[j]);
+		}
+	}
+	for (; i < count; ++i) {
+		for (size_t axis{ 0 }; axis < 3; ++axis) {
+			box.min[axis] = std::min(box.min[axis], positions[i][axis]);
+			box.max[axis] = std::max(box.max[axis], positions[i][axis]);
+		}
+	}
+	return box;
+}
+
+nyan::BoundingBox nyan::BoundsCalculator::compute_box(std::span<const Math::vec3> positions, std::span<const uint32_t> indices)
+{
+	BoundingBox box;
+	for (auto index : indices) {
+		assert(index < positions.size());
+		for (size_t axis{ 0 }; axis < 3; ++axis) {
+			box.min[axis] = std::min(box.min[axis], positions[index][axis]);
+			box.max[axis] = std::max(box.max[axis], positions[index][axis]);
+		}
+	}
+	return box;
+}
+
+nyan::BoundingSphere nyan::BoundsCalculator::compute_sphere(std::span<const Math::vec3> positions)
+{
+	BoundingSphere sphere;
+	if (positions.empty())
+		return sphere;
+	std::array<size_t, boundsDirections.size()> minPoints{};
+	std::array<size_t, boundsDirections.size()> maxPoints{};
+	std::array<float, boundsDirections.size()> minProjections;
+	std::array<float, boundsDirections.size()> maxProjections;
+	for (size_t k{ 0 }; k < boundsDirections.size(); ++k)
+		minProjections[k] = maxProjections[k] = boundsDirections[k].dot(positions[0]);
+	for (size_t i{ 1 }; i < positions.size(); ++i) {
+		for (size_t k{ 0 }; k < boundsDirections.size(); ++k) {
+			const auto projection = boundsDirections[k].dot(positions[i]);
+			if (projection < minProjections[k]) {
+				minProjections[k] = projection;
+				minPoints[k] = i;
+			}
+			if (projection > maxProjections[k]) {
+				maxProjections[k] = projection;
+				maxPoints[k] = i;
+			}
+		}
+	}
+	//The most distant extremal pair is the initial diameter, the remaining extremal points grow it first
+	size_t best{ 0 };
+	float bestDistance{ -1.f };
+	for (size_t k{ 0 }; k < boundsDirections.size(); ++k) {
+		const auto distance = (positions[maxPoints[k]] - positions[minPoints[k]]).L2_square();
+		if (distance > bestDistance) {
+			bestDistance = distance;
+			best = k;
+		}
+	}
+	sphere.center = (positions[minPoints[best]] + positions[maxPoints[best]]) * 0.5f;
+	sphere.radius = std::sqrt(bestDistance) * 0.5f;
+	for (size_t k{ 0 }; k < boundsDirections.size(); ++k) {
+		bounds_grow(sphere, positions[minPoints[k]]);
+		bounds_grow(sphere, positions[maxPoints[k]]);
+	}
+	for (const auto& position : positions)
+		bounds_grow(sphere, position);
+	//Growing only ever overestimates, the exact radius around the final center is never larger
+	float radiusSquare{ 0.f };
+	for (const auto& position : positions)
+		radiusSquare = std::max(radiusSquare, (position - sphere.center).L2_square());
+	sphere.radius = std::sqrt(radiusSquare);
+	return sphere;
+}
+
+nyan::BoundingSphere nyan::BoundsCalculator::compute_sphere(std::span<const Math::vec3> positions, std::span<const uint32_t> indices)
+{
+	std::vector<Math::vec3> gathered;
+	gathered.reserve(indices.size());
+	for (auto index : indices) {
+		assert(index < positions.size());
+		gathered.push_back(positions[index]);
+	}
+	return compute_sphere(gathered);
+}
+
+nyan::MeshBounds nyan::BoundsCalculator::compute(std::span<const Math::vec3> positions)
+{
+	return MeshBounds{
+		.box {compute_box(positions)},
+		.sphere {compute_sphere(positions)},
+	};
+}
+
+void nyan::BoundsCalculator::compute(nyan::Mesh& mesh)
+{
+	mesh.bounds = compute(mesh.positions);
+	for (auto& submesh : mesh.submeshes) {
+		assert(submesh.firstIndex + submesh.indexCount <= mesh.indices.size());
+		const std::span<const uint32_t> indices{ mesh.indices.data() + submesh.firstIndex, submesh.indexCount };
+		submesh.bounds = MeshBounds{
+			.box {compute_box(mesh.positions, indices)},
+			.sphere {compute_sphere(mesh.positions, indices)},
+		};
+	}
+}
+
+nyan::MeshBounds nyan::BoundsCalculator::transform(const MeshBounds& bounds, const Math::Mat<float, 3, 4, false>& transform)
+{
+	auto transform_point = [&](const Math::vec3& point) {
+		Math::vec3 result{ 0.f };
+		for (size_t row{ 0 }; row < 3; ++row)
+			result[row] = transform(0, row) * point[0] + transform(1, row) * point[1] + transform(2, row) * point[2] + transform(3, row);
+		return result;
+	};
+	MeshBounds result;
+	if (bounds.box.valid()) {
+		const auto center = transform_point(bounds.box.center());
+		const auto extent = bounds.box.extent();
+		Math::vec3 worldExtent{ 0.f };
+		for (size_t row{ 0 }; row < 3; ++row)
+			for (size_t col{ 0 }; col < 3; ++col)
+				worldExtent[row] += std::abs(transform(col, row)) * extent[col];
+		result.box = BoundingBox{
+			.min {center - worldExtent},
+			.max {center + worldExtent},
+		};
+	}
+	if (bounds.sphere.valid()) {
+		float scaleSquare{ 0.f };
+		for (size_t col{ 0 }; col < 3; ++col)
+			scaleSquare = std::max(scaleSquare, transform(col, 0) * transform(col, 0) + transform(col, 1) * transform(col, 1) + transform(col, 2) * transform(col, 2));
+		result.sphere = BoundingSphere{
+			.center {transform_point(bounds.sphere.center)},
+			.radius {bounds.sphere.radius * std::sqrt(scaleSquare)},
+		};
+	}
+	return result;
+}
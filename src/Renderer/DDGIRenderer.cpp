@@ -32,6 +32,8 @@ nyan::DDGIRenderer::DDGIRenderer(vulkan::LogicalDevice& device, entt::registry&
 	//dstBuf2 = std::make_unique< vulkan::BufferHandle>(r_device.create_buffer(info, {}));
 
 	pass.add_renderfunction(std::bind(&DDGIRenderer::render, this, std::placeholders::_1, std::placeholders::_2), false);
+	//Probe tracing, border copies and relocation only read the scene, they can overlap the G-Buffer
+	pass.allow_async_compute();
 }
 
 void nyan::DDGIRenderer::begin_frame() 
@@ -164,6 +166,9 @@ void nyan::DDGIRenderer::render(vulkan::CommandBuffer& cmd, nyan::Renderpass&)
 			.numRows {rtConfig.numRows}
 		};
 		auto& rtPipeline = get_rt_pipeline(rtConfig);
+		//The volume keeps its last update until the pipeline finished compiling
+		if (!rtPipeline.update())
+			continue;
 		if (m_clear) {
 			auto& res = r_renderManager.get_render_graph().get_resource(parameters.irradianceResource);
 			auto& res0 = r_renderManager.get_render_graph().get_resource(parameters.data0Resource);
@@ -880,7 +885,9 @@ nyan::DDGIVisualizer::DDGIVisualizer(vulkan::LogicalDevice& device, entt::regist
 	create_pipeline();
 	r_pass.add_renderfunction([this, &ddgiManager](vulkan::CommandBuffer& cmd, nyan::Renderpass&)
 		{
-
+			//The visualizer is skipped while its pipeline still compiles in the background
+			if (m_pipeline == vulkan::invalidPipelineId)
+				return;
 			auto pipelineBind = cmd.bind_graphics_pipeline(m_pipeline);
 
 			auto [viewport, scissor] = r_device.get_swapchain_viewport_and_scissor();
@@ -942,7 +949,7 @@ void nyan::DDGIVisualizer::create_pipeline()
 	visualizerConfig.dynamicState.cull_mode = VK_CULL_MODE_NONE;
 	visualizerConfig.dynamicState.stencil_test_enable = VK_FALSE;
 
-	r_pass.add_pipeline(visualizerConfig, &m_pipeline);
+	r_pass.add_pipeline(visualizerConfig, &m_pipeline, vulkan::invalidPipelineId);
 }
 
 
@@ -1358,6 +1365,8 @@ void nyan::DDGIReSTIRRenderer::generate_samples(vulkan::CommandBuffer& cmd, cons
 		.maxPathLength {volume.maxPathLength},
 	};
 	auto& rtPipeline = get_sample_generation_pipeline(rtConfig);
+	if (!rtPipeline.update())
+		return;
 	r_renderManager.get_profiler().begin_profile(cmd, "Generate Samples");
 	static constexpr auto renderTargetWidth = 11ul;
 	const std::array dispatch{
@@ -1385,6 +1394,8 @@ void nyan::DDGIReSTIRRenderer::validate_samples(vulkan::CommandBuffer& cmd, cons
 		.maxPathLength {volume.maxPathLength},
 	};
 	auto& rtPipeline = get_sample_validation_pipeline(rtConfig);
+	if (!rtPipeline.update())
+		return;
 	r_renderManager.get_profiler().begin_profile(cmd, "Validate Samples");
 	const std::array dispatch{
 		volume.probeCountX * volume.irradianceProbeSize,
@@ -122,6 +122,8 @@ nyan::DeferredRayShadowsLighting::DeferredRayShadowsLighting(vulkan::LogicalDevi
 	renderManager.get_ddgi_restir_manager().add_read(pass.get_id());
 	pass.add_renderfunction([this](vulkan::CommandBuffer& cmd, nyan::Renderpass&)
 		{
+			if (!m_pipeline.update())
+				return;
 			auto pipelineBind = cmd.bind_raytracing_pipeline(m_pipeline);
 
 			render(pipelineBind);
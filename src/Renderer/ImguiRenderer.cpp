@@ -370,7 +370,8 @@ nyan::ImguiRenderer::ImguiRenderer(LogicalDevice& device, entt::registry& regist
 	{
 		ImGui::Render();
 		ImDrawData* drawData = ImGui::GetDrawData();
-		if (drawData->TotalVtxCount > 0)
+		//Nothing is drawn while the pipeline still compiles in the background
+		if (drawData->TotalVtxCount > 0 && m_pipeline != vulkan::invalidPipelineId)
 		{
 			prep_buffer(drawData);
 			create_cmds(drawData, cmd);
@@ -640,7 +641,7 @@ void nyan::ImguiRenderer::set_up_pipeline(vulkan::ShaderManager& shaderManager,
 	config.dynamicState.depth_write_enable = VK_FALSE;
 	config.dynamicState.depth_test_enable = VK_FALSE;
 	config.dynamicState.cull_mode = VK_CULL_MODE_NONE;
-	pass.add_pipeline(config, &m_pipeline);
+	pass.add_pipeline(config, &m_pipeline, vulkan::invalidPipelineId);
 }
 
 void nyan::ImguiRenderer::set_up_font()
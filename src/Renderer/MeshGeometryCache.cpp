@@ -0,0 +1,47 @@
+#include "Renderer/MeshGeometryCache.h"
+
+nyan::MeshGeometryCache::MeshGeometryCache(MeshUploadBackend& backend) :
+	r_backend(backend)
+{
+}
+
+nyan::MeshGeometryCache::Result nyan::MeshGeometryCache::acquire(const QuantizedMesh& mesh)
+{
+	auto key = compute_key(mesh);
+	if (auto it = m_geometries.find(key); it != m_geometries.end()) {
+		m_statistics.sharedMeshes++;
+		m_statistics.savedBytes += key.byteSize;
+		return Result{
+			.geometry {it->second},
+			.shared {true},
+		};
+	}
+	auto geometry = r_backend.upload_geometry(mesh);
+	m_geometries.emplace(key, geometry);
+	m_statistics.uploads++;
+	m_statistics.uploadedBytes += key.byteSize;
+	return Result{
+		.geometry {geometry},
+		.shared {false},
+	};
+}
+
+nyan::MeshGeometryKey nyan::MeshGeometryCache::compute_key(const QuantizedMesh& mesh)
+{
+	//The render type decides the acceleration structure geometry flags, the position transform is part of the geometry buffer
+	Utility::StreamHasher hasher;
+	const auto type = static_cast<uint32_t>(mesh.type);
+	hasher.update(&type, sizeof(type));
+	hasher.update(&mesh.positionOffset, sizeof(mesh.positionOffset));
+	hasher.update(&mesh.positionScale, sizeof(mesh.positionScale));
+	hasher.update(mesh.shortIndices);
+	hasher.update(mesh.indices);
+	hasher.update(mesh.positions);
+	hasher.update(mesh.uvs0);
+	hasher.update(mesh.normals);
+	hasher.update(mesh.tangents);
+	return MeshGeometryKey{
+		.hash {hasher.finish()},
+		.byteSize {MeshQuantizer::index_byte_size(mesh) + MeshQuantizer::vertex_byte_size(mesh)},
+	};
+}
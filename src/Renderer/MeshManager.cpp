@@ -6,11 +6,31 @@
 using namespace vulkan;
 using namespace nyan;
 
+static constexpr VkDeviceSize meshIndexWordSize{ sizeof(uint32_t) };
+static constexpr VkDeviceSize meshPositionStride{ sizeof(decltype(nyan::QuantizedMesh::positions)::value_type) };
+static constexpr VkDeviceSize meshTexCoordStride{ sizeof(decltype(nyan::QuantizedMesh::uvs0)::value_type) };
+static constexpr VkDeviceSize meshNormalStride{ sizeof(decltype(nyan::QuantizedMesh::normals)::value_type) };
+static constexpr VkDeviceSize meshTangentStride{ sizeof(decltype(nyan::QuantizedMesh::tangents)::value_type) };
+
+static VkBufferUsageFlags mesh_arena_usage(bool buildAccelerationStructures)
+{
+	VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+		VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	if (buildAccelerationStructures)
+		usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+			| VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+	return usage;
+}
+
 nyan::MeshManager::MeshManager(vulkan::LogicalDevice& device, nyan::MaterialManager& materialManager, bool buildAccelerationStructures) :
 	DataManager(device),
 	r_materialManager(materialManager),
 	m_builder(std::make_unique<AccelerationStructureBuilder>(r_device)),
-	m_buildAccs(buildAccelerationStructures)
+	m_buildAccs(buildAccelerationStructures),
+	m_geometryCache(*this)
 {
 }
 nyan::MeshManager::~MeshManager()
@@ -18,100 +38,216 @@ nyan::MeshManager::~MeshManager()
 }
 nyan::MeshID nyan::MeshManager::add_mesh(const nyan::Mesh& data)
 {
+	return add_mesh(MeshQuantizer::quantize(data));
+}
+nyan::MeshID nyan::MeshManager::add_mesh(const nyan::QuantizedMesh& data)
+{
+	return add_mesh(data, data.materialBinding);
+}
+nyan::MeshID nyan::MeshManager::add_mesh(const nyan::QuantizedMesh& data, nyan::MaterialId materialBinding)
+{
+	auto geometryId = m_geometryCache.acquire(data).geometry;
+	//Meshes quantized without bounds fall back to the conservative quantization range
+	const auto bounds = data.bounds.valid() ? data.bounds : MeshBounds{
+		.box {
+			.min {data.positionOffset - data.positionScale},
+			.max {data.positionOffset + data.positionScale},
+		},
+		.sphere {
+			.center {data.positionOffset},
+			.radius {data.positionScale.L2_norm()},
+		},
+	};
+	const auto& geometry = m_geometries[geometryId];
+	const auto& arena = m_arenas[geometry.arena];
+	const VkDeviceSize vertexOffset { geometry.vertices.offset };
+
+	auto id = add(nyan::shaders::Mesh {
+		.materialBinding { r_materialManager.get_binding() },
+		.materialId {(materialBinding == nyan::shaders::INVALID_BINDING) ? r_materialManager.get_material(data.material) : materialBinding },
+		.indicesAddress { arena.indexBuffer->get_address() + geometry.indices.offset * meshIndexWordSize },
+		.positionsAddress { arena.positionBuffer->get_address() + vertexOffset * meshPositionStride },
+		.uvsAddress { arena.texCoordBuffer->get_address() + vertexOffset * meshTexCoordStride },
+		.normalsAddress { arena.normalBuffer->get_address() + vertexOffset * meshNormalStride },
+		.tangentsAddress { arena.tangentBuffer->get_address() + vertexOffset * meshTangentStride },
+		.positionOffset { data.positionOffset },
+		.flags { data.uses_short_indices() ? nyan::shaders::MESH_SHORT_INDICES_FLAG : 0u },
+		.positionScale { data.positionScale },
+		.boundsRadius { bounds.sphere.radius },
+		.boundsCenter { bounds.sphere.center },
+		.pad0 { 0.f },
+		.boundsMin { bounds.box.min },
+		.pad1 { 0.f },
+		.boundsMax { bounds.box.max },
+		.pad2 { 0.f },
+		});
+	m_meshGeometries.emplace(id, geometryId);
+	m_meshIndex.emplace(data.name, id);
+	return id;
+}
+
+nyan::MeshGeometryID nyan::MeshManager::upload_geometry(const nyan::QuantizedMesh& data)
+{
+	auto geometryId = static_cast<MeshGeometryID>(m_geometries.size());
+	const auto vertexCount = static_cast<uint32_t>(data.positions.size());
+	const auto indexWords = static_cast<uint32_t>(Utility::align_up(MeshQuantizer::index_byte_size(data), meshIndexWordSize) / meshIndexWordSize);
+	auto mesh = allocate_geometry(vertexCount, indexWords);
+	const auto& arena = m_arenas[mesh.arena];
+	const auto indexType { data.uses_short_indices() ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32 };
+	const VkDeviceSize vertexOffset { mesh.vertices.offset };
+
 	std::vector<vulkan::InputData> inputData;
-	std::vector<uint32_t> offsets;
-	inputData.push_back(InputData{ .ptr = data.indices.data(), .size = data.indices.size() * sizeof(decltype(data.indices)::value_type) });
-	inputData.push_back(InputData{ .ptr = data.positions.data(), .size = data.positions.size() * sizeof(decltype(data.positions)::value_type) });
-	inputData.push_back(InputData{ .ptr = data.uvs0.data(), .size = data.uvs0.size() * sizeof(decltype(data.uvs0)::value_type) });
-	inputData.push_back(InputData{ .ptr = data.normals.data(), .size = data.normals.size() * sizeof(decltype(data.normals)::value_type) });
-	inputData.push_back(InputData{ .ptr = data.tangents.data(), .size = data.tangents.size() * sizeof(decltype(data.tangents)::value_type) });
-	uint32_t offset = 0;
+	std::vector<std::pair<const vulkan::Buffer*, VkDeviceSize>> destinations;
+	if (data.uses_short_indices())
+		inputData.push_back(InputData{ .ptr = data.shortIndices.data(), .size = data.shortIndices.size() * sizeof(decltype(data.shortIndices)::value_type) });
+	else
+		inputData.push_back(InputData{ .ptr = data.indices.data(), .size = data.indices.size() * sizeof(decltype(data.indices)::value_type) });
+	destinations.emplace_back(&*arena.indexBuffer, mesh.indices.offset * meshIndexWordSize);
+	inputData.push_back(InputData{ .ptr = data.positions.data(), .size = data.positions.size() * meshPositionStride });
+	destinations.emplace_back(&*arena.positionBuffer, vertexOffset * meshPositionStride);
+	inputData.push_back(InputData{ .ptr = data.uvs0.data(), .size = data.uvs0.size() * meshTexCoordStride });
+	destinations.emplace_back(&*arena.texCoordBuffer, vertexOffset * meshTexCoordStride);
+	inputData.push_back(InputData{ .ptr = data.normals.data(), .size = data.normals.size() * meshNormalStride });
+	destinations.emplace_back(&*arena.normalBuffer, vertexOffset * meshNormalStride);
+	inputData.push_back(InputData{ .ptr = data.tangents.data(), .size = data.tangents.size() * meshTangentStride });
+	destinations.emplace_back(&*arena.tangentBuffer, vertexOffset * meshTangentStride);
+	//The BLAS is built from the quantized positions, the geometry transform dequantizes them
+	const VkTransformMatrixKHR dequantization{
+		.matrix {
+			{ data.positionScale[0], 0.f, 0.f, data.positionOffset[0] },
+			{ 0.f, data.positionScale[1], 0.f, data.positionOffset[1] },
+			{ 0.f, 0.f, data.positionScale[2], data.positionOffset[2] },
+		}
+	};
+	if (m_buildAccs) {
+		inputData.push_back(InputData{ .ptr = &dequantization, .size = sizeof(dequantization) });
+		destinations.emplace_back(&**arena.transformBuffer, mesh.transform.offset * sizeof(VkTransformMatrixKHR));
+	}
+	VkDeviceSize stagingSize = 0;
 	for (auto& inputDate : inputData) {
 		inputDate.stride = Utility::align_up(inputDate.size, 16ull);
-		offsets.push_back(offset);
-		offset += static_cast<uint32_t>(inputDate.stride);
+		stagingSize += inputDate.stride;
 	}
-	vulkan::BufferInfo info{
-		.size = offset,
-		.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
-				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | 
-				VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+	vulkan::BufferInfo stagingInfo{
+		.size = stagingSize,
+		.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 		.offset = 0,
-		.memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY
-
+		.memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY
 	};
-	if (m_buildAccs) {
-		info.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT 
-			| VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
-	}
-	VkIndexType indexType { VK_INDEX_TYPE_UINT32 };
-	if constexpr (std::is_same_v<decltype(data.indices)::value_type, uint32_t>) {
-		indexType = VK_INDEX_TYPE_UINT32;
+	auto stagingBuffer = r_device.create_buffer(stagingInfo, inputData);
+	auto cmd = r_device.request_command_buffer(CommandBufferType::Transfer);
+	VkDeviceSize stagingOffset = 0;
+	for (size_t i = 0; i < inputData.size(); ++i) {
+		if (inputData[i].size)
+			cmd->copy_buffer(*destinations[i].first, *stagingBuffer, destinations[i].second, stagingOffset, inputData[i].size);
+		stagingOffset += inputData[i].stride;
 	}
-	if constexpr (std::is_same_v<decltype(data.indices)::value_type, uint16_t>) {
-		indexType = VK_INDEX_TYPE_UINT16;
-	}
-
-	MeshManager::Mesh mesh{
-		.buffer = r_device.create_buffer(info, inputData),
-		.offset {0},
-		.mesh {
-			.indexCount {static_cast<uint32_t>(data.indices.size())},
-			.firstIndex {0},
-			.vertexOffset {0},
-			.firstInstance {0},
-
-			.indexBuffer {mesh.buffer->get_handle()},
-			.indexOffset {offsets[0]},
-			.indexType {indexType},
-			.vertexBuffers {
-				.positionBuffer {mesh.buffer->get_handle()},
-				.texCoordBuffer {mesh.buffer->get_handle()},
-				.normalBuffer {mesh.buffer->get_handle()},
-				.tangentBuffer {mesh.buffer->get_handle()},
-			},
-			.vertexOffsets {
-				.positionOffset {offsets[1]},
-				.texCoordOffset {offsets[2]},
-				.normalOffset {offsets[3]},
-				.tangentOffset {offsets[4]},
-			},
-		}
+	r_device.submit_staging(cmd, mesh_arena_usage(m_buildAccs), true);
+
+	//All meshes of an arena bind the same buffers, the allocation offsets go into the draw parameters
+	mesh.mesh = StaticTangentVulkanMesh{
+		.indexCount {static_cast<uint32_t>(data.index_count())},
+		.firstIndex {mesh.indices.offset * static_cast<uint32_t>(meshIndexWordSize / (data.uses_short_indices() ? sizeof(uint16_t) : sizeof(uint32_t)))},
+		.vertexOffset {static_cast<int32_t>(mesh.vertices.offset)},
+		.firstInstance {0},
+
+		.indexBuffer {arena.indexBuffer->get_handle()},
+		.indexOffset {0},
+		.indexType {indexType},
+		.vertexBuffers {
+			.positionBuffer {arena.positionBuffer->get_handle()},
+			.texCoordBuffer {arena.texCoordBuffer->get_handle()},
+			.normalBuffer {arena.normalBuffer->get_handle()},
+			.tangentBuffer {arena.tangentBuffer->get_handle()},
+		},
+		.vertexOffsets {
+			.positionOffset {0},
+			.texCoordOffset {0},
+			.normalOffset {0},
+			.tangentOffset {0},
+		},
 	};
-	auto addr = mesh.buffer->get_address();
-
-	auto id = add(nyan::shaders::Mesh {
-		.materialBinding { r_materialManager.get_binding() },
-		.materialId {(data.materialBinding == nyan::shaders::INVALID_BINDING) ? r_materialManager.get_material(data.material) : data.materialBinding },
-		.indicesAddress { addr + mesh.mesh.indexOffset },
-		.positionsAddress { addr + mesh.mesh.vertexOffsets.positionOffset },
-		.uvsAddress { addr + mesh.mesh.vertexOffsets.texCoordOffset },
-		.normalsAddress { addr + mesh.mesh.vertexOffsets.normalOffset },
-		.tangentsAddress { addr + mesh.mesh.vertexOffsets.tangentOffset },
-		});
 
 	if (m_buildAccs) {
 		vulkan::AccelerationStructureBuilder::BLASInfo blasInfo{
 			.vertexBuffer { mesh.mesh.vertexBuffers.positionBuffer },
-			.vertexCount { static_cast<uint32_t>(data.positions.size()) },
-			.vertexOffset { mesh.mesh.vertexOffsets.positionOffset },
+			.vertexCount { vertexCount },
+			.vertexOffset { vertexOffset * meshPositionStride },
 			.vertexFormat { get_format<decltype(data.positions)::value_type>() },
 			.vertexStride { format_bytesize<decltype(data.positions)::value_type>() },
 			.indexBuffer { mesh.mesh.indexBuffer },
 			.indexCount {mesh.mesh.indexCount},
-			.indexOffset { mesh.mesh.indexOffset },
-			.transformBuffer { VK_NULL_HANDLE },
-			.transformOffset { 0 },
+			.indexOffset { mesh.indices.offset * meshIndexWordSize },
+			.transformBuffer { (*arena.transformBuffer)->get_handle() },
+			.transformOffset { static_cast<uint32_t>(mesh.transform.offset * sizeof(VkTransformMatrixKHR)) },
 			.indexType { mesh.mesh.indexType },
 			.geometryFlags {(data.type == nyan::Mesh::RenderType::Opaque) ? VK_GEOMETRY_OPAQUE_BIT_KHR : VkGeometryFlagsKHR{VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_NV }},
 		};
 		auto ret = m_builder->queue_item(blasInfo);
 		if(ret)
-			m_pendingAccBuildIndex.emplace_back( *ret, id);
+			m_pendingAccBuildIndex.emplace_back( *ret, geometryId);
 	}
-	m_staticTangentMeshes.emplace(id, mesh);
-	m_meshIndex.emplace(data.name, id);
-	return id;
+	m_geometries.push_back(std::move(mesh));
+	return geometryId;
+}
+
+uint32_t nyan::MeshManager::create_arena(uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+	const auto usage = mesh_arena_usage(m_buildAccs);
+	auto create = [&](VkDeviceSize size) {
+		return r_device.create_buffer(vulkan::BufferInfo{
+			.size = size,
+			.usage = usage,
+			.offset = 0,
+			.memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY
+		}, {});
+	};
+	auto arenaId = static_cast<uint32_t>(m_arenas.size());
+	m_arenas.push_back(GeometryArena{
+		.indexBuffer {create(indexCapacity * meshIndexWordSize)},
+		.positionBuffer {create(vertexCapacity * meshPositionStride)},
+		.texCoordBuffer {create(vertexCapacity * meshTexCoordStride)},
+		.normalBuffer {create(vertexCapacity * meshNormalStride)},
+		.tangentBuffer {create(vertexCapacity * meshTangentStride)},
+		.transformBuffer {m_buildAccs ? std::optional<vulkan::BufferHandle>{create(arenaTransformCapacity * sizeof(VkTransformMatrixKHR))} : std::nullopt},
+		.indexAllocator {Utility::OffsetAllocator{indexCapacity}},
+		.vertexAllocator {Utility::OffsetAllocator{vertexCapacity}},
+		.transformAllocator {Utility::OffsetAllocator{m_buildAccs ? arenaTransformCapacity : 0u}},
+	});
+	return arenaId;
+}
+
+nyan::MeshManager::Mesh nyan::MeshManager::allocate_geometry(uint32_t vertexCount, uint32_t indexWords)
+{
+	auto try_allocate = [&](uint32_t arenaId) -> std::optional<MeshManager::Mesh> {
+		auto& arena = m_arenas[arenaId];
+		auto vertices = arena.vertexAllocator.allocate(vertexCount);
+		if (!vertices.valid())
+			return std::nullopt;
+		auto indices = arena.indexAllocator.allocate(indexWords);
+		Utility::OffsetAllocator::Allocation transform{};
+		if (m_buildAccs && indices.valid())
+			transform = arena.transformAllocator.allocate(1);
+		if (!indices.valid() || (m_buildAccs && !transform.valid())) {
+			arena.vertexAllocator.free(vertices);
+			arena.indexAllocator.free(indices);
+			return std::nullopt;
+		}
+		return MeshManager::Mesh{
+			.arena {arenaId},
+			.indices {indices},
+			.vertices {vertices},
+			.transform {transform},
+			.accStructure {std::nullopt},
+			.mesh {},
+		};
+	};
+	for (uint32_t arenaId = 0; arenaId < m_arenas.size(); ++arenaId)
+		if (auto mesh = try_allocate(arenaId); mesh)
+			return *mesh;
+	auto mesh = try_allocate(create_arena(std::max(vertexCount, arenaVertexCapacity), std::max(indexWords, arenaIndexCapacity)));
+	assert(mesh);
+	return *mesh;
 }
 
 nyan::MeshID nyan::MeshManager::get_mesh(const std::string& name)
@@ -123,11 +259,10 @@ void nyan::MeshManager::build()
 {
 	if (m_buildAccs) {
 		auto handles = m_builder->build_pending();
-		for (auto [handleId, meshId] : m_pendingAccBuildIndex) {
+		for (auto [handleId, geometryId] : m_pendingAccBuildIndex) {
 			assert(handleId < handles.size());
-			auto it = m_staticTangentMeshes.find(meshId);
-			assert(it != m_staticTangentMeshes.end());
-			it->second.accStructure = handles[handleId];
+			assert(geometryId < m_geometries.size());
+			m_geometries[geometryId].accStructure = handles[handleId];
 		}
 		m_pendingAccBuildIndex.clear();
 	}
@@ -138,28 +273,56 @@ const nyan::shaders::Mesh& nyan::MeshManager::get_shader_mesh(MeshID idx) const
 }
 const StaticTangentVulkanMesh& nyan::MeshManager::get_static_tangent_mesh(MeshID idx) const
 {
-	assert(m_staticTangentMeshes.find(idx) != m_staticTangentMeshes.end());
-	return m_staticTangentMeshes.find(idx)->second.mesh;
+	return get_geometry(idx).mesh;
 }
 
 const StaticTangentVulkanMesh& nyan::MeshManager::get_static_tangent_mesh(const std::string& name) const
 {
 	assert(m_meshIndex.find(name) != m_meshIndex.end());
-	assert(m_staticTangentMeshes.find(m_meshIndex.find(name)->second) != m_staticTangentMeshes.end());
-	return m_staticTangentMeshes.find(m_meshIndex.find(name)->second)->second.mesh;
+	return get_geometry(m_meshIndex.find(name)->second).mesh;
 }
 
 std::optional<vulkan::AccelerationStructureHandle> nyan::MeshManager::get_acceleration_structure(MeshID idx) 
 {
-	assert(m_staticTangentMeshes.find(idx) != m_staticTangentMeshes.end());
-	return m_staticTangentMeshes.find(idx)->second.accStructure;
+	return get_geometry(idx).accStructure;
 }
 
 std::optional<vulkan::AccelerationStructureHandle> nyan::MeshManager::get_acceleration_structure(const std::string& name)
 {
 	assert(m_meshIndex.find(name) != m_meshIndex.end());
-	assert(m_staticTangentMeshes.find(m_meshIndex.find(name)->second) != m_staticTangentMeshes.end());
-	return m_staticTangentMeshes.find(m_meshIndex.find(name)->second)->second.accStructure;
+	return get_geometry(m_meshIndex.find(name)->second).accStructure;
+}
+
+nyan::MeshBounds nyan::MeshManager::get_bounds(MeshID idx) const
+{
+	const auto& mesh = get(idx);
+	return MeshBounds{
+		.box {
+			.min {mesh.boundsMin},
+			.max {mesh.boundsMax},
+		},
+		.sphere {
+			.center {mesh.boundsCenter},
+			.radius {mesh.boundsRadius},
+		},
+	};
+}
+
+const nyan::MeshGeometryCache::Statistics& nyan::MeshManager::get_geometry_statistics() const
+{
+	return m_geometryCache.get_statistics();
+}
+
+const nyan::MeshManager::Mesh& nyan::MeshManager::get_geometry(MeshID idx) const
+{
+	assert(m_meshGeometries.find(idx) != m_meshGeometries.end());
+	return m_geometries[m_meshGeometries.find(idx)->second];
+}
+
+nyan::MeshManager::Mesh& nyan::MeshManager::get_geometry(MeshID idx)
+{
+	assert(m_meshGeometries.find(idx) != m_meshGeometries.end());
+	return m_geometries[m_meshGeometries.find(idx)->second];
 }
 
 nyan::InstanceManager::InstanceManager(vulkan::LogicalDevice& device, bool buildAccelerationStructures) :
@@ -216,6 +379,17 @@ InstanceId nyan::InstanceManager::add_instance(const InstanceData& instanceData)
 {
 	return add(instanceData);
 }
+void nyan::InstanceManager::set_world_bounds(InstanceId id, const MeshBounds& bounds)
+{
+	if (m_worldBounds.size() <= id)
+		m_worldBounds.resize(static_cast<size_t>(id) + 1);
+	m_worldBounds[id] = bounds;
+}
+const MeshBounds& nyan::InstanceManager::get_world_bounds(InstanceId id) const
+{
+	assert(id < m_worldBounds.size());
+	return m_worldBounds[id];
+}
 
 
 
@@ -0,0 +1,411 @@
+#include "Renderer/MeshOptimizer.h"
+#include "Utility/JobSystem.h"
+#include <algorithm>
+#include <numeric>
+#include <cassert>
+
+struct TriangleAdjacency {
+	std::vector<uint32_t> counts;
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> triangles;
+};
+
+static TriangleAdjacency build_triangle_adjacency(std::span<const uint32_t> indices, size_t vertexCount)
+{
+	TriangleAdjacency adjacency{
+		.counts = std::vector<uint32_t>(vertexCount, 0),
+		.offsets = std::vector<uint32_t>(vertexCount, 0),
+		.triangles = std::vector<uint32_t>(indices.size()),
+	};
+	for (auto index : indices) {
+		assert(index < vertexCount);
+		adjacency.counts[index]++;
+	}
+	uint32_t offset{ 0 };
+	for (size_t i{ 0 }; i < vertexCount; ++i) {
+		adjacency.offsets[i] = offset;
+		offset += adjacency.counts[i];
+	}
+	std::vector<uint32_t> fill(adjacency.offsets);
+	for (size_t i{ 0 }; i < indices.size(); ++i)
+		adjacency.triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	return adjacency;
+}
+
+//FIFO cache simulation, a vertex is cached iff time - cacheTime[v] <= cacheSize
+static uint32_t simulate_fifo_triangle(const uint32_t* triangle, std::vector<uint32_t>& cacheTime, uint32_t& time, uint32_t cacheSize)
+{
+	uint32_t misses{ 0 };
+	for (uint32_t j{ 0 }; j < 3; ++j) {
+		auto vertex = triangle[j];
+		if (time - cacheTime[vertex] > cacheSize) {
+			cacheTime[vertex] = time++;
+			++misses;
+		}
+	}
+	return misses;
+}
+
+template<typename T>
+static void remap_vertex_stream(std::vector<T>& stream, const std::vector<uint32_t>& remap, size_t vertexCount, size_t uniqueVertexCount)
+{
+	if (stream.empty() || vertexCount == 0)
+		return;
+	assert(stream.size() % vertexCount == 0);
+	const size_t components = stream.size() / vertexCount;
+	std::vector<T> result(uniqueVertexCount * components);
+	for (size_t vertex{ 0 }; vertex < vertexCount; ++vertex) {
+		if (remap[vertex] == ~0u)
+			continue;
+		std::copy_n(stream.begin() + vertex * components, components, result.begin() + remap[vertex] * components);
+	}
+	stream = std::move(result);
+}
+
+template<typename T>
+static size_t stream_vertex_size(const std::vector<T>& stream, size_t vertexCount)
+{
+	if (stream.empty() || vertexCount == 0)
+		return 0;
+	return sizeof(T) * (stream.size() / vertexCount);
+}
+
+nyan::MeshOptimizer::Statistics nyan::MeshOptimizer::optimize(nyan::Mesh& mesh, const Settings& settings)
+{
+	Statistics statistics{};
+	const auto vertexCount = mesh.positions.size();
+	if (mesh.indices.empty() || vertexCount == 0)
+		return statistics;
+	assert(mesh.indices.size() % 3 == 0);
+	statistics.cacheBefore = analyze_vertex_cache(mesh.indices, vertexCount, settings.cacheSize);
+	statistics.fetchBefore = analyze_vertex_fetch(mesh);
+
+	if (settings.optimizeVertexCache)
+		optimize_vertex_cache(mesh.indices, vertexCount, settings.cacheSize);
+	if (settings.optimizeOverdraw)
+		optimize_overdraw(mesh.indices, mesh.positions, settings.cacheSize, settings.overdrawThreshold);
+	if (settings.optimizeVertexFetch)
+		optimize_vertex_fetch(mesh);
+
+	statistics.cacheAfter = analyze_vertex_cache(mesh.indices, mesh.positions.size(), settings.cacheSize);
+	statistics.fetchAfter = analyze_vertex_fetch(mesh);
+	return statistics;
+}
+
+nyan::MeshOptimizer::Statistics nyan::MeshOptimizer::optimize(nyan::Mesh& mesh)
+{
+	return optimize(mesh, Settings{});
+}
+
+std::vector<nyan::MeshOptimizer::Statistics> nyan::MeshOptimizer::optimize(std::span<nyan::Mesh> meshes, const Settings& settings)
+{
+	std::vector<Statistics> statistics(meshes.size());
+	Utility::JobSystem::get().parallel_for(meshes.size(), [&](size_t i) {
+		statistics[i] = optimize(meshes[i], settings);
+	});
+	return statistics;
+}
+
+std::vector<nyan::MeshOptimizer::Statistics> nyan::MeshOptimizer::optimize(std::span<nyan::Mesh> meshes)
+{
+	return optimize(meshes, Settings{});
+}
+
+void nyan::MeshOptimizer::optimize_vertex_cache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+{
+	if (indices.size() < 3 || vertexCount == 0)
+		return;
+	const size_t triangleCount = indices.size() / 3;
+	const auto adjacency = build_triangle_adjacency(indices, vertexCount);
+
+	std::vector<uint32_t> liveTriangles(adjacency.counts);
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnd;
+	deadEnd.reserve(indices.size());
+	std::vector<uint32_t> candidates;
+	candidates.reserve(64);
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	constexpr uint32_t invalidVertex{ ~0u };
+	uint32_t fanningVertex{ indices[0] };
+	uint32_t time{ cacheSize + 1 };
+	size_t scanCursor{ 0 };
+
+	while (fanningVertex != invalidVertex) {
+		candidates.clear();
+		const auto begin = adjacency.offsets[fanningVertex];
+		const auto end = begin + adjacency.counts[fanningVertex];
+		for (auto it = begin; it < end; ++it) {
+			auto triangle = adjacency.triangles[it];
+			if (emitted[triangle])
+				continue;
+			for (uint32_t j{ 0 }; j < 3; ++j) {
+				auto vertex = indices[triangle * 3 + j];
+				result.push_back(vertex);
+				deadEnd.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+				if (time - cacheTime[vertex] > cacheSize)
+					cacheTime[vertex] = time++;
+			}
+			emitted[triangle] = true;
+		}
+
+		//Prefer vertices that stay in cache after emitting all of their remaining triangles
+		fanningVertex = invalidVertex;
+		int64_t bestPriority{ -1 };
+		for (auto vertex : candidates) {
+			if (!liveTriangles[vertex])
+				continue;
+			int64_t priority{ 0 };
+			if (static_cast<int64_t>(time - cacheTime[vertex]) + 2 * static_cast<int64_t>(liveTriangles[vertex]) <= static_cast<int64_t>(cacheSize))
+				priority = time - cacheTime[vertex];
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				fanningVertex = vertex;
+			}
+		}
+		if (fanningVertex != invalidVertex)
+			continue;
+		while (!deadEnd.empty()) {
+			auto vertex = deadEnd.back();
+			deadEnd.pop_back();
+			if (liveTriangles[vertex]) {
+				fanningVertex = vertex;
+				break;
+			}
+		}
+		if (fanningVertex != invalidVertex)
+			continue;
+		for (; scanCursor < vertexCount; ++scanCursor) {
+			if (liveTriangles[scanCursor]) {
+				fanningVertex = static_cast<uint32_t>(scanCursor);
+				break;
+			}
+		}
+	}
+	assert(result.size() == indices.size());
+	std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void nyan::MeshOptimizer::optimize_overdraw(std::span<uint32_t> indices, std::span<const Math::vec3> positions, uint32_t cacheSize, float threshold)
+{
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2 || positions.empty())
+		return;
+	const size_t vertexCount = positions.size();
+
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	uint32_t time{ cacheSize + 1 };
+	auto flush_cache = [&]() { time += cacheSize + 1; };
+
+	//Hard boundaries, triangles where the simulated cache missed all three vertices
+	std::vector<size_t> hardClusters;
+	for (size_t i{ 0 }; i < triangleCount; ++i) {
+		auto misses = simulate_fifo_triangle(&indices[i * 3], cacheTime, time, cacheSize);
+		if (i == 0 || misses == 3)
+			hardClusters.push_back(i);
+	}
+	//Soft boundaries, split hard clusters as soon as the running ACMR is within threshold of the cluster ACMR
+	std::vector<size_t> clusters;
+	for (size_t cluster{ 0 }; cluster < hardClusters.size(); ++cluster) {
+		const auto start = hardClusters[cluster];
+		const auto end = (cluster + 1 < hardClusters.size()) ? hardClusters[cluster + 1] : triangleCount;
+		flush_cache();
+		size_t clusterMisses{ 0 };
+		for (size_t i{ start }; i < end; ++i)
+			clusterMisses += simulate_fifo_triangle(&indices[i * 3], cacheTime, time, cacheSize);
+		const float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+		const auto firstCluster = clusters.size();
+		clusters.push_back(start);
+		flush_cache();
+		size_t runningMisses{ 0 };
+		size_t runningTriangles{ 0 };
+		for (size_t i{ start }; i < end; ++i) {
+			runningMisses += simulate_fifo_triangle(&indices[i * 3], cacheTime, time, cacheSize);
+			runningTriangles++;
+			if (static_cast<float>(runningMisses) <= clusterThreshold * static_cast<float>(runningTriangles) && i + 1 < end) {
+				clusters.push_back(i + 1);
+				flush_cache();
+				runningMisses = 0;
+				runningTriangles = 0;
+			}
+		}
+		//The tail never reached the target ACMR, merge it into the previous cluster
+		if (clusters.size() - firstCluster > 1 && runningTriangles > 0)
+			clusters.pop_back();
+	}
+
+	Math::vec3 meshCentroid{ 0.f };
+	for (const auto& position : positions)
+		meshCentroid += position;
+	meshCentroid *= 1.f / static_cast<float>(vertexCount);
+
+	std::vector<float> sortKeys(clusters.size());
+	for (size_t cluster{ 0 }; cluster < clusters.size(); ++cluster) {
+		const auto start = clusters[cluster];
+		const auto end = (cluster + 1 < clusters.size()) ? clusters[cluster + 1] : triangleCount;
+		Math::vec3 centroid{ 0.f };
+		Math::vec3 normal{ 0.f };
+		float area{ 0.f };
+		for (size_t i{ start }; i < end; ++i) {
+			const auto& p0 = positions[indices[i * 3 + 0]];
+			const auto& p1 = positions[indices[i * 3 + 1]];
+			const auto& p2 = positions[indices[i * 3 + 2]];
+			auto triangleNormal = (p1 - p0).cross(p2 - p0);
+			auto triangleArea = triangleNormal.L2_norm();
+			centroid += (p0 + p1 + p2) * (triangleArea / 3.f);
+			normal += triangleNormal;
+			area += triangleArea;
+		}
+		if (area > 0.f)
+			centroid *= 1.f / area;
+		auto normalLength = normal.L2_norm();
+		if (normalLength > 0.f)
+			normal *= 1.f / normalLength;
+		sortKeys[cluster] = (centroid - meshCentroid).dot(normal);
+	}
+
+	std::vector<uint32_t> order(clusters.size());
+	std::iota(order.begin(), order.end(), 0u);
+	//Outward facing clusters first, they are likely to occlude the rest of the mesh
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) { return sortKeys[lhs] > sortKeys[rhs]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (auto cluster : order) {
+		const auto start = clusters[cluster];
+		const auto end = (cluster + 1 < clusters.size()) ? clusters[cluster + 1] : triangleCount;
+		result.insert(result.end(), indices.begin() + start * 3, indices.begin() + end * 3);
+	}
+	std::copy(result.begin(), result.end(), indices.begin());
+}
+
+std::vector<uint32_t> nyan::MeshOptimizer::generate_fetch_remap(std::span<const uint32_t> indices, size_t vertexCount, size_t& uniqueVertexCount)
+{
+	std::vector<uint32_t> remap(vertexCount, ~0u);
+	uint32_t next{ 0 };
+	for (auto index : indices) {
+		assert(index < vertexCount);
+		if (remap[index] == ~0u)
+			remap[index] = next++;
+	}
+	uniqueVertexCount = next;
+	return remap;
+}
+
+size_t nyan::MeshOptimizer::optimize_vertex_fetch(nyan::Mesh& mesh)
+{
+	const auto vertexCount = mesh.positions.size();
+	if (vertexCount == 0)
+		return 0;
+	size_t uniqueVertexCount{ 0 };
+	auto remap = generate_fetch_remap(mesh.indices, vertexCount, uniqueVertexCount);
+	for (auto& index : mesh.indices)
+		index = remap[index];
+	remap_vertex_stream(mesh.positions, remap, vertexCount, uniqueVertexCount);
+	remap_vertex_stream(mesh.uvs0, remap, vertexCount, uniqueVertexCount);
+	remap_vertex_stream(mesh.uvs1, remap, vertexCount, uniqueVertexCount);
+	remap_vertex_stream(mesh.uvs2, remap, vertexCount, uniqueVertexCount);
+	remap_vertex_stream(mesh.normals, remap, vertexCount, uniqueVertexCount);
+	remap_vertex_stream(mesh.tangents, remap, vertexCount, uniqueVertexCount);
+	remap_vertex_stream(mesh.colors0, remap, vertexCount, uniqueVertexCount);
+	return uniqueVertexCount;
+}
+
+nyan::VertexCacheStatistics nyan::MeshOptimizer::analyze_vertex_cache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStatistics statistics{
+		.triangleCount {static_cast<uint32_t>(indices.size() / 3)},
+	};
+	if (!statistics.triangleCount || !vertexCount)
+		return statistics;
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32_t time{ cacheSize + 1 };
+	for (size_t i{ 0 }; i < statistics.triangleCount; ++i)
+		statistics.transformedVertices += simulate_fifo_triangle(&indices[i * 3], cacheTime, time, cacheSize);
+	for (auto index : indices) {
+		if (!referenced[index]) {
+			referenced[index] = true;
+			statistics.vertexCount++;
+		}
+	}
+	statistics.acmr = static_cast<float>(statistics.transformedVertices) / static_cast<float>(statistics.triangleCount);
+	statistics.atvr = static_cast<float>(statistics.transformedVertices) / static_cast<float>(statistics.vertexCount);
+	return statistics;
+}
+
+nyan::VertexFetchStatistics nyan::MeshOptimizer::analyze_vertex_fetch(const nyan::Mesh& mesh)
+{
+	//Every post transform cache miss fetches the vertex from each stream through a small FIFO line cache
+	constexpr uint32_t cacheLineSize{ 64 };
+	constexpr uint32_t cacheLines{ 16 * 1024 / cacheLineSize };
+	constexpr uint32_t transformCacheSize{ 16 };
+	VertexFetchStatistics statistics{};
+	const auto vertexCount = mesh.positions.size();
+	if (mesh.indices.empty() || vertexCount == 0)
+		return statistics;
+
+	std::vector<uint32_t> vertexTime(vertexCount, 0);
+	uint32_t transformTime{ transformCacheSize + 1 };
+	std::vector<uint32_t> fetched;
+	fetched.reserve(mesh.indices.size());
+	for (auto index : mesh.indices) {
+		if (transformTime - vertexTime[index] > transformCacheSize) {
+			vertexTime[index] = transformTime++;
+			fetched.push_back(index);
+		}
+	}
+
+	auto fetch_stream = [&](size_t elementSize) {
+		if (!elementSize)
+			return;
+		const size_t lineCount = (vertexCount * elementSize + cacheLineSize - 1) / cacheLineSize;
+		std::vector<uint32_t> lineTime(lineCount, 0);
+		uint32_t time{ cacheLines + 1 };
+		for (auto vertex : fetched) {
+			const size_t firstLine = (vertex * elementSize) / cacheLineSize;
+			const size_t lastLine = (vertex * elementSize + elementSize - 1) / cacheLineSize;
+			for (size_t line{ firstLine }; line <= lastLine; ++line) {
+				if (time - lineTime[line] > cacheLines) {
+					lineTime[line] = time++;
+					statistics.bytesFetched += cacheLineSize;
+				}
+			}
+		}
+	};
+	fetch_stream(stream_vertex_size(mesh.positions, vertexCount));
+	fetch_stream(stream_vertex_size(mesh.uvs0, vertexCount));
+	fetch_stream(stream_vertex_size(mesh.uvs1, vertexCount));
+	fetch_stream(stream_vertex_size(mesh.uvs2, vertexCount));
+	fetch_stream(stream_vertex_size(mesh.normals, vertexCount));
+	fetch_stream(stream_vertex_size(mesh.tangents, vertexCount));
+	fetch_stream(stream_vertex_size(mesh.colors0, vertexCount));
+
+	std::vector<bool> referenced(vertexCount, false);
+	size_t referencedCount{ 0 };
+	for (auto index : mesh.indices) {
+		if (!referenced[index]) {
+			referenced[index] = true;
+			referencedCount++;
+		}
+	}
+	statistics.overfetch = static_cast<float>(statistics.bytesFetched) / static_cast<float>(referencedCount * vertex_byte_size(mesh));
+	return statistics;
+}
+
+size_t nyan::MeshOptimizer::vertex_byte_size(const nyan::Mesh& mesh)
+{
+	const auto vertexCount = mesh.positions.size();
+	return stream_vertex_size(mesh.positions, vertexCount) +
+		stream_vertex_size(mesh.uvs0, vertexCount) +
+		stream_vertex_size(mesh.uvs1, vertexCount) +
+		stream_vertex_size(mesh.uvs2, vertexCount) +
+		stream_vertex_size(mesh.normals, vertexCount) +
+		stream_vertex_size(mesh.tangents, vertexCount) +
+		stream_vertex_size(mesh.colors0, vertexCount);
+}
@@ -0,0 +1,242 @@
+#include "Renderer/MeshQuantizer.h"
+#include "Utility/JobSystem.h"
+#include <algorithm>
+#include <limits>
+#include <cassert>
+
+template<typename T>
+static size_t quantizer_stream_size(const std::vector<T>& stream)
+{
+	return stream.size() * sizeof(T);
+}
+
+static float quantizer_sign(float f)
+{
+	return f >= 0.f ? 1.f : -1.f;
+}
+
+//Rounds to the closest grid point and then picks the best of the four surrounding ones
+//Plain rounding in the octahedral domain can be noticeably off after renormalization at low bit counts
+static std::array<int32_t, 2> quantizer_quantize_octahedral(const Math::vec3& direction, int32_t maxValue)
+{
+	auto encoded = nyan::MeshQuantizer::encode_octahedral(direction);
+	const auto max = static_cast<float>(maxValue);
+	std::array<int32_t, 2> base{
+		static_cast<int32_t>(std::floor(encoded[0] * max)),
+		static_cast<int32_t>(std::floor(encoded[1] * max))
+	};
+	std::array<int32_t, 2> best{ base };
+	float bestDot{ -2.f };
+	for (int32_t dy{ 0 }; dy < 2; ++dy) {
+		for (int32_t dx{ 0 }; dx < 2; ++dx) {
+			std::array<int32_t, 2> candidate{
+				std::clamp(base[0] + dx, -maxValue, maxValue),
+				std::clamp(base[1] + dy, -maxValue, maxValue)
+			};
+			auto decoded = nyan::MeshQuantizer::decode_octahedral(Math::vec2{ static_cast<float>(candidate[0]) / max, static_cast<float>(candidate[1]) / max });
+			auto dot = decoded.dot(direction);
+			if (dot > bestDot) {
+				bestDot = dot;
+				best = candidate;
+			}
+		}
+	}
+	return best;
+}
+
+//Sign extends the bits [offset, offset + bits) and applies the Vulkan snorm conversion
+static float quantizer_unpack_snorm(uint32_t data, uint32_t offset, uint32_t bits)
+{
+	const auto shift = 32 - bits;
+	const auto value = static_cast<int32_t>(data << (shift - offset)) >> shift;
+	const auto max = static_cast<float>((1 << (bits - 1)) - 1);
+	return std::max(static_cast<float>(value) / max, -1.f);
+}
+
+nyan::QuantizedMesh nyan::MeshQuantizer::quantize(const nyan::Mesh& mesh)
+{
+	QuantizedMesh quantized{
+		.type {mesh.type},
+		.name {mesh.name},
+		.material {mesh.material},
+		.materialBinding {mesh.materialBinding},
+		.bounds {mesh.bounds.valid() ? mesh.bounds : BoundsCalculator::compute(mesh.positions)},
+	};
+	const auto vertexCount = mesh.positions.size();
+	if (vertexCount <= static_cast<size_t>(std::numeric_limits<uint16_t>::max()) + 1) {
+		quantized.shortIndices.resize(mesh.indices.size());
+		std::transform(mesh.indices.begin(), mesh.indices.end(), quantized.shortIndices.begin(), [](uint32_t index) { return static_cast<uint16_t>(index); });
+	}
+	else {
+		quantized.indices = mesh.indices;
+	}
+
+	if (vertexCount) {
+		const auto& min = quantized.bounds.box.min;
+		const auto& max = quantized.bounds.box.max;
+		for (size_t axis{ 0 }; axis < 3; ++axis) {
+			quantized.positionOffset[axis] = (max[axis] + min[axis]) * 0.5f;
+			const auto halfExtent = (max[axis] - min[axis]) * 0.5f;
+			quantized.positionScale[axis] = halfExtent > 0.f ? halfExtent : 1.f;
+		}
+	}
+	quantized.positions.resize(vertexCount);
+	for (size_t i{ 0 }; i < vertexCount; ++i) {
+		const auto& position = mesh.positions[i];
+		quantized.positions[i] = Math::sn16vec4{
+			Math::snorm16{ (position[0] - quantized.positionOffset[0]) / quantized.positionScale[0] },
+			Math::snorm16{ (position[1] - quantized.positionOffset[1]) / quantized.positionScale[1] },
+			Math::snorm16{ (position[2] - quantized.positionOffset[2]) / quantized.positionScale[2] },
+			Math::snorm16{ 0.f }
+		};
+	}
+
+	quantized.uvs0 = mesh.uvs0;
+
+	quantized.normals.resize(mesh.normals.size());
+	for (size_t i{ 0 }; i < mesh.normals.size(); ++i)
+		quantized.normals[i] = encode_normal(Math::vec3{ mesh.normals[i] });
+
+	quantized.tangents.resize(mesh.tangents.size());
+	for (size_t i{ 0 }; i < mesh.tangents.size(); ++i)
+		quantized.tangents[i] = encode_tangent(Math::vec4{ mesh.tangents[i] });
+
+	return quantized;
+}
+
+std::vector<nyan::QuantizedMesh> nyan::MeshQuantizer::quantize(std::span<const nyan::Mesh> meshes)
+{
+	std::vector<QuantizedMesh> quantized(meshes.size());
+	Utility::JobSystem::get().parallel_for(meshes.size(), [&](size_t i) {
+		quantized[i] = quantize(meshes[i]);
+	});
+	return quantized;
+}
+
+nyan::Mesh nyan::MeshQuantizer::dequantize(const QuantizedMesh& quantized)
+{
+	nyan::Mesh mesh{
+		.type {quantized.type},
+		.name {quantized.name},
+		.material {quantized.material},
+		.materialBinding {quantized.materialBinding},
+	};
+	mesh.bounds = quantized.bounds;
+	mesh.indices.resize(quantized.index_count());
+	for (size_t i{ 0 }; i < mesh.indices.size(); ++i)
+		mesh.indices[i] = quantized.get_index(i);
+
+	mesh.positions.resize(quantized.positions.size());
+	for (size_t i{ 0 }; i < quantized.positions.size(); ++i) {
+		const auto& position = quantized.positions[i];
+		for (size_t axis{ 0 }; axis < 3; ++axis)
+			mesh.positions[i][axis] = quantized.positionOffset[axis] + quantized.positionScale[axis] * static_cast<float>(position[axis]);
+	}
+
+	mesh.uvs0 = quantized.uvs0;
+
+	mesh.normals.resize(quantized.normals.size());
+	for (size_t i{ 0 }; i < quantized.normals.size(); ++i)
+		mesh.normals[i] = Math::hvec3{ decode_normal(quantized.normals[i]) };
+
+	mesh.tangents.resize(quantized.tangents.size());
+	for (size_t i{ 0 }; i < quantized.tangents.size(); ++i)
+		mesh.tangents[i] = Math::hvec4{ decode_tangent(quantized.tangents[i]) };
+
+	return mesh;
+}
+
+nyan::QuantizationStatistics nyan::MeshQuantizer::analyze(const nyan::Mesh& mesh, const QuantizedMesh& quantized)
+{
+	QuantizationStatistics statistics{
+		.sourceBytes {index_byte_size(mesh) + vertex_byte_size(mesh)},
+		.quantizedBytes {index_byte_size(quantized) + vertex_byte_size(quantized)},
+	};
+	if (statistics.sourceBytes)
+		statistics.ratio = static_cast<float>(statistics.quantizedBytes) / static_cast<float>(statistics.sourceBytes);
+	return statistics;
+}
+
+size_t nyan::MeshQuantizer::index_byte_size(const nyan::Mesh& mesh)
+{
+	return quantizer_stream_size(mesh.indices);
+}
+
+size_t nyan::MeshQuantizer::index_byte_size(const QuantizedMesh& mesh)
+{
+	return quantizer_stream_size(mesh.shortIndices) + quantizer_stream_size(mesh.indices);
+}
+
+size_t nyan::MeshQuantizer::vertex_byte_size(const nyan::Mesh& mesh)
+{
+	return quantizer_stream_size(mesh.positions) +
+		quantizer_stream_size(mesh.uvs0) +
+		quantizer_stream_size(mesh.normals) +
+		quantizer_stream_size(mesh.tangents);
+}
+
+size_t nyan::MeshQuantizer::vertex_byte_size(const QuantizedMesh& mesh)
+{
+	return quantizer_stream_size(mesh.positions) +
+		quantizer_stream_size(mesh.uvs0) +
+		quantizer_stream_size(mesh.normals) +
+		quantizer_stream_size(mesh.tangents);
+}
+
+Math::vec2 nyan::MeshQuantizer::encode_octahedral(const Math::vec3& direction)
+{
+	const auto l1 = std::abs(direction[0]) + std::abs(direction[1]) + std::abs(direction[2]);
+	if (l1 <= 0.f)
+		return Math::vec2{ 0.f, 0.f };
+	auto x = direction[0] / l1;
+	auto y = direction[1] / l1;
+	if (direction[2] < 0.f) {
+		const auto foldedX = (1.f - std::abs(y)) * quantizer_sign(x);
+		const auto foldedY = (1.f - std::abs(x)) * quantizer_sign(y);
+		x = foldedX;
+		y = foldedY;
+	}
+	return Math::vec2{ x, y };
+}
+
+Math::vec3 nyan::MeshQuantizer::decode_octahedral(const Math::vec2& encoded)
+{
+	Math::vec3 direction{ encoded[0], encoded[1], 1.f - std::abs(encoded[0]) - std::abs(encoded[1]) };
+	const auto t = std::max(-direction[2], 0.f);
+	direction[0] += direction[0] >= 0.f ? -t : t;
+	direction[1] += direction[1] >= 0.f ? -t : t;
+	return direction * (1.f / direction.L2_norm());
+}
+
+Math::sn16vec2 nyan::MeshQuantizer::encode_normal(const Math::vec3& normal)
+{
+	constexpr int32_t max = std::numeric_limits<int16_t>::max();
+	auto quantized = quantizer_quantize_octahedral(normal, max);
+	Math::sn16vec2 encoded;
+	encoded[0].data = static_cast<int16_t>(quantized[0]);
+	encoded[1].data = static_cast<int16_t>(quantized[1]);
+	return encoded;
+}
+
+Math::vec3 nyan::MeshQuantizer::decode_normal(const Math::sn16vec2& normal)
+{
+	return decode_octahedral(Math::vec2{ static_cast<float>(normal[0]), static_cast<float>(normal[1]) });
+}
+
+nyan::PackedTangent nyan::MeshQuantizer::encode_tangent(const Math::vec4& tangent)
+{
+	constexpr int32_t max = (1 << 9) - 1;
+	auto quantized = quantizer_quantize_octahedral(Math::vec3{ tangent }, max);
+	const uint32_t sign = tangent[3] < 0.f ? 0x3u : 0x1u;
+	return PackedTangent{
+		.data {(static_cast<uint32_t>(quantized[0]) & 0x3FFu) |
+			((static_cast<uint32_t>(quantized[1]) & 0x3FFu) << 10) |
+			(sign << 30)}
+	};
+}
+
+Math::vec4 nyan::MeshQuantizer::decode_tangent(PackedTangent tangent)
+{
+	auto direction = decode_octahedral(Math::vec2{ quantizer_unpack_snorm(tangent.data, 0, 10), quantizer_unpack_snorm(tangent.data, 10, 10) });
+	return Math::vec4{ direction[0], direction[1], direction[2], quantizer_unpack_snorm(tangent.data, 30, 2) };
+}
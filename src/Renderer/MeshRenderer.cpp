@@ -18,73 +18,62 @@ nyan::MeshRenderer::MeshRenderer(vulkan::LogicalDevice& device, entt::registry&
 	r_pass.add_attachment(m_gbuffer.pbr, true);
 
 	create_pipeline();
-	pass.add_renderfunction([this](vulkan::CommandBuffer& cmd, nyan::Renderpass&)
+	//The draw list is gathered up front, chunks of it are recorded in parallel and only read it
+	pass.add_parallel_renderfunction([this]()
 	{
-		{
-			auto pipelineBind = cmd.bind_graphics_pipeline(m_staticTangentPipeline);
-
-			auto [viewport, scissor] = r_device.get_swapchain_viewport_and_scissor();
-			pipelineBind.set_scissor_with_count(1, &scissor);
-			pipelineBind.set_viewport_with_count(1, &viewport);
-
-			PushConstants instance{
-				.meshBinding {r_renderManager.get_mesh_manager().get_binding()},
-				.instanceBinding {r_renderManager.get_instance_manager().get_binding()},
-				.instanceId {0},
-				.sceneBinding {r_renderManager.get_scene_manager().get_binding()},
-			};
-			{
-				auto view = r_registry.view<const MeshID, const InstanceId, const Deferred>();
-				for (const auto& [entity, meshID, instanceId] : view.each()) {
-					instance.instanceId = instanceId;
-					render(pipelineBind, meshID, instance);
-				}
-			}
-			{
-				pipelineBind.set_cull_mode(VK_CULL_MODE_NONE);
-				auto view = r_registry.view<const MeshID, const InstanceId, const DeferredDoubleSided>();
-				for (const auto& [entity, meshID, instanceId] : view.each()) {
-					instance.instanceId = instanceId;
-					render(pipelineBind, meshID, instance);
-				}
-			}
-		}
-		{
-			auto pipelineBind = cmd.bind_graphics_pipeline(m_staticTangentAlphaDiscardPipeline);
-
-			auto [viewport, scissor] = r_device.get_swapchain_viewport_and_scissor();
-			pipelineBind.set_scissor_with_count(1, &scissor);
-			pipelineBind.set_viewport_with_count(1, &viewport);
+		m_draws.clear();
+		m_drawGroupOffsets[0] = 0;
+		for (const auto& [entity, meshID, instanceId] : r_registry.view<const MeshID, const InstanceId, const Deferred>().each())
+			m_draws.push_back({ meshID, instanceId });
+		m_drawGroupOffsets[1] = m_draws.size();
+		for (const auto& [entity, meshID, instanceId] : r_registry.view<const MeshID, const InstanceId, const DeferredDoubleSided>().each())
+			m_draws.push_back({ meshID, instanceId });
+		m_drawGroupOffsets[2] = m_draws.size();
+		for (const auto& [entity, meshID, instanceId] : r_registry.view<const MeshID, const InstanceId, const DeferredAlphaTest>().each())
+			m_draws.push_back({ meshID, instanceId });
+		m_drawGroupOffsets[3] = m_draws.size();
+		for (const auto& [entity, meshID, instanceId] : r_registry.view<const MeshID, const InstanceId, const DeferredDoubleSidedAlphaTest>().each())
+			m_draws.push_back({ meshID, instanceId });
+		m_drawGroupOffsets[4] = m_draws.size();
+		return m_draws.size();
+	}, [this](vulkan::CommandBuffer& cmd, nyan::Renderpass&, size_t begin, size_t end)
+	{
+		render(cmd, begin, end);
+	}, true, minDrawsPerChunk);
+}
 
-			PushConstants instance{
-				.meshBinding {r_renderManager.get_mesh_manager().get_binding()},
-				.instanceBinding {r_renderManager.get_instance_manager().get_binding()},
-				.instanceId {0},
-				.sceneBinding {r_renderManager.get_scene_manager().get_binding()},
-			};
-			{
-				auto view = r_registry.view<const MeshID, const InstanceId, const DeferredAlphaTest>();
-				for (const auto& [entity, meshID, instanceId] : view.each()) {
-					instance.instanceId = instanceId;
-					render(pipelineBind, meshID, instance);
-				}
-			}
-			{
-				pipelineBind.set_cull_mode(VK_CULL_MODE_NONE);
-				auto view = r_registry.view<const MeshID, const InstanceId, const DeferredDoubleSidedAlphaTest>();
-				for (const auto& [entity, meshID, instanceId] : view.each()) {
-					instance.instanceId = instanceId;
-					render(pipelineBind, meshID, instance);
-				}
-			}
+void nyan::MeshRenderer::render(vulkan::CommandBuffer& cmd, size_t begin, size_t end)
+{
+	auto [viewport, scissor] = r_device.get_swapchain_viewport_and_scissor();
+	PushConstants instance{
+		.meshBinding {r_renderManager.get_mesh_manager().get_binding()},
+		.instanceBinding {r_renderManager.get_instance_manager().get_binding()},
+		.instanceId {0},
+		.sceneBinding {r_renderManager.get_scene_manager().get_binding()},
+	};
+	//Groups in order: single sided, double sided, alpha tested, double sided alpha tested
+	for (size_t group{ 0 }; group + 1 < m_drawGroupOffsets.size(); group++) {
+		const auto groupBegin = std::max(begin, m_drawGroupOffsets[group]);
+		const auto groupEnd = std::min(end, m_drawGroupOffsets[group + 1]);
+		if (groupBegin >= groupEnd)
+			continue;
+		//Secondary command buffers don't inherit any state
+		auto pipelineBind = cmd.bind_graphics_pipeline(group < 2 ? m_staticTangentPipeline : m_staticTangentAlphaDiscardPipeline);
+		pipelineBind.set_scissor_with_count(1, &scissor);
+		pipelineBind.set_viewport_with_count(1, &viewport);
+		if (group % 2)
+			pipelineBind.set_cull_mode(VK_CULL_MODE_NONE);
+		for (auto i = groupBegin; i < groupEnd; i++) {
+			instance.instanceId = m_draws[i].instanceId;
+			render(pipelineBind, m_draws[i].meshId, instance);
 		}
-	}, true);
+	}
 }
 
 void nyan::MeshRenderer::render(vulkan::GraphicsPipelineBind& pipelineBind, const MeshID& meshId, const PushConstants& instance)
 {
 	auto& mesh = r_renderManager.get_mesh_manager().get_static_tangent_mesh(meshId);
-	pipelineBind.bind_index_buffer(mesh.indexBuffer, mesh.indexOffset,  VK_INDEX_TYPE_UINT32);
+	pipelineBind.bind_index_buffer(mesh.indexBuffer, mesh.indexOffset, mesh.indexType);
 	pipelineBind.bind_vertex_buffers(0u, mesh.vertexBuffers.size(), mesh.vertexBuffers.data(), mesh.vertexOffsets.data());
 
 
@@ -108,10 +97,10 @@ void nyan::MeshRenderer::create_pipeline()
 			vulkan::defaultBlendAttachment,
 		}
 		},
-	.vertexInputCount = get_num_formats<nyan::Mesh>(),
+	.vertexInputCount = get_num_formats<nyan::QuantizedMesh>(),
 	.shaderCount = 2,
 	.vertexInputFormats {
-		get_formats<nyan::Mesh>()
+		get_formats<nyan::QuantizedMesh>()
 	},
 	.shaderInstances {
 		r_renderManager.get_shader_manager().get_shader_instance_id("staticTangent_vert"),
@@ -198,7 +187,7 @@ nyan::ForwardMeshRenderer::ForwardMeshRenderer(vulkan::LogicalDevice& device, en
 void nyan::ForwardMeshRenderer::render(vulkan::GraphicsPipelineBind& bind, const MeshID& meshId, const PushConstants& instance)
 {
 	auto& mesh = r_renderManager.get_mesh_manager().get_static_tangent_mesh(meshId);
-	bind.bind_index_buffer(mesh.indexBuffer, mesh.indexOffset, VK_INDEX_TYPE_UINT32);
+	bind.bind_index_buffer(mesh.indexBuffer, mesh.indexOffset, mesh.indexType);
 	bind.bind_vertex_buffers(0u, mesh.vertexBuffers.size(), mesh.vertexBuffers.data(), mesh.vertexOffsets.data());
 
 	bind.push_constants(instance);
@@ -220,10 +209,10 @@ void nyan::ForwardMeshRenderer::create_pipeline()
 			vulkan::alphaBlendAttachment,
 		}
 		},
-	.vertexInputCount = get_num_formats<nyan::Mesh>(),
+	.vertexInputCount = get_num_formats<nyan::QuantizedMesh>(),
 	.shaderCount = 2,
 	.vertexInputFormats {
-		get_formats<nyan::Mesh>()
+		get_formats<nyan::QuantizedMesh>()
 	},
 	.shaderInstances {
 		r_renderManager.get_shader_manager().get_shader_instance_id("staticTangent_vert"),
@@ -270,6 +259,8 @@ void nyan::RTMeshRenderer::render(vulkan::CommandBuffer& cmd, nyan::Renderpass&)
 		.frameCount {++m_frameCount}
 	};
 	auto& rtPipeline = get_rt_pipeline(rtConfig);
+	if (!rtPipeline.update())
+		return;
 	auto bind = cmd.bind_raytracing_pipeline(rtPipeline);
 	bind.push_constants(constants);
 	bind.trace_rays(rtPipeline, diffuseResource.handle->get_info().width, diffuseResource.handle->get_info().height, 1);
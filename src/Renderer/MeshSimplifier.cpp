@@ -0,0 +1,776 @@
+#include "Renderer/MeshSimplifier.h"
+#include "Renderer/MeshOptimizer.h"
+#include "Utility/JobSystem.h"
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <unordered_map>
+#include <bit>
+#include <utility>
+#include <cassert>
+
+enum class SimplifierVertexKind : uint8_t {
+	Manifold,
+	//Single open border passes through the vertex, may only move along it
+	Border,
+	//Two wedges separated by an attribute seam, may only move along the seam
+	Seam,
+	Locked
+};
+
+//Symmetric 3x3 quadric, error(p) = p^T A p + 2 b^T p + c
+struct SimplifierQuadric {
+	float a00{ 0.f }, a11{ 0.f }, a22{ 0.f }, a01{ 0.f }, a02{ 0.f }, a12{ 0.f };
+	float b0{ 0.f }, b1{ 0.f }, b2{ 0.f };
+	float c{ 0.f };
+	float w{ 0.f };
+	SimplifierQuadric& operator+=(const SimplifierQuadric& other) {
+		a00 += other.a00; a11 += other.a11; a22 += other.a22;
+		a01 += other.a01; a02 += other.a02; a12 += other.a12;
+		b0 += other.b0; b1 += other.b1; b2 += other.b2;
+		c += other.c;
+		w += other.w;
+		return *this;
+	}
+	//Quadric of the squared distance to the plane dot(normal, p) + d = 0
+	static SimplifierQuadric plane(const Math::vec3& normal, float d, float weight) {
+		return SimplifierQuadric{
+			.a00 {weight * normal[0] * normal[0]}, .a11 {weight * normal[1] * normal[1]}, .a22 {weight * normal[2] * normal[2]},
+			.a01 {weight * normal[0] * normal[1]}, .a02 {weight * normal[0] * normal[2]}, .a12 {weight * normal[1] * normal[2]},
+			.b0 {weight * normal[0] * d}, .b1 {weight * normal[1] * d}, .b2 {weight * normal[2] * d},
+			.c {weight * d * d},
+			.w {weight},
+		};
+	}
+	float evaluate(const Math::vec3& p) const {
+		const auto x = p[0], y = p[1], z = p[2];
+		return a00 * x * x + a11 * y * y + a22 * z * z + 2.f * (a01 * x * y + a02 * x * z + a12 * y * z) +
+			2.f * (b0 * x + b1 * y + b2 * z) + c;
+	}
+};
+
+//Squared deviation of a linearly interpolated attribute, error(p, a) = (dot(g, p) + d - a)^2
+struct SimplifierAttributeQuadric {
+	SimplifierQuadric plane;
+	Math::vec3 gradient{ 0.f };
+	float offset{ 0.f };
+	SimplifierAttributeQuadric& operator+=(const SimplifierAttributeQuadric& other) {
+		plane += other.plane;
+		gradient += other.gradient;
+		offset += other.offset;
+		return *this;
+	}
+	float evaluate(const Math::vec3& p, float attribute) const {
+		return plane.evaluate(p) - 2.f * attribute * (gradient.dot(p) + offset) + attribute * attribute * plane.w;
+	}
+};
+
+//Compressed per vertex lists
+struct SimplifierAdjacency {
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> data;
+	std::span<const uint32_t> operator[](uint32_t vertex) const {
+		return { data.data() + offsets[vertex], data.data() + offsets[vertex + 1] };
+	}
+	bool contains(uint32_t from, uint32_t to) const {
+		auto list = (*this)[from];
+		return std::find(list.begin(), list.end(), to) != list.end();
+	}
+};
+
+struct SimplifierPositionHash {
+	size_t operator()(const std::array<uint32_t, 3>& position) const {
+		return (position[0] * 73856093u) ^ (position[1] * 19349663u) ^ (position[2] * 83492791u);
+	}
+};
+
+static uint32_t simplifier_remap(std::span<const uint32_t> remap, uint32_t index)
+{
+	return remap.empty() ? index : remap[index];
+}
+
+//Directed edges between remapped vertices, optionally including the reversed edges
+static SimplifierAdjacency simplifier_build_edges(std::span<const uint32_t> indices, std::span<const uint32_t> remap, size_t vertexCount, bool undirected)
+{
+	SimplifierAdjacency adjacency{ .offsets = std::vector<uint32_t>(vertexCount + 1, 0) };
+	const uint32_t edgesPerCorner = undirected ? 2 : 1;
+	for (auto index : indices)
+		adjacency.offsets[simplifier_remap(remap, index) + 1] += edgesPerCorner;
+	std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+	adjacency.data.resize(adjacency.offsets.back());
+	std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+	for (size_t i{ 0 }; i < indices.size(); i += 3) {
+		for (uint32_t corner{ 0 }; corner < 3; ++corner) {
+			auto a = simplifier_remap(remap, indices[i + corner]);
+			auto b = simplifier_remap(remap, indices[i + (corner + 1) % 3]);
+			adjacency.data[fill[a]++] = b;
+			if (undirected)
+				adjacency.data[fill[b]++] = a;
+		}
+	}
+	return adjacency;
+}
+
+//Triangles around each remapped vertex
+static SimplifierAdjacency simplifier_build_fans(std::span<const uint32_t> indices, std::span<const uint32_t> remap, size_t vertexCount)
+{
+	SimplifierAdjacency adjacency{ .offsets = std::vector<uint32_t>(vertexCount + 1, 0) };
+	for (auto index : indices)
+		adjacency.offsets[simplifier_remap(remap, index) + 1]++;
+	std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+	adjacency.data.resize(adjacency.offsets.back());
+	std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+	for (size_t i{ 0 }; i < indices.size(); ++i)
+		adjacency.data[fill[simplifier_remap(remap, indices[i])]++] = static_cast<uint32_t>(i / 3);
+	return adjacency;
+}
+
+struct SimplifierCollapse {
+	uint32_t from;
+	uint32_t to;
+	float cost;
+	float error;
+};
+
+//Stable radix sort by cost, non negative floats sort like their bit patterns
+static void simplifier_sort_collapses(std::vector<SimplifierCollapse>& collapses, std::vector<SimplifierCollapse>& scratch)
+{
+	constexpr uint32_t radixBits{ 11 };
+	constexpr uint32_t radixSize{ 1u << radixBits };
+	scratch.resize(collapses.size());
+	for (uint32_t shift{ 0 }; shift < 32; shift += radixBits) {
+		std::array<uint32_t, radixSize> histogram{};
+		for (const auto& collapse : collapses)
+			histogram[(std::bit_cast<uint32_t>(collapse.cost) >> shift) & (radixSize - 1)]++;
+		uint32_t sum{ 0 };
+		for (auto& bucket : histogram)
+			sum += std::exchange(bucket, sum);
+		for (const auto& collapse : collapses)
+			scratch[histogram[(std::bit_cast<uint32_t>(collapse.cost) >> shift) & (radixSize - 1)]++] = collapse;
+		collapses.swap(scratch);
+	}
+}
+
+//Ericson, Real-Time Collision Detection 5.1.5
+static float simplifier_point_triangle_distance_squared(const Math::vec3& p, const Math::vec3& a, const Math::vec3& b, const Math::vec3& c)
+{
+	auto ab = b - a;
+	auto ac = c - a;
+	auto ap = p - a;
+	auto d1 = ab.dot(ap);
+	auto d2 = ac.dot(ap);
+	if (d1 <= 0.f && d2 <= 0.f)
+		return ap.L2_square();
+	auto bp = p - b;
+	auto d3 = ab.dot(bp);
+	auto d4 = ac.dot(bp);
+	if (d3 >= 0.f && d4 <= d3)
+		return bp.L2_square();
+	auto vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+		return (p - (a + ab * (d1 / (d1 - d3)))).L2_square();
+	auto cp = p - c;
+	auto d5 = ab.dot(cp);
+	auto d6 = ac.dot(cp);
+	if (d6 >= 0.f && d5 <= d6)
+		return cp.L2_square();
+	auto vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+		return (p - (a + ac * (d2 / (d2 - d6)))).L2_square();
+	auto va = d3 * d6 - d5 * d4;
+	if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+		return (p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))))).L2_square();
+	auto denom = 1.f / (va + vb + vc);
+	return (p - (a + ab * (vb * denom) + ac * (vc * denom))).L2_square();
+}
+
+//Uniform grid over triangles for closest surface point queries
+class SimplifierTriangleGrid {
+public:
+	SimplifierTriangleGrid(const nyan::Mesh& mesh, const Math::vec3& min, const Math::vec3& max) :
+		r_mesh(mesh),
+		m_min(min)
+	{
+		const auto triangleCount = std::max<size_t>(mesh.indices.size() / 3, 1);
+		auto extent = max - min;
+		auto maxExtent = std::max({ extent[0], extent[1], extent[2], 1e-6f });
+		//Cells about the size of an average triangle, a surface only touches a small fraction of the cells
+		double area{ 0.0 };
+		for (size_t i{ 0 }; i < mesh.indices.size(); i += 3) {
+			const auto& p0 = mesh.positions[mesh.indices[i]];
+			area += 0.5 * (mesh.positions[mesh.indices[i + 1]] - p0).cross(mesh.positions[mesh.indices[i + 2]] - p0).L2_norm();
+		}
+		m_cellSize = std::max(static_cast<float>(std::sqrt(area / static_cast<double>(triangleCount))) * 2.f, maxExtent / 1024.f);
+		//Limit the memory of volumetric meshes
+		while (std::ceil(extent[0] / m_cellSize) * std::ceil(extent[1] / m_cellSize) * std::ceil(extent[2] / m_cellSize) > 8.f * static_cast<float>(triangleCount))
+			m_cellSize *= 1.25f;
+		for (uint32_t axis{ 0 }; axis < 3; ++axis)
+			m_resolution[axis] = std::max(1u, static_cast<uint32_t>(std::ceil(extent[axis] / m_cellSize)));
+
+		m_cells.offsets.assign(static_cast<size_t>(m_resolution[0]) * m_resolution[1] * m_resolution[2] + 1, 0);
+		auto for_each_cell = [&](size_t triangle, auto&& function) {
+			std::array<uint32_t, 3> first, last;
+			for (uint32_t axis{ 0 }; axis < 3; ++axis) {
+				float lo{ std::numeric_limits<float>::max() };
+				float hi{ -std::numeric_limits<float>::max() };
+				for (uint32_t corner{ 0 }; corner < 3; ++corner) {
+					auto value = mesh.positions[mesh.indices[triangle * 3 + corner]][axis];
+					lo = std::min(lo, value);
+					hi = std::max(hi, value);
+				}
+				first[axis] = cell_coordinate(lo, axis);
+				last[axis] = cell_coordinate(hi, axis);
+			}
+			for (auto z = first[2]; z <= last[2]; ++z)
+				for (auto y = first[1]; y <= last[1]; ++y)
+					for (auto x = first[0]; x <= last[0]; ++x)
+						function(cell_index(x, y, z));
+		};
+		for (size_t triangle{ 0 }; triangle < mesh.indices.size() / 3; ++triangle)
+			for_each_cell(triangle, [&](size_t cell) { m_cells.offsets[cell + 1]++; });
+		std::partial_sum(m_cells.offsets.begin(), m_cells.offsets.end(), m_cells.offsets.begin());
+		m_cells.data.resize(m_cells.offsets.back());
+		std::vector<uint32_t> fill(m_cells.offsets.begin(), m_cells.offsets.end() - 1);
+		for (size_t triangle{ 0 }; triangle < mesh.indices.size() / 3; ++triangle)
+			for_each_cell(triangle, [&](size_t cell) { m_cells.data[fill[cell]++] = static_cast<uint32_t>(triangle); });
+	}
+	float distance_squared(const Math::vec3& point) const {
+		std::array<int32_t, 3> center;
+		for (uint32_t axis{ 0 }; axis < 3; ++axis)
+			center[axis] = static_cast<int32_t>(cell_coordinate(point[axis], axis));
+		const auto maxRing = static_cast<int32_t>(std::max({ m_resolution[0], m_resolution[1], m_resolution[2] }));
+		float best{ std::numeric_limits<float>::max() };
+		for (int32_t ring{ 0 }; ring <= maxRing; ++ring) {
+			for (int32_t z = std::max(center[2] - ring, 0); z <= std::min(center[2] + ring, static_cast<int32_t>(m_resolution[2]) - 1); ++z) {
+				for (int32_t y = std::max(center[1] - ring, 0); y <= std::min(center[1] + ring, static_cast<int32_t>(m_resolution[1]) - 1); ++y) {
+					for (int32_t x = std::max(center[0] - ring, 0); x <= std::min(center[0] + ring, static_cast<int32_t>(m_resolution[0]) - 1); ++x) {
+						if (std::max({ std::abs(x - center[0]), std::abs(y - center[1]), std::abs(z - center[2]) }) != ring)
+							continue;
+						for (auto triangle : m_cells[static_cast<uint32_t>(cell_index(x, y, z))]) {
+							best = std::min(best, simplifier_point_triangle_distance_squared(point,
+								r_mesh.positions[r_mesh.indices[triangle * 3 + 0]],
+								r_mesh.positions[r_mesh.indices[triangle * 3 + 1]],
+								r_mesh.positions[r_mesh.indices[triangle * 3 + 2]]));
+						}
+					}
+				}
+			}
+			//Distance from the point to the outside of the searched block, the grid borders don't count since there are no cells beyond
+			auto bound = std::numeric_limits<float>::max();
+			for (uint32_t axis{ 0 }; axis < 3; ++axis) {
+				if (center[axis] - ring > 0)
+					bound = std::min(bound, point[axis] - (m_min[axis] + static_cast<float>(center[axis] - ring) * m_cellSize));
+				if (center[axis] + ring + 1 < static_cast<int32_t>(m_resolution[axis]))
+					bound = std::min(bound, m_min[axis] + static_cast<float>(center[axis] + ring + 1) * m_cellSize - point[axis]);
+			}
+			bound = std::max(bound, 0.f);
+			if (bound == std::numeric_limits<float>::max() || best <= bound * bound)
+				break;
+		}
+		return best;
+	}
+private:
+	uint32_t cell_coordinate(float value, uint32_t axis) const {
+		auto cell = static_cast<int64_t>(std::floor((value - m_min[axis]) / m_cellSize));
+		return static_cast<uint32_t>(std::clamp<int64_t>(cell, 0, m_resolution[axis] - 1));
+	}
+	size_t cell_index(size_t x, size_t y, size_t z) const {
+		return x + m_resolution[0] * (y + m_resolution[1] * z);
+	}
+	const nyan::Mesh& r_mesh;
+	Math::vec3 m_min;
+	float m_cellSize;
+	std::array<uint32_t, 3> m_resolution;
+	SimplifierAdjacency m_cells;
+};
+
+//Maximum and sum of the distances of samples on from to the surface of to
+static std::pair<float, double> simplifier_one_sided_distance(const nyan::Mesh& from, const SimplifierTriangleGrid& to, size_t& sampleCount)
+{
+	const auto triangleCount = from.indices.size() / 3;
+	constexpr size_t batchSize{ 1024 };
+	const auto batchCount = (triangleCount + batchSize - 1) / batchSize;
+	std::vector<std::pair<float, double>> batches(batchCount, { 0.f, 0.0 });
+	Utility::JobSystem::get().parallel_for(batchCount, [&](size_t batch) {
+		auto& [maximum, sum] = batches[batch];
+		auto sample = [&](const Math::vec3& point) {
+			auto distance = std::sqrt(to.distance_squared(point));
+			maximum = std::max(maximum, distance);
+			sum += distance;
+		};
+		for (auto triangle = batch * batchSize; triangle < std::min(triangleCount, (batch + 1) * batchSize); ++triangle) {
+			const auto& p0 = from.positions[from.indices[triangle * 3 + 0]];
+			const auto& p1 = from.positions[from.indices[triangle * 3 + 1]];
+			const auto& p2 = from.positions[from.indices[triangle * 3 + 2]];
+			//Corners and edges are shared between triangles, sample one of each per triangle
+			sample(p0);
+			sample((p0 + p1) * 0.5f);
+			sample((p0 + p1 + p2) * (1.f / 3.f));
+		}
+	});
+	sampleCount += triangleCount * 3;
+	std::pair<float, double> result{ 0.f, 0.0 };
+	for (const auto& [maximum, sum] : batches) {
+		result.first = std::max(result.first, maximum);
+		result.second += sum;
+	}
+	return result;
+}
+
+nyan::MeshSimplifier::Result nyan::MeshSimplifier::simplify(const nyan::Mesh& mesh, std::span<const uint32_t> sourceIndices, size_t targetIndexCount, const Settings& settings)
+{
+	assert(sourceIndices.size() % 3 == 0);
+	const auto vertexCount = mesh.positions.size();
+	Result result{ .indices {sourceIndices.begin(), sourceIndices.end()}, .error {0.f} };
+	if (result.indices.size() <= targetIndexCount || !vertexCount)
+		return result;
+
+	//Normalize to the unit cube so that errors and attribute weights are independent of the mesh scale
+	Math::vec3 min{ std::numeric_limits<float>::max() };
+	Math::vec3 max{ -std::numeric_limits<float>::max() };
+	for (const auto& position : mesh.positions) {
+		for (uint32_t axis{ 0 }; axis < 3; ++axis) {
+			min[axis] = std::min(min[axis], position[axis]);
+			max[axis] = std::max(max[axis], position[axis]);
+		}
+	}
+	auto extent = std::max({ max[0] - min[0], max[1] - min[1], max[2] - min[2] });
+	if (extent <= 0.f)
+		extent = 1.f;
+	std::vector<Math::vec3> positions(vertexCount);
+	for (size_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+		positions[vertex] = (mesh.positions[vertex] - min) * (1.f / extent);
+
+	//Vertices with identical positions are wedges of one position, positionIds point to the first one
+	std::vector<uint32_t> positionIds(vertexCount);
+	std::vector<uint32_t> wedges(vertexCount);
+	{
+		std::unordered_map<std::array<uint32_t, 3>, uint32_t, SimplifierPositionHash> firstVertex;
+		firstVertex.reserve(vertexCount);
+		for (uint32_t vertex{ 0 }; vertex < vertexCount; ++vertex) {
+			const auto& position = mesh.positions[vertex];
+			//Adding zero turns -0 into +0
+			auto [it, inserted] = firstVertex.try_emplace({ std::bit_cast<uint32_t>(position[0] + 0.f), std::bit_cast<uint32_t>(position[1] + 0.f), std::bit_cast<uint32_t>(position[2] + 0.f) }, vertex);
+			positionIds[vertex] = it->second;
+			if (inserted) {
+				wedges[vertex] = vertex;
+			}
+			else {
+				wedges[vertex] = wedges[it->second];
+				wedges[it->second] = vertex;
+			}
+		}
+	}
+	auto degenerate = [&](const uint32_t* triangle) {
+		auto a = positionIds[triangle[0]];
+		auto b = positionIds[triangle[1]];
+		auto c = positionIds[triangle[2]];
+		return a == b || b == c || a == c;
+	};
+	{
+		size_t write{ 0 };
+		for (size_t i{ 0 }; i < result.indices.size(); i += 3) {
+			if (degenerate(&result.indices[i]))
+				continue;
+			std::copy_n(&result.indices[i], 3, &result.indices[write]);
+			write += 3;
+		}
+		result.indices.resize(write);
+	}
+
+	const bool hasUvs = mesh.uvs0.size() == vertexCount && settings.uvWeight > 0.f;
+	const bool hasNormals = mesh.normals.size() == vertexCount && settings.normalWeight > 0.f;
+	const uint32_t attributeCount = (hasUvs ? 2 : 0) + (hasNormals ? 3 : 0);
+	std::vector<float> attributes(vertexCount * attributeCount);
+	for (size_t vertex{ 0 }; vertex < vertexCount; ++vertex) {
+		auto* attribute = &attributes[vertex * attributeCount];
+		if (hasUvs)
+			for (uint32_t i{ 0 }; i < 2; ++i)
+				*attribute++ = static_cast<float>(mesh.uvs0[vertex][i]) * settings.uvWeight;
+		if (hasNormals)
+			for (uint32_t i{ 0 }; i < 3; ++i)
+				*attribute++ = static_cast<float>(mesh.normals[vertex][i]) * settings.normalWeight;
+	}
+
+	//Position quadrics are stored at the position id, attribute quadrics per wedge
+	std::vector<SimplifierQuadric> quadrics(vertexCount);
+	std::vector<SimplifierAttributeQuadric> attributeQuadrics(vertexCount * attributeCount);
+	//Normals of the source triangles, kept in sync with the simplified triangles
+	std::vector<Math::vec3> triangleNormals(result.indices.size() / 3, Math::vec3{ 0.f });
+	for (size_t i{ 0 }; i < result.indices.size(); i += 3) {
+		const auto* triangle = &result.indices[i];
+		const auto& p0 = positions[triangle[0]];
+		const auto& p1 = positions[triangle[1]];
+		const auto& p2 = positions[triangle[2]];
+		auto e1 = p1 - p0;
+		auto e2 = p2 - p0;
+		auto normal = e1.cross(e2);
+		auto length = normal.L2_norm();
+		if (length <= 0.f)
+			continue;
+		auto area = length * 0.5f;
+		normal *= 1.f / length;
+		triangleNormals[i / 3] = normal;
+		auto plane = SimplifierQuadric::plane(normal, -normal.dot(p0), area);
+		for (uint32_t corner{ 0 }; corner < 3; ++corner)
+			quadrics[positionIds[triangle[corner]]] += plane;
+		if (!attributeCount)
+			continue;
+		//Gradient of the attribute within the triangle plane, dot(g, e1) = a1 - a0 and dot(g, e2) = a2 - a0
+		auto e11 = e1.dot(e1);
+		auto e12 = e1.dot(e2);
+		auto e22 = e2.dot(e2);
+		auto det = e11 * e22 - e12 * e12;
+		if (det <= 0.f)
+			continue;
+		auto invDet = 1.f / det;
+		for (uint32_t k{ 0 }; k < attributeCount; ++k) {
+			auto a0 = attributes[triangle[0] * attributeCount + k];
+			auto da1 = attributes[triangle[1] * attributeCount + k] - a0;
+			auto da2 = attributes[triangle[2] * attributeCount + k] - a0;
+			auto gradient = e1 * ((da1 * e22 - da2 * e12) * invDet) + e2 * ((da2 * e11 - da1 * e12) * invDet);
+			auto offset = a0 - gradient.dot(p0);
+			SimplifierAttributeQuadric quadric{
+				.plane {SimplifierQuadric::plane(gradient, offset, area)},
+				.gradient {gradient * area},
+				.offset {offset * area},
+			};
+			for (uint32_t corner{ 0 }; corner < 3; ++corner)
+				attributeQuadrics[triangle[corner] * attributeCount + k] += quadric;
+		}
+	}
+
+	//Classify positions by their open edges and attribute seams, both get planes perpendicular to the surface to keep them in place
+	std::vector<SimplifierVertexKind> kinds(vertexCount, SimplifierVertexKind::Locked);
+	{
+		auto positionEdges = simplifier_build_edges(result.indices, positionIds, vertexCount, false);
+		auto vertexEdges = simplifier_build_edges(result.indices, {}, vertexCount, false);
+		std::vector<uint32_t> openOut(vertexCount, 0);
+		std::vector<uint32_t> openIn(vertexCount, 0);
+		std::vector<uint32_t> seamOut(vertexCount, 0);
+		std::vector<uint32_t> seamIn(vertexCount, 0);
+		for (size_t i{ 0 }; i < result.indices.size(); i += 3) {
+			for (uint32_t corner{ 0 }; corner < 3; ++corner) {
+				auto x = result.indices[i + corner];
+				auto y = result.indices[i + (corner + 1) % 3];
+				auto a = positionIds[x];
+				auto b = positionIds[y];
+				bool open = !positionEdges.contains(b, a);
+				bool seam = !open && !vertexEdges.contains(y, x);
+				if (open) {
+					openOut[a]++;
+					openIn[b]++;
+				}
+				if (seam) {
+					seamOut[x]++;
+					seamIn[y]++;
+				}
+				if (!open && !seam)
+					continue;
+				auto edge = positions[b] - positions[a];
+				auto normal = edge.cross(triangleNormals[i / 3]);
+				auto length = normal.L2_norm();
+				if (length <= 0.f)
+					continue;
+				normal *= 1.f / length;
+				auto plane = SimplifierQuadric::plane(normal, -normal.dot(positions[a]), edge.L2_square() * settings.borderWeight);
+				quadrics[a] += plane;
+				quadrics[b] += plane;
+			}
+		}
+		for (uint32_t vertex{ 0 }; vertex < vertexCount; ++vertex) {
+			if (positionIds[vertex] != vertex)
+				continue;
+			uint32_t wedgeCount{ 0 };
+			bool seamsValid{ true };
+			bool hasSeams{ false };
+			auto wedge = vertex;
+			do {
+				wedgeCount++;
+				seamsValid &= seamOut[wedge] == 1 && seamIn[wedge] == 1;
+				hasSeams |= seamOut[wedge] || seamIn[wedge];
+				wedge = wedges[wedge];
+			} while (wedge != vertex);
+			if (wedgeCount == 1 && !hasSeams) {
+				if (!openOut[vertex] && !openIn[vertex])
+					kinds[vertex] = SimplifierVertexKind::Manifold;
+				else if (openOut[vertex] == 1 && openIn[vertex] == 1 && !settings.lockBorder)
+					kinds[vertex] = SimplifierVertexKind::Border;
+			}
+			else if (wedgeCount == 2 && seamsValid && !openOut[vertex] && !openIn[vertex]) {
+				kinds[vertex] = SimplifierVertexKind::Seam;
+			}
+		}
+	}
+
+	std::vector<SimplifierCollapse> collapses;
+	std::vector<SimplifierCollapse> sortScratch;
+	std::vector<uint32_t> collapseRemap(vertexCount);
+	std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+	std::vector<uint8_t> collapseLocked(vertexCount);
+	const float maxError = settings.maxError * settings.maxError;
+	float resultError{ 0.f };
+
+	while (result.indices.size() > targetIndexCount) {
+		auto neighbours = simplifier_build_edges(result.indices, {}, vertexCount, true);
+		auto positionEdges = simplifier_build_edges(result.indices, positionIds, vertexCount, false);
+		auto fans = simplifier_build_fans(result.indices, positionIds, vertexCount);
+
+		//Each wedge of from has to move onto the unique wedge of to it shares an edge with
+		auto find_partners = [&](uint32_t from, uint32_t to, std::array<uint32_t, 2>& partners) {
+			uint32_t count{ 0 };
+			auto wedge = from;
+			do {
+				if (count == partners.size())
+					return false;
+				uint32_t partner{ ~0u };
+				auto candidate = to;
+				do {
+					if (neighbours.contains(wedge, candidate)) {
+						if (partner != ~0u)
+							return false;
+						partner = candidate;
+					}
+					candidate = wedges[candidate];
+				} while (candidate != to);
+				if (partner == ~0u)
+					return false;
+				partners[count++] = partner;
+				wedge = wedges[wedge];
+			} while (wedge != from);
+			return count == 1 || partners[0] != partners[1];
+		};
+		auto evaluate = [&](uint32_t from, uint32_t to, const std::array<uint32_t, 2>& partners, float& error) {
+			auto quadric = quadrics[from];
+			quadric += quadrics[to];
+			auto weight = std::max(quadric.w, 1e-20f);
+			error = std::abs(quadric.evaluate(positions[to])) / weight;
+			if (!attributeCount)
+				return error;
+			float attributeError{ 0.f };
+			uint32_t idx{ 0 };
+			auto wedge = from;
+			do {
+				auto partner = partners[idx++];
+				for (uint32_t k{ 0 }; k < attributeCount; ++k) {
+					auto attributeQuadric = attributeQuadrics[wedge * attributeCount + k];
+					attributeQuadric += attributeQuadrics[partner * attributeCount + k];
+					attributeError += attributeQuadric.evaluate(positions[to], attributes[partner * attributeCount + k]);
+				}
+				wedge = wedges[wedge];
+			} while (wedge != from);
+			return error + std::abs(attributeError) / weight;
+		};
+		auto allowed = [&](uint32_t from, uint32_t to) {
+			switch (kinds[from]) {
+			case SimplifierVertexKind::Manifold:
+				return true;
+			case SimplifierVertexKind::Border:
+				return !positionEdges.contains(to, from) || !positionEdges.contains(from, to);
+			case SimplifierVertexKind::Seam:
+				return kinds[to] == SimplifierVertexKind::Seam || kinds[to] == SimplifierVertexKind::Locked;
+			default:
+				return false;
+			}
+		};
+
+		collapses.clear();
+		for (size_t i{ 0 }; i < result.indices.size(); i += 3) {
+			for (uint32_t corner{ 0 }; corner < 3; ++corner) {
+				auto a = positionIds[result.indices[i + corner]];
+				auto b = positionIds[result.indices[i + (corner + 1) % 3]];
+				//Interior edges are seen from both sides, only consider them once
+				if (a > b && positionEdges.contains(b, a))
+					continue;
+				SimplifierCollapse best{ .from {~0u}, .to {~0u}, .cost {std::numeric_limits<float>::max()}, .error {0.f} };
+				for (auto [from, to] : { std::pair{ a, b }, std::pair{ b, a } }) {
+					std::array<uint32_t, 2> partners;
+					if (!allowed(from, to) || !find_partners(from, to, partners))
+						continue;
+					float error;
+					auto cost = evaluate(from, to, partners, error);
+					if (cost < best.cost)
+						best = SimplifierCollapse{ .from {from}, .to {to}, .cost {cost}, .error {error} };
+				}
+				if (best.from != ~0u && best.error <= maxError)
+					collapses.push_back(best);
+			}
+		}
+		if (collapses.empty())
+			break;
+		simplifier_sort_collapses(collapses, sortScratch);
+
+		//Interior collapses remove two triangles, limit the pass so the target isn't overshot and bad collapses wait for updated quadrics
+		const auto triangleCount = result.indices.size() / 3;
+		const auto collapseGoal = std::max<size_t>((triangleCount - targetIndexCount / 3 + 1) / 2, 1);
+		//Skipped collapses move the cost goal further down the sorted list
+		size_t skipped{ 0 };
+		auto cost_goal = [&]() {
+			return collapseGoal + skipped < collapses.size() ? collapses[collapseGoal + skipped].cost * 1.5f : std::numeric_limits<float>::max();
+		};
+		std::fill(collapseLocked.begin(), collapseLocked.end(), 0);
+		size_t applied{ 0 };
+		for (const auto& collapse : collapses) {
+			if (applied >= collapseGoal || collapse.cost > cost_goal())
+				break;
+			if (collapseLocked[collapse.from] || collapseLocked[collapse.to]) {
+				skipped++;
+				continue;
+			}
+			//Reject collapses which flip or strongly rotate triangles around from
+			bool flips{ false };
+			for (auto triangle : fans[collapse.from]) {
+				uint32_t corner{ 0 };
+				while (positionIds[result.indices[triangle * 3 + corner]] != collapse.from)
+					corner++;
+				auto b = positionIds[result.indices[triangle * 3 + (corner + 1) % 3]];
+				auto c = positionIds[result.indices[triangle * 3 + (corner + 2) % 3]];
+				if (b == collapse.to || c == collapse.to)
+					continue;
+				auto before = (positions[b] - positions[collapse.from]).cross(positions[c] - positions[collapse.from]);
+				auto after = (positions[b] - positions[collapse.to]).cross(positions[c] - positions[collapse.to]);
+				//Small rotations can add up over many collapses, also compare against the source surface
+				if (before.dot(after) <= 0.25f * before.L2_norm() * after.L2_norm() || after.dot(triangleNormals[triangle]) < 0.f) {
+					flips = true;
+					break;
+				}
+			}
+			if (flips) {
+				skipped++;
+				continue;
+			}
+			std::array<uint32_t, 2> partners;
+			[[maybe_unused]] auto found = find_partners(collapse.from, collapse.to, partners);
+			assert(found);
+			uint32_t idx{ 0 };
+			auto wedge = collapse.from;
+			do {
+				auto partner = partners[idx++];
+				collapseRemap[wedge] = partner;
+				for (uint32_t k{ 0 }; k < attributeCount; ++k)
+					attributeQuadrics[partner * attributeCount + k] += attributeQuadrics[wedge * attributeCount + k];
+				wedge = wedges[wedge];
+			} while (wedge != collapse.from);
+			quadrics[collapse.to] += quadrics[collapse.from];
+			resultError = std::max(resultError, collapse.error);
+			//Flip checks assume that only from moves within its fan
+			for (auto triangle : fans[collapse.from])
+				for (uint32_t corner{ 0 }; corner < 3; ++corner)
+					collapseLocked[positionIds[result.indices[triangle * 3 + corner]]] = 1;
+			applied++;
+		}
+		if (!applied)
+			break;
+		size_t write{ 0 };
+		for (size_t i{ 0 }; i < result.indices.size(); i += 3) {
+			std::array<uint32_t, 3> triangle{ collapseRemap[result.indices[i]], collapseRemap[result.indices[i + 1]], collapseRemap[result.indices[i + 2]] };
+			if (degenerate(triangle.data()))
+				continue;
+			std::copy(triangle.begin(), triangle.end(), &result.indices[write]);
+			triangleNormals[write / 3] = triangleNormals[i / 3];
+			write += 3;
+		}
+		result.indices.resize(write);
+		triangleNormals.resize(write / 3);
+	}
+	result.error = std::sqrt(resultError) * extent;
+	return result;
+}
+
+nyan::MeshSimplifier::Result nyan::MeshSimplifier::simplify(const nyan::Mesh& mesh, size_t targetIndexCount, const Settings& settings)
+{
+	return simplify(mesh, mesh.indices, targetIndexCount, settings);
+}
+
+nyan::MeshSimplifier::Result nyan::MeshSimplifier::simplify(const nyan::Mesh& mesh, size_t targetIndexCount)
+{
+	return simplify(mesh, mesh.indices, targetIndexCount, Settings{});
+}
+
+std::vector<nyan::MeshLod> nyan::MeshSimplifier::generate_lods(const nyan::Mesh& mesh, const LodSettings& settings)
+{
+	std::vector<MeshLod> lods;
+	lods.reserve(settings.ratios.size());
+	const auto* previous = &mesh;
+	float error{ 0.f };
+	const auto triangleCount = mesh.indices.size() / 3;
+	for (auto ratio : settings.ratios) {
+		auto target = static_cast<size_t>(static_cast<float>(triangleCount) * ratio) * 3;
+		//Simplify the previous level, each step only measures its error against that level
+		auto result = simplify(*previous, target, settings.simplification);
+		if (result.indices.empty() || static_cast<float>(result.indices.size()) > static_cast<float>(previous->indices.size()) * (1.f - settings.minReduction))
+			break;
+		error += result.error;
+		MeshLod lod{ .mesh {*previous}, .error {error} };
+		lod.mesh.name = mesh.name + "_LOD" + std::to_string(lods.size() + 1);
+		lod.mesh.indices = std::move(result.indices);
+		if (settings.optimize)
+			MeshOptimizer::optimize(lod.mesh);
+		else
+			MeshOptimizer::optimize_vertex_fetch(lod.mesh);
+		lods.push_back(std::move(lod));
+		previous = &lods.back().mesh;
+	}
+	return lods;
+}
+
+std::vector<nyan::MeshLod> nyan::MeshSimplifier::generate_lods(const nyan::Mesh& mesh)
+{
+	return generate_lods(mesh, LodSettings{});
+}
+
+std::vector<std::vector<nyan::MeshLod>> nyan::MeshSimplifier::generate_lods(std::span<const nyan::Mesh> meshes, const LodSettings& settings)
+{
+	std::vector<std::vector<MeshLod>> lods(meshes.size());
+	Utility::JobSystem::get().parallel_for(meshes.size(), [&](size_t i) {
+		lods[i] = generate_lods(meshes[i], settings);
+	});
+	return lods;
+}
+
+std::vector<std::vector<nyan::MeshLod>> nyan::MeshSimplifier::generate_lods(std::span<const nyan::Mesh> meshes)
+{
+	return generate_lods(meshes, LodSettings{});
+}
+
+nyan::MeshDistance nyan::MeshSimplifier::measure_distance(const nyan::Mesh& reference, const nyan::Mesh& simplified)
+{
+	if (reference.indices.empty() || simplified.indices.empty())
+		return {};
+	Math::vec3 min{ std::numeric_limits<float>::max() };
+	Math::vec3 max{ -std::numeric_limits<float>::max() };
+	for (const auto* mesh : { &reference, &simplified }) {
+		for (auto index : mesh->indices) {
+			for (uint32_t axis{ 0 }; axis < 3; ++axis) {
+				min[axis] = std::min(min[axis], mesh->positions[index][axis]);
+				max[axis] = std::max(max[axis], mesh->positions[index][axis]);
+			}
+		}
+	}
+	SimplifierTriangleGrid referenceGrid{ reference, min, max };
+	SimplifierTriangleGrid simplifiedGrid{ simplified, min, max };
+	size_t sampleCount{ 0 };
+	auto [forwardMax, forwardSum] = simplifier_one_sided_distance(reference, simplifiedGrid, sampleCount);
+	auto [backwardMax, backwardSum] = simplifier_one_sided_distance(simplified, referenceGrid, sampleCount);
+	return MeshDistance{
+		.hausdorff {std::max(forwardMax, backwardMax)},
+		.mean {static_cast<float>((forwardSum + backwardSum) / static_cast<double>(sampleCount))},
+	};
+}
+
+float nyan::LodSelector::projected_error(float error, float distance, const PerspectiveCamera& camera, float screenWidth)
+{
+	auto halfWidth = std::tan(camera.fovX * 0.5f * static_cast<float>(Math::deg_to_rad));
+	return error * screenWidth / (2.f * halfWidth * std::max(distance, camera.nearPlane));
+}
+
+uint32_t nyan::LodSelector::select(std::span<const float> errors, float distance, const PerspectiveCamera& camera, float screenWidth, float threshold)
+{
+	uint32_t lod{ 0 };
+	for (uint32_t i{ 1 }; i < errors.size(); ++i) {
+		if (projected_error(errors[i], distance, camera, screenWidth) > threshold)
+			break;
+		lod = i;
+	}
+	return lod;
+}
@@ -0,0 +1,407 @@
+#include "Renderer/MeshletBuilder.h"
+#include "Utility/JobSystem.h"
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cassert>
+
+//Kd-tree over triangle centroids, used to seed meshlets with the nearest unused triangle
+class MeshletKdTree {
+public:
+	MeshletKdTree(std::span<const Math::vec3> points) :
+		r_points(points),
+		m_items(points.size()),
+		m_leafOf(points.size()),
+		m_removed(points.size(), false)
+	{
+		std::iota(m_items.begin(), m_items.end(), 0u);
+		m_nodes.reserve(2 * (points.size() / leafSize + 1));
+		build(0, static_cast<uint32_t>(points.size()), invalid);
+	}
+	void remove(uint32_t item) {
+		for (auto node = m_leafOf[item]; node != invalid; node = m_nodes[node].parent)
+			m_nodes[node].remaining--;
+		m_removed[item] = true;
+	}
+	uint32_t nearest(const Math::vec3& point) const {
+		uint32_t best{ invalid };
+		float bestDistance{ std::numeric_limits<float>::max() };
+		if (!m_nodes.empty())
+			nearest(0, point, best, bestDistance);
+		return best;
+	}
+private:
+	static constexpr uint32_t leafSize{ 8 };
+	static constexpr uint32_t invalid{ ~0u };
+	struct Node {
+		uint32_t parent;
+		uint32_t remaining;
+		uint32_t first;
+		uint32_t count;
+		uint32_t axis;
+		uint32_t right;
+		float split;
+	};
+	uint32_t build(uint32_t first, uint32_t count, uint32_t parent) {
+		auto nodeIdx = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.push_back(Node{ .parent {parent}, .remaining {count}, .first {first}, .count {count}, .axis {3}, .right {invalid}, .split {0.f} });
+		if (count <= leafSize) {
+			for (uint32_t i{ first }; i < first + count; ++i)
+				m_leafOf[m_items[i]] = nodeIdx;
+			return nodeIdx;
+		}
+		Math::vec3 min{ std::numeric_limits<float>::max() };
+		Math::vec3 max{ -std::numeric_limits<float>::max() };
+		for (uint32_t i{ first }; i < first + count; ++i) {
+			const auto& p = r_points[m_items[i]];
+			for (uint32_t axis{ 0 }; axis < 3; ++axis) {
+				min[axis] = std::min(min[axis], p[axis]);
+				max[axis] = std::max(max[axis], p[axis]);
+			}
+		}
+		auto extent = max - min;
+		uint32_t axis = (extent[0] >= extent[1] && extent[0] >= extent[2]) ? 0 : (extent[1] >= extent[2] ? 1 : 2);
+		auto middle = first + count / 2;
+		std::nth_element(m_items.begin() + first, m_items.begin() + middle, m_items.begin() + first + count,
+			[&](uint32_t lhs, uint32_t rhs) { return r_points[lhs][axis] < r_points[rhs][axis]; });
+		m_nodes[nodeIdx].axis = axis;
+		m_nodes[nodeIdx].split = r_points[m_items[middle]][axis];
+		build(first, middle - first, nodeIdx);
+		auto right = build(middle, first + count - middle, nodeIdx);
+		m_nodes[nodeIdx].right = right;
+		return nodeIdx;
+	}
+	void nearest(uint32_t nodeIdx, const Math::vec3& point, uint32_t& best, float& bestDistance) const {
+		const auto& node = m_nodes[nodeIdx];
+		if (!node.remaining)
+			return;
+		if (node.axis == 3) {
+			for (uint32_t i{ node.first }; i < node.first + node.count; ++i) {
+				auto item = m_items[i];
+				if (m_removed[item])
+					continue;
+				auto distance = (r_points[item] - point).L2_square();
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					best = item;
+				}
+			}
+			return;
+		}
+		auto delta = point[node.axis] - node.split;
+		auto first = delta <= 0.f ? nodeIdx + 1 : node.right;
+		auto second = delta <= 0.f ? node.right : nodeIdx + 1;
+		nearest(first, point, best, bestDistance);
+		if (delta * delta <= bestDistance)
+			nearest(second, point, best, bestDistance);
+	}
+	std::span<const Math::vec3> r_points;
+	std::vector<uint32_t> m_items;
+	std::vector<uint32_t> m_leafOf;
+	std::vector<bool> m_removed;
+	std::vector<Node> m_nodes;
+};
+
+static Math::vec4 normalize_frustum_plane(const Math::vec4& plane)
+{
+	auto length = Math::vec3{ plane }.L2_norm();
+	if (length <= 0.f)
+		return Math::vec4{ 0.f, 0.f, 0.f, 1.f };
+	return plane / length;
+}
+
+nyan::MeshletData nyan::MeshletBuilder::build(const nyan::Mesh& mesh, const Settings& settings)
+{
+	assert(settings.maxVertices >= 3 && settings.maxVertices <= 256);
+	assert(settings.maxTriangles >= 1 && settings.maxTriangles <= 512);
+	MeshletData data{};
+	const auto vertexCount = mesh.positions.size();
+	const auto triangleCount = mesh.indices.size() / 3;
+	if (!triangleCount || !vertexCount)
+		return data;
+	const auto& indices = mesh.indices;
+	const auto& positions = mesh.positions;
+
+	std::vector<Math::vec3> centroids(triangleCount);
+	std::vector<Math::vec3> normals(triangleCount);
+	for (size_t triangle{ 0 }; triangle < triangleCount; ++triangle) {
+		const auto& p0 = positions[indices[triangle * 3 + 0]];
+		const auto& p1 = positions[indices[triangle * 3 + 1]];
+		const auto& p2 = positions[indices[triangle * 3 + 2]];
+		centroids[triangle] = (p0 + p1 + p2) * (1.f / 3.f);
+		auto normal = (p1 - p0).cross(p2 - p0);
+		auto length = normal.L2_norm();
+		normals[triangle] = length > 0.f ? normal * (1.f / length) : Math::vec3{ 0.f };
+	}
+
+	//Vertex to triangle adjacency, emitted triangles get swap removed from the live range
+	std::vector<uint32_t> liveCounts(vertexCount, 0);
+	std::vector<uint32_t> adjacencyOffsets(vertexCount, 0);
+	std::vector<uint32_t> adjacency(indices.size());
+	for (auto index : indices)
+		liveCounts[index]++;
+	for (size_t vertex{ 1 }; vertex < vertexCount; ++vertex)
+		adjacencyOffsets[vertex] = adjacencyOffsets[vertex - 1] + liveCounts[vertex - 1];
+	{
+		std::vector<uint32_t> fill(adjacencyOffsets);
+		for (size_t i{ 0 }; i < indices.size(); ++i)
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	MeshletKdTree kdTree{ centroids };
+	//Wider than the uint8_t triangle indices, a full meshlet of 256 vertices uses local index 255
+	constexpr uint16_t notInMeshlet{ 0xFFFF };
+	std::vector<uint16_t> localIndex(vertexCount, notInMeshlet);
+
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint8_t> meshletTriangles;
+	meshletVertices.reserve(settings.maxVertices);
+	meshletTriangles.reserve(settings.maxTriangles * 3);
+	Math::vec3 centroidSum{ 0.f };
+	Math::vec3 normalSum{ 0.f };
+	Math::vec3 lastCenter{ centroids[0] };
+
+	data.meshlets.reserve(triangleCount / settings.maxTriangles + 1);
+
+	auto flush = [&]() {
+		if (meshletTriangles.empty())
+			return;
+		nyan::shaders::Meshlet meshlet{
+			.vertexOffset {static_cast<uint32_t>(data.vertices.size())},
+			.triangleOffset {static_cast<uint32_t>(data.triangles.size())},
+			.vertexCount {static_cast<uint32_t>(meshletVertices.size())},
+			.triangleCount {static_cast<uint32_t>(meshletTriangles.size() / 3)},
+		};
+		data.meshlets.push_back(meshlet);
+		data.bounds.push_back(compute_bounds(meshletVertices, meshletTriangles, positions));
+		data.vertices.insert(data.vertices.end(), meshletVertices.begin(), meshletVertices.end());
+		data.triangles.insert(data.triangles.end(), meshletTriangles.begin(), meshletTriangles.end());
+		//Keep every meshlet's triangle block four byte aligned for uint loads on the gpu
+		while (data.triangles.size() & 3)
+			data.triangles.push_back(0);
+		lastCenter = centroidSum * (1.f / static_cast<float>(meshlet.triangleCount));
+		for (auto vertex : meshletVertices)
+			localIndex[vertex] = notInMeshlet;
+		meshletVertices.clear();
+		meshletTriangles.clear();
+		centroidSum = Math::vec3{ 0.f };
+		normalSum = Math::vec3{ 0.f };
+	};
+	auto new_vertices = [&](uint32_t triangle) {
+		uint32_t count{ 0 };
+		for (uint32_t j{ 0 }; j < 3; ++j)
+			count += localIndex[indices[triangle * 3 + j]] == notInMeshlet;
+		return count;
+	};
+
+	for (size_t emittedCount{ 0 }; emittedCount < triangleCount;) {
+		uint32_t best{ ~0u };
+		uint32_t bestExtra{ ~0u };
+		float bestScore{ std::numeric_limits<float>::max() };
+		if (!meshletTriangles.empty()) {
+			const auto center = centroidSum * (1.f / static_cast<float>(meshletTriangles.size() / 3));
+			auto axisLength = normalSum.L2_norm();
+			const auto axis = axisLength > 0.f ? normalSum * (1.f / axisLength) : Math::vec3{ 0.f };
+			for (auto vertex : meshletVertices) {
+				const auto begin = adjacencyOffsets[vertex];
+				for (auto it = begin; it < begin + liveCounts[vertex]; ++it) {
+					auto triangle = adjacency[it];
+					auto extra = new_vertices(triangle);
+					if (extra > bestExtra)
+						continue;
+					auto score = (centroids[triangle] - center).L2_square() * (1.f + settings.coneWeight * (1.f - normals[triangle].dot(axis)));
+					if (extra < bestExtra || score < bestScore) {
+						best = triangle;
+						bestExtra = extra;
+						bestScore = score;
+					}
+				}
+			}
+		}
+		if (best == ~0u) {
+			//Disconnected from the current meshlet, continue with the spatially closest triangle
+			best = kdTree.nearest(meshletTriangles.empty() ? lastCenter : centroidSum * (1.f / static_cast<float>(meshletTriangles.size() / 3)));
+			assert(best != ~0u);
+			bestExtra = new_vertices(best);
+		}
+		if (meshletVertices.size() + bestExtra > settings.maxVertices || meshletTriangles.size() / 3 + 1 > settings.maxTriangles) {
+			flush();
+			continue;
+		}
+		for (uint32_t j{ 0 }; j < 3; ++j) {
+			auto vertex = indices[best * 3 + j];
+			if (localIndex[vertex] == notInMeshlet) {
+				localIndex[vertex] = static_cast<uint16_t>(meshletVertices.size());
+				meshletVertices.push_back(vertex);
+			}
+			meshletTriangles.push_back(static_cast<uint8_t>(localIndex[vertex]));
+			const auto begin = adjacencyOffsets[vertex];
+			auto& live = liveCounts[vertex];
+			for (auto it = begin; it < begin + live; ++it) {
+				if (adjacency[it] == best) {
+					std::swap(adjacency[it], adjacency[begin + live - 1]);
+					live--;
+					break;
+				}
+			}
+		}
+		centroidSum += centroids[best];
+		normalSum += normals[best];
+		kdTree.remove(best);
+		emittedCount++;
+	}
+	flush();
+	return data;
+}
+
+nyan::MeshletData nyan::MeshletBuilder::build(const nyan::Mesh& mesh)
+{
+	return build(mesh, Settings{});
+}
+
+std::vector<nyan::MeshletData> nyan::MeshletBuilder::build(std::span<const nyan::Mesh> meshes, const Settings& settings)
+{
+	std::vector<MeshletData> data(meshes.size());
+	Utility::JobSystem::get().parallel_for(meshes.size(), [&](size_t i) {
+		data[i] = build(meshes[i], settings);
+	});
+	return data;
+}
+
+std::vector<nyan::MeshletData> nyan::MeshletBuilder::build(std::span<const nyan::Mesh> meshes)
+{
+	return build(meshes, Settings{});
+}
+
+nyan::shaders::MeshletBounds nyan::MeshletBuilder::compute_bounds(std::span<const uint32_t> vertices, std::span<const uint8_t> triangles, std::span<const Math::vec3> positions)
+{
+	assert(!vertices.empty());
+	assert(triangles.size() % 3 == 0);
+	nyan::shaders::MeshletBounds bounds{
+		.center {positions[vertices[0]]},
+		.radius {0.f},
+		.coneApex {Math::vec3{ 0.f }},
+		.coneCutoff {2.f},
+		.coneAxis {Math::vec3{ 0.f }},
+		.pad {0.f},
+	};
+	//Ritter's bounding sphere
+	auto farthest = [&](const Math::vec3& from) {
+		uint32_t result = vertices[0];
+		float distance{ -1.f };
+		for (auto vertex : vertices) {
+			auto d = (positions[vertex] - from).L2_square();
+			if (d > distance) {
+				distance = d;
+				result = vertex;
+			}
+		}
+		return result;
+	};
+	auto a = farthest(positions[vertices[0]]);
+	auto b = farthest(positions[a]);
+	bounds.center = (positions[a] + positions[b]) * 0.5f;
+	bounds.radius = (positions[b] - positions[a]).L2_norm() * 0.5f;
+	for (auto vertex : vertices) {
+		auto offset = positions[vertex] - bounds.center;
+		auto distance = offset.L2_norm();
+		if (distance > bounds.radius) {
+			auto newRadius = (bounds.radius + distance) * 0.5f;
+			bounds.center += offset * ((newRadius - bounds.radius) / distance);
+			bounds.radius = newRadius;
+		}
+	}
+
+	const size_t triangleCount = triangles.size() / 3;
+	std::vector<Math::vec3> normals;
+	normals.reserve(triangleCount);
+	Math::vec3 axis{ 0.f };
+	for (size_t triangle{ 0 }; triangle < triangleCount; ++triangle) {
+		const auto& p0 = positions[vertices[triangles[triangle * 3 + 0]]];
+		const auto& p1 = positions[vertices[triangles[triangle * 3 + 1]]];
+		const auto& p2 = positions[vertices[triangles[triangle * 3 + 2]]];
+		auto normal = (p1 - p0).cross(p2 - p0);
+		auto length = normal.L2_norm();
+		if (length <= 0.f)
+			continue;
+		normal *= 1.f / length;
+		normals.push_back(normal);
+		axis += normal;
+	}
+	auto axisLength = axis.L2_norm();
+	if (normals.empty() || axisLength <= 1e-6f)
+		return bounds;
+	axis *= 1.f / axisLength;
+	float minDot{ 1.f };
+	for (const auto& normal : normals)
+		minDot = std::min(minDot, normal.dot(axis));
+	bounds.coneAxis = axis;
+	//Cones wider than 90 degrees can't be culled from any position
+	if (minDot <= 0.f)
+		return bounds;
+	//Move the apex back along the axis until it lies behind every triangle plane
+	float apexDistance{ 0.f };
+	size_t normalIdx{ 0 };
+	for (size_t triangle{ 0 }; triangle < triangleCount; ++triangle) {
+		const auto& p0 = positions[vertices[triangles[triangle * 3 + 0]]];
+		const auto& p1 = positions[vertices[triangles[triangle * 3 + 1]]];
+		const auto& p2 = positions[vertices[triangles[triangle * 3 + 2]]];
+		if ((p1 - p0).cross(p2 - p0).L2_norm() <= 0.f)
+			continue;
+		const auto& normal = normals[normalIdx++];
+		apexDistance = std::max(apexDistance, (bounds.center - p0).dot(normal) / normal.dot(axis));
+	}
+	bounds.coneApex = bounds.center - axis * apexDistance;
+	bounds.coneCutoff = std::sqrt(1.f - minDot * minDot);
+	return bounds;
+}
+
+nyan::MeshletCuller::Frustum nyan::MeshletCuller::extract_frustum(const Math::Mat<float, 4, 4, true>& viewProj)
+{
+	auto row = [&](size_t r) { return Math::vec4{ viewProj(0, r), viewProj(1, r), viewProj(2, r), viewProj(3, r) }; };
+	auto r0 = row(0);
+	auto r1 = row(1);
+	auto r2 = row(2);
+	auto r3 = row(3);
+	//Zero to one depth, works for regular and inverse depth, degenerate planes of infinite projections always pass
+	return Frustum{
+		normalize_frustum_plane(r3 + r0),
+		normalize_frustum_plane(r3 - r0),
+		normalize_frustum_plane(r3 + r1),
+		normalize_frustum_plane(r3 - r1),
+		normalize_frustum_plane(r2),
+		normalize_frustum_plane(r3 - r2),
+	};
+}
+
+bool nyan::MeshletCuller::frustum_visible(const nyan::shaders::MeshletBounds& bounds, const Frustum& frustum)
+{
+	for (const auto& plane : frustum)
+		if (Math::vec3{ plane }.dot(bounds.center) + plane[3] < -bounds.radius)
+			return false;
+	return true;
+}
+
+bool nyan::MeshletCuller::cone_visible(const nyan::shaders::MeshletBounds& bounds, const Math::vec3& cameraPosition)
+{
+	auto view = bounds.coneApex - cameraPosition;
+	auto length = view.L2_norm();
+	if (length <= 0.f)
+		return true;
+	return view.dot(bounds.coneAxis) < bounds.coneCutoff * length;
+}
+
+bool nyan::MeshletCuller::visible(const nyan::shaders::MeshletBounds& bounds, const Frustum& frustum, const Math::vec3& cameraPosition)
+{
+	return cone_visible(bounds, cameraPosition) && frustum_visible(bounds, frustum);
+}
+
+std::vector<uint32_t> nyan::MeshletCuller::cull(const MeshletData& data, const Frustum& frustum, const Math::vec3& cameraPosition)
+{
+	std::vector<uint32_t> visibleMeshlets;
+	visibleMeshlets.reserve(data.bounds.size());
+	for (uint32_t i{ 0 }; i < data.bounds.size(); ++i)
+		if (visible(data.bounds[i], frustum, cameraPosition))
+			visibleMeshlets.push_back(i);
+	return visibleMeshlets;
+}
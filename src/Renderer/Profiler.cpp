@@ -17,7 +17,8 @@ void nyan::Profiler::begin_frame()
 {
 	size_t index{ 0 };
 	ImGui::Begin("Profiler");
-	if(ImGui::CollapsingHeader("GPU"))
+	//The GPU averages are collected even while collapsed, the Rendergraph schedules with them
+	const bool showGPU = ImGui::CollapsingHeader("GPU");
 	{
 		auto& timestamps = r_device.previous_frame().get_timestamps().get_results();
 		for (auto& [threadId, threadData] : m_GPUprofiles) {
@@ -29,25 +30,39 @@ void nyan::Profiler::begin_frame()
 					std::chrono::duration<float, std::milli> fp_ms = fp_ns;
 
 					m_averages[profile.name].add_sample(fp_ms.count());
-					ImGui::Text("%s%s : %f ms (avg: %f)", tabs.c_str(), profile.name.c_str(), fp_ms.count(), m_averages[profile.name].average());
+					if (showGPU)
+						ImGui::Text("%s%s : %f ms (avg: %f)", tabs.c_str(), profile.name.c_str(), fp_ms.count(), m_averages[profile.name].average());
 				}
 			}
 			threadData.timestamp.clear();
 			threadData.stack.clear();
 		}
 	}
-	if (ImGui::CollapsingHeader("CPU"))
+	const bool showCPU = ImGui::CollapsingHeader("CPU");
 	{
 		for (auto& [threadId, threadData] : m_profiles) {
 			for (const auto& profile : threadData.timestamp) {
 				std::string tabs(profile.depth, '\t');
-				std::chrono::duration<float, std::milli> fp_ms = profile.secondTimepoint - profile.firstTimepoint;
+				auto duration = profile.secondTimepoint - profile.firstTimepoint;
+				if (auto it = m_addedCPUTimes.find(profile.name); it != m_addedCPUTimes.end()) {
+					duration += it->second;
+					m_addedCPUTimes.erase(it);
+				}
+				std::chrono::duration<float, std::milli> fp_ms = duration;
 				m_averages[profile.name + "CPU"].add_sample(fp_ms.count());
-				ImGui::Text("%s%s : %f ms (avg: %f)", tabs.c_str(), profile.name.c_str(), fp_ms.count(), m_averages[profile.name + "CPU"].average());
+				if (showCPU)
+					ImGui::Text("%s%s : %f ms (avg: %f)", tabs.c_str(), profile.name.c_str(), fp_ms.count(), m_averages[profile.name + "CPU"].average());
 			}
 			threadData.timestamp.clear();
 			threadData.stack.clear();
 		}
+		for (const auto& [name, duration] : m_addedCPUTimes) {
+			std::chrono::duration<float, std::milli> fp_ms = duration;
+			m_averages[name + "CPU"].add_sample(fp_ms.count());
+			if (showCPU)
+				ImGui::Text("%s : %f ms (avg: %f)", name.c_str(), fp_ms.count(), m_averages[name + "CPU"].average());
+		}
+		m_addedCPUTimes.clear();
 	}
 
 	ImGui::End();
@@ -111,6 +126,25 @@ void nyan::Profiler::begin_profile(const std::string& name)
 	threadData.timestamp.push_back(timestamp);
 }
 
+void nyan::Profiler::add_cpu_time(const std::string& name, std::chrono::steady_clock::duration duration)
+{
+	m_addedCPUTimes[name] += duration;
+}
+
+std::optional<float> nyan::Profiler::get_gpu_time(const std::string& name) const
+{
+	if (auto it = m_averages.find(name); it != m_averages.end())
+		return it->second.average();
+	return std::nullopt;
+}
+
+std::optional<float> nyan::Profiler::get_cpu_time(const std::string& name) const
+{
+	if (auto it = m_averages.find(name + "CPU"); it != m_averages.end())
+		return it->second.average();
+	return std::nullopt;
+}
+
 void nyan::Profiler::end_profile()
 {
 	auto& threadData = m_profiles[std::this_thread::get_id()];
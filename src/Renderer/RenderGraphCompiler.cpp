@@ -0,0 +1,343 @@
+#include "Renderer/RenderGraphCompiler.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <queue>
+#include <stdexcept>
+#include <string_view>
+
+struct CompilerAccess {
+	uint32_t resource;
+	bool read;
+	bool write;
+};
+
+//A pass may declare several accesses of the same resource, e.g. depth as attachment and as stencil read
+static std::vector<CompilerAccess> compiler_merge_accesses(const nyan::RenderGraphDescription::Pass& pass, size_t resourceCount)
+{
+	std::vector<CompilerAccess> accesses;
+	accesses.reserve(pass.accesses.size());
+	for (const auto& access : pass.accesses) {
+		if (access.resource >= resourceCount)
+			throw std::out_of_range("RenderGraphCompiler: Pass \"" + pass.name + "\" accesses an unknown resource");
+		const bool read = access.type != nyan::RenderGraphDescription::Access::Type::Write;
+		const bool write = access.type != nyan::RenderGraphDescription::Access::Type::Read;
+		if (auto it = std::find_if(accesses.begin(), accesses.end(), [&](const auto& merged) { return merged.resource == access.resource; }); it != accesses.end()) {
+			//Reading and overwriting in the same pass still reads the previous contents
+			it->read |= read;
+			it->write |= write;
+		}
+		else {
+			accesses.push_back({ access.resource, read, write });
+		}
+	}
+	return accesses;
+}
+
+static void compiler_add_edge(std::vector<uint32_t>& predecessors, uint32_t predecessor, uint32_t pass)
+{
+	if (predecessor == pass || predecessor == nyan::RenderGraphPlan::invalidIndex)
+		return;
+	if (std::find(predecessors.begin(), predecessors.end(), predecessor) == predecessors.end())
+		predecessors.push_back(predecessor);
+}
+
+//Only producer edges keep passes alive, write after read and write after write edges merely order them
+static std::vector<bool> compiler_cull(const nyan::RenderGraphDescription& description, const std::vector<std::vector<CompilerAccess>>& accesses)
+{
+	const auto passCount = description.passes.size();
+	std::vector<std::vector<uint32_t>> producers(passCount);
+	std::vector<uint32_t> lastWriter(description.resources.size(), nyan::RenderGraphPlan::invalidIndex);
+	//Reads before the first write consume what the last writer produced in the previous frame
+	std::vector<std::vector<uint32_t>> carriedReaders(description.resources.size());
+	std::vector<uint32_t> worklist;
+	std::vector<bool> alive(passCount, false);
+	for (uint32_t pass{ 0 }; pass < passCount; pass++) {
+		bool root = description.passes[pass].sideEffects;
+		bool writes = false;
+		for (const auto& access : accesses[pass]) {
+			if (access.read) {
+				if (lastWriter[access.resource] != nyan::RenderGraphPlan::invalidIndex)
+					compiler_add_edge(producers[pass], lastWriter[access.resource], pass);
+				else
+					carriedReaders[access.resource].push_back(pass);
+			}
+			if (access.write) {
+				writes = true;
+				root |= description.resources[access.resource].exported;
+				lastWriter[access.resource] = pass;
+			}
+		}
+		if (root || !writes) {
+			alive[pass] = true;
+			worklist.push_back(pass);
+		}
+	}
+	for (uint32_t resource{ 0 }; resource < carriedReaders.size(); resource++)
+		for (auto reader : carriedReaders[resource])
+			compiler_add_edge(producers[reader], lastWriter[resource], reader);
+	while (!worklist.empty()) {
+		const auto pass = worklist.back();
+		worklist.pop_back();
+		for (auto producer : producers[pass]) {
+			if (!alive[producer]) {
+				alive[producer] = true;
+				worklist.push_back(producer);
+			}
+		}
+	}
+	return alive;
+}
+
+//Each queue executes its passes in execution order, a pass starts once its queue is free and its dependencies finished
+//Returns the time the last pass finishes
+static float compiler_estimate_time(const nyan::RenderGraphDescription& description, const std::vector<uint32_t>& order,
+	const std::vector<std::vector<uint32_t>>& dependencies, const std::vector<nyan::RenderGraphDescription::Queue>& queues, float syncCost,
+	std::vector<float>& finish)
+{
+	std::array<float, 3> queueFree{};
+	float time{ 0.f };
+	for (auto pass : order) {
+		const auto queue = queues[pass];
+		auto start = queueFree[static_cast<size_t>(queue)];
+		for (auto dependency : dependencies[pass])
+			start = std::max(start, finish[dependency] + (queues[dependency] != queue ? syncCost : 0.f));
+		finish[pass] = start + description.passes[pass].cost;
+		queueFree[static_cast<size_t>(queue)] = finish[pass];
+		time = std::max(time, finish[pass]);
+	}
+	return time;
+}
+
+nyan::RenderGraphPlan nyan::RenderGraphCompiler::compile(const RenderGraphDescription& description)
+{
+	return compile(description, Settings{});
+}
+
+nyan::RenderGraphPlan nyan::RenderGraphCompiler::compile(const RenderGraphDescription& description, const Settings& settings)
+{
+	const auto passCount = static_cast<uint32_t>(description.passes.size());
+	const auto resourceCount = description.resources.size();
+	std::vector<std::vector<CompilerAccess>> accesses(passCount);
+	for (uint32_t pass{ 0 }; pass < passCount; pass++)
+		accesses[pass] = compiler_merge_accesses(description.passes[pass], resourceCount);
+
+	const auto alive = settings.cullPasses ? compiler_cull(description, accesses) : std::vector<bool>(passCount, true);
+
+	//Ordering edges between surviving passes only, so orderings through culled passes aren't lost
+	RenderGraphPlan plan;
+	plan.m_dependencies.resize(passCount);
+	{
+		std::vector<uint32_t> lastWriter(resourceCount, RenderGraphPlan::invalidIndex);
+		std::vector<uint32_t> lastUser(resourceCount, RenderGraphPlan::invalidIndex);
+		std::vector<std::vector<uint32_t>> readers(resourceCount);
+		for (uint32_t pass{ 0 }; pass < passCount; pass++) {
+			if (!alive[pass])
+				continue;
+			auto& dependencies = plan.m_dependencies[pass];
+			for (const auto& [resource, read, write] : accesses[pass]) {
+				if (settings.orderResourceUses)
+					compiler_add_edge(dependencies, lastUser[resource], pass);
+				if (read)
+					compiler_add_edge(dependencies, lastWriter[resource], pass);
+				if (write) {
+					for (auto reader : readers[resource])
+						compiler_add_edge(dependencies, reader, pass);
+					compiler_add_edge(dependencies, lastWriter[resource], pass);
+					lastWriter[resource] = pass;
+					readers[resource].clear();
+				}
+				else {
+					readers[resource].push_back(pass);
+				}
+				lastUser[resource] = pass;
+			}
+		}
+	}
+
+	//Edges always point from earlier to later declarations, reverse declaration order is a reverse topological order
+	std::vector<std::vector<uint32_t>> successors(passCount);
+	std::vector<uint32_t> pendingDependencies(passCount, 0);
+	for (uint32_t pass{ 0 }; pass < passCount; pass++) {
+		pendingDependencies[pass] = static_cast<uint32_t>(plan.m_dependencies[pass].size());
+		for (auto dependency : plan.m_dependencies[pass])
+			successors[dependency].push_back(pass);
+	}
+	std::vector<float> criticalPath(passCount, 0.f);
+	for (uint32_t pass = passCount; pass-- > 0;) {
+		float longest{ 0.f };
+		for (auto successor : successors[pass])
+			longest = std::max(longest, criticalPath[successor]);
+		criticalPath[pass] = description.passes[pass].cost + longest;
+	}
+
+	auto later = [&criticalPath](uint32_t lhs, uint32_t rhs) {
+		if (criticalPath[lhs] != criticalPath[rhs])
+			return criticalPath[lhs] < criticalPath[rhs];
+		return lhs > rhs;
+	};
+	std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(later)> ready(later);
+	for (uint32_t pass{ 0 }; pass < passCount; pass++)
+		if (alive[pass] && !pendingDependencies[pass])
+			ready.push(pass);
+	plan.m_position.assign(passCount, RenderGraphPlan::invalidIndex);
+	plan.m_order.reserve(passCount);
+	while (!ready.empty()) {
+		const auto pass = ready.top();
+		ready.pop();
+		plan.m_position[pass] = static_cast<uint32_t>(plan.m_order.size());
+		plan.m_order.push_back(pass);
+		for (auto successor : successors[pass])
+			if (!--pendingDependencies[successor])
+				ready.push(successor);
+	}
+	assert(plan.m_order.size() == static_cast<size_t>(std::count(alive.begin(), alive.end(), true)));
+
+	plan.m_queues.reserve(passCount);
+	for (const auto& pass : description.passes)
+		plan.m_queues.push_back(pass.queue);
+	std::vector<float> finish(passCount, 0.f);
+	plan.m_estimatedTime = compiler_estimate_time(description, plan.m_order, plan.m_dependencies, plan.m_queues, settings.queueSyncCost, finish);
+	//Local search, one pass is moved at a time and kept on the other queue only if the estimate strictly improves
+	//Independent work on the graphics queue hides the moved pass, passes on the critical path only gain the sync cost and stay
+	for (bool improved{ settings.scheduleAsyncCompute }; improved;) {
+		improved = false;
+		for (auto pass : plan.m_order) {
+			if (!description.passes[pass].asyncCompute)
+				continue;
+			auto& queue = plan.m_queues[pass];
+			const auto previous = queue;
+			queue = previous == RenderGraphDescription::Queue::Compute ? RenderGraphDescription::Queue::Graphics : RenderGraphDescription::Queue::Compute;
+			const auto time = compiler_estimate_time(description, plan.m_order, plan.m_dependencies, plan.m_queues, settings.queueSyncCost, finish);
+			if (time < plan.m_estimatedTime) {
+				plan.m_estimatedTime = time;
+				improved = true;
+			}
+			else {
+				queue = previous;
+			}
+		}
+	}
+
+	//A batch ends after a pass another queue waits for and starts at a pass waiting on another queue
+	std::vector<bool> signalsOtherQueue(passCount, false);
+	for (auto pass : plan.m_order)
+		for (auto dependency : plan.m_dependencies[pass])
+			if (plan.m_queues[dependency] != plan.m_queues[pass])
+				signalsOtherQueue[dependency] = true;
+	plan.m_batch.assign(passCount, RenderGraphPlan::invalidIndex);
+	bool batchWaitsExternally{ false };
+	for (uint32_t position{ 0 }; position < plan.m_order.size(); position++) {
+		const auto pass = plan.m_order[position];
+		const auto& passDescription = description.passes[pass];
+		const auto queue = plan.m_queues[pass];
+		const bool waitsOnOtherQueue = std::any_of(plan.m_dependencies[pass].begin(), plan.m_dependencies[pass].end(),
+			[&](uint32_t dependency) { return plan.m_queues[dependency] != queue; });
+		if (plan.m_batches.empty() || plan.m_batches.back().queue != queue || waitsOnOtherQueue ||
+				signalsOtherQueue[plan.m_order[position - 1]] || (passDescription.externalWait && !batchWaitsExternally)) {
+			plan.m_batches.push_back(RenderGraphPlan::Batch{ .queue {queue}, .begin {position}, .end {position} });
+			batchWaitsExternally = false;
+		}
+		const auto batchIndex = static_cast<uint32_t>(plan.m_batches.size() - 1);
+		auto& batch = plan.m_batches.back();
+		batch.end = position + 1;
+		batchWaitsExternally |= passDescription.externalWait;
+		plan.m_batch[pass] = batchIndex;
+		//Batches of a queue finish in submission order, waiting for the latest one covers the earlier ones
+		for (auto dependency : plan.m_dependencies[pass]) {
+			const auto producer = plan.m_batch[dependency];
+			const auto producerQueue = plan.m_batches[producer].queue;
+			if (producerQueue == batch.queue)
+				continue;
+			auto it = std::find_if(batch.waits.begin(), batch.waits.end(), [&](uint32_t wait) { return plan.m_batches[wait].queue == producerQueue; });
+			if (it == batch.waits.end())
+				batch.waits.push_back(producer);
+			else
+				*it = std::max(*it, producer);
+		}
+	}
+	for (const auto& batch : plan.m_batches)
+		for (auto wait : batch.waits)
+			plan.m_batches[wait].signals = true;
+
+	plan.m_lifetimes.resize(resourceCount);
+	for (uint32_t position{ 0 }; position < plan.m_order.size(); position++) {
+		for (const auto& access : accesses[plan.m_order[position]]) {
+			auto& lifetime = plan.m_lifetimes[access.resource];
+			if (!lifetime.used())
+				lifetime.first = position;
+			lifetime.last = position;
+		}
+	}
+	return plan;
+}
+
+uint64_t nyan::RenderGraphCompiler::hash(const RenderGraphDescription& description, const RenderGraphPlan& plan)
+{
+	assert(plan.get_pass_count() == description.passes.size());
+	std::vector<uint32_t> words;
+	words.push_back(static_cast<uint32_t>(description.resources.size()));
+	for (const auto& resource : description.resources)
+		words.push_back(resource.exported);
+	words.push_back(static_cast<uint32_t>(description.passes.size()));
+	for (uint32_t pass{ 0 }; pass < description.passes.size(); pass++) {
+		const auto& passDescription = description.passes[pass];
+		words.push_back(static_cast<uint32_t>(passDescription.accesses.size()));
+		for (const auto& [resource, type] : passDescription.accesses) {
+			words.push_back(resource);
+			words.push_back(static_cast<uint32_t>(type));
+		}
+		words.push_back(static_cast<uint32_t>(passDescription.sideEffects) | static_cast<uint32_t>(passDescription.externalWait) << 1 |
+			static_cast<uint32_t>(passDescription.asyncCompute) << 2);
+		words.push_back(static_cast<uint32_t>(plan.get_queue(pass)));
+		words.push_back(plan.get_position(pass));
+	}
+	return std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t)));
+}
+
+nyan::RenderGraphBarrierSchedule nyan::RenderGraphCompiler::schedule_barriers(const RenderGraphPlan& plan, std::span<const RenderGraphBarrierSchedule::Transition> transitions)
+{
+	RenderGraphBarrierSchedule schedule;
+	const auto passCount = plan.get_pass_count();
+	schedule.m_types.resize(transitions.size(), RenderGraphBarrierSchedule::Type::Barrier);
+	schedule.m_transitionEvents.resize(transitions.size(), RenderGraphPlan::invalidIndex);
+	schedule.m_barriers.resize(passCount);
+	schedule.m_waits.resize(passCount);
+	schedule.m_sets.resize(passCount);
+
+	for (uint32_t transition{ 0 }; transition < transitions.size(); transition++) {
+		const auto [producer, consumer] = transitions[transition];
+		assert(consumer < passCount && !plan.is_culled(consumer));
+		//Previous frame or an earlier submission, nothing of the batch runs before the consumer that could overlap
+		const bool split = producer != RenderGraphPlan::invalidIndex && !plan.is_culled(producer) &&
+			plan.get_position(producer) + 1 < plan.get_position(consumer) &&
+			plan.get_batch(producer) == plan.get_batch(consumer);
+		if (!split) {
+			schedule.m_barriers[consumer].push_back(transition);
+			continue;
+		}
+		auto event = static_cast<uint32_t>(std::find_if(schedule.m_events.begin(), schedule.m_events.end(),
+			[producer, consumer](const RenderGraphBarrierSchedule::Event& candidate) { return candidate.producer == producer && candidate.consumer == consumer; }) - schedule.m_events.begin());
+		if (event == schedule.m_events.size()) {
+			schedule.m_events.push_back({ .producer {producer}, .consumer {consumer} });
+			schedule.m_sets[producer].push_back(event);
+			schedule.m_waits[consumer].push_back(event);
+		}
+		schedule.m_types[transition] = RenderGraphBarrierSchedule::Type::Event;
+		schedule.m_transitionEvents[transition] = event;
+	}
+	return schedule;
+}
+
+void nyan::RenderGraphBackend::execute(const RenderGraphPlan& plan)
+{
+	begin_plan(plan);
+	const auto& batches = plan.get_batches();
+	for (uint32_t batch{ 0 }; batch < batches.size(); batch++) {
+		begin_batch(batch);
+		for (auto position = batches[batch].begin; position < batches[batch].end; position++)
+			execute_pass(plan.get_order()[position]);
+		end_batch(batch);
+	}
+	end_plan();
+}
@@ -0,0 +1,188 @@
+#include "Renderer/RenderGraphExporter.h"
+#include <format>
+#include <fstream>
+#include <stdexcept>
+
+static constexpr const char* exporter_queue_name(nyan::RenderGraphDescription::Queue queue)
+{
+	switch (queue) {
+	case nyan::RenderGraphDescription::Queue::Graphics:
+		return "Graphics";
+	case nyan::RenderGraphDescription::Queue::Compute:
+		return "Compute";
+	case nyan::RenderGraphDescription::Queue::Transfer:
+		return "Transfer";
+	}
+	return "Unknown";
+}
+
+static constexpr const char* exporter_access_name(nyan::RenderGraphDescription::Access::Type type)
+{
+	switch (type) {
+	case nyan::RenderGraphDescription::Access::Type::Read:
+		return "Read";
+	case nyan::RenderGraphDescription::Access::Type::Write:
+		return "Write";
+	case nyan::RenderGraphDescription::Access::Type::ReadWrite:
+		return "ReadWrite";
+	}
+	return "Unknown";
+}
+
+//Valid inside double quotes of both DOT and JSON
+static std::string exporter_escape(std::string_view string)
+{
+	std::string escaped;
+	escaped.reserve(string.size());
+	for (auto c : string) {
+		if (c == '"' || c == '\\') {
+			escaped.push_back('\\');
+			escaped.push_back(c);
+		}
+		else if (static_cast<unsigned char>(c) < 0x20) {
+			escaped += std::format("\\u{:04x}", static_cast<unsigned>(c));
+		}
+		else {
+			escaped.push_back(c);
+		}
+	}
+	return escaped;
+}
+
+//Fixed precision, the exports of two runs only differ where the numbers do
+static std::string exporter_time(const std::optional<float>& time)
+{
+	return time ? std::format("{:.3f}", *time) : "null";
+}
+
+static std::string exporter_index(uint32_t index)
+{
+	return index == nyan::RenderGraphPlan::invalidIndex ? "null" : std::to_string(index);
+}
+
+template<typename T>
+static const T& exporter_stats(const std::vector<T>& stats, size_t index)
+{
+	static const T defaultStats{};
+	return index < stats.size() ? stats[index] : defaultStats;
+}
+
+std::string nyan::RenderGraphExporter::to_dot(const RenderGraphDescription& description, const RenderGraphPlan& plan, const Stats& stats)
+{
+	std::string dot;
+	dot += "digraph RenderGraph {\n";
+	dot += "\trankdir=LR;\n";
+	dot += std::format("\tlabel=\"estimated time {:.3f}\";\n", plan.get_estimated_time());
+	dot += "\tnode [fontname=\"monospace\"];\n";
+	auto append_pass = [&](uint32_t pass, std::string_view indent) {
+		const auto& passStats = exporter_stats(stats.passes, pass);
+		dot += std::format("{}pass{} [shape=box, label=\"{}\\n{} | cpu {} ms | gpu {} ms\\nbarriers {} | waits {} | sets {}\"{}];\n",
+			indent, pass, exporter_escape(description.passes[pass].name), exporter_queue_name(plan.get_queue(pass)),
+			exporter_time(passStats.cpuTime), exporter_time(passStats.gpuTime),
+			passStats.barriers, passStats.eventWaits, passStats.eventSets,
+			plan.is_culled(pass) ? ", style=dashed" : "");
+	};
+	const auto& batches = plan.get_batches();
+	for (uint32_t batch = 0; batch < batches.size(); batch++) {
+		dot += std::format("\tsubgraph cluster_batch{} {{\n", batch);
+		dot += std::format("\t\tlabel=\"batch {} ({})\";\n", batch, exporter_queue_name(batches[batch].queue));
+		for (auto position = batches[batch].begin; position < batches[batch].end; position++)
+			append_pass(plan.get_order()[position], "\t\t");
+		dot += "\t}\n";
+	}
+	for (uint32_t pass = 0; pass < description.passes.size(); pass++)
+		if (plan.is_culled(pass))
+			append_pass(pass, "\t");
+	for (uint32_t resource = 0; resource < description.resources.size(); resource++) {
+		const auto& lifetime = plan.get_lifetime(resource);
+		const auto& resourceStats = exporter_stats(stats.resources, resource);
+		std::string label = exporter_escape(description.resources[resource].name);
+		if (lifetime.used())
+			label += std::format("\\n[{}, {}]", lifetime.first, lifetime.last);
+		if (resourceStats.transientSize)
+			label += std::format("\\n{:.3f} MiB transient", static_cast<double>(resourceStats.transientSize) / (1 << 20));
+		dot += std::format("\tresource{} [shape=ellipse, label=\"{}\"{}{}];\n", resource, label,
+			description.resources[resource].exported ? ", peripheries=2" : "",
+			lifetime.used() ? "" : ", style=dashed");
+	}
+	for (uint32_t pass = 0; pass < description.passes.size(); pass++) {
+		for (const auto& [resource, type] : description.passes[pass].accesses) {
+			if (type != RenderGraphDescription::Access::Type::Write)
+				dot += std::format("\tresource{} -> pass{};\n", resource, pass);
+			if (type != RenderGraphDescription::Access::Type::Read)
+				dot += std::format("\tpass{} -> resource{};\n", pass, resource);
+		}
+	}
+	dot += "}\n";
+	return dot;
+}
+
+std::string nyan::RenderGraphExporter::to_json(const RenderGraphDescription& description, const RenderGraphPlan& plan, const Stats& stats)
+{
+	auto join = [](const std::vector<uint32_t>& values) {
+		std::string joined;
+		for (auto value : values) {
+			if (!joined.empty())
+				joined += ", ";
+			joined += std::to_string(value);
+		}
+		return joined;
+	};
+	std::string json;
+	json += "{\n";
+	json += std::format("\"estimatedTime\": {:.3f},\n", plan.get_estimated_time());
+	json += "\"passes\": [\n";
+	for (uint32_t pass = 0; pass < description.passes.size(); pass++) {
+		const auto& passDescription = description.passes[pass];
+		const auto& passStats = exporter_stats(stats.passes, pass);
+		std::string accesses;
+		for (const auto& [resource, type] : passDescription.accesses) {
+			if (!accesses.empty())
+				accesses += ", ";
+			accesses += std::format("{{\"resource\": {}, \"type\": \"{}\"}}", resource, exporter_access_name(type));
+		}
+		json += std::format("{{\"index\": {}, \"name\": \"{}\", \"queue\": \"{}\", \"culled\": {}, \"position\": {}, \"batch\": {}, "
+			"\"dependencies\": [{}], \"accesses\": [{}], \"cost\": {:.3f}, \"cpuTimeMs\": {}, \"gpuTimeMs\": {}, "
+			"\"barriers\": {}, \"eventWaits\": {}, \"eventSets\": {}}}{}\n",
+			pass, exporter_escape(passDescription.name), exporter_queue_name(plan.get_queue(pass)), plan.is_culled(pass),
+			exporter_index(plan.get_position(pass)), exporter_index(plan.get_batch(pass)),
+			join(plan.get_dependencies(pass)), accesses, passDescription.cost,
+			exporter_time(passStats.cpuTime), exporter_time(passStats.gpuTime),
+			passStats.barriers, passStats.eventWaits, passStats.eventSets,
+			pass + 1 < description.passes.size() ? "," : "");
+	}
+	json += "],\n";
+	json += "\"resources\": [\n";
+	for (uint32_t resource = 0; resource < description.resources.size(); resource++) {
+		const auto& lifetime = plan.get_lifetime(resource);
+		const auto& resourceStats = exporter_stats(stats.resources, resource);
+		json += std::format("{{\"index\": {}, \"name\": \"{}\", \"exported\": {}, \"first\": {}, \"last\": {}, "
+			"\"transientSize\": {}, \"heap\": {}, \"offset\": {}}}{}\n",
+			resource, exporter_escape(description.resources[resource].name), description.resources[resource].exported,
+			exporter_index(lifetime.first), exporter_index(lifetime.last),
+			resourceStats.transientSize, exporter_index(resourceStats.heap), resourceStats.offset,
+			resource + 1 < description.resources.size() ? "," : "");
+	}
+	json += "],\n";
+	json += "\"batches\": [\n";
+	const auto& batches = plan.get_batches();
+	for (uint32_t batch = 0; batch < batches.size(); batch++) {
+		json += std::format("{{\"index\": {}, \"queue\": \"{}\", \"begin\": {}, \"end\": {}, \"waits\": [{}], \"signals\": {}}}{}\n",
+			batch, exporter_queue_name(batches[batch].queue), batches[batch].begin, batches[batch].end,
+			join(batches[batch].waits), batches[batch].signals,
+			batch + 1 < batches.size() ? "," : "");
+	}
+	json += "]\n";
+	json += "}\n";
+	return json;
+}
+
+void nyan::RenderGraphExporter::write(const std::filesystem::path& path, std::string_view contents)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+		throw std::runtime_error("Could not open file: \"" + path.string() + "\"");
+	file.write(contents.data(), contents.size());
+	if (!file)
+		throw std::runtime_error("Could not write file: \"" + path.string() + "\"");
+}
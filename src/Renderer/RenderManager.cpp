@@ -1,5 +1,6 @@
 #include "Renderer/RenderManager.h"
 #include "Renderer/Light.h"
+#include "Renderer/MeshSimplifier.h"
 #include "Utility/Exceptions.h"
 #include "VulkanWrapper/LogicalDevice.h"
 #include "VulkanWrapper/CommandBuffer.h"
@@ -21,6 +22,7 @@ nyan::RenderManager::RenderManager(vulkan::LogicalDevice& device, bool useRaytra
 	m_ddgiManager(r_device, m_rendergraph, m_registry),
 	m_ddgiReSTIRManager(r_device, m_rendergraph, m_registry),
 	m_profiler(r_device),
+	m_assetStreamer(),
 	m_useRayTracing(r_device.get_physical_device().get_acceleration_structure_features().accelerationStructure &&
 		r_device.get_physical_device().get_ray_tracing_pipeline_features().rayTracingPipeline),
 	m_primaryCamera(entt::null)
@@ -122,6 +124,10 @@ const nyan::Profiler& nyan::RenderManager::get_profiler() const
 {
 	return m_profiler;
 }
+nyan::AssetStreamer& nyan::RenderManager::get_asset_streamer()
+{
+	return m_assetStreamer;
+}
 
 void nyan::RenderManager::add_materials(const std::vector<nyan::MaterialData>& materials)
 {
@@ -137,7 +143,7 @@ void nyan::RenderManager::add_materials(const std::vector<nyan::MaterialData>& m
 		}
 		try {
 			if (!material.normalTex.empty())
-				m_textureManager.request_texture(material.normalTex);
+				m_textureManager.request_texture(material.normalTex, Utility::TextureCooker::Settings{ .usage {Utility::TextureUsage::Normal}, .sRGB {false} });
 		}
 		catch (Utility::FileNotFoundException e) {
 			Utility::log_error().message(e.what());
@@ -160,33 +166,8 @@ const entt::entity& nyan::RenderManager::get_primary_camera() const
 
 void nyan::RenderManager::update([[maybe_unused]]std::chrono::nanoseconds dt)
 {
-	{
-		auto view = m_registry.view<const MeshID, const InstanceId>();
-		for (const auto& [entity, meshId, instanceId] : view.each()) {
-			//auto transformMatrix = Math::Mat<float, 4, 4, false>::affine_transformation_matrix(transform.orientation, transform.position);
-			auto transformMatrix = Math::Mat<float, 4, 4, false>::identity();
-			for (auto parent = entity; parent != entt::null; parent = m_registry.all_of<Parent>(parent) ? m_registry.get<Parent>(parent).parent : entt::null) {
-				if (m_registry.all_of<Transform>(parent)) {
-					const auto& parentTransform = m_registry.get<Transform>(parent);
-					transformMatrix = Math::Mat<float, 4, 4, false>::affine_transformation_matrix(parentTransform.orientation, parentTransform.position, parentTransform.scale) * transformMatrix;
-
-				}
-			}
-
-			m_instanceManager.set_transform(instanceId, Math::Mat<float, 3, 4, false>(transformMatrix));
-
-			auto accHandle = m_meshManager.get_acceleration_structure(meshId);
-			if (accHandle) {
-				auto instance = (*accHandle)->create_instance();
-				m_instanceManager.set_acceleration_structure(instanceId, instance.accelerationStructureReference);
-				m_instanceManager.set_flags(instanceId, instance.flags); 
-				m_instanceManager.set_mask(instanceId, instance.mask);
-				m_instanceManager.set_instance_shader_binding_table_record_offset(instanceId, instance.instanceShaderBindingTableRecordOffset);
-				m_instanceManager.set_instance_custom_index(instanceId, meshId);
-			}
-		}
-	}
-
+	PerspectiveCamera perspective{};
+	Math::vec3 cameraPos{};
 	{
 		auto transformMatrix = Math::Mat<float, 4, 4, false>::identity();
 		for (auto parent = m_primaryCamera; parent != entt::null; parent = m_registry.all_of<Parent>(parent) ? m_registry.get<Parent>(parent).parent : entt::null) {
@@ -196,8 +177,6 @@ void nyan::RenderManager::update([[maybe_unused]]std::chrono::nanoseconds dt)
 			}
 		}
 
-		PerspectiveCamera perspective{};
-
 		if (m_primaryCamera != entt::null && m_registry.all_of<PerspectiveCamera>(m_primaryCamera)) {
 			perspective = m_registry.get<PerspectiveCamera>(m_primaryCamera);
 		}
@@ -210,15 +189,58 @@ void nyan::RenderManager::update([[maybe_unused]]std::chrono::nanoseconds dt)
 			m_sceneManager.set_proj_matrix(
 				Math::Mat<float, 4, 4, true>::perspectiveFovXLH(perspective.nearPlane, perspective.farPlane, perspective.fovX, perspective.aspect));
 		}
-		auto cameraPos = static_cast<Math::vec3>(transformMatrix.col(3));
+		cameraPos = static_cast<Math::vec3>(transformMatrix.col(3));
 		auto cameraDir = static_cast<Math::vec3>(transformMatrix * static_cast<Math::vec4>(perspective.forward)).normalize();
 		auto cameraUp = static_cast<Math::vec3>(transformMatrix * static_cast<Math::vec4>(perspective.up)).normalize();
 		auto cameraRight = static_cast<Math::vec3>(transformMatrix * static_cast<Math::vec4>(perspective.right)).normalize();
 		m_sceneManager.set_view_matrix(Math::Mat<float, 4, 4, true>::first_person(cameraPos, cameraDir, cameraUp, cameraRight));
 		m_sceneManager.set_view_pos(cameraPos);
+		m_assetStreamer.set_camera_position(cameraPos);
 		m_sceneManager.set_camera_up(cameraUp);
 	}
 
+	{
+		auto screenWidth = static_cast<float>(r_device.get_swapchain_width());
+		auto view = m_registry.view<MeshID, const InstanceId>();
+		for (auto [entity, meshId, instanceId] : view.each()) {
+			//auto transformMatrix = Math::Mat<float, 4, 4, false>::affine_transformation_matrix(transform.orientation, transform.position);
+			auto transformMatrix = Math::Mat<float, 4, 4, false>::identity();
+			for (auto parent = entity; parent != entt::null; parent = m_registry.all_of<Parent>(parent) ? m_registry.get<Parent>(parent).parent : entt::null) {
+				if (m_registry.all_of<Transform>(parent)) {
+					const auto& parentTransform = m_registry.get<Transform>(parent);
+					transformMatrix = Math::Mat<float, 4, 4, false>::affine_transformation_matrix(parentTransform.orientation, parentTransform.position, parentTransform.scale) * transformMatrix;
+
+				}
+			}
+
+			const Math::Mat<float, 3, 4, false> instanceTransform(transformMatrix);
+			m_instanceManager.set_transform(instanceId, instanceTransform);
+
+			if (const auto* lodChain = m_registry.try_get<MeshLodChain>(entity)) {
+				auto scale = std::max({ static_cast<Math::vec3>(transformMatrix.col(0)).L2_norm(),
+					static_cast<Math::vec3>(transformMatrix.col(1)).L2_norm(),
+					static_cast<Math::vec3>(transformMatrix.col(2)).L2_norm() });
+				//Measured to the geometry, the origin of a mesh can be far away from it
+				const auto worldBounds = BoundsCalculator::transform(m_meshManager.get_bounds(lodChain->meshes.front()), instanceTransform);
+				auto distance = (cameraPos - worldBounds.sphere.center).L2_norm();
+				//Scaling the error is equivalent to dividing the distance by the scale
+				//meshId is a non-const reference into the registry, this writes the selected level back to the entity
+				meshId = lodChain->meshes[LodSelector::select(lodChain->errors, distance / std::max(scale, 1e-6f), perspective, screenWidth)];
+			}
+			m_instanceManager.set_world_bounds(instanceId, BoundsCalculator::transform(m_meshManager.get_bounds(meshId), instanceTransform));
+
+			auto accHandle = m_meshManager.get_acceleration_structure(meshId);
+			if (accHandle) {
+				auto instance = (*accHandle)->create_instance();
+				m_instanceManager.set_acceleration_structure(instanceId, instance.accelerationStructureReference);
+				m_instanceManager.set_flags(instanceId, instance.flags); 
+				m_instanceManager.set_mask(instanceId, instance.mask);
+				m_instanceManager.set_instance_shader_binding_table_record_offset(instanceId, instance.instanceShaderBindingTableRecordOffset);
+				m_instanceManager.set_instance_custom_index(instanceId, meshId);
+			}
+		}
+	}
+
 	{
 		{
 			nyan::shaders::DirectionalLight light;
@@ -292,6 +314,7 @@ void nyan::RenderManager::begin_frame()
 	m_ddgiManager.begin_frame();
 	m_ddgiReSTIRManager.begin_frame();
 
+	m_assetStreamer.commit(*this);
 	m_meshManager.build();
 
 	bool needsSemaphore = false;
@@ -314,6 +337,15 @@ void nyan::RenderManager::begin_frame()
 	m_instanceManager.build();
 }
 
+void nyan::RenderManager::upload([[maybe_unused]] AssetRequestId id, AssetPayload& payload)
+{
+	//The texture manager stages on the same transfer queue as begin_frame
+	if (auto* streamedTexture = dynamic_cast<StreamedTexture*>(&payload))
+		m_textureManager.upload_streamed(*streamedTexture);
+	else if (auto* streamedScene = dynamic_cast<StreamedScene*>(&payload))
+		streamedScene->commit(streamedScene->asset);
+}
+
 void nyan::RenderManager::end_frame()
 {
 	m_ddgiManager.end_frame();
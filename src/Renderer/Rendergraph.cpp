@@ -2,10 +2,27 @@
 #include "VulkanWrapper/Image.h"
 #include "CommandBuffer.h"
 #include "Renderer/Profiler.hpp"
+#include "Renderer/RenderGraphExporter.h"
+#include "Utility/JobSystem.h"
+#include <chrono>
+#include <utility>
 
 using namespace nyan;
 //using namespace vulkan;
 
+//Transfer passes are recorded on the generic queue as well
+static vulkan::CommandBufferType rendergraph_command_buffer_type(RenderGraphDescription::Queue queue)
+{
+	return queue == RenderGraphDescription::Queue::Compute ? vulkan::CommandBufferType::Compute : vulkan::CommandBufferType::Generic;
+}
+
+static RenderGraphCompiler::Settings rendergraph_compiler_settings()
+{
+	//Barriers are set up between consecutive uses in declaration order, the order of reads has to be kept for them
+	//Pass costs are profiled milliseconds, a cross-queue wait costs about as much as a small dispatch
+	return RenderGraphCompiler::Settings{ .orderResourceUses {true}, .scheduleAsyncCompute {true}, .queueSyncCost {0.05f} };
+}
+
 nyan::Renderpass::Renderpass(nyan::Rendergraph& graph, nyan::Renderpass::Type type, Id id, const std::string& name) :
 	r_graph(graph),
 	m_type(type),
@@ -17,7 +34,8 @@ nyan::Renderpass::Renderpass(nyan::Rendergraph& graph, nyan::Renderpass::Type ty
 nyan::Renderpass::~Renderpass()
 {
 	for (const auto& waitInfo : m_waitInfos)
-		r_graph.r_device.frame().recycle_semaphore(waitInfo.semaphore);
+		if (!waitInfo.value)
+			r_graph.r_device.frame().recycle_semaphore(waitInfo.semaphore);
 }
 
 Rendergraph& nyan::Renderpass::get_graph() noexcept
@@ -223,12 +241,17 @@ void nyan::Renderpass::execute(vulkan::CommandBuffer& cmd)
 {
 	if (m_rendersSwap)
 		cmd.touch_swapchain();
-	for (size_t i{ 0 }; i < m_renderFunctions.size(); i++) {
-		const auto &renderFunction = m_renderFunctions[i];
-		if (m_useRendering[i])
-			begin_rendering(cmd);
-		renderFunction(cmd, *this);
-		if (m_useRendering[i])
+	for (auto& renderFunction : m_renderFunctions) {
+		if (renderFunction.rendering)
+			begin_rendering(cmd, renderFunction.prepare ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0);
+		if (renderFunction.prepare) {
+			cmd.execute_commands(renderFunction.chunks);
+			renderFunction.chunks.clear();
+		}
+		else {
+			renderFunction.record(cmd, *this);
+		}
+		if (renderFunction.rendering)
 			end_rendering(cmd);
 	}
 	do_copies(cmd);
@@ -291,6 +314,20 @@ void nyan::Renderpass::apply_post_barriers(vulkan::CommandBuffer& cmd)
 	}
 }
 
+bool nyan::Renderpass::has_pre_barriers() const noexcept
+{
+	return m_globalBarriers2.postIndex != m_globalBarriers2.preIndex ||
+		m_bufferBarriers2.postIndex != m_bufferBarriers2.preIndex ||
+		m_imageBarriers2.postIndex != m_imageBarriers2.preIndex;
+}
+
+bool nyan::Renderpass::has_post_barriers() const noexcept
+{
+	return m_globalBarriers2.barriers.size() != m_globalBarriers2.postIndex ||
+		m_bufferBarriers2.barriers.size() != m_bufferBarriers2.postIndex ||
+		m_imageBarriers2.barriers.size() != m_imageBarriers2.postIndex;
+}
+
 void nyan::Renderpass::add_pre_barrier(const VkImageMemoryBarrier2& barrier, RenderResource::Id image)
 {
 	m_imageBarriers2.postIndex++;
@@ -328,15 +365,27 @@ void nyan::Renderpass::add_post_barrier(const VkMemoryBarrier2& barrier)
 	m_globalBarriers2.barriers.insert(m_globalBarriers2.barriers.begin() + m_globalBarriers2.postIndex, barrier);
 }
 
-void nyan::Renderpass::add_pipeline(vulkan::GraphicsPipelineConfig config, vulkan::PipelineId* id)
+void nyan::Renderpass::add_pipeline(vulkan::GraphicsPipelineConfig config, vulkan::PipelineId* id, vulkan::PipelineId placeholder)
 {
-	m_queuedPipelineBuilds.emplace_back(config, id);
+	if (r_graph.m_state == Rendergraph::State::Setup) {
+		m_queuedPipelineBuilds.emplace_back(config, id, vulkan::PipelineFuture{}, placeholder);
+		return;
+	}
+	//Rendering infos are already built, waiting for the compile here would stall the frame
+	config.renderingCreateInfo = m_renderingCreateInfo;
+	auto future = r_graph.r_device.get_pipeline_storage().compile_pipeline(config);
+	*id = future.get_or(placeholder);
+	m_pendingPipelineBuilds.emplace_back(config, id, std::move(future), placeholder);
+	update_pipelines();
 }
 
-void nyan::Renderpass::begin_rendering(vulkan::CommandBuffer& cmd)
+void nyan::Renderpass::begin_rendering(vulkan::CommandBuffer& cmd, VkRenderingFlags flags)
 {
-	if (m_type == Renderpass::Type::Generic)
-		cmd.begin_rendering(m_renderInfo);
+	if (m_type == Renderpass::Type::Generic) {
+		auto renderInfo = m_renderInfo;
+		renderInfo.flags = flags;
+		cmd.begin_rendering(renderInfo);
+	}
 }
 
 void nyan::Renderpass::end_rendering(vulkan::CommandBuffer& cmd)
@@ -385,13 +434,13 @@ uint32_t nyan::Renderpass::get_read_bind(RenderResource::Id id, Read::Type type)
 
 }
 
-void nyan::Renderpass::add_wait(VkSemaphore wait, VkPipelineStageFlags2 stage)
+void nyan::Renderpass::add_wait(VkSemaphore wait, VkPipelineStageFlags2 stage, uint64_t value)
 {
 	m_waitInfos.push_back(VkSemaphoreSubmitInfo{
 			.sType {VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO },
 			.pNext {nullptr},
 			.semaphore {wait},
-			.value {0},
+			.value {value},
 			.stageMask {stage}
 		});
 }
@@ -409,10 +458,12 @@ void nyan::Renderpass::build()
 
 void nyan::Renderpass::clear_dependencies()
 {
+	m_globalBarriers2.clear();
 	m_bufferBarriers2.clear();
 	m_imageBarriers2.clear();
-	m_bufferBarriers2.clear();
 	m_signals.clear();
+	m_eventBarriers.clear();
+	m_eventWaits.clear();
 }
 
 void nyan::Renderpass::clear_resource_references(RenderResource::Id id)
@@ -537,13 +588,34 @@ void nyan::Renderpass::build_rendering_info()
 
 void nyan::Renderpass::build_pipelines()
 {
-	for (auto& [config, id] : m_queuedPipelineBuilds) {
+	//The ids are valid right away, the graph waits for all passes at once so their pipelines compile in parallel
+	for (auto& [config, id, future] : m_queuedPipelineBuilds) {
 		config.renderingCreateInfo = m_renderingCreateInfo;
-		*id = r_graph.r_device.get_pipeline_storage().add_pipeline(config);
+		future = r_graph.r_device.get_pipeline_storage().compile_pipeline(config);
+		*id = future.get_id();
 	}
 	//m_queuedPipelineBuilds.clear();
 }
 
+uint32_t nyan::Renderpass::wait_for_pipelines()
+{
+	for (const auto& build : m_queuedPipelineBuilds)
+		if (build.future.valid())
+			build.future.get();
+	return static_cast<uint32_t>(m_queuedPipelineBuilds.size());
+}
+
+void nyan::Renderpass::update_pipelines()
+{
+	std::erase_if(m_pendingPipelineBuilds, [](const PipelineBuild& build) {
+		if (!build.future.ready())
+			return false;
+		//Rethrows compile errors
+		*build.id = build.future.get();
+		return true;
+		});
+}
+
 
 void nyan::Renderpass::update_binds() {
 
@@ -610,6 +682,13 @@ void nyan::Renderpass::update_image_barriers()
 		assert(resource.handle);
 		barrier.image = resource.handle->get_handle();
 	}
+	for (auto& eventBarriers : m_eventBarriers) {
+		for (size_t i = 0; i < eventBarriers.barriers.size(); i++) {
+			auto& resource = r_graph.m_renderresources.get(eventBarriers.images[i]);
+			assert(resource.handle);
+			eventBarriers.barriers[i].image = resource.handle->get_handle();
+		}
+	}
 }
 
 void nyan::Renderpass::update_rendering_info()
@@ -754,6 +833,17 @@ nyan::Rendergraph::Rendergraph(vulkan::LogicalDevice& device)
 	
 }
 
+nyan::Rendergraph::~Rendergraph()
+{
+	if (std::none_of(m_timelineSemaphores.begin(), m_timelineSemaphores.end(), [](VkSemaphore semaphore) { return semaphore != VK_NULL_HANDLE; }))
+		return;
+	//Submitted batches may still signal them
+	r_device.wait_idle();
+	for (auto semaphore : m_timelineSemaphores)
+		if (semaphore != VK_NULL_HANDLE)
+			r_device.destroy_semaphore(semaphore);
+}
+
 Renderpass::Id nyan::Rendergraph::add_pass(const std::string& name, Renderpass::Type type)
 {
 	Renderpass::Id id = Renderpass::Id{ m_renderpassCount++ };
@@ -775,99 +865,337 @@ void nyan::Rendergraph::build()
 {
 	assert(m_state == State::Setup);
 	m_state = State::Build;
-	m_renderresources.for_each([&](RenderResource& resource) {
-		setup_render_resource_barriers(resource);
-	});
+	compile();
+	update_transient_resources();
+	set_up_barriers();
+	const auto pipelineStart = std::chrono::steady_clock::now();
 	m_renderpasses.for_each([&](Renderpass& pass) {
 
 		pass.build();
 		});
+	uint32_t pipelineCount = 0;
+	m_renderpasses.for_each([&](Renderpass& pass) {
+		pipelineCount += pass.wait_for_pipelines();
+		});
+	Utility::log().format("Rendergraph: {} pipelines ready in {:.2f} ms, {} pipeline cache", pipelineCount,
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pipelineStart).count(),
+		r_device.is_pipeline_cache_warm() ? "warm" : "cold");
 
 	assert(m_state == State::Build);
 	m_state = State::Execute;
 }
 void nyan::Rendergraph::begin_frame()
 {
+	m_renderpasses.for_each([](Renderpass& pass) {
+		pass.update_pipelines();
+		});
+	//Profiled timings are noisy, the queue placement is only revisited every few frames and changes rebuild the barriers
+	constexpr uint32_t scheduleInterval = 64;
+	if (p_profiler && m_state == State::Execute && ++m_framesSinceSchedule >= scheduleInterval) {
+		m_framesSinceSchedule = 0;
+		if (schedule_changed())
+			m_state = State::Dirty;
+	}
+	const VkExtent2D swapchainExtent{ r_device.get_swapchain_width(), r_device.get_swapchain_height() };
+	const bool resized = swapchainExtent.width != m_swapchainExtent.width || swapchainExtent.height != m_swapchainExtent.height;
+	if (m_state != State::Dirty && !resized) {
+		//Views, rendering infos and barriers of the other passes still reference the same images
+		if (m_swapchainResource != InvalidResourceId)
+			update_render_resource(m_renderresources.get(m_swapchainResource));
+		for (auto passId : m_swapchainPasses)
+			m_renderpasses.get(passId).update();
+		return;
+	}
 	if (m_state == State::Dirty)
 	{
-		clear_dependencies();
 		remove_queued_resources();
-		m_renderresources.for_each([&](RenderResource& resource) {
-			setup_render_resource_barriers(resource);
-			});
-
-		m_state = State::Execute;
+		compile();
 	}
+	m_swapchainExtent = swapchainExtent;
+	//Swapchain resizes change the packing without dirtying the graph, the aliasing barriers follow it through the key
+	update_transient_resources();
+	set_up_barriers();
+	m_state = State::Execute;
 	//Update Attachments
 	m_renderresources.for_each([&](RenderResource& resource) {
 		update_render_resource(resource);
 		});
 	m_renderpasses.for_each([this](Renderpass& pass) {
-		pass.update();
+		if (!m_plan.is_culled(pass.m_id.id))
+			pass.update();
 		});
 }
 
 void nyan::Rendergraph::end_frame()
 {
-
 	assert(m_state == State::Execute);
+	execute(m_plan);
+	if (m_exportInterval && ++m_framesSinceExport >= m_exportInterval) {
+		m_framesSinceExport = 0;
+		try {
+			export_graph(m_exportDirectory);
+		}
+		catch (const std::exception& e) {
+			Utility::log_warning().format("Rendergraph: Couldn't export to \"{}\": {}", m_exportDirectory.string(), e.what());
+		}
+	}
+}
 
-	m_renderpasses.for_each([this](Renderpass& pass) {
+void nyan::Rendergraph::export_graph(const std::filesystem::path& directory) const
+{
+	RenderGraphExporter::Stats stats;
+	stats.passes.resize(m_renderpassCount);
+	for (Renderpass::Id::Type i = 0; i < m_renderpassCount; i++) {
+		const auto& pass = m_renderpasses.get(Renderpass::Id{ i });
+		auto& passStats = stats.passes[i];
+		if (p_profiler) {
+			passStats.cpuTime = p_profiler->get_cpu_time(pass.m_name);
+			passStats.gpuTime = p_profiler->get_gpu_time(pass.m_name);
+		}
+		passStats.barriers = static_cast<uint32_t>(pass.m_globalBarriers2.postIndex - pass.m_globalBarriers2.preIndex +
+			pass.m_bufferBarriers2.postIndex - pass.m_bufferBarriers2.preIndex +
+			pass.m_imageBarriers2.postIndex - pass.m_imageBarriers2.preIndex);
+		passStats.eventWaits = static_cast<uint32_t>(pass.m_eventWaits.size());
+		passStats.eventSets = static_cast<uint32_t>(pass.m_eventBarriers.size());
+	}
+	stats.resources.resize(m_resourceCount);
+	for (size_t i = 0; i < m_transientResources.size(); i++) {
+		const auto& placement = m_transientPacking.placements[i];
+		if (placement.placed())
+			stats.resources[m_transientResources[i].id] = RenderGraphExporter::ResourceStats{ .transientSize {placement.size}, .heap {placement.heap}, .offset {placement.offset} };
+	}
+	const auto description = build_description();
+	RenderGraphExporter::write(directory / "rendergraph.dot", RenderGraphExporter::to_dot(description, m_plan, stats));
+	RenderGraphExporter::write(directory / "rendergraph.json", RenderGraphExporter::to_json(description, m_plan, stats));
+}
 
-		vulkan::CommandBufferType commandBufferType = vulkan::CommandBufferType::Generic;
-		switch (pass.get_type()) {
-		case Renderpass::Type::AsyncCompute:
-			commandBufferType = vulkan::CommandBufferType::Compute;
-			break;
-		case Renderpass::Type::Generic:
-			commandBufferType = vulkan::CommandBufferType::Generic;
-			break;
+void nyan::Rendergraph::set_export(const std::filesystem::path& directory, uint32_t interval)
+{
+	m_exportDirectory = directory;
+	m_exportInterval = interval;
+	m_framesSinceExport = 0;
+}
+
+void nyan::Rendergraph::begin_plan(const RenderGraphPlan& plan)
+{
+	m_batchValues.assign(plan.get_batches().size(), 0);
+	record_parallel_renderfunctions(plan);
+}
+
+void nyan::Rendergraph::record_parallel_renderfunctions(const RenderGraphPlan& plan)
+{
+	//More chunks than recording threads only add secondary command buffers to execute
+	const size_t maxChunkCount = r_device.get_thread_count();
+	m_parallelChunks.clear();
+	m_parallelCpuTimes.assign(m_renderpassCount, {});
+	for (auto passIndex : plan.get_order()) {
+		auto& pass = m_renderpasses.get(Renderpass::Id{ passIndex });
+		for (uint32_t function{ 0 }; function < pass.m_renderFunctions.size(); function++) {
+			auto& renderFunction = pass.m_renderFunctions[function];
+			if (!renderFunction.prepare)
+				continue;
+			const auto prepareStart = std::chrono::steady_clock::now();
+			const auto count = renderFunction.prepare();
+			m_parallelCpuTimes[passIndex] += std::chrono::steady_clock::now() - prepareStart;
+			const auto minChunkSize = std::max(renderFunction.minChunkSize, size_t{ 1 });
+			const auto chunkCount = std::min((count + minChunkSize - 1) / minChunkSize, maxChunkCount);
+			renderFunction.chunks.assign(chunkCount, VK_NULL_HANDLE);
+			for (uint32_t chunk{ 0 }; chunk < chunkCount; chunk++) {
+				m_parallelChunks.push_back(ParallelChunk{
+					.pass {&pass},
+					.function {function},
+					.chunk {chunk},
+					.begin {count * chunk / chunkCount},
+					.end {count * (chunk + 1) / chunkCount},
+				});
+			}
 		}
-		//std::cout << "Execute pass: "<< pass.get_id() << "\n";
-		auto cmdHandle = r_device.request_command_buffer(commandBufferType);
-		auto& cmd = *cmdHandle;
-		if (p_profiler)
-			p_profiler->begin_profile(cmd, pass.m_name);
-		cmd.begin_region(pass.m_name.c_str());
-		pass.apply_pre_barriers(cmd);
-		for (auto [id, type, view, binding] : pass.m_writes) {
-			auto& resource = m_renderresources.get(id);
-			auto& attachment = std::get<ImageAttachment>(resource.attachment);
-			if (resource.m_type == RenderResource::Type::Image && !vulkan::ImageInfo::is_depth_or_stencil_format(attachment.format)) {
-				if (resource.uses[pass.m_id.id].test(RenderResource::ImageUse::Clear)) {
-					VkClearColorValue clearValue{
-						.float32 {
-							attachment.clearColor.x(),
-							attachment.clearColor.y(),
-							attachment.clearColor.z(),
-							attachment.clearColor.w()
-						}
-					};
-					cmd.clear_color_image(*resource.handle, VK_IMAGE_LAYOUT_GENERAL, &clearValue);
-				}
+	}
+	//Chunks only write their own slot, the primary command buffers execute them in pass order afterwards
+	Utility::JobSystem::get().parallel_for(m_parallelChunks.size(), [this](size_t i) {
+		auto& [pass, function, chunk, begin, end, cpuTime] = m_parallelChunks[i];
+		const auto start = std::chrono::steady_clock::now();
+		auto& renderFunction = pass->m_renderFunctions[function];
+		const bool rendering = renderFunction.rendering && pass->m_type == Renderpass::Type::Generic;
+		auto cmd = r_device.request_secondary_command_buffer(pass->m_type == Renderpass::Type::AsyncCompute ? vulkan::CommandBufferType::Compute : vulkan::CommandBufferType::Generic,
+			rendering ? &pass->m_renderingCreateInfo : nullptr);
+		renderFunction.recordChunk(cmd, *pass, begin, end);
+		cmd.end();
+		renderFunction.chunks[chunk] = cmd.get_handle();
+		cpuTime = std::chrono::steady_clock::now() - start;
+	});
+	if (!p_profiler)
+		return;
+	//Summed over all workers, recorded before execute_pass so it is added to the profile of the pass
+	for (const auto& parallelChunk : m_parallelChunks)
+		m_parallelCpuTimes[parallelChunk.pass->m_id.id] += parallelChunk.cpuTime;
+	for (auto passIndex : plan.get_order())
+		if (m_parallelCpuTimes[passIndex] != std::chrono::steady_clock::duration::zero())
+			p_profiler->add_cpu_time(m_renderpasses.get(Renderpass::Id{ passIndex }).m_name, m_parallelCpuTimes[passIndex]);
+}
+
+void nyan::Rendergraph::begin_batch(uint32_t batchIndex)
+{
+	assert(!m_batchCommandBuffer);
+	m_batchCommandBuffer.emplace(r_device.request_command_buffer(rendergraph_command_buffer_type(m_plan.get_batches()[batchIndex].queue)));
+}
+
+void nyan::Rendergraph::execute_pass(uint32_t passIndex)
+{
+	auto& pass = m_renderpasses.get(Renderpass::Id{ passIndex });
+	//std::cout << "Execute pass: "<< pass.get_id() << "\n";
+	assert(m_batchCommandBuffer);
+	auto& cmd = **m_batchCommandBuffer;
+	if (p_profiler)
+		p_profiler->begin_profile(cmd, pass.m_name);
+	cmd.begin_region(pass.m_name.c_str());
+	record_barriers(cmd, std::exchange(p_pendingPostBarriers, nullptr), &pass);
+	if (!pass.m_eventWaits.empty()) {
+		m_waitEvents.clear();
+		m_waitDependencies.clear();
+		//Has to match the dependency info the producer set the event with
+		for (const auto& [producer, index] : pass.m_eventWaits) {
+			const auto& eventBarriers = m_renderpasses.get(producer).m_eventBarriers[index];
+			assert(eventBarriers.event != VK_NULL_HANDLE);
+			m_waitEvents.push_back(eventBarriers.event);
+			m_waitDependencies.push_back(VkDependencyInfo{
+				.sType {VK_STRUCTURE_TYPE_DEPENDENCY_INFO},
+				.pNext {nullptr},
+				.dependencyFlags {0},
+				.memoryBarrierCount {0},
+				.pMemoryBarriers {nullptr},
+				.bufferMemoryBarrierCount {0},
+				.pBufferMemoryBarriers {nullptr},
+				.imageMemoryBarrierCount {static_cast<uint32_t>(eventBarriers.barriers.size())},
+				.pImageMemoryBarriers {eventBarriers.barriers.data()},
+			});
+		}
+		cmd.wait_events2(static_cast<uint32_t>(m_waitEvents.size()), m_waitEvents.data(), m_waitDependencies.data());
+	}
+	for (auto [id, type, view, binding] : pass.m_writes) {
+		auto& resource = m_renderresources.get(id);
+		auto& attachment = std::get<ImageAttachment>(resource.attachment);
+		if (resource.m_type == RenderResource::Type::Image && !vulkan::ImageInfo::is_depth_or_stencil_format(attachment.format)) {
+			if (resource.uses[pass.m_id.id].test(RenderResource::ImageUse::Clear)) {
+				VkClearColorValue clearValue{
+					.float32 {
+						attachment.clearColor.x(),
+						attachment.clearColor.y(),
+						attachment.clearColor.z(),
+						attachment.clearColor.w()
+					}
+				};
+				cmd.clear_color_image(*resource.handle, VK_IMAGE_LAYOUT_GENERAL, &clearValue);
 			}
 		}
-		pass.execute(cmd);
-		pass.apply_post_barriers(cmd);
-		cmd.end_region();
-		if (p_profiler)
-			p_profiler->end_profile(cmd);
+	}
+	pass.execute(cmd);
+	//Passes in between don't wait for the transitions to the consumer
+	for (auto& eventBarriers : pass.m_eventBarriers) {
+		eventBarriers.event = r_device.request_event();
+		cmd.set_event2(eventBarriers.event, static_cast<uint32_t>(eventBarriers.barriers.size()), eventBarriers.barriers.data());
+	}
+	p_pendingPostBarriers = &pass;
+	cmd.end_region();
+	if (p_profiler)
+		p_profiler->end_profile(cmd);
+}
 
-		r_device.add_wait_semaphores(commandBufferType, pass.m_waitInfos);
+void nyan::Rendergraph::record_barriers(vulkan::CommandBuffer& cmd, Renderpass* post, Renderpass* pre)
+{
+	if (!post || !post->has_post_barriers() || !pre || !pre->has_pre_barriers()) {
+		if (post)
+			post->apply_post_barriers(cmd);
+		if (pre)
+			pre->apply_pre_barriers(cmd);
+		return;
+	}
+	const auto& postGlobals = post->m_globalBarriers2;
+	const auto& postBuffers = post->m_bufferBarriers2;
+	const auto& postImages = post->m_imageBarriers2;
+	m_mergedGlobalBarriers.assign(postGlobals.barriers.begin() + postGlobals.postIndex, postGlobals.barriers.end());
+	m_mergedBufferBarriers.assign(postBuffers.barriers.begin() + postBuffers.postIndex, postBuffers.barriers.end());
+	m_mergedImageBarriers.assign(postImages.barriers.begin() + postImages.postIndex, postImages.barriers.end());
+	const auto& preGlobals = pre->m_globalBarriers2;
+	const auto& preBuffers = pre->m_bufferBarriers2;
+	const auto& preImages = pre->m_imageBarriers2;
+	m_mergedGlobalBarriers.insert(m_mergedGlobalBarriers.end(), preGlobals.barriers.begin() + preGlobals.preIndex, preGlobals.barriers.begin() + preGlobals.postIndex);
+	m_mergedBufferBarriers.insert(m_mergedBufferBarriers.end(), preBuffers.barriers.begin() + preBuffers.preIndex, preBuffers.barriers.begin() + preBuffers.postIndex);
+	m_mergedImageBarriers.insert(m_mergedImageBarriers.end(), preImages.barriers.begin() + preImages.preIndex, preImages.barriers.begin() + preImages.postIndex);
+	cmd.barrier2(
+		static_cast<uint32_t>(m_mergedGlobalBarriers.size()), m_mergedGlobalBarriers.data(),
+		static_cast<uint32_t>(m_mergedBufferBarriers.size()), m_mergedBufferBarriers.data(),
+		static_cast<uint32_t>(m_mergedImageBarriers.size()), m_mergedImageBarriers.data());
+}
+
+void nyan::Rendergraph::end_batch(uint32_t batchIndex)
+{
+	assert(m_batchCommandBuffer);
+	//Releases and the present transition have to be recorded before the submission signals
+	record_barriers(**m_batchCommandBuffer, std::exchange(p_pendingPostBarriers, nullptr), nullptr);
+	const auto& batch = m_plan.get_batches()[batchIndex];
+	const auto commandBufferType = rendergraph_command_buffer_type(batch.queue);
+	const auto& order = m_plan.get_order();
+
+	//One wait per queue, waiting for the latest value of a timeline covers all earlier ones
+	std::vector<VkSemaphoreSubmitInfo> waitInfos;
+	auto add_wait_info = [&waitInfos](const VkSemaphoreSubmitInfo& waitInfo) {
+		auto it = std::find_if(waitInfos.begin(), waitInfos.end(), [&](const auto& info) { return info.semaphore == waitInfo.semaphore; });
+		if (it == waitInfos.end()) {
+			waitInfos.push_back(waitInfo);
+			return;
+		}
+		it->value = std::max(it->value, waitInfo.value);
+		it->stageMask |= waitInfo.stageMask;
+	};
+	for (auto wait : batch.waits) {
+		assert(m_batchValues[wait]);
+		add_wait_info(VkSemaphoreSubmitInfo{
+			.sType {VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO },
+			.pNext {nullptr},
+			.semaphore {m_timelineSemaphores[static_cast<size_t>(m_plan.get_batches()[wait].queue)]},
+			.value {m_batchValues[wait]},
+			.stageMask {0},
+		});
+	}
+	bool signals = batch.signals;
+	for (auto position = batch.begin; position < batch.end; position++) {
+		auto& pass = m_renderpasses.get(Renderpass::Id{ order[position] });
+		for (const auto& waitInfo : pass.m_waitInfos)
+			add_wait_info(waitInfo);
 		pass.m_waitInfos.clear();
-		std::vector<VkSemaphore> signals(pass.m_signals.size(), VK_NULL_HANDLE);
-		if (pass.m_id == m_lastCompute || pass.m_id == m_lastGeneric)
-			signals.push_back(VK_NULL_HANDLE);
-		r_device.submit(cmdHandle, static_cast<uint32_t>(signals.size()), signals.data());
-		for (size_t i{ 0 }; i < pass.m_signals.size(); i++) {
-			assert(pass.m_signals[i].passId);
-			assert(pass.m_signals[i].passId != pass.m_id);
-			auto& waitPass = m_renderpasses.get(pass.m_signals[i].passId);
-			waitPass.add_wait(signals[i], pass.m_signals[i].stage);
+		signals |= !pass.m_signals.empty() || pass.m_id == m_lastCompute || pass.m_id == m_lastGeneric;
+	}
+	//Only the stages of queue ownership transfers are known, other dependencies wait for everything
+	for (auto& waitInfo : waitInfos)
+		if (!waitInfo.stageMask)
+			waitInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+	//Flush the work already queued, it doesn't have to wait
+	if (!waitInfos.empty())
+		r_device.add_wait_semaphores(commandBufferType, waitInfos, true);
+
+	if (!signals) {
+		r_device.submit(*m_batchCommandBuffer);
+		m_batchCommandBuffer.reset();
+		return;
+	}
+	auto& timeline = m_timelineSemaphores[static_cast<size_t>(batch.queue)];
+	if (timeline == VK_NULL_HANDLE)
+		timeline = r_device.create_timeline_semaphore();
+	auto value = ++m_timelineValues[static_cast<size_t>(batch.queue)];
+	m_batchValues[batchIndex] = value;
+	r_device.submit(*m_batchCommandBuffer, 1, &timeline, nullptr, &value);
+	m_batchCommandBuffer.reset();
+	for (auto position = batch.begin; position < batch.end; position++) {
+		const auto& pass = m_renderpasses.get(Renderpass::Id{ order[position] });
+		for (const auto& signal : pass.m_signals) {
+			assert(signal.passId);
+			assert(signal.passId != pass.m_id);
+			m_renderpasses.get(signal.passId).add_wait(timeline, signal.stage, value);
 		}
 		if (pass.m_id == m_lastCompute || pass.m_id == m_lastGeneric)
-			r_device.add_wait_semaphore(vulkan::CommandBufferType::Transfer, signals.back(), VK_PIPELINE_STAGE_2_COPY_BIT);
-	});
+			r_device.add_wait_semaphore(vulkan::CommandBufferType::Transfer, timeline, VK_PIPELINE_STAGE_2_COPY_BIT, value);
+	}
 }
 
 void nyan::Rendergraph::set_profiler(nyan::Profiler* profiler)
@@ -989,6 +1317,207 @@ bool nyan::Rendergraph::resource_exists(RenderResource::Id id)
 	return m_renderresources.contains(id);
 }
 
+void nyan::Rendergraph::export_resource(RenderResource::Id id)
+{
+	if (m_state != State::Setup)
+		m_state = State::Dirty;
+	get_resource(id).exported = true;
+}
+
+RenderGraphDescription nyan::Rendergraph::build_description() const
+{
+	RenderGraphDescription description;
+	description.resources.resize(m_resourceCount);
+	for (RenderResource::Id::Type i = 0; i < m_resourceCount; i++) {
+		if (!m_renderresources.contains(RenderResource::Id{ i }))
+			continue;
+		const auto& resource = m_renderresources.get(RenderResource::Id{ i });
+		description.resources[i] = RenderGraphDescription::Resource{
+			.name {resource.name},
+			.exported {resource.exported || resource.m_id == m_swapchainResource},
+		};
+	}
+	description.passes.reserve(m_renderpassCount);
+	for (Renderpass::Id::Type i = 0; i < m_renderpassCount; i++) {
+		const auto& pass = m_renderpasses.get(Renderpass::Id{ i });
+		//Transfer passes are recorded on the generic queue, batching has to see them there
+		auto& passDescription = description.passes.emplace_back(RenderGraphDescription::Pass{
+			.name {pass.m_name},
+			.queue {pass.m_type == Renderpass::Type::AsyncCompute ? RenderGraphDescription::Queue::Compute : RenderGraphDescription::Queue::Graphics},
+			.externalWait {pass.m_rendersSwap},
+		});
+		if (p_profiler)
+			if (auto time = p_profiler->get_gpu_time(pass.m_name))
+				passDescription.cost = *time;
+		//Attachments, the swapchain, copies and clears through the first transition are set up for the graphics queue only
+		passDescription.asyncCompute = pass.m_asyncCompute && pass.m_attachments.empty() && !pass.m_depth && !pass.m_stencil && !pass.m_rendersSwap && pass.m_copies.empty() &&
+			std::none_of(pass.m_writes.cbegin(), pass.m_writes.cend(), [&](const auto& passWrite) {
+				const auto& uses = get_resource(passWrite.id).uses;
+				return uses.size() > i && uses[i].test(RenderResource::ImageUse::Clear);
+			});
+		//Without a clear the previous contents are loaded, so the pass also consumes them
+		auto write = [&](RenderResource::Id id) {
+			const auto& uses = get_resource(id).uses;
+			const bool clear = uses.size() > i && uses[i].test(RenderResource::ImageUse::Clear);
+			passDescription.accesses.push_back({ id.id, clear ? RenderGraphDescription::Access::Type::Write : RenderGraphDescription::Access::Type::ReadWrite });
+		};
+		for (const auto& read : pass.m_reads)
+			passDescription.accesses.push_back({ read.id.id, RenderGraphDescription::Access::Type::Read });
+		for (const auto& passWrite : pass.m_writes)
+			write(passWrite.id);
+		for (auto attachment : pass.m_attachments)
+			write(attachment);
+		if (pass.m_depth)
+			write(pass.m_depth);
+		if (pass.m_stencil && pass.m_stencil != pass.m_depth)
+			write(pass.m_stencil);
+		for (const auto& [src, dst] : pass.m_copies) {
+			passDescription.accesses.push_back({ src.id, RenderGraphDescription::Access::Type::Read });
+			passDescription.accesses.push_back({ dst.id, RenderGraphDescription::Access::Type::Write });
+		}
+	}
+	return description;
+}
+
+void nyan::Rendergraph::compile()
+{
+	m_plan = RenderGraphCompiler::compile(build_description(), rendergraph_compiler_settings());
+	m_lastGeneric = InvalidRenderpassId;
+	m_lastCompute = InvalidRenderpassId;
+	for (auto passIndex : m_plan.get_order()) {
+		auto& pass = m_renderpasses.get(Renderpass::Id{ passIndex });
+		//Barriers, command buffer types and queue ownership transfers follow the type
+		if (pass.m_asyncCompute)
+			pass.m_type = m_plan.get_queue(passIndex) == RenderGraphDescription::Queue::Compute ? Renderpass::Type::AsyncCompute : Renderpass::Type::Generic;
+		if (pass.m_type == Renderpass::Type::Generic)
+			m_lastGeneric = pass.m_id;
+		else if (pass.m_type == Renderpass::Type::AsyncCompute)
+			m_lastCompute = pass.m_id;
+	}
+}
+
+bool nyan::Rendergraph::schedule_changed() const
+{
+	//The current placement is the starting point, passes only move if the estimate strictly improves
+	const auto plan = RenderGraphCompiler::compile(build_description(), rendergraph_compiler_settings());
+	for (auto passIndex : plan.get_order()) {
+		const auto& pass = m_renderpasses.get(Renderpass::Id{ passIndex });
+		if (pass.m_asyncCompute && (plan.get_queue(passIndex) == RenderGraphDescription::Queue::Compute) != (pass.m_type == Renderpass::Type::AsyncCompute))
+			return true;
+	}
+	return false;
+}
+
+//Barriers are derived from the plan, the uses and the attachment descriptors, the swapchain extent decides the transient packing
+Utility::HashValue nyan::Rendergraph::compute_plan_key() const
+{
+	Utility::Hasher hasher{ RenderGraphCompiler::hash(build_description(), m_plan) };
+	hasher(m_swapchainExtent.width);
+	hasher(m_swapchainExtent.height);
+	hasher(m_swapchainResource.id);
+	for (RenderResource::Id::Type i = 0; i < m_resourceCount; i++) {
+		if (!m_renderresources.contains(RenderResource::Id{ i }))
+			continue;
+		const auto& resource = m_renderresources.get(RenderResource::Id{ i });
+		hasher(i);
+		hasher(static_cast<uint32_t>(resource.m_type));
+		for (const auto& use : resource.uses)
+			hasher(static_cast<Utility::HashValue>(use.to_ullong()));
+		if (resource.m_type != RenderResource::Type::Image)
+			continue;
+		const auto& attachment = std::get<ImageAttachment>(resource.attachment);
+		hasher(attachment.format);
+		hasher(static_cast<uint32_t>(attachment.size));
+		hasher(attachment.width);
+		hasher(attachment.height);
+		hasher(attachment.arrayLayers);
+	}
+	for (Renderpass::Id::Type i = 0; i < m_renderpassCount; i++) {
+		const auto& pass = m_renderpasses.get(Renderpass::Id{ i });
+		hasher(static_cast<uint32_t>(pass.m_type));
+		for (const auto& read : pass.m_reads)
+			hasher(static_cast<uint32_t>(read.type));
+		for (const auto& write : pass.m_writes)
+			hasher(static_cast<uint32_t>(write.type));
+	}
+	return hasher();
+}
+
+void nyan::Rendergraph::set_up_barriers()
+{
+	const auto key = compute_plan_key();
+	if (const auto* cached = m_dependencyCache.find(key)) {
+		for (Renderpass::Id::Type i = 0; i < m_renderpassCount; i++) {
+			auto& pass = m_renderpasses.get(Renderpass::Id{ i });
+			const auto& dependencies = (*cached)[i];
+			pass.m_globalBarriers2 = dependencies.globalBarriers;
+			pass.m_imageBarriers2 = dependencies.imageBarriers;
+			pass.m_bufferBarriers2 = dependencies.bufferBarriers;
+			pass.m_signals = dependencies.signals;
+			pass.m_eventBarriers = dependencies.eventBarriers;
+			pass.m_eventWaits = dependencies.eventWaits;
+		}
+	}
+	else {
+		clear_dependencies();
+		m_renderresources.for_each([&](RenderResource& resource) {
+			setup_render_resource_barriers(resource);
+			});
+		schedule_transitions();
+		std::vector<CachedDependencies> dependencies;
+		dependencies.reserve(m_renderpassCount);
+		for (Renderpass::Id::Type i = 0; i < m_renderpassCount; i++) {
+			const auto& pass = m_renderpasses.get(Renderpass::Id{ i });
+			dependencies.push_back(CachedDependencies{
+				.globalBarriers {pass.m_globalBarriers2},
+				.imageBarriers {pass.m_imageBarriers2},
+				.bufferBarriers {pass.m_bufferBarriers2},
+				.signals {pass.m_signals},
+				.eventBarriers {pass.m_eventBarriers},
+				.eventWaits {pass.m_eventWaits},
+			});
+		}
+		m_dependencyCache.insert(key, std::move(dependencies));
+	}
+	m_swapchainPasses.clear();
+	if (m_swapchainResource == InvalidResourceId)
+		return;
+	const auto& uses = m_renderresources.get(m_swapchainResource).uses;
+	for (Renderpass::Id::Type i = 0; i < static_cast<Renderpass::Id::Type>(uses.size()); i++)
+		if (uses[i].any() && !m_plan.is_culled(i))
+			m_swapchainPasses.push_back(Renderpass::Id{ i });
+}
+
+void nyan::Rendergraph::schedule_transitions()
+{
+	std::vector<RenderGraphBarrierSchedule::Transition> transitions;
+	transitions.reserve(m_transitions.size());
+	for (const auto& transition : m_transitions)
+		transitions.push_back({ .producer {transition.from.id}, .consumer {transition.to.id} });
+	const auto schedule = RenderGraphCompiler::schedule_barriers(m_plan, transitions);
+
+	std::vector<uint32_t> eventIndices;
+	eventIndices.reserve(schedule.get_events().size());
+	for (const auto& [producer, consumer] : schedule.get_events()) {
+		auto& src = m_renderpasses.get(Renderpass::Id{ producer });
+		auto& dst = m_renderpasses.get(Renderpass::Id{ consumer });
+		const auto index = static_cast<uint32_t>(src.m_eventBarriers.size());
+		src.m_eventBarriers.push_back(Renderpass::EventBarriers{ .consumer {dst.m_id} });
+		dst.m_eventWaits.push_back(Renderpass::EventWait{ .producer {src.m_id}, .index {index} });
+		eventIndices.push_back(index);
+	}
+	for (uint32_t i = 0; i < m_transitions.size(); i++) {
+		const auto& [from, to, image, barrier] = m_transitions[i];
+		if (schedule.get_type(i) == RenderGraphBarrierSchedule::Type::Barrier) {
+			m_renderpasses.get(to).add_pre_barrier(barrier, image);
+			continue;
+		}
+		auto& eventBarriers = m_renderpasses.get(from).m_eventBarriers[eventIndices[schedule.get_event(i)]];
+		eventBarriers.images.push_back(image);
+		eventBarriers.barriers.push_back(barrier);
+	}
+}
+
 void nyan::Rendergraph::swapchain_present_transition(Renderpass::Id src_const)
 {
 	if (m_swapchainResource == InvalidResourceId) {
@@ -1280,9 +1809,12 @@ void nyan::Rendergraph::set_up_transition(Renderpass::Id from, Renderpass::Id to
 		srcUsage.only(RenderResource::ImageUse::Attachment) && dstUsage.only(RenderResource::ImageUse::Attachment)) {
 		Utility::log().format("Renderpass {} -> {}, Barrier for attachment only usage without layout transition or Queue Ownership transfer", src.m_name, dst.m_name);
 	}
-	else {
+	else if (imageBarrier.srcQueueFamilyIndex != imageBarrier.dstQueueFamilyIndex) {
 		src.add_post_barrier(imageBarrier, resource.m_id);
 	}
+	else {
+		m_transitions.push_back(Transition{ .from {from}, .to {to}, .image {resource.m_id}, .barrier {imageBarrier} });
+	}
 	//src.m_imageBarriers2.postIndex++;
 	//src.m_imageBarriers2.copyIndex++;
 	//src.m_imageBarriers2.preIndex++;
@@ -1300,9 +1832,9 @@ void nyan::Rendergraph::update_render_resource(RenderResource& resource)
 	}
 }
 
-void nyan::Rendergraph::update_render_resource_image(RenderResource& resource)
+std::optional<vulkan::ImageInfo> nyan::Rendergraph::get_image_info(const RenderResource& resource) const
 {
-	auto& attachment = std::get<ImageAttachment>(resource.attachment);
+	const auto& attachment = std::get<ImageAttachment>(resource.attachment);
 	uint32_t width = r_device.get_swapchain_width();
 	uint32_t height = r_device.get_swapchain_height();
 	if (attachment.size == ImageAttachment::Size::Absolute) {
@@ -1313,93 +1845,238 @@ void nyan::Rendergraph::update_render_resource_image(RenderResource& resource)
 		width = static_cast<uint32_t>(width * attachment.width);
 		height = static_cast<uint32_t>(height * attachment.height);
 	}
-	if (m_swapchainResource == resource.m_id) {
-		resource.handle = r_device.get_swapchain_image();
-		assert(attachment.arrayLayers == 1);
-	}
-	else {
-		VkImageUsageFlags usage = 0;
-		if (debug)
-			usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-		VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		bool first = true;
-		Utility::bitset<static_cast<size_t>(RenderResource::ImageUse::Size), RenderResource::ImageUse> totalUses;
-
-		for (const auto& use : resource.uses) {
-			totalUses |= use;
-			//TODO add transfer dst for clear depth stencil
-			//if (use.test(RenderResource::ImageUse::Clear) 
-			//	&& vulkan::ImageInfo::is_depth_or_stencil_format(attachment.format)
-			//	&& ) {
-			//	usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-			//}
-
-			if (use.any_of(RenderResource::ImageUse::BlitTarget, RenderResource::ImageUse::CopyTarget)) {
-				usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-				if (first) {
-					first = false;
-					initialLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-				}
+	VkImageUsageFlags usage = 0;
+	if (debug)
+		usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	bool first = true;
+	Utility::bitset<static_cast<size_t>(RenderResource::ImageUse::Size), RenderResource::ImageUse> totalUses;
+
+	for (Renderpass::Id::Type i = 0; i < static_cast<Renderpass::Id::Type>(resource.uses.size()); i++) {
+		//The initial layout has to match the first pass which actually executes
+		if (m_plan.is_culled(i))
+			continue;
+		const auto& use = resource.uses[i];
+		totalUses |= use;
+		//TODO add transfer dst for clear depth stencil
+		//if (use.test(RenderResource::ImageUse::Clear) 
+		//	&& vulkan::ImageInfo::is_depth_or_stencil_format(attachment.format)
+		//	&& ) {
+		//	usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		//}
+
+		if (use.any_of(RenderResource::ImageUse::BlitTarget, RenderResource::ImageUse::CopyTarget)) {
+			usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			if (first) {
+				first = false;
+				initialLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 			}
-			if (use.test(RenderResource::ImageUse::Sample)) {
-				usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
-				if (first) {
-					first = false;
-					initialLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
-					Utility::log().format("First usage of image %d is sampling, is this intended?", resource.name);
-				}
+		}
+		if (use.test(RenderResource::ImageUse::Sample)) {
+			usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+			if (first) {
+				first = false;
+				initialLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+				Utility::log().format("First usage of image %d is sampling, is this intended?", resource.name);
 			}
-			if (use.any_of(RenderResource::ImageUse::ImageLoad, RenderResource::ImageUse::ImageStore)) {
-				usage |= VK_IMAGE_USAGE_STORAGE_BIT;
-				if (first) {
-					first = false;
-					initialLayout = VK_IMAGE_LAYOUT_GENERAL;
-				}
+		}
+		if (use.any_of(RenderResource::ImageUse::ImageLoad, RenderResource::ImageUse::ImageStore)) {
+			usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+			if (first) {
+				first = false;
+				initialLayout = VK_IMAGE_LAYOUT_GENERAL;
 			}
-			if (use.test(RenderResource::ImageUse::Attachment) && vulkan::ImageInfo::is_depth_or_stencil_format(attachment.format)) {
-				usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-				if (first) {
-					first = false;
-					initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-				}
+		}
+		if (use.test(RenderResource::ImageUse::Attachment) && vulkan::ImageInfo::is_depth_or_stencil_format(attachment.format)) {
+			usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			if (first) {
+				first = false;
+				initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 			}
-			if (use.test(RenderResource::ImageUse::Attachment) && !vulkan::ImageInfo::is_depth_or_stencil_format(attachment.format)) {
-				usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-				if (first) {
-					first = false;
-					initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-				}
+		}
+		if (use.test(RenderResource::ImageUse::Attachment) && !vulkan::ImageInfo::is_depth_or_stencil_format(attachment.format)) {
+			usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			if (first) {
+				first = false;
+				initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 			}
-			if (use.any_of(RenderResource::ImageUse::BlitSource, RenderResource::ImageUse::CopySource)) {
-				usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-				if (first) {
-					first = false;
-					initialLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-					Utility::log().format("First usage of image %d is as copy source, is this intended?", resource.name);
-				}
+		}
+		if (use.any_of(RenderResource::ImageUse::BlitSource, RenderResource::ImageUse::CopySource)) {
+			usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			if (first) {
+				first = false;
+				initialLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+				Utility::log().format("First usage of image %d is as copy source, is this intended?", resource.name);
 			}
 		}
-		if (!totalUses.none())
-			resource.handle = r_device.request_render_target(width, height, attachment.format, resource.m_id.id, usage, initialLayout, VK_SAMPLE_COUNT_1_BIT, attachment.arrayLayers);
+	}
+	if (totalUses.none())
+		return std::nullopt;
+	auto info = vulkan::ImageInfo::render_target(width, height, attachment.format, attachment.arrayLayers);
+	info.usage |= usage;
+	info.layout = initialLayout;
+	return info;
+}
+
+void nyan::Rendergraph::update_render_resource_image(RenderResource& resource)
+{
+	if (m_swapchainResource == resource.m_id) {
+		resource.handle = r_device.get_swapchain_image();
+		assert(std::get<ImageAttachment>(resource.attachment).arrayLayers == 1);
+	}
+	else if (auto transient = m_transientImages.find(resource.m_id); transient != m_transientImages.end()) {
+		resource.handle = transient->second;
+	}
+	else if (auto info = get_image_info(resource)) {
+		resource.handle = r_device.request_render_target(info->width, info->height, info->format, resource.m_id.id, info->usage, info->layout, VK_SAMPLE_COUNT_1_BIT, info->arrayLayers);
+	}
+	else {
+		//Resources only used by culled passes have no image
+		resource.handle = nullptr;
+		return;
 	}
 	resource.handle->set_debug_label(resource.name.data());
 	resource.handle->get_view()->set_debug_label((resource.name + "_view").c_str());
 }
 
+//Transient resources are cleared by their first executed use, their contents don't survive between frames
+//Only graphics passes use them, their lifetimes are positions in the submission order of a single queue
+bool nyan::Rendergraph::is_transient(const RenderResource& resource) const
+{
+	if (resource.m_type != RenderResource::Type::Image || resource.m_id == m_swapchainResource || resource.exported)
+		return false;
+	bool first = true;
+	for (Renderpass::Id::Type i = 0; i < static_cast<Renderpass::Id::Type>(resource.uses.size()); i++) {
+		if (resource.uses[i].none() || m_plan.is_culled(i))
+			continue;
+		if (first && !resource.uses[i].test(RenderResource::ImageUse::Clear))
+			return false;
+		first = false;
+		if (m_renderpasses.get(Renderpass::Id{ i }).m_type != Renderpass::Type::Generic)
+			return false;
+	}
+	return !first;
+}
+
+bool nyan::Rendergraph::update_transient_resources()
+{
+	std::vector<RenderResource::Id> resources;
+	std::vector<vulkan::ImageInfo> infos;
+	Utility::Hasher hasher;
+	for (RenderResource::Id::Type i = 0; i < m_resourceCount; i++) {
+		if (!m_renderresources.contains(RenderResource::Id{ i }))
+			continue;
+		const auto& resource = m_renderresources.get(RenderResource::Id{ i });
+		if (!is_transient(resource))
+			continue;
+		auto info = get_image_info(resource);
+		assert(info);
+		const auto& lifetime = m_plan.get_lifetime(i);
+		hasher(i);
+		hasher(info->width);
+		hasher(info->height);
+		hasher(info->format);
+		hasher(info->usage);
+		hasher(info->arrayLayers);
+		hasher(lifetime.first);
+		hasher(lifetime.last);
+		resources.push_back(resource.m_id);
+		infos.push_back(*info);
+	}
+	const auto key = hasher(static_cast<uint32_t>(resources.size()));
+	if (key == m_transientKey)
+		return false;
+	m_transientKey = key;
+
+	std::vector<TransientMemoryPacker::Resource> requests;
+	requests.reserve(infos.size());
+	for (size_t i = 0; i < infos.size(); i++) {
+		const auto requirements = r_device.get_image_memory_requirements(infos[i]);
+		requests.push_back(TransientMemoryPacker::Resource{
+			.lifetime {m_plan.get_lifetime(resources[i].id)},
+			.size {requirements.size},
+			.alignment {requirements.alignment},
+			.memoryTypeBits {requirements.memoryTypeBits},
+		});
+	}
+	m_transientPacking = TransientMemoryPacker::pack(requests);
+	m_transientResources = std::move(resources);
+	//Images of frames in flight keep their heaps alive until their deletion is processed
+	m_transientImages.clear();
+	m_transientHeaps.clear();
+	for (const auto& heap : m_transientPacking.heaps)
+		m_transientHeaps.push_back(r_device.allocate_memory(VkMemoryRequirements{ .size {heap.size}, .alignment {heap.alignment}, .memoryTypeBits {heap.memoryTypeBits} }));
+	for (size_t i = 0; i < m_transientResources.size(); i++) {
+		const auto& placement = m_transientPacking.placements[i];
+		if (placement.placed())
+			m_transientImages.emplace(m_transientResources[i], r_device.create_aliased_image(infos[i], m_transientHeaps[placement.heap], placement.offset));
+	}
+	constexpr double mebibyte = 1024.0 * 1024.0;
+	Utility::log().format("Transient attachments: {:.1f} MiB in {} heaps, {:.1f} MiB without aliasing",
+		static_cast<double>(m_transientPacking.get_size()) / mebibyte, m_transientPacking.heaps.size(),
+		static_cast<double>(m_transientPacking.unaliasedSize) / mebibyte);
+	return true;
+}
+
+//The previous contents are discarded, but the accesses of resources sharing the memory have to finish first
+//Aliases used later in the frame were last accessed in the previous frame, which the pipeline barrier covers as well
+void nyan::Rendergraph::set_up_aliasing_barrier(const RenderResource& resource, VkImageMemoryBarrier2& barrier) const
+{
+	auto transient = std::find(m_transientResources.begin(), m_transientResources.end(), resource.m_id);
+	if (transient == m_transientResources.end())
+		return;
+	for (auto alias : m_transientPacking.aliases[transient - m_transientResources.begin()]) {
+		const auto& aliasResource = m_renderresources.get(m_transientResources[alias]);
+		const auto& aliasAttachment = std::get<ImageAttachment>(aliasResource.attachment);
+		for (auto i = static_cast<Renderpass::Id::Type>(aliasResource.uses.size()); i-- > 0;) {
+			if (aliasResource.uses[i].none() || m_plan.is_culled(i))
+				continue;
+			const auto& use = aliasResource.uses[i];
+			if (use.test(RenderResource::ImageUse::Attachment)) {
+				if (vulkan::ImageInfo::is_depth_or_stencil_format(aliasAttachment.format)) {
+					barrier.srcStageMask |= VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+					barrier.srcAccessMask |= VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+				}
+				else {
+					barrier.srcStageMask |= VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+					barrier.srcAccessMask |= VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+				}
+			}
+			if (use.any_of(RenderResource::ImageUse::Sample, RenderResource::ImageUse::ImageLoad))
+				barrier.srcStageMask |= VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR;
+			if (use.test(RenderResource::ImageUse::ImageStore)) {
+				barrier.srcStageMask |= VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+				barrier.srcAccessMask |= VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+			}
+			if (use.any_of(RenderResource::ImageUse::CopySource, RenderResource::ImageUse::CopyTarget))
+				barrier.srcStageMask |= VK_PIPELINE_STAGE_2_COPY_BIT;
+			if (use.any_of(RenderResource::ImageUse::BlitSource, RenderResource::ImageUse::BlitTarget))
+				barrier.srcStageMask |= VK_PIPELINE_STAGE_2_BLIT_BIT;
+			if (use.any_of(RenderResource::ImageUse::CopyTarget, RenderResource::ImageUse::BlitTarget))
+				barrier.srcAccessMask |= VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			break;
+		}
+	}
+}
+
 void nyan::Rendergraph::setup_render_resource_barriers(RenderResource& resource)
 {
 	bool first = true;
+	//Culled passes don't execute, the transitions skip over them
+	auto unused = [&](Renderpass::Id::Type i) {
+		return resource.uses[i].none() || m_plan.is_culled(i);
+	};
 
 	for (Renderpass::Id::Type i = 0; i < static_cast<Renderpass::Id::Type>(resource.uses.size()); i++) {
-		const auto& srcUse = resource.uses[i];
-		if (srcUse.none())
+		if (unused(i))
 			continue;
+		const auto& srcUse = resource.uses[i];
 		if (first) {
 			first = false;
 			//CreatePreBarrier
 			auto lastUse = i;
 			for (auto j = i; j < static_cast<Renderpass::Id::Type>(resource.uses.size()); j++) {
-				if (!resource.uses[j].none())
+				if (!unused(j))
 					lastUse = j;
 			}
 			if (srcUse.test(RenderResource::ImageUse::Clear) || resource.m_id == m_swapchainResource)
@@ -1410,8 +2087,7 @@ void nyan::Rendergraph::setup_render_resource_barriers(RenderResource& resource)
 		set_up_copy(Renderpass::Id{ i }, resource);
 		auto j = i + 1;
 		for (; j < static_cast<Renderpass::Id::Type>(resource.uses.size()); j++) {
-			const auto& dstUse = resource.uses[j];
-			if (!dstUse.none())
+			if (!unused(j))
 				break;
 		}
 		if (j < static_cast<Renderpass::Id::Type>(resource.uses.size())) {
@@ -1423,8 +2099,7 @@ void nyan::Rendergraph::setup_render_resource_barriers(RenderResource& resource)
 	if (resource.m_id == m_swapchainResource) {
 
 		for (int64_t i = static_cast<int64_t>(resource.uses.size()) - 1; i > 0; i--) {
-			const auto& srcUse = resource.uses[i];
-			if (!srcUse.none()) {
+			if (!unused(static_cast<Renderpass::Id::Type>(i))) {
 				swapchain_present_transition(Renderpass::Id{ static_cast<Renderpass::Id::Type>(i) });
 				break;
 			}
@@ -1512,6 +2187,7 @@ void nyan::Rendergraph::set_up_first_transition(Renderpass::Id dst_const, const
 	}
 	if (imageBarrier.newLayout == VK_IMAGE_LAYOUT_UNDEFINED)
 		return;
+	set_up_aliasing_barrier(resource, imageBarrier);
 
 	if (debugBarriers) {
 		Utility::log().format("Ressource ({}) Renderpass ({})", resource.name.data(), dst.m_name);
@@ -1662,6 +2338,7 @@ void nyan::Rendergraph::clear_dependencies()
 	m_renderpasses.for_each([this](Renderpass& pass) {
 		pass.clear_dependencies();
 		});
+	m_transitions.clear();
 }
 
 void nyan::Rendergraph::remove_queued_resources()
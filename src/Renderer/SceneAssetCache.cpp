@@ -0,0 +1,251 @@
+#include "Renderer/SceneAssetCache.h"
+#include "Utility/BinaryStream.h"
+#include "Utility/MappedFile.h"
+#include "Utility/StreamHasher.h"
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+struct SceneAssetCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceKey;
+	uint64_t dataSize;
+	//StreamHasher of the data
+	uint64_t checksum;
+};
+
+static uint64_t scene_cache_checksum(std::span<const std::byte> data)
+{
+	Utility::StreamHasher hasher;
+	hasher.update(data.data(), data.size());
+	return hasher.finish();
+}
+
+static void write_mesh(Utility::BinaryWriter& writer, const nyan::QuantizedMesh& mesh)
+{
+	writer.write(mesh.type);
+	writer.write(mesh.name);
+	writer.write(mesh.material);
+	writer.write(mesh.materialBinding);
+	writer.write(mesh.bounds);
+	writer.write(mesh.positionOffset);
+	writer.write(mesh.positionScale);
+	writer.write(mesh.shortIndices);
+	writer.write(mesh.indices);
+	writer.write(mesh.positions);
+	writer.write(mesh.uvs0);
+	writer.write(mesh.normals);
+	writer.write(mesh.tangents);
+}
+
+static bool read_mesh(Utility::BinaryReader& reader, nyan::QuantizedMesh& mesh)
+{
+	return reader.read(mesh.type) && reader.read(mesh.name) && reader.read(mesh.material) && reader.read(mesh.materialBinding) &&
+		reader.read(mesh.bounds) && reader.read(mesh.positionOffset) && reader.read(mesh.positionScale) &&
+		reader.read(mesh.shortIndices) && reader.read(mesh.indices) && reader.read(mesh.positions) &&
+		reader.read(mesh.uvs0) && reader.read(mesh.normals) && reader.read(mesh.tangents);
+}
+
+static void write_asset(Utility::BinaryWriter& writer, const nyan::SceneAsset& asset)
+{
+	writer.write(asset.name);
+	writer.write(static_cast<uint32_t>(asset.textures.size()));
+	for (const auto& texture : asset.textures) {
+		writer.write(texture.name);
+		writer.write(texture.file.generic_string());
+		writer.write(texture.width);
+		writer.write(texture.height);
+		writer.write(texture.components);
+		writer.write(texture.bitsPerChannel);
+		writer.write(texture.data);
+	}
+	writer.write(static_cast<uint32_t>(asset.materials.size()));
+	for (const auto& material : asset.materials) {
+		writer.write(material.name);
+		writer.write(material.albedoTex);
+		writer.write(material.emissiveTex);
+		writer.write(material.roughnessMetalnessTex);
+		writer.write(material.normalTex);
+		writer.write(material.albedoFactor);
+		writer.write(material.emissiveFactor);
+		writer.write(material.alphaMode);
+		writer.write(material.alphaCutoff);
+		writer.write(material.doubleSided);
+		writer.write(material.metallicFactor);
+		writer.write(material.roughnessFactor);
+	}
+	writer.write(static_cast<uint32_t>(asset.primitives.size()));
+	for (const auto& primitive : asset.primitives) {
+		write_mesh(writer, primitive.mesh);
+		writer.write(primitive.material);
+		writer.write(static_cast<uint32_t>(primitive.lods.size()));
+		for (const auto& lod : primitive.lods)
+			write_mesh(writer, lod);
+		writer.write(primitive.lodErrors);
+	}
+	writer.write(static_cast<uint32_t>(asset.meshes.size()));
+	for (const auto& mesh : asset.meshes) {
+		writer.write(mesh.name);
+		writer.write(mesh.primitives);
+	}
+	writer.write(static_cast<uint32_t>(asset.nodes.size()));
+	for (const auto& node : asset.nodes) {
+		writer.write(node.name);
+		writer.write(node.transform);
+		writer.write(node.mesh);
+		writer.write(node.light.has_value());
+		if (node.light)
+			writer.write(*node.light);
+		writer.write(node.children);
+	}
+	writer.write(static_cast<uint32_t>(asset.scenes.size()));
+	for (const auto& scene : asset.scenes) {
+		writer.write(scene.name);
+		writer.write(scene.nodes);
+	}
+	writer.write(asset.quantizationStatistics);
+}
+
+static bool read_asset(Utility::BinaryReader& reader, nyan::SceneAsset& asset)
+{
+	//Every element starts with at least one count, four bytes is a safe lower bound for all of them
+	constexpr size_t minElementSize = sizeof(uint32_t);
+	uint32_t count;
+	if (!reader.read(asset.name) || !reader.read_count(count, minElementSize))
+		return false;
+	asset.textures.resize(count);
+	for (auto& texture : asset.textures) {
+		std::string file;
+		if (!reader.read(texture.name) || !reader.read(file) || !reader.read(texture.width) || !reader.read(texture.height) ||
+			!reader.read(texture.components) || !reader.read(texture.bitsPerChannel) || !reader.read(texture.data))
+			return false;
+		texture.file = file;
+	}
+	if (!reader.read_count(count, minElementSize))
+		return false;
+	asset.materials.resize(count);
+	for (auto& material : asset.materials)
+		if (!reader.read(material.name) || !reader.read(material.albedoTex) || !reader.read(material.emissiveTex) ||
+			!reader.read(material.roughnessMetalnessTex) || !reader.read(material.normalTex) || !reader.read(material.albedoFactor) ||
+			!reader.read(material.emissiveFactor) || !reader.read(material.alphaMode) || !reader.read(material.alphaCutoff) ||
+			!reader.read(material.doubleSided) || !reader.read(material.metallicFactor) || !reader.read(material.roughnessFactor))
+			return false;
+	if (!reader.read_count(count, minElementSize))
+		return false;
+	asset.primitives.resize(count);
+	for (auto& primitive : asset.primitives) {
+		uint32_t lodCount;
+		if (!read_mesh(reader, primitive.mesh) || !reader.read(primitive.material) || !reader.read_count(lodCount, minElementSize))
+			return false;
+		primitive.lods.resize(lodCount);
+		for (auto& lod : primitive.lods)
+			if (!read_mesh(reader, lod))
+				return false;
+		if (!reader.read(primitive.lodErrors))
+			return false;
+	}
+	if (!reader.read_count(count, minElementSize))
+		return false;
+	asset.meshes.resize(count);
+	for (auto& mesh : asset.meshes)
+		if (!reader.read(mesh.name) || !reader.read(mesh.primitives))
+			return false;
+	if (!reader.read_count(count, minElementSize))
+		return false;
+	asset.nodes.resize(count);
+	for (auto& node : asset.nodes) {
+		bool hasLight;
+		if (!reader.read(node.name) || !reader.read(node.transform) || !reader.read(node.mesh) || !reader.read(hasLight))
+			return false;
+		if (hasLight) {
+			nyan::Pointlight light;
+			if (!reader.read(light))
+				return false;
+			node.light = light;
+		}
+		if (!reader.read(node.children))
+			return false;
+	}
+	if (!reader.read_count(count, minElementSize))
+		return false;
+	asset.scenes.resize(count);
+	for (auto& scene : asset.scenes)
+		if (!reader.read(scene.name) || !reader.read(scene.nodes))
+			return false;
+	return reader.read(asset.quantizationStatistics) && reader.done();
+}
+
+std::optional<nyan::SceneAsset> nyan::SceneAssetCache::load(const std::filesystem::path& directory, uint64_t sourceKey)
+{
+	const auto path = get_path(directory, sourceKey);
+	std::error_code ec;
+	if (!std::filesystem::exists(path, ec))
+		return std::nullopt;
+	try {
+		Utility::MappedFile file(path);
+		return deserialize(file.span(), sourceKey);
+	}
+	catch (const std::runtime_error&) {
+		return std::nullopt;
+	}
+}
+
+void nyan::SceneAssetCache::store(const std::filesystem::path& directory, uint64_t sourceKey, const SceneAsset& asset)
+{
+	const auto data = serialize(asset, sourceKey);
+	std::filesystem::create_directories(directory);
+	const auto path = get_path(directory, sourceKey);
+	auto temporary = path;
+	temporary += ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary);
+		if (!file.is_open())
+			throw std::runtime_error("Could not open file: \"" + temporary.string() + "\"");
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		if (!file)
+			throw std::runtime_error("Could not write file: \"" + temporary.string() + "\"");
+	}
+	std::filesystem::rename(temporary, path);
+}
+
+std::filesystem::path nyan::SceneAssetCache::get_path(const std::filesystem::path& directory, uint64_t sourceKey)
+{
+	return directory / std::format("{:016x}.scene", sourceKey);
+}
+
+std::vector<std::byte> nyan::SceneAssetCache::serialize(const SceneAsset& asset, uint64_t sourceKey)
+{
+	Utility::BinaryWriter body;
+	write_asset(body, asset);
+	const SceneAssetCacheHeader header{
+		.magic {magic},
+		.version {version},
+		.sourceKey {sourceKey},
+		.dataSize {body.get_data().size()},
+		.checksum {scene_cache_checksum(body.get_data())},
+	};
+	Utility::BinaryWriter file;
+	file.reserve(sizeof(header) + body.get_data().size());
+	file.write(header);
+	file.write_bytes(body.get_data());
+	return file.take_data();
+}
+
+std::optional<nyan::SceneAsset> nyan::SceneAssetCache::deserialize(std::span<const std::byte> data, uint64_t sourceKey)
+{
+	Utility::BinaryReader reader(data);
+	SceneAssetCacheHeader header;
+	if (!reader.read(header))
+		return std::nullopt;
+	const auto body = data.subspan(sizeof(header));
+	if (header.magic != magic || header.version != version || header.sourceKey != sourceKey ||
+		header.dataSize != body.size() || header.checksum != scene_cache_checksum(body))
+		return std::nullopt;
+	Utility::BinaryReader bodyReader(body);
+	SceneAsset asset;
+	if (!read_asset(bodyReader, asset))
+		return std::nullopt;
+	return asset;
+}
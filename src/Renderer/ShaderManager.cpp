@@ -1,27 +1,22 @@
 #include "Renderer/ShaderManager.h"
 #include "VulkanWrapper/Shader.h"
 #include "Utility/Exceptions.h"
+#include "Utility/JobSystem.h"
+#include "Utility/MappedFile.h"
+#include <chrono>
+#include <optional>
 
-static std::vector<uint32_t> read_binary_file(const std::filesystem::path& path)
+//Mappings are page aligned, the words can be used in place
+static std::span<const uint32_t> shader_manager_code(const Utility::MappedFile& file)
 {
-
-	std::vector<uint32_t> data;
-	std::ifstream in(path, std::ios::binary);
-	if (in.is_open()) {
-		auto size = std::filesystem::file_size(path);
-		data.resize(size / sizeof(uint32_t));
-		in.read(reinterpret_cast<char*>(data.data()), size);
-		in.close();
-	}
-	else {
-		Utility::log("Could not open: \"" + path.string() + '\"');
-	}
-
-	return data;
+	if (file.size() == 0 || file.size() % sizeof(uint32_t))
+		throw std::runtime_error("Invalid SPIR-V size");
+	return { reinterpret_cast<const uint32_t*>(file.data()), file.size() / sizeof(uint32_t) };
 }
 
-vulkan::ShaderManager::ShaderManager(LogicalDevice& device, const std::filesystem::path& shaderDirectory)
-	: r_device(device) 
+vulkan::ShaderManager::ShaderManager(LogicalDevice& device, const std::filesystem::path& shaderDirectory, const std::filesystem::path& reflectionCachePath)
+	: r_device(device),
+	m_reflectionCache(reflectionCachePath)
 {
 	load_shaders(shaderDirectory);
 }
@@ -41,21 +36,55 @@ void vulkan::ShaderManager::throw_size_error(uint32_t x, uint32_t y, uint32_t z,
 void vulkan::ShaderManager::load_shaders(const std::filesystem::path& shaderDirectory) 
 {
 	if (std::filesystem::exists(shaderDirectory)) {
+		const auto start = std::chrono::steady_clock::now();
 		auto& shaderStorage = r_device.get_shader_storage();
 		shaderStorage.clear();
+		std::vector<std::filesystem::path> paths;
 		for (const auto& entry : std::filesystem::directory_iterator{ shaderDirectory }) {
 			if (!entry.is_regular_file())
 				continue;
 			if (entry.path().extension().compare(".spv"))
 				continue;
-			auto shaderCode = read_binary_file(entry.path());
-			auto shaderId = shaderStorage.add_shader(shaderCode);
+			paths.push_back(entry.path());
+		}
+		//Mapping, hashing and reflecting is independent per shader, only the storage is filled on this thread
+		struct LoadedShader {
+			Utility::MappedFile file;
+			Utility::HashValue hash{ 0 };
+			std::optional<Utility::ShaderReflection> reflection;
+		};
+		std::vector<LoadedShader> shaders(paths.size());
+		Utility::JobSystem::get().parallel_for(paths.size(), [&](size_t i) {
+			auto& shader = shaders[i];
+			try {
+				shader.file = Utility::MappedFile(paths[i]);
+				const auto code = shader_manager_code(shader.file);
+				shader.hash = Utility::ShaderReflectionCache::compute_key(code);
+				shader.reflection = m_reflectionCache.get(code, shader.hash, &Shader::reflect);
+			}
+			catch (const std::exception& e) {
+				Utility::log_warning().format("ShaderManager: Couldn't load \"{}\": {}", paths[i].string(), e.what());
+			}
+		});
+		for (size_t i = 0; i < shaders.size(); i++) {
+			if (!shaders[i].reflection)
+				continue;
+			auto shaderId = shaderStorage.add_shader(shader_manager_code(shaders[i].file), shaders[i].hash, *shaders[i].reflection);
 			auto* shader = shaderStorage.get_shader(shaderId);
-			shader->set_debug_label(entry.path().stem().string().c_str());
-			m_shaderMapping[entry.path().stem().string()] = shaderId;
+			shader->set_debug_label(paths[i].stem().string().c_str());
+			m_shaderMapping[paths[i].stem().string()] = shaderId;
 			//auto shaderInstanceId = shaderStorage.add_instance(shaderId);
 			//m_shaderInstanceMapping[entry.path().stem().string()] = shaderInstanceId;
 		}
+		try {
+			m_reflectionCache.save();
+		}
+		catch (const std::exception& e) {
+			Utility::log_warning().format("ShaderManager: Couldn't save \"{}\": {}", m_reflectionCache.get_path().string(), e.what());
+		}
+		const auto statistics = m_reflectionCache.get_statistics();
+		Utility::log().format("ShaderManager: Loaded {} shaders in {:.2f} ms, {} reflected, {} from the reflection cache", m_shaderMapping.size(),
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), statistics.misses, statistics.hits);
 	}
 	else {
 		Utility::log("Invalid shader directory given");
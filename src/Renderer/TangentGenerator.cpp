@@ -0,0 +1,238 @@
+#include "Renderer/TangentGenerator.h"
+#include "Utility/JobSystem.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <cassert>
+
+//Triangles and vertices are processed in batches, single elements are far too small for a job
+static constexpr size_t tangentBatchSize{ 4096 };
+static constexpr uint32_t tangentInvalidVertex{ ~0u };
+
+struct TangentTriangle {
+	//Unit length uv space s direction, zero without uv area
+	Math::vec3 tangent{ 0.f };
+	//1 orientation preserving, -1 mirrored, 0 without uv area
+	float sign{ 0.f };
+};
+
+using TangentWeldKey = std::array<std::byte, sizeof(Math::vec3) + sizeof(Math::hvec3) + sizeof(Math::hvec2)>;
+
+//Returns weld[v], the smallest vertex index with bitwise identical position, normal and uv
+static std::vector<uint32_t> tangent_weld_vertices(const nyan::Mesh& mesh)
+{
+	const auto vertexCount = mesh.positions.size();
+	std::vector<TangentWeldKey> keys(vertexCount);
+	Utility::JobSystem::get().parallel_for(vertexCount, [&](size_t v) {
+		auto& key = keys[v];
+		key.fill(std::byte{ 0 });
+		std::memcpy(key.data(), &mesh.positions[v], sizeof(Math::vec3));
+		if (!mesh.normals.empty())
+			std::memcpy(key.data() + sizeof(Math::vec3), &mesh.normals[v], sizeof(Math::hvec3));
+		if (!mesh.uvs0.empty())
+			std::memcpy(key.data() + sizeof(Math::vec3) + sizeof(Math::hvec3), &mesh.uvs0[v], sizeof(Math::hvec2));
+	}, tangentBatchSize);
+	std::vector<uint32_t> order(vertexCount);
+	std::iota(order.begin(), order.end(), 0u);
+	std::sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) {
+		if (keys[lhs] != keys[rhs])
+			return keys[lhs] < keys[rhs];
+		return lhs < rhs;
+	});
+	std::vector<uint32_t> weld(vertexCount);
+	for (size_t i{ 0 }; i < vertexCount; ++i)
+		weld[order[i]] = (i && keys[order[i]] == keys[order[i - 1]]) ? weld[order[i - 1]] : order[i];
+	return weld;
+}
+
+//Area weighted face normals for meshes without normals, indexed by welded vertex
+static std::vector<Math::vec3> tangent_face_normals(const nyan::Mesh& mesh, const std::vector<uint32_t>& weld)
+{
+	std::vector<Math::vec3> normals(mesh.positions.size(), Math::vec3{ 0.f });
+	for (size_t i{ 0 }; i + 2 < mesh.indices.size(); i += 3) {
+		const auto& p0 = mesh.positions[mesh.indices[i]];
+		const auto normal = (mesh.positions[mesh.indices[i + 1]] - p0).cross(mesh.positions[mesh.indices[i + 2]] - p0);
+		for (size_t j{ 0 }; j < 3; ++j)
+			normals[weld[mesh.indices[i + j]]] += normal;
+	}
+	for (auto& normal : normals)
+		if (normal.L2_square() > 0.f)
+			normal.normalize();
+	return normals;
+}
+
+//Corner angle between the edges projected onto the normal plane, the MikkTSpace weight
+static float tangent_corner_angle(const Math::vec3& normal, const Math::vec3& p0, const Math::vec3& p1, const Math::vec3& p2)
+{
+	auto e1 = p1 - p0;
+	auto e2 = p2 - p0;
+	e1 -= normal * normal.dot(e1);
+	e2 -= normal * normal.dot(e2);
+	const auto lengths = e1.L2_norm() * e2.L2_norm();
+	if (!(lengths > 0.f))
+		return 0.f;
+	return std::acos(std::clamp(e1.dot(e2) / lengths, -1.f, 1.f));
+}
+
+template<typename T>
+static void tangent_duplicate_stream(std::vector<T>& stream, size_t vertexCount, const std::vector<uint32_t>& sources)
+{
+	if (stream.size() != vertexCount)
+		return;
+	stream.reserve(vertexCount + sources.size());
+	for (auto source : sources)
+		stream.push_back(stream[source]);
+}
+
+nyan::TangentGenerator::Statistics nyan::TangentGenerator::generate(nyan::Mesh& mesh)
+{
+	Statistics statistics{};
+	const auto vertexCount = mesh.positions.size();
+	const auto triangleCount = mesh.indices.size() / 3;
+	assert(mesh.normals.empty() || mesh.normals.size() == vertexCount);
+	assert(mesh.uvs0.empty() || mesh.uvs0.size() == vertexCount);
+	auto& jobSystem = Utility::JobSystem::get();
+
+	const auto weld = tangent_weld_vertices(mesh);
+	std::vector<Math::vec3> faceNormals;
+	if (mesh.normals.empty())
+		faceNormals = tangent_face_normals(mesh, weld);
+	auto vertexNormal = [&](uint32_t vertex) {
+		return mesh.normals.empty() ? faceNormals[weld[vertex]] : Math::vec3{ mesh.normals[vertex] };
+	};
+
+	//Per triangle s directions, straight line code without cross triangle dependencies
+	std::vector<TangentTriangle> triangles(triangleCount);
+	if (!mesh.uvs0.empty()) {
+		jobSystem.parallel_for(triangleCount, [&](size_t t) {
+			const auto* triangle = &mesh.indices[t * 3];
+			const auto& p0 = mesh.positions[triangle[0]];
+			const auto e1 = mesh.positions[triangle[1]] - p0;
+			const auto e2 = mesh.positions[triangle[2]] - p0;
+			const auto u0 = static_cast<float>(mesh.uvs0[triangle[0]][0]);
+			const auto v0 = static_cast<float>(mesh.uvs0[triangle[0]][1]);
+			const auto du1 = static_cast<float>(mesh.uvs0[triangle[1]][0]) - u0;
+			const auto dv1 = static_cast<float>(mesh.uvs0[triangle[1]][1]) - v0;
+			const auto du2 = static_cast<float>(mesh.uvs0[triangle[2]][0]) - u0;
+			const auto dv2 = static_cast<float>(mesh.uvs0[triangle[2]][1]) - v0;
+			const auto signedArea = du1 * dv2 - du2 * dv1;
+			const auto s = e1 * dv2 - e2 * dv1;
+			const auto length = s.L2_norm();
+			if (std::abs(signedArea) > std::numeric_limits<float>::min() && length > 0.f) {
+				const auto sign = signedArea > 0.f ? 1.f : -1.f;
+				triangles[t] = TangentTriangle{
+					.tangent {s * (sign / length)},
+					.sign {sign},
+				};
+			}
+		}, tangentBatchSize);
+	}
+
+	//Corners grouped by welded vertex and orientation, group = 2 * weld[v] + mirrored
+	const auto groupCount = vertexCount * 2;
+	std::vector<uint32_t> groupOffsets(groupCount + 1, 0);
+	auto corner_group = [&](size_t corner) {
+		return static_cast<size_t>(weld[mesh.indices[corner]]) * 2 + (triangles[corner / 3].sign < 0.f);
+	};
+	for (size_t corner{ 0 }; corner < triangleCount * 3; ++corner)
+		if (triangles[corner / 3].sign != 0.f)
+			groupOffsets[corner_group(corner) + 1]++;
+	std::partial_sum(groupOffsets.begin(), groupOffsets.end(), groupOffsets.begin());
+	std::vector<uint32_t> groupCorners(groupOffsets.back());
+	{
+		std::vector<uint32_t> fill(groupOffsets.begin(), groupOffsets.end() - 1);
+		for (size_t corner{ 0 }; corner < triangleCount * 3; ++corner)
+			if (triangles[corner / 3].sign != 0.f)
+				groupCorners[fill[corner_group(corner)]++] = static_cast<uint32_t>(corner);
+			else if (corner % 3 == 0)
+				statistics.degenerateTriangles++;
+	}
+
+	//Angle weighted average of the projected triangle directions
+	std::vector<Math::vec3> groupTangents(groupCount, Math::vec3{ 0.f });
+	jobSystem.parallel_for(groupCount, [&](size_t group) {
+		if (groupOffsets[group] == groupOffsets[group + 1])
+			return;
+		const auto normal = vertexNormal(static_cast<uint32_t>(group / 2));
+		Math::vec3 sum{ 0.f };
+		for (auto i{ groupOffsets[group] }; i < groupOffsets[group + 1]; ++i) {
+			const auto corner = groupCorners[i];
+			const auto* triangle = &mesh.indices[corner - corner % 3];
+			const auto j = corner % 3;
+			auto tangent = triangles[corner / 3].tangent;
+			tangent -= normal * normal.dot(tangent);
+			const auto length = tangent.L2_norm();
+			if (!(length > 0.f))
+				continue;
+			const auto angle = tangent_corner_angle(normal, mesh.positions[triangle[j]], mesh.positions[triangle[(j + 1) % 3]], mesh.positions[triangle[(j + 2) % 3]]);
+			sum += tangent * (angle / length);
+		}
+		if (sum.L2_square() > 0.f)
+			groupTangents[group] = sum * (1.f / sum.L2_norm());
+	}, tangentBatchSize);
+
+	//A vertex used by triangles of both orientations needs two tangent frames, the mirrored corners get a copy
+	std::vector<float> vertexSigns(vertexCount, 0.f);
+	std::vector<uint32_t> splits(vertexCount, tangentInvalidVertex);
+	std::vector<uint32_t> splitSources;
+	for (size_t corner{ 0 }; corner < triangleCount * 3; ++corner) {
+		const auto sign = triangles[corner / 3].sign;
+		if (sign == 0.f)
+			continue;
+		const auto vertex = mesh.indices[corner];
+		if (vertexSigns[vertex] == 0.f) {
+			vertexSigns[vertex] = sign;
+		}
+		else if (vertexSigns[vertex] != sign) {
+			if (splits[vertex] == tangentInvalidVertex) {
+				splits[vertex] = static_cast<uint32_t>(vertexCount + splitSources.size());
+				splitSources.push_back(vertex);
+			}
+			mesh.indices[corner] = splits[vertex];
+		}
+	}
+	statistics.splitVertices = splitSources.size();
+	for (auto source : splitSources)
+		vertexSigns.push_back(-vertexSigns[source]);
+	tangent_duplicate_stream(mesh.positions, vertexCount, splitSources);
+	tangent_duplicate_stream(mesh.normals, vertexCount, splitSources);
+	tangent_duplicate_stream(mesh.uvs0, vertexCount, splitSources);
+	tangent_duplicate_stream(mesh.uvs1, vertexCount, splitSources);
+	tangent_duplicate_stream(mesh.uvs2, vertexCount, splitSources);
+	tangent_duplicate_stream(mesh.colors0, vertexCount, splitSources);
+
+	mesh.tangents.resize(vertexCount + splitSources.size());
+	jobSystem.parallel_for(mesh.tangents.size(), [&](size_t vertex) {
+		const auto source = vertex < vertexCount ? static_cast<uint32_t>(vertex) : splitSources[vertex - vertexCount];
+		const auto group = static_cast<size_t>(weld[source]) * 2;
+		auto sign = vertexSigns[vertex];
+		//Vertices only used by triangles without uv area take the frame of their welded vertex
+		if (sign == 0.f)
+			sign = groupOffsets[group] != groupOffsets[group + 1] || groupOffsets[group + 1] == groupOffsets[group + 2] ? 1.f : -1.f;
+		auto tangent = groupTangents[group + (sign < 0.f)];
+		if (tangent.L2_square() == 0.f)
+			tangent = orthogonal(vertexNormal(source));
+		mesh.tangents[vertex] = Math::hvec4{ Math::vec4{ tangent[0], tangent[1], tangent[2], sign } };
+	}, tangentBatchSize);
+	return statistics;
+}
+
+std::vector<nyan::TangentGenerator::Statistics> nyan::TangentGenerator::generate(std::span<nyan::Mesh> meshes)
+{
+	std::vector<Statistics> statistics(meshes.size());
+	Utility::JobSystem::get().parallel_for(meshes.size(), [&](size_t i) {
+		statistics[i] = generate(meshes[i]);
+	});
+	return statistics;
+}
+
+Math::vec3 nyan::TangentGenerator::orthogonal(const Math::vec3& normal)
+{
+	//Duff et al. 2017 "Building an Orthonormal Basis, Revisited"
+	const auto sign = std::copysign(1.f, normal[2]);
+	const auto a = -1.f / (sign + normal[2]);
+	const auto b = normal[0] * normal[1] * a;
+	return Math::vec3{ 1.f + sign * normal[0] * normal[0] * a, sign * b, -sign * normal[0] };
+}
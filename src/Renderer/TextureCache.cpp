@@ -0,0 +1,215 @@
+#include "Renderer/TextureCache.h"
+#include "Utility/MappedFile.h"
+#include "Utility/StreamHasher.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <format>
+#include <utility>
+#include <vector>
+
+//Bump whenever the cooker output changes, old entries then miss and get evicted over time
+static constexpr uint64_t textureCacheVersion{ 1 };
+static constexpr std::string_view textureCacheExtension{ ".dds" };
+static constexpr std::string_view textureCacheTemporaryExtension{ ".tmp" };
+
+nyan::TextureCache::TextureCache(const std::filesystem::path& directory, uint64_t maxSize) :
+	m_directory(directory),
+	m_maxSize(maxSize)
+{
+	std::filesystem::create_directories(m_directory);
+	for (const auto& file : std::filesystem::directory_iterator(m_directory)) {
+		if (!file.is_regular_file())
+			continue;
+		const auto& path = file.path();
+		//Leftovers of cooks that were interrupted
+		if (path.extension() == textureCacheTemporaryExtension) {
+			std::error_code ec;
+			std::filesystem::remove(path, ec);
+			continue;
+		}
+		if (path.extension() != textureCacheExtension)
+			continue;
+		const auto stem = path.stem().string();
+		uint64_t key;
+		if (auto [ptr, ec] = std::from_chars(stem.data(), stem.data() + stem.size(), key, 16); ec != std::errc() || ptr != stem.data() + stem.size())
+			continue;
+		const auto size = file.file_size();
+		m_entries.emplace(key, Entry{ .size {size}, .lastUse {file.last_write_time()} });
+		m_size += size;
+	}
+	trim_locked();
+}
+
+nyan::TextureCache::Lease::Lease(TextureCache& cache, uint64_t key, std::filesystem::path path) :
+	p_cache(&cache),
+	m_key(key),
+	m_path(std::move(path))
+{
+}
+
+nyan::TextureCache::Lease::~Lease()
+{
+	release();
+}
+
+nyan::TextureCache::Lease::Lease(Lease&& other) noexcept :
+	p_cache(std::exchange(other.p_cache, nullptr)),
+	m_key(other.m_key),
+	m_path(std::move(other.m_path))
+{
+}
+
+nyan::TextureCache::Lease& nyan::TextureCache::Lease::operator=(Lease&& other) noexcept
+{
+	if (this != &other) {
+		release();
+		p_cache = std::exchange(other.p_cache, nullptr);
+		m_key = other.m_key;
+		m_path = std::move(other.m_path);
+	}
+	return *this;
+}
+
+const std::filesystem::path& nyan::TextureCache::Lease::get_path() const noexcept
+{
+	return m_path;
+}
+
+void nyan::TextureCache::Lease::release()
+{
+	if (!p_cache)
+		return;
+	std::scoped_lock lock(p_cache->m_mutex);
+	if (auto it = p_cache->m_entries.find(m_key); it != p_cache->m_entries.end() && it->second.users) {
+		if (!--it->second.users) {
+			//Cooks that failed leave an entry without a file behind
+			if (!it->second.size)
+				p_cache->m_entries.erase(it);
+			//Trims skipped the entry while it was leased
+			p_cache->trim_locked();
+		}
+	}
+	p_cache = nullptr;
+}
+
+nyan::TextureCache::Lease nyan::TextureCache::acquire(const std::filesystem::path& source, const Utility::TextureCooker::Settings& settings)
+{
+	const auto key = [&]() {
+		Utility::MappedFile file(source);
+		return compute_key(file.span(), settings);
+	}();
+	const auto path = get_entry_path(key);
+	std::filesystem::path temporary;
+	//Leased while cooking as well, a trim triggered by another thread can't remove the file between rename and lookup
+	Lease lease;
+	{
+		std::scoped_lock lock(m_mutex);
+		auto [it, inserted] = m_entries.try_emplace(key, Entry{ .size {0}, .lastUse {std::filesystem::file_time_type::clock::now()} });
+		it->second.users++;
+		lease = Lease(*this, key, path);
+		if (!inserted) {
+			std::error_code ec;
+			it->second.lastUse = std::filesystem::file_time_type::clock::now();
+			std::filesystem::last_write_time(path, it->second.lastUse, ec);
+			if (!ec) {
+				m_statistics.hits++;
+				return lease;
+			}
+			//Removed behind our back or still being cooked by another thread, cook it again
+			m_size -= it->second.size;
+			it->second.size = 0;
+		}
+		m_statistics.misses++;
+		//Unique per miss so concurrent cooks of the same source don't write into the same file
+		temporary = m_directory / std::format("{:016x}.{}{}", key, m_statistics.misses, textureCacheTemporaryExtension);
+	}
+	//Cooking takes long, other textures can be looked up meanwhile
+	try {
+		Utility::TextureCooker::cook(source, temporary, settings);
+		std::filesystem::rename(temporary, path);
+	}
+	catch (...) {
+		std::error_code ec;
+		std::filesystem::remove(temporary, ec);
+		throw;
+	}
+	//File times may be coarser than the clock, keep the exact time in memory so entries cooked in a row stay ordered
+	const auto lastUse = std::filesystem::file_time_type::clock::now();
+	std::error_code ec;
+	std::filesystem::last_write_time(path, lastUse, ec);
+	const auto size = std::filesystem::file_size(path);
+	std::scoped_lock lock(m_mutex);
+	auto& entry = m_entries.at(key);
+	m_size -= entry.size;
+	m_size += size;
+	entry.size = size;
+	entry.lastUse = lastUse;
+	//Leased entries aren't evicted, a single entry above the budget stays
+	trim_locked();
+	return lease;
+}
+
+void nyan::TextureCache::trim()
+{
+	std::scoped_lock lock(m_mutex);
+	trim_locked();
+}
+
+uint64_t nyan::TextureCache::get_size() const
+{
+	std::scoped_lock lock(m_mutex);
+	return m_size;
+}
+
+nyan::TextureCache::Statistics nyan::TextureCache::get_statistics() const
+{
+	std::scoped_lock lock(m_mutex);
+	return m_statistics;
+}
+
+uint64_t nyan::TextureCache::compute_key(std::span<const std::byte> source, const Utility::TextureCooker::Settings& settings)
+{
+	//Field by field, the settings struct has padding
+	Utility::StreamHasher hasher(textureCacheVersion);
+	const std::array<uint32_t, 6> packedSettings{
+		static_cast<uint32_t>(settings.usage),
+		settings.sRGB,
+		settings.highQuality,
+		settings.generateMips,
+		static_cast<uint32_t>(settings.mipFilter),
+		settings.preserveAlphaCoverage,
+	};
+	hasher.update(packedSettings.data(), sizeof(packedSettings));
+	hasher.update(&settings.alphaCutoff, sizeof(settings.alphaCutoff));
+	hasher.update(source.data(), source.size());
+	return hasher.finish();
+}
+
+std::filesystem::path nyan::TextureCache::get_entry_path(uint64_t key) const
+{
+	return m_directory / std::format("{:016x}{}", key, textureCacheExtension);
+}
+
+void nyan::TextureCache::trim_locked()
+{
+	if (m_size <= m_maxSize || m_entries.size() <= 1)
+		return;
+	std::vector<std::pair<std::filesystem::file_time_type, uint64_t>> order;
+	order.reserve(m_entries.size());
+	for (const auto& [key, entry] : m_entries)
+		order.emplace_back(entry.lastUse, key);
+	std::sort(order.begin(), order.end());
+	for (size_t i{ 0 }; i + 1 < order.size() && m_size > m_maxSize; i++) {
+		const auto key = order[i].second;
+		auto it = m_entries.find(key);
+		//Still in use by a caller, a later trim gets it
+		if (it->second.users)
+			continue;
+		std::error_code ec;
+		std::filesystem::remove(get_entry_path(key), ec);
+		m_size -= it->second.size;
+		m_entries.erase(it);
+		m_statistics.evictions++;
+	}
+}
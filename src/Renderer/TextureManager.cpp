@@ -1,32 +1,66 @@
 #include "Renderer/TextureManager.h"
 #include "VulkanWrapper/Image.h"
 #include "Utility/ImageReader.h"
+#include "Utility/MipGenerator.h"
 #include "Utility/Exceptions.h"
 #include "Renderer/ShaderInterface.h"
 
+//Non DDS images only come with level 0, the CPU chain makes their mips available for streaming
+//Levels [startMip, mipLevels) are packed behind each other like in a DDS file
+//The cook settings pick the color space and the mip filter like for cooked textures
+static std::pair<std::vector<uint8_t>, vulkan::InitialImageData> texture_mip_chain(const std::filesystem::path& path, uint32_t startMip, const Utility::TextureCooker::Settings& settings, Utility::TextureInfo& texInfo)
+{
+	auto [data, info] = Utility::ImageReader::read_image_file(path);
+	texInfo = info;
+	const auto mipSettings = Utility::TextureCooker::get_mip_settings(settings);
+	texInfo.format = mipSettings.sRGB ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+	const std::span<const uint8_t> texels{ static_cast<const uint8_t*>(data.data), static_cast<size_t>(info.width) * info.height * 4 };
+	auto levels = Utility::MipGenerator::generate(texels, info.width, info.height, mipSettings);
+	Utility::ImageReader::free_image(data.data);
+
+	vulkan::InitialImageData imageData{};
+	texInfo.mipLevels = static_cast<uint32_t>(Math::min(levels.size(), imageData.mipOffsets.size()));
+	startMip = Math::min(startMip, texInfo.mipLevels - 1);
+	size_t size{ 0 };
+	for (uint32_t level = startMip; level < texInfo.mipLevels; level++)
+		size += levels[level].texels.size();
+	std::vector<uint8_t> packed;
+	packed.reserve(size);
+	for (uint32_t level = startMip; level < texInfo.mipLevels; level++) {
+		imageData.mipOffsets[level - startMip] = static_cast<uint32_t>(packed.size());
+		packed.insert(packed.end(), levels[level].texels.begin(), levels[level].texels.end());
+	}
+	imageData.mipCounts = texInfo.mipLevels - startMip;
+	return { std::move(packed), imageData };
+}
+
 nyan::TextureManager::TextureManager(vulkan::LogicalDevice& device, bool streaming, const std::filesystem::path& folder) :
 	r_device(device),
 	m_directory(folder),
 	m_streaming(streaming)
 {
-	std::vector< std::filesystem::path> defaultImages{ "white.png" ,"black.png", "normal.png" };
-	for (const auto& img : defaultImages) {
-		create_image(img);
+	std::vector<std::pair<std::filesystem::path, Utility::TextureCooker::Settings>> defaultImages{
+		{"white.png", {}},
+		{"black.png", {}},
+		{"normal.png", {.usage {Utility::TextureUsage::Normal}, .sRGB {false}}},
+	};
+	for (const auto& [img, settings] : defaultImages) {
+		create_image(img, 0, settings);
 	}
 }
 
-::vulkan::Image* nyan::TextureManager::request_texture(const std::string& name)
+::vulkan::Image* nyan::TextureManager::request_texture(const std::string& name, const Utility::TextureCooker::Settings& settings)
 {
 	std::filesystem::path path{ name };
-	return request_texture(path);
+	return request_texture(path, settings);
 }
-vulkan::Image* nyan::TextureManager::request_texture(const std::filesystem::path& path)
+vulkan::Image* nyan::TextureManager::request_texture(const std::filesystem::path& path, const Utility::TextureCooker::Settings& settings)
 {
 	if (const auto& res = m_textureIndex.find(path.filename().string()); res != m_textureIndex.end()) {
 		assert(m_usedTextures.find(res->second) != m_usedTextures.end());
 		return m_usedTextures.find(res->second)->second.handle;
 	}
-	return create_image(path, m_minimumMipLevel);
+	return create_image(path, m_minimumMipLevel, settings);
 }
 vulkan::Image* nyan::TextureManager::request_texture(const TextureInfo& info, const std::vector<unsigned char>& data)
 {
@@ -70,6 +104,8 @@ void nyan::TextureManager::change_mip(const std::string& name, uint32_t targetMi
 		targetMip = m_minimumMipLevel;
 	assert(m_usedTextures.find(res->second) != m_usedTextures.end());
 	auto& pair = m_usedTextures.find(res->second)->second;
+	if (pair.pending || pair.source.empty())
+		return;
 	vulkan::Image& image = *pair.handle;
 	if (image.is_being_resized())
 		return;
@@ -77,9 +113,22 @@ void nyan::TextureManager::change_mip(const std::string& name, uint32_t targetMi
 		if (image.get_available_mip() == targetMip)
 			return;
 		else if (targetMip < image.get_available_mip()) {
-			auto imgData = Utility::DDSReader::readDDSFileInMemory(name);
-			std::vector<vulkan::InitialImageData> initalImageData = Utility::DDSReader::parseImage(pair.info,imgData);
-			r_device.upsize_sparse_image(image, initalImageData.data(), targetMip);
+			const bool dds = !pair.source.extension().compare(".dds");
+			if (dds || m_textureCache) {
+				//The lease keeps the cooked file from being evicted until it is mapped
+				TextureCache::Lease cooked;
+				if (!dds)
+					cooked = m_textureCache->acquire(pair.source, pair.settings);
+				Utility::DDSView view(dds ? pair.source : cooked.get_path());
+				std::vector<vulkan::InitialImageData> initalImageData = view.get_image_data();
+				r_device.upsize_sparse_image(image, initalImageData.data(), targetMip);
+			}
+			else {
+				Utility::TextureInfo texInfo;
+				auto [texels, imageData] = texture_mip_chain(pair.source, 0, pair.settings, texInfo);
+				imageData.data = texels.data();
+				r_device.upsize_sparse_image(image, &imageData, targetMip);
+			}
 		}
 		else if (targetMip <= image.get_info().mipLevels) {
 			r_device.downsize_sparse_image(image, targetMip);
@@ -88,12 +137,87 @@ void nyan::TextureManager::change_mip(const std::string& name, uint32_t targetMi
 	else {
 		if ((pair.info.mipLevels - targetMip) == image.get_info().mipLevels)
 			return;
-		auto newImage = create_image(name, targetMip);
+		auto newImage = create_image(pair.source, targetMip, pair.settings);
 		image = std::move(*newImage);
 	}
 
 }
 
+void nyan::TextureManager::stream_texture(AssetStreamer& streamer, const std::filesystem::path& file, const std::string& placeholder, const Utility::TextureCooker::Settings& settings, const Math::vec3& position, float priorityBias)
+{
+	std::filesystem::path path = file;
+	if (path.is_relative())
+		path = m_directory / path;
+	const auto name = path.filename().string();
+	if (m_textureIndex.contains(name))
+		return;
+	auto placeholderTexture = m_usedTextures.at(m_textureIndex.at(placeholder));
+	auto idx = r_device.get_bindless_set().set_sampled_image(VkDescriptorImageInfo{ .imageView = *placeholderTexture.handle->get_view(), .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+	placeholderTexture.pending = true;
+	placeholderTexture.source = path;
+	placeholderTexture.settings = settings;
+	m_usedTextures.emplace(idx, std::move(placeholderTexture));
+	m_textureIndex.emplace(name, idx);
+	static_cast<void>(streamer.request(AssetStreamer::Request{
+		.path {path},
+		.decoder {[cache = m_textureCache.get(), settings](const std::filesystem::path& path, std::span<const std::byte> data) -> std::unique_ptr<AssetPayload> {
+			if (!cache && path.extension().compare(".dds"))
+				return StreamedTexture::decode(path, data);
+			//Created from the file on upload, cooking is the expensive part and happens here on the job system
+			auto texture = std::make_unique<StreamedTexture>();
+			texture->texture.name = path.filename().string();
+			if (!path.extension().compare(".dds")) {
+				texture->texture.file = path;
+				texture->fileSize = data.size();
+			}
+			else {
+				texture->cooked = cache->acquire(path, settings);
+				texture->texture.file = texture->cooked.get_path();
+				texture->fileSize = std::filesystem::file_size(texture->texture.file);
+			}
+			return texture;
+		}},
+		.position {position},
+		.priorityBias {priorityBias},
+	}));
+}
+
+void nyan::TextureManager::upload_streamed(const StreamedTexture& streamed)
+{
+	const auto& texture = streamed.texture;
+	//The slot reserved by stream_texture knows the source and the settings
+	std::filesystem::path source = texture.file;
+	Utility::TextureCooker::Settings settings{};
+	if (auto res = m_textureIndex.find(texture.name); res != m_textureIndex.end()) {
+		const auto& reserved = m_usedTextures.at(res->second);
+		if (!reserved.pending)
+			return;
+		source = reserved.source;
+		settings = reserved.settings;
+	}
+	if (!texture.is_embedded()) {
+		create_dds_image(texture.file, texture.name, m_minimumMipLevel, source, settings);
+		return;
+	}
+	create_image(TextureInfo{
+		.name {texture.name},
+		.width {texture.width},
+		.height {texture.height},
+		.components {texture.components},
+		.bitsPerChannel {texture.bitsPerChannel},
+		.sRGB {Utility::TextureCooker::get_mip_settings(settings).sRGB},
+		}, texture.data);
+	//Decoded without a cache, mip changes read the source again
+	auto& added = m_usedTextures.at(m_textureIndex.at(texture.name));
+	added.source = source;
+	added.settings = settings;
+}
+
+void nyan::TextureManager::enable_texture_cache(const std::filesystem::path& directory, uint64_t maxSize)
+{
+	m_textureCache = std::make_unique<TextureCache>(directory, maxSize);
+}
+
 vulkan::ImageHandle nyan::TextureManager::create_image(const TextureInfo& info, const std::vector<unsigned char>& data)
 {
 	VkFormat format {VK_FORMAT_UNDEFINED};
@@ -207,43 +331,39 @@ vulkan::ImageHandle nyan::TextureManager::create_image(const TextureInfo& info,
 	if (m_useSparse) {
 		imageInfo.flags |= (VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT);
 		auto image = r_device.create_sparse_image(imageInfo, &imageData);
-
 		r_device.wait_idle();
-		auto idx = r_device.get_bindless_set().set_sampled_image(VkDescriptorImageInfo{ .imageView = *image->get_view(), .imageLayout = imageInfo.layout });
-		m_usedTextures.emplace(idx, ::nyan::TextureManager::Texture{ image, texInfo });
-		m_textureIndex.emplace(info.name, idx);
+		add_texture(info.name, image, texInfo);
 		return image;
 	}
 	else {
 		auto image = r_device.create_image(imageInfo, &imageData);
-
 		r_device.wait_idle();
-
-		auto idx = r_device.get_bindless_set().set_sampled_image(VkDescriptorImageInfo{ .imageView = *image->get_view(), .imageLayout = imageInfo.layout });
-		m_usedTextures.emplace(idx, ::nyan::TextureManager::Texture{ image, texInfo });
-		m_textureIndex.emplace(info.name, idx);
-
+		add_texture(info.name, image, texInfo);
 		return image;
 	}
 }
 
-vulkan::ImageHandle nyan::TextureManager::create_image(const std::filesystem::path& file, uint32_t mipLevel)
+vulkan::ImageHandle nyan::TextureManager::create_image(const std::filesystem::path& file, uint32_t mipLevel, const Utility::TextureCooker::Settings& settings)
 {
 	std::filesystem::path path = file;
 	if (path.is_relative())
 		path = m_directory / path;
 	if (!file.extension().compare(".dds"))
-		return create_dds_image(path, mipLevel);
+		return create_dds_image(path, path.filename().string(), mipLevel, path, settings);
+	if (m_textureCache)
+		return create_dds_image(m_textureCache->acquire(path, settings).get_path(), path.filename().string(), mipLevel, path, settings);
 	
-	auto [data, texInfo] = Utility::ImageReader::read_image_file(path);
-
+	Utility::TextureInfo texInfo;
+	auto [texels, data] = texture_mip_chain(path, mipLevel, settings, texInfo);
+	data.data = texels.data();
+	mipLevel = Math::min(mipLevel, texInfo.mipLevels - 1);
 
 	vulkan::ImageInfo info{
 		.format = texInfo.format,
 		.width = Math::max(1u, texInfo.width >> mipLevel),
 		.height = Math::max(1u, texInfo.height >> mipLevel),
 		.depth = texInfo.depth,
-		.mipLevels = texInfo.mipLevels - Math::min(mipLevel, texInfo.mipLevels -1),
+		.mipLevels = texInfo.mipLevels - mipLevel,
 		.arrayLayers = texInfo.arrayLayers,
 		.usage = VK_IMAGE_USAGE_SAMPLED_BIT,
 		.type = texInfo.type,
@@ -253,36 +373,26 @@ vulkan::ImageHandle nyan::TextureManager::create_image(const std::filesystem::pa
 	};
 	//info.createFlags.set(vulkan::ImageInfo::Flags::ConcurrentAsyncCompute);
 	//info.createFlags.set(vulkan::ImageInfo::Flags::ConcurrentGraphics);
-	info.createFlags.set(vulkan::ImageInfo::Flags::GenerateMips);
 	if (m_useSparse) {
 		info.flags |= (VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT);
 		auto image = r_device.create_sparse_image(info, &data);
-
 		r_device.wait_idle();
-		auto idx = r_device.get_bindless_set().set_sampled_image(VkDescriptorImageInfo{ .imageView = *image->get_view(), .imageLayout = info.layout });
-		m_usedTextures.emplace(idx, ::nyan::TextureManager::Texture{ image, texInfo });
-		m_textureIndex.emplace(path.filename().string(), idx);
-		Utility::ImageReader::free_image(data.data);
+		add_texture(path.filename().string(), image, texInfo, path, settings);
 		return image;
 	}
 	else {
 		auto image = r_device.create_image(info, &data);
-
 		r_device.wait_idle();
-
-		auto idx = r_device.get_bindless_set().set_sampled_image(VkDescriptorImageInfo{ .imageView = *image->get_view(), .imageLayout = info.layout });
-		m_usedTextures.emplace(idx, ::nyan::TextureManager::Texture{ image, texInfo });
-		m_textureIndex.emplace(path.filename().string(), idx);
-		Utility::ImageReader::free_image(data.data);
-			
+		add_texture(path.filename().string(), image, texInfo, path, settings);
 		return image;
 	}
 }
-vulkan::ImageHandle nyan::TextureManager::create_dds_image(const std::filesystem::path& file, uint32_t mipLevel)
+vulkan::ImageHandle nyan::TextureManager::create_dds_image(const std::filesystem::path& file, const std::string& name, uint32_t mipLevel, const std::filesystem::path& source, const Utility::TextureCooker::Settings& settings)
 {
-	auto texInfo = Utility::DDSReader::readDDSFileHeader(file);
-	auto imgData = Utility::DDSReader::readDDSFileInMemory(file);
-	std::vector<vulkan::InitialImageData> initalImageData = Utility::DDSReader::parseImage(texInfo, imgData, mipLevel);
+	//The staging copy reads straight from the mapping, the view has to stay alive until the image is created
+	Utility::DDSView view(file);
+	const auto& texInfo = view.get_info();
+	std::vector<vulkan::InitialImageData> initalImageData = view.get_image_data(mipLevel);
 
 	vulkan::ImageInfo info{
 		.format = texInfo.format,
@@ -302,17 +412,30 @@ vulkan::ImageHandle nyan::TextureManager::create_dds_image(const std::filesystem
 		info.flags |= (VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT);
 		auto image = r_device.create_sparse_image(info, initalImageData.data());
 		r_device.wait_idle();
-		auto idx = r_device.get_bindless_set().set_sampled_image(VkDescriptorImageInfo{ .imageView = *image->get_view(), .imageLayout = info.layout });
-		m_usedTextures.emplace(idx, ::nyan::TextureManager::Texture{ image, texInfo });
-		m_textureIndex.emplace(file.filename().string(), idx);
+		add_texture(name, image, texInfo, source, settings);
 		return image;
 	}
 	else {
 		auto image = r_device.create_image(info, initalImageData.data());
 		r_device.wait_idle();
-		auto idx = r_device.get_bindless_set().set_sampled_image(VkDescriptorImageInfo{ .imageView = *image->get_view(), .imageLayout = info.layout });
-		m_usedTextures.emplace(idx, ::nyan::TextureManager::Texture{ image, texInfo });
-		m_textureIndex.emplace(file.filename().string(), idx);
+		add_texture(name, image, texInfo, source, settings);
 		return image;
 	}
-}
\ No newline at end of file
+}
+
+void nyan::TextureManager::add_texture(const std::string& name, const vulkan::ImageHandle& image, const Utility::TextureInfo& info, const std::filesystem::path& source, const Utility::TextureCooker::Settings& settings)
+{
+	auto handle = image;
+	const VkDescriptorImageInfo descriptor{ .imageView = *handle->get_view(), .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	if (auto res = m_textureIndex.find(name); res != m_textureIndex.end()) {
+		auto& texture = m_usedTextures.at(res->second);
+		if (texture.pending) {
+			r_device.get_bindless_set().set_sampled_image(res->second, descriptor);
+			texture = Texture{ .handle {handle}, .info {info}, .source {source}, .settings {settings} };
+			return;
+		}
+	}
+	auto idx = r_device.get_bindless_set().set_sampled_image(descriptor);
+	m_usedTextures.emplace(idx, Texture{ .handle {handle}, .info {info}, .source {source}, .settings {settings} });
+	m_textureIndex.emplace(name, idx);
+}
@@ -0,0 +1,93 @@
+#include "Renderer/TransientMemoryPacker.h"
+#include <algorithm>
+#include <cassert>
+
+static uint64_t transient_align(uint64_t offset, uint64_t alignment)
+{
+	assert(alignment);
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+static bool transient_lifetimes_overlap(const nyan::RenderGraphPlan::Lifetime& lhs, const nyan::RenderGraphPlan::Lifetime& rhs)
+{
+	return lhs.first <= rhs.last && rhs.first <= lhs.last;
+}
+
+nyan::TransientMemoryPacker::Packing nyan::TransientMemoryPacker::pack(std::span<const Resource> resources)
+{
+	Packing packing;
+	packing.placements.resize(resources.size());
+	packing.aliases.resize(resources.size());
+
+	std::vector<uint32_t> order;
+	order.reserve(resources.size());
+	for (uint32_t i{ 0 }; i < resources.size(); i++) {
+		if (!resources[i].lifetime.used() || !resources[i].size)
+			continue;
+		order.push_back(i);
+		packing.unaliasedSize += resources[i].size;
+	}
+	std::sort(order.begin(), order.end(), [&resources](uint32_t lhs, uint32_t rhs) {
+		if (resources[lhs].size != resources[rhs].size)
+			return resources[lhs].size > resources[rhs].size;
+		if (resources[lhs].lifetime.first != resources[rhs].lifetime.first)
+			return resources[lhs].lifetime.first < resources[rhs].lifetime.first;
+		return lhs < rhs;
+	});
+
+	std::vector<std::vector<uint32_t>> heapResources;
+	struct Range {
+		uint64_t begin;
+		uint64_t end;
+	};
+	std::vector<Range> occupied;
+	for (auto resourceIndex : order) {
+		const auto& resource = resources[resourceIndex];
+		auto heap = static_cast<uint32_t>(std::find_if(packing.heaps.begin(), packing.heaps.end(),
+			[&resource](const Heap& candidate) { return candidate.memoryTypeBits == resource.memoryTypeBits; }) - packing.heaps.begin());
+		if (heap == packing.heaps.size()) {
+			packing.heaps.push_back(Heap{ .memoryTypeBits {resource.memoryTypeBits} });
+			heapResources.emplace_back();
+		}
+		//Memory of resources alive at the same time can't be reused
+		occupied.clear();
+		for (auto placedIndex : heapResources[heap]) {
+			if (transient_lifetimes_overlap(resource.lifetime, resources[placedIndex].lifetime)) {
+				const auto begin = packing.placements[placedIndex].offset;
+				occupied.push_back({ begin, begin + resources[placedIndex].size });
+			}
+		}
+		std::sort(occupied.begin(), occupied.end(), [](const Range& lhs, const Range& rhs) { return lhs.begin < rhs.begin; });
+		uint64_t offset{ 0 };
+		for (const auto& range : occupied) {
+			if (transient_align(offset, resource.alignment) + resource.size <= range.begin)
+				break;
+			offset = std::max(offset, range.end);
+		}
+		offset = transient_align(offset, resource.alignment);
+		packing.placements[resourceIndex] = Placement{ .heap {heap}, .offset {offset}, .size {resource.size} };
+		auto& heapInfo = packing.heaps[heap];
+		heapInfo.size = std::max(heapInfo.size, offset + resource.size);
+		heapInfo.alignment = std::max(heapInfo.alignment, resource.alignment);
+		heapResources[heap].push_back(resourceIndex);
+	}
+
+	for (const auto& placedResources : heapResources) {
+		for (size_t i{ 0 }; i < placedResources.size(); i++) {
+			const auto lhs = placedResources[i];
+			const auto lhsBegin = packing.placements[lhs].offset;
+			for (size_t j{ i + 1 }; j < placedResources.size(); j++) {
+				const auto rhs = placedResources[j];
+				const auto rhsBegin = packing.placements[rhs].offset;
+				if (lhsBegin < rhsBegin + resources[rhs].size && rhsBegin < lhsBegin + resources[lhs].size) {
+					assert(!transient_lifetimes_overlap(resources[lhs].lifetime, resources[rhs].lifetime));
+					packing.aliases[lhs].push_back(rhs);
+					packing.aliases[rhs].push_back(lhs);
+				}
+			}
+		}
+	}
+	for (auto& aliases : packing.aliases)
+		std::sort(aliases.begin(), aliases.end());
+	return packing;
+}
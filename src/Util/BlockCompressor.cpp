@@ -0,0 +1,768 @@
+#include "Utility/BlockCompressor.h"
+#include "Utility/JobSystem.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define BC_SSE
+#include <emmintrin.h>
+#endif
+
+//Texels of one block as structure of arrays, four texels of a channel fill one SSE register
+struct BcTexels {
+	alignas(16) std::array<std::array<float, 16>, 4> channels;
+};
+using BcEndpoint = std::array<float, 4>;
+using BcSteps = std::array<int32_t, 16>;
+
+//Interpolation weights of the 4 bit indices of BC6H and BC7
+static constexpr std::array<int32_t, 16> bcWeights4{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+//Nearest 4 bit index for a position on the endpoint line in 64ths
+static constexpr std::array<uint8_t, 65> bcWeightIndex = []() {
+	std::array<uint8_t, 65> ret{};
+	for (int32_t t{ 0 }; t <= 64; t++)
+		for (uint8_t i{ 1 }; i < bcWeights4.size(); i++)
+			if ((bcWeights4[i] - t) * (bcWeights4[i] - t) < (bcWeights4[ret[t]] - t) * (bcWeights4[ret[t]] - t))
+				ret[t] = i;
+	return ret;
+}();
+//BC1 palette index of the steps 0 to 3 along color0 -> color1
+static constexpr std::array<uint32_t, 4> bc1Index{ 0, 2, 3, 1 };
+static constexpr std::array<int32_t, 4> bc1Step{ 0, 3, 1, 2 };
+//Least squares refinement rounds, most blocks converge after the first
+static constexpr uint32_t bcRefineIterations{ 3 };
+
+//Little endian bit stream over one 128 bit block, fields never exceed 32 bits
+struct BcBitStream {
+	std::array<uint64_t, 2> words{};
+	uint32_t position{ 0 };
+	void write(uint32_t value, uint32_t count) {
+		const uint64_t masked = value & ((1ull << count) - 1);
+		const auto word = position >> 6;
+		const auto shift = position & 63;
+		words[word] |= masked << shift;
+		if (shift + count > 64)
+			words[word + 1] |= masked >> (64 - shift);
+		position += count;
+	}
+	uint32_t read(uint32_t count) {
+		const auto word = position >> 6;
+		const auto shift = position & 63;
+		uint64_t value = words[word] >> shift;
+		if (shift + count > 64)
+			value |= words[word + 1] << (64 - shift);
+		position += count;
+		return static_cast<uint32_t>(value & ((1ull << count) - 1));
+	}
+};
+
+static BcTexels bc_load(const Utility::BlockCompressor::Block& block)
+{
+	BcTexels texels;
+	for (size_t i{ 0 }; i < 16; i++)
+		for (size_t c{ 0 }; c < 4; c++)
+			texels.channels[c][i] = block[i * 4 + c];
+	return texels;
+}
+
+//Line through the mean along the principal axis of the texels, power iteration on the covariance matrix
+//The endpoints are the extreme projections onto that line
+static std::pair<BcEndpoint, BcEndpoint> bc_fit_axis(const BcTexels& texels, uint32_t channels)
+{
+	BcEndpoint mean{};
+	for (uint32_t c{ 0 }; c < channels; c++) {
+		for (auto value : texels.channels[c])
+			mean[c] += value;
+		mean[c] *= 1.f / 16.f;
+	}
+	std::array<BcEndpoint, 4> covariance{};
+	for (size_t i{ 0 }; i < 16; i++)
+		for (uint32_t a{ 0 }; a < channels; a++)
+			for (uint32_t b{ a }; b < channels; b++)
+				covariance[a][b] += (texels.channels[a][i] - mean[a]) * (texels.channels[b][i] - mean[b]);
+	uint32_t largest{ 0 };
+	for (uint32_t a{ 0 }; a < channels; a++) {
+		for (uint32_t b{ 0 }; b < a; b++)
+			covariance[a][b] = covariance[b][a];
+		if (covariance[a][a] > covariance[largest][largest])
+			largest = a;
+	}
+	//The row of the channel with the largest variance is never orthogonal to the principal axis
+	auto axis = covariance[largest];
+	for (uint32_t iteration{ 0 }; iteration < 8; iteration++) {
+		BcEndpoint next{};
+		float scale{ 0 };
+		for (uint32_t a{ 0 }; a < channels; a++) {
+			for (uint32_t b{ 0 }; b < channels; b++)
+				next[a] += covariance[a][b] * axis[b];
+			scale = std::max(scale, std::abs(next[a]));
+		}
+		if (scale == 0.f)
+			break;
+		for (uint32_t a{ 0 }; a < channels; a++)
+			axis[a] = next[a] / scale;
+	}
+	float length{ 0 };
+	for (uint32_t c{ 0 }; c < channels; c++)
+		length += axis[c] * axis[c];
+	if (length < 1e-12f)
+		return { mean, mean };
+	float minT{ 0 };
+	float maxT{ 0 };
+	for (size_t i{ 0 }; i < 16; i++) {
+		float t{ 0 };
+		for (uint32_t c{ 0 }; c < channels; c++)
+			t += (texels.channels[c][i] - mean[c]) * axis[c];
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+	BcEndpoint low{};
+	BcEndpoint high{};
+	for (uint32_t c{ 0 }; c < channels; c++) {
+		low[c] = mean[c] + axis[c] * (minT / length);
+		high[c] = mean[c] + axis[c] * (maxT / length);
+	}
+	return { low, high };
+}
+
+//Nearest of scale + 1 evenly spaced positions on the line start -> end for every texel
+static void bc_project(const BcTexels& texels, uint32_t firstChannel, uint32_t channels, const BcEndpoint& start, const BcEndpoint& end, float scale, BcSteps& steps)
+{
+	BcEndpoint direction{};
+	float length{ 0 };
+	float offset{ 0 };
+	for (uint32_t c{ 0 }; c < channels; c++) {
+		direction[c] = end[c] - start[c];
+		length += direction[c] * direction[c];
+		offset -= start[c] * direction[c];
+	}
+	if (length < 1e-8f) {
+		steps.fill(0);
+		return;
+	}
+	const float factor = scale / length;
+#ifdef BC_SSE
+	const auto zero = _mm_setzero_ps();
+	const auto maximum = _mm_set1_ps(scale);
+	const auto factors = _mm_set1_ps(factor);
+	for (size_t i{ 0 }; i < 16; i += 4) {
+		auto dot = _mm_set1_ps(offset);
+		for (uint32_t c{ 0 }; c < channels; c++)
+			dot = _mm_add_ps(dot, _mm_mul_ps(_mm_load_ps(&texels.channels[firstChannel + c][i]), _mm_set1_ps(direction[c])));
+		const auto t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(dot, factors), zero), maximum);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&steps[i]), _mm_cvtps_epi32(t));
+	}
+#else
+	for (size_t i{ 0 }; i < 16; i++) {
+		float dot{ offset };
+		for (uint32_t c{ 0 }; c < channels; c++)
+			dot += texels.channels[firstChannel + c][i] * direction[c];
+		steps[i] = static_cast<int32_t>(std::nearbyint(std::clamp(dot * factor, 0.f, scale)));
+	}
+#endif
+}
+
+//Least squares endpoints for fixed interpolation weights in [0, 1], false if the weights are degenerate
+static bool bc_refine(const BcTexels& texels, uint32_t channels, const std::array<float, 16>& weights, BcEndpoint& start, BcEndpoint& end)
+{
+	float aa{ 0 };
+	float ab{ 0 };
+	float bb{ 0 };
+	BcEndpoint startSum{};
+	BcEndpoint endSum{};
+	for (size_t i{ 0 }; i < 16; i++) {
+		const auto b = weights[i];
+		const auto a = 1.f - b;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (uint32_t c{ 0 }; c < channels; c++) {
+			startSum[c] += a * texels.channels[c][i];
+			endSum[c] += b * texels.channels[c][i];
+		}
+	}
+	const auto determinant = aa * bb - ab * ab;
+	if (std::abs(determinant) < 1e-6f)
+		return false;
+	for (uint32_t c{ 0 }; c < channels; c++) {
+		start[c] = (bb * startSum[c] - ab * endSum[c]) / determinant;
+		end[c] = (aa * endSum[c] - ab * startSum[c]) / determinant;
+	}
+	return true;
+}
+
+static uint16_t bc_pack_565(const BcEndpoint& color)
+{
+	const auto r = static_cast<uint32_t>(std::nearbyint(std::clamp(color[0], 0.f, 255.f) * (31.f / 255.f)));
+	const auto g = static_cast<uint32_t>(std::nearbyint(std::clamp(color[1], 0.f, 255.f) * (63.f / 255.f)));
+	const auto b = static_cast<uint32_t>(std::nearbyint(std::clamp(color[2], 0.f, 255.f) * (31.f / 255.f)));
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static std::array<int32_t, 3> bc_unpack_565(uint16_t color)
+{
+	const int32_t r = color >> 11;
+	const int32_t g = (color >> 5) & 0x3F;
+	const int32_t b = color & 0x1F;
+	return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+}
+
+//Four color palette of BC1, in step order color0, 1/3, 2/3, color1
+static std::array<std::array<int32_t, 3>, 4> bc1_palette(uint16_t color0, uint16_t color1)
+{
+	std::array<std::array<int32_t, 3>, 4> palette{ bc_unpack_565(color0), {}, {}, bc_unpack_565(color1) };
+	for (size_t c{ 0 }; c < 3; c++) {
+		palette[1][c] = (2 * palette[0][c] + palette[3][c] + 1) / 3;
+		palette[2][c] = (palette[0][c] + 2 * palette[3][c] + 1) / 3;
+	}
+	return palette;
+}
+
+static void bc_encode_color(const BcTexels& texels, std::byte* output)
+{
+	auto [low, high] = bc_fit_axis(texels, 3);
+	//Inset the endpoints, the extreme texels are rarely worth a whole palette entry
+	for (uint32_t c{ 0 }; c < 3; c++) {
+		const auto inset = (high[c] - low[c]) * (1.f / 16.f);
+		low[c] += inset;
+		high[c] -= inset;
+	}
+	uint16_t color0 = bc_pack_565(high);
+	uint16_t color1 = bc_pack_565(low);
+	uint16_t bestColor0 = color0;
+	uint16_t bestColor1 = color1;
+	BcSteps bestSteps{};
+	float bestError{ std::numeric_limits<float>::max() };
+	for (uint32_t iteration{ 0 }; iteration < bcRefineIterations; iteration++) {
+		const auto palette = bc1_palette(color0, color1);
+		BcEndpoint start{ static_cast<float>(palette[0][0]), static_cast<float>(palette[0][1]), static_cast<float>(palette[0][2]) };
+		BcEndpoint end{ static_cast<float>(palette[3][0]), static_cast<float>(palette[3][1]), static_cast<float>(palette[3][2]) };
+		BcSteps steps;
+		bc_project(texels, 0, 3, start, end, 3.f, steps);
+		float error{ 0 };
+		std::array<float, 16> weights;
+		for (size_t i{ 0 }; i < 16; i++) {
+			for (size_t c{ 0 }; c < 3; c++) {
+				const auto difference = texels.channels[c][i] - static_cast<float>(palette[steps[i]][c]);
+				error += difference * difference;
+			}
+			weights[i] = static_cast<float>(steps[i]) * (1.f / 3.f);
+		}
+		if (error < bestError) {
+			bestError = error;
+			bestColor0 = color0;
+			bestColor1 = color1;
+			bestSteps = steps;
+		}
+		if (error == 0.f || !bc_refine(texels, 3, weights, start, end))
+			break;
+		const auto refined0 = bc_pack_565(start);
+		const auto refined1 = bc_pack_565(end);
+		if (refined0 == color0 && refined1 == color1)
+			break;
+		color0 = refined0;
+		color1 = refined1;
+	}
+	//color0 > color1 selects the four color mode, equal endpoints decode index 0 in either mode
+	if (bestColor0 < bestColor1) {
+		std::swap(bestColor0, bestColor1);
+		for (auto& step : bestSteps)
+			step = 3 - step;
+	}
+	uint32_t indices{ 0 };
+	if (bestColor0 != bestColor1)
+		for (size_t i{ 0 }; i < 16; i++)
+			indices |= bc1Index[bestSteps[i]] << (2 * i);
+	std::memcpy(output, &bestColor0, sizeof(uint16_t));
+	std::memcpy(output + 2, &bestColor1, sizeof(uint16_t));
+	std::memcpy(output + 4, &indices, sizeof(uint32_t));
+}
+
+//BC4 block of one channel, always in the eight value mode with the block's extremes as endpoints
+static void bc_encode_channel(const BcTexels& texels, uint32_t channel, std::byte* output)
+{
+	const auto [minimum, maximum] = std::minmax_element(texels.channels[channel].begin(), texels.channels[channel].end());
+	const auto red0 = static_cast<uint32_t>(std::nearbyint(*maximum));
+	const auto red1 = static_cast<uint32_t>(std::nearbyint(*minimum));
+	BcBitStream bits;
+	bits.write(red0, 8);
+	bits.write(red1, 8);
+	if (red0 != red1) {
+		BcSteps steps;
+		bc_project(texels, channel, 1, { static_cast<float>(red0) }, { static_cast<float>(red1) }, 7.f, steps);
+		for (auto step : steps)
+			bits.write(step == 0 ? 0 : (step == 7 ? 1 : step + 1), 3);
+	}
+	std::memcpy(output, bits.words.data(), sizeof(uint64_t));
+}
+
+//Mode 6 endpoint, seven bits per channel and a shared lowest bit
+static uint32_t bc7_quantize(const BcEndpoint& endpoint, std::array<uint32_t, 4>& quantized)
+{
+	float bestError{ std::numeric_limits<float>::max() };
+	uint32_t bestBit{ 0 };
+	for (uint32_t bit{ 0 }; bit < 2; bit++) {
+		float error{ 0 };
+		std::array<uint32_t, 4> candidate;
+		for (size_t c{ 0 }; c < 4; c++) {
+			candidate[c] = static_cast<uint32_t>(std::clamp(std::nearbyint((endpoint[c] - static_cast<float>(bit)) * 0.5f), 0.f, 127.f));
+			const auto difference = static_cast<float>((candidate[c] << 1) | bit) - endpoint[c];
+			error += difference * difference;
+		}
+		if (error < bestError) {
+			bestError = error;
+			bestBit = bit;
+			quantized = candidate;
+		}
+	}
+	return bestBit;
+}
+
+static int32_t bc_interpolate(int32_t start, int32_t end, int32_t weight)
+{
+	return ((64 - weight) * start + weight * end + 32) >> 6;
+}
+
+static void bc_encode_bc7(const BcTexels& texels, std::byte* output)
+{
+	auto [start, end] = bc_fit_axis(texels, 4);
+	std::array<std::array<uint32_t, 4>, 2> best{};
+	std::array<uint32_t, 2> bestBits{};
+	BcSteps bestIndices{};
+	float bestError{ std::numeric_limits<float>::max() };
+	for (uint32_t iteration{ 0 }; iteration < bcRefineIterations; iteration++) {
+		std::array<std::array<uint32_t, 4>, 2> quantized;
+		std::array<uint32_t, 2> bits{ bc7_quantize(start, quantized[0]), bc7_quantize(end, quantized[1]) };
+		std::array<std::array<int32_t, 4>, 2> decoded;
+		for (size_t e{ 0 }; e < 2; e++)
+			for (size_t c{ 0 }; c < 4; c++)
+				decoded[e][c] = static_cast<int32_t>((quantized[e][c] << 1) | bits[e]);
+		BcSteps indices;
+		bc_project(texels, 0, 4, { static_cast<float>(decoded[0][0]), static_cast<float>(decoded[0][1]), static_cast<float>(decoded[0][2]), static_cast<float>(decoded[0][3]) },
+			{ static_cast<float>(decoded[1][0]), static_cast<float>(decoded[1][1]), static_cast<float>(decoded[1][2]), static_cast<float>(decoded[1][3]) }, 64.f, indices);
+		float error{ 0 };
+		std::array<float, 16> weights;
+		for (size_t i{ 0 }; i < 16; i++) {
+			indices[i] = bcWeightIndex[indices[i]];
+			const auto weight = bcWeights4[indices[i]];
+			for (size_t c{ 0 }; c < 4; c++) {
+				const auto difference = texels.channels[c][i] - static_cast<float>(bc_interpolate(decoded[0][c], decoded[1][c], weight));
+				error += difference * difference;
+			}
+			weights[i] = static_cast<float>(weight) * (1.f / 64.f);
+		}
+		if (error < bestError) {
+			bestError = error;
+			best = quantized;
+			bestBits = bits;
+			bestIndices = indices;
+		}
+		if (error == 0.f || !bc_refine(texels, 4, weights, start, end))
+			break;
+	}
+	//The anchor index has an implicit zero top bit
+	if (bestIndices[0] & 0x8) {
+		std::swap(best[0], best[1]);
+		std::swap(bestBits[0], bestBits[1]);
+		for (auto& index : bestIndices)
+			index = 15 - index;
+	}
+	BcBitStream stream;
+	stream.write(1u << 6, 7);
+	for (size_t c{ 0 }; c < 4; c++) {
+		stream.write(best[0][c], 7);
+		stream.write(best[1][c], 7);
+	}
+	stream.write(bestBits[0], 1);
+	stream.write(bestBits[1], 1);
+	for (size_t i{ 0 }; i < 16; i++)
+		stream.write(bestIndices[i], i ? 4 : 3);
+	std::memcpy(output, stream.words.data(), sizeof(stream.words));
+}
+
+//Round to nearest, negative values and NaN become 0, everything above the largest finite half is clamped
+static uint16_t bc_float_to_half(float value)
+{
+	if (!(value > 0.f))
+		return 0;
+	if (value >= 65504.f)
+		return 0x7BFF;
+	const auto bits = std::bit_cast<uint32_t>(value);
+	const auto exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+	auto mantissa = bits & 0x7FFFFF;
+	if (exponent <= 0) {
+		if (exponent < -10)
+			return 0;
+		mantissa |= 0x800000;
+		const auto shift = static_cast<uint32_t>(14 - exponent);
+		return static_cast<uint16_t>((mantissa >> shift) + ((mantissa >> (shift - 1)) & 1));
+	}
+	const auto half = (static_cast<uint32_t>(exponent) << 10 | (mantissa >> 13)) + ((mantissa >> 12) & 1);
+	return static_cast<uint16_t>(std::min(half, 0x7BFFu));
+}
+
+static float bc_half_to_float(uint16_t half)
+{
+	const auto exponent = static_cast<int32_t>((half >> 10) & 0x1F);
+	const auto mantissa = static_cast<int32_t>(half & 0x3FF);
+	if (!exponent)
+		return std::ldexp(static_cast<float>(mantissa), -24);
+	if (exponent == 31)
+		return mantissa ? std::numeric_limits<float>::quiet_NaN() : std::numeric_limits<float>::infinity();
+	return std::ldexp(static_cast<float>(1024 + mantissa), exponent - 25);
+}
+
+//Unsigned BC6H endpoints are stored in 10 bits and expanded to 16 before interpolation,
+//the interpolated value is scaled by 31/64 back into the half float range
+static int32_t bc6_unquantize(uint32_t value)
+{
+	if (value == 0)
+		return 0;
+	if (value == 1023)
+		return 0xFFFF;
+	return static_cast<int32_t>(((value << 16) + 0x8000) >> 10);
+}
+
+static int32_t bc6_finish(int32_t value)
+{
+	return (value * 31) >> 6;
+}
+
+//Single region mode with 10 bit endpoints, texels hold the half float bit patterns
+//Fitting in that space weights errors roughly relative to the magnitude, like the eye does
+static void bc_encode_bc6h(const BcTexels& texels, std::byte* output)
+{
+	auto [start, end] = bc_fit_axis(texels, 3);
+	std::array<std::array<uint32_t, 3>, 2> best{};
+	BcSteps bestIndices{};
+	float bestError{ std::numeric_limits<float>::max() };
+	for (uint32_t iteration{ 0 }; iteration < bcRefineIterations; iteration++) {
+		std::array<std::array<uint32_t, 3>, 2> quantized;
+		std::array<std::array<int32_t, 3>, 2> unquantized;
+		std::array<BcEndpoint, 2> decoded{};
+		for (size_t c{ 0 }; c < 3; c++) {
+			quantized[0][c] = static_cast<uint32_t>(std::clamp(std::nearbyint((start[c] - 15.f) * (1.f / 31.f)), 0.f, 1023.f));
+			quantized[1][c] = static_cast<uint32_t>(std::clamp(std::nearbyint((end[c] - 15.f) * (1.f / 31.f)), 0.f, 1023.f));
+			for (size_t e{ 0 }; e < 2; e++) {
+				unquantized[e][c] = bc6_unquantize(quantized[e][c]);
+				decoded[e][c] = static_cast<float>(bc6_finish(unquantized[e][c]));
+			}
+		}
+		BcSteps indices;
+		bc_project(texels, 0, 3, decoded[0], decoded[1], 64.f, indices);
+		float error{ 0 };
+		std::array<float, 16> weights;
+		for (size_t i{ 0 }; i < 16; i++) {
+			indices[i] = bcWeightIndex[indices[i]];
+			const auto weight = bcWeights4[indices[i]];
+			for (size_t c{ 0 }; c < 3; c++) {
+				const auto difference = texels.channels[c][i] - static_cast<float>(bc6_finish(bc_interpolate(unquantized[0][c], unquantized[1][c], weight)));
+				error += difference * difference;
+			}
+			weights[i] = static_cast<float>(weight) * (1.f / 64.f);
+		}
+		if (error < bestError) {
+			bestError = error;
+			best = quantized;
+			bestIndices = indices;
+		}
+		if (error == 0.f || !bc_refine(texels, 3, weights, start, end))
+			break;
+	}
+	if (bestIndices[0] & 0x8) {
+		std::swap(best[0], best[1]);
+		for (auto& index : bestIndices)
+			index = 15 - index;
+	}
+	BcBitStream stream;
+	stream.write(0x03, 5);
+	for (size_t e{ 0 }; e < 2; e++)
+		for (size_t c{ 0 }; c < 3; c++)
+			stream.write(best[e][c], 10);
+	for (size_t i{ 0 }; i < 16; i++)
+		stream.write(bestIndices[i], i ? 4 : 3);
+	std::memcpy(output, stream.words.data(), sizeof(stream.words));
+}
+
+static void bc_decode_color(const std::byte* input, Utility::BlockCompressor::Block& block, bool allowTransparent)
+{
+	uint16_t color0;
+	uint16_t color1;
+	uint32_t indices;
+	std::memcpy(&color0, input, sizeof(uint16_t));
+	std::memcpy(&color1, input + 2, sizeof(uint16_t));
+	std::memcpy(&indices, input + 4, sizeof(uint32_t));
+	auto palette = bc1_palette(color0, color1);
+	std::array<int32_t, 4> alpha{ 255, 255, 255, 255 };
+	//Three color mode with transparent black, the color blocks of BC3 always use four colors
+	if (allowTransparent && color0 <= color1) {
+		for (size_t c{ 0 }; c < 3; c++) {
+			palette[1][c] = (palette[0][c] + palette[3][c]) / 2;
+			palette[2][c] = 0;
+		}
+		alpha[2] = 0;
+	}
+	for (size_t i{ 0 }; i < 16; i++) {
+		const auto step = bc1Step[(indices >> (2 * i)) & 0x3];
+		for (size_t c{ 0 }; c < 3; c++)
+			block[i * 4 + c] = static_cast<uint8_t>(palette[step][c]);
+		block[i * 4 + 3] = static_cast<uint8_t>(alpha[step]);
+	}
+}
+
+static void bc_decode_channel(const std::byte* input, Utility::BlockCompressor::Block& block, uint32_t channel)
+{
+	BcBitStream bits;
+	std::memcpy(bits.words.data(), input, sizeof(uint64_t));
+	const auto red0 = static_cast<int32_t>(bits.read(8));
+	const auto red1 = static_cast<int32_t>(bits.read(8));
+	std::array<int32_t, 8> palette{ red0, red1 };
+	if (red0 > red1) {
+		for (int32_t i{ 2 }; i < 8; i++)
+			palette[i] = ((8 - i) * red0 + (i - 1) * red1 + 3) / 7;
+	}
+	else {
+		for (int32_t i{ 2 }; i < 6; i++)
+			palette[i] = ((6 - i) * red0 + (i - 1) * red1 + 2) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+	for (size_t i{ 0 }; i < 16; i++)
+		block[i * 4 + channel] = static_cast<uint8_t>(palette[bits.read(3)]);
+}
+
+//Only mode 6 blocks are decoded, other modes decode to transparent black
+static void bc_decode_bc7(const std::byte* input, Utility::BlockCompressor::Block& block)
+{
+	BcBitStream stream;
+	std::memcpy(stream.words.data(), input, sizeof(stream.words));
+	block.fill(0);
+	if (stream.read(7) != (1u << 6))
+		return;
+	std::array<std::array<int32_t, 4>, 2> endpoints;
+	for (size_t c{ 0 }; c < 4; c++) {
+		endpoints[0][c] = static_cast<int32_t>(stream.read(7) << 1);
+		endpoints[1][c] = static_cast<int32_t>(stream.read(7) << 1);
+	}
+	for (size_t e{ 0 }; e < 2; e++) {
+		const auto bit = static_cast<int32_t>(stream.read(1));
+		for (auto& value : endpoints[e])
+			value |= bit;
+	}
+	for (size_t i{ 0 }; i < 16; i++) {
+		const auto weight = bcWeights4[stream.read(i ? 4 : 3)];
+		for (size_t c{ 0 }; c < 4; c++)
+			block[i * 4 + c] = static_cast<uint8_t>(bc_interpolate(endpoints[0][c], endpoints[1][c], weight));
+	}
+}
+
+template<typename Block, typename Texel, typename Encode>
+static std::vector<std::byte> bc_compress_image(std::span<const Texel> texels, uint32_t width, uint32_t height, size_t blockSize, Encode&& encode)
+{
+	if (texels.size() < static_cast<size_t>(width) * height * 4)
+		throw std::runtime_error("BlockCompressor: Image data smaller than width * height texels");
+	const size_t blocksX = (width + 3) / 4;
+	const size_t blocksY = (height + 3) / 4;
+	std::vector<std::byte> output(blocksX * blocksY * blockSize);
+	Utility::JobSystem::get().parallel_for(blocksY, [&](size_t blockY) {
+		Block block;
+		for (size_t blockX{ 0 }; blockX < blocksX; blockX++) {
+			for (size_t y{ 0 }; y < 4; y++) {
+				const auto sourceY = std::min(blockY * 4 + y, static_cast<size_t>(height - 1));
+				for (size_t x{ 0 }; x < 4; x++) {
+					const auto sourceX = std::min(blockX * 4 + x, static_cast<size_t>(width - 1));
+					std::memcpy(&block[(y * 4 + x) * 4], &texels[(sourceY * width + sourceX) * 4], 4 * sizeof(Texel));
+				}
+			}
+			encode(block, output.data() + (blockY * blocksX + blockX) * blockSize);
+		}
+	});
+	return output;
+}
+
+template<typename Block, typename Texel, typename Decode>
+static std::vector<Texel> bc_decompress_image(std::span<const std::byte> data, uint32_t width, uint32_t height, size_t blockSize, Decode&& decode)
+{
+	const size_t blocksX = (width + 3) / 4;
+	const size_t blocksY = (height + 3) / 4;
+	if (data.size() < blocksX * blocksY * blockSize)
+		throw std::runtime_error("BlockCompressor: Compressed data smaller than the image");
+	std::vector<Texel> output(static_cast<size_t>(width) * height * 4);
+	Utility::JobSystem::get().parallel_for(blocksY, [&](size_t blockY) {
+		Block block;
+		for (size_t blockX{ 0 }; blockX < blocksX; blockX++) {
+			decode(data.data() + (blockY * blocksX + blockX) * blockSize, block);
+			for (size_t y{ 0 }; y < 4 && blockY * 4 + y < height; y++)
+				for (size_t x{ 0 }; x < 4 && blockX * 4 + x < width; x++)
+					std::memcpy(&output[((blockY * 4 + y) * width + blockX * 4 + x) * 4], &block[(y * 4 + x) * 4], 4 * sizeof(Texel));
+		}
+	});
+	return output;
+}
+
+size_t Utility::BlockCompressor::block_size(BlockFormat format)
+{
+	switch (format) {
+	case BlockFormat::BC1:
+	case BlockFormat::BC4:
+		return 8;
+	default:
+		return 16;
+	}
+}
+
+size_t Utility::BlockCompressor::compressed_size(BlockFormat format, uint32_t width, uint32_t height)
+{
+	return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * block_size(format);
+}
+
+Utility::DXGI_FORMAT Utility::BlockCompressor::get_dxgi_format(BlockFormat format, bool sRGB)
+{
+	switch (format) {
+	case BlockFormat::BC1:
+		return sRGB ? DXGI_FORMAT::DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT::DXGI_FORMAT_BC1_UNORM;
+	case BlockFormat::BC3:
+		return sRGB ? DXGI_FORMAT::DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT::DXGI_FORMAT_BC3_UNORM;
+	case BlockFormat::BC4:
+		return DXGI_FORMAT::DXGI_FORMAT_BC4_UNORM;
+	case BlockFormat::BC5:
+		return DXGI_FORMAT::DXGI_FORMAT_BC5_UNORM;
+	case BlockFormat::BC6H:
+		return DXGI_FORMAT::DXGI_FORMAT_BC6H_UF16;
+	case BlockFormat::BC7:
+		return sRGB ? DXGI_FORMAT::DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT::DXGI_FORMAT_BC7_UNORM;
+	default:
+		assert(false);
+		return DXGI_FORMAT::DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+std::vector<std::byte> Utility::BlockCompressor::compress(BlockFormat format, std::span<const uint8_t> rgba, uint32_t width, uint32_t height)
+{
+	if (format == BlockFormat::BC6H)
+		throw std::runtime_error("BlockCompressor: BC6H requires float input");
+	if (!width || !height)
+		return {};
+	return bc_compress_image<Block>(rgba, width, height, block_size(format), [format](const Block& block, std::byte* output) {
+		compress_block(format, block, output);
+	});
+}
+
+std::vector<std::byte> Utility::BlockCompressor::compress_hdr(std::span<const float> rgba, uint32_t width, uint32_t height)
+{
+	if (!width || !height)
+		return {};
+	return bc_compress_image<HdrBlock>(rgba, width, height, block_size(BlockFormat::BC6H), [](const HdrBlock& block, std::byte* output) {
+		compress_block_hdr(block, output);
+	});
+}
+
+std::vector<uint8_t> Utility::BlockCompressor::decompress(BlockFormat format, std::span<const std::byte> data, uint32_t width, uint32_t height)
+{
+	if (format == BlockFormat::BC6H)
+		throw std::runtime_error("BlockCompressor: BC6H decodes to float");
+	return bc_decompress_image<Block, uint8_t>(data, width, height, block_size(format), [format](const std::byte* input, Block& block) {
+		decompress_block(format, input, block);
+	});
+}
+
+std::vector<float> Utility::BlockCompressor::decompress_hdr(std::span<const std::byte> data, uint32_t width, uint32_t height)
+{
+	return bc_decompress_image<HdrBlock, float>(data, width, height, block_size(BlockFormat::BC6H), [](const std::byte* input, HdrBlock& block) {
+		decompress_block_hdr(input, block);
+	});
+}
+
+void Utility::BlockCompressor::compress_block(BlockFormat format, const Block& block, std::byte* output)
+{
+	const auto texels = bc_load(block);
+	switch (format) {
+	case BlockFormat::BC1:
+		bc_encode_color(texels, output);
+		break;
+	case BlockFormat::BC3:
+		bc_encode_channel(texels, 3, output);
+		bc_encode_color(texels, output + 8);
+		break;
+	case BlockFormat::BC4:
+		bc_encode_channel(texels, 0, output);
+		break;
+	case BlockFormat::BC5:
+		bc_encode_channel(texels, 0, output);
+		bc_encode_channel(texels, 1, output + 8);
+		break;
+	case BlockFormat::BC7:
+		bc_encode_bc7(texels, output);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+}
+
+void Utility::BlockCompressor::compress_block_hdr(const HdrBlock& block, std::byte* output)
+{
+	BcTexels texels;
+	for (size_t i{ 0 }; i < 16; i++)
+		for (size_t c{ 0 }; c < 3; c++)
+			texels.channels[c][i] = static_cast<float>(bc_float_to_half(block[i * 4 + c]));
+	texels.channels[3].fill(0.f);
+	bc_encode_bc6h(texels, output);
+}
+
+void Utility::BlockCompressor::decompress_block(BlockFormat format, const std::byte* input, Block& block)
+{
+	switch (format) {
+	case BlockFormat::BC1:
+		bc_decode_color(input, block, true);
+		break;
+	case BlockFormat::BC3:
+		bc_decode_color(input + 8, block, false);
+		bc_decode_channel(input, block, 3);
+		break;
+	case BlockFormat::BC4:
+		block.fill(0);
+		bc_decode_channel(input, block, 0);
+		for (size_t i{ 0 }; i < 16; i++)
+			block[i * 4 + 3] = 255;
+		break;
+	case BlockFormat::BC5:
+		block.fill(0);
+		bc_decode_channel(input, block, 0);
+		bc_decode_channel(input + 8, block, 1);
+		for (size_t i{ 0 }; i < 16; i++)
+			block[i * 4 + 3] = 255;
+		break;
+	case BlockFormat::BC7:
+		bc_decode_bc7(input, block);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+}
+
+//Only the single region mode written by the encoder is decoded, other modes decode to 0
+void Utility::BlockCompressor::decompress_block_hdr(const std::byte* input, HdrBlock& block)
+{
+	BcBitStream stream;
+	std::memcpy(stream.words.data(), input, sizeof(stream.words));
+	block.fill(0.f);
+	for (size_t i{ 0 }; i < 16; i++)
+		block[i * 4 + 3] = 1.f;
+	if (stream.read(5) != 0x03)
+		return;
+	std::array<std::array<int32_t, 3>, 2> endpoints;
+	for (size_t e{ 0 }; e < 2; e++)
+		for (size_t c{ 0 }; c < 3; c++)
+			endpoints[e][c] = bc6_unquantize(stream.read(10));
+	for (size_t i{ 0 }; i < 16; i++) {
+		const auto weight = bcWeights4[stream.read(i ? 4 : 3)];
+		for (size_t c{ 0 }; c < 3; c++)
+			block[i * 4 + c] = bc_half_to_float(static_cast<uint16_t>(bc6_finish(bc_interpolate(endpoints[0][c], endpoints[1][c], weight))));
+	}
+}
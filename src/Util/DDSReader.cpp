@@ -3,6 +3,7 @@
 #include "VulkanWrapper/VulkanIncludes.h"
 #include "VkWrapper.h"
 #include "Image.h"
+#include <cstring>
 
 static VkFormat convertToVk(Utility::DXGI_FORMAT format) {
 	switch (format) {
@@ -234,67 +235,13 @@ static VkFormat convertToVk(Utility::DXGI_FORMAT format) {
 		return VK_FORMAT_UNDEFINED;
 	}
 }
-constexpr uint32_t DDSMagicNumber = 0x20534444u;
-std::vector<std::byte> Utility::DDSReader::readDDSFileInMemory(const std::filesystem::path& filename)
-{
-	std::ifstream file(filename, std::ios::binary);
-	if (!(file.is_open())) {
-		throw std::runtime_error("Could not open file: \"" + filename.string() + "\"");
-	}
-	auto fileSize = std::filesystem::file_size(filename);
-	if (fileSize < 128)
-		throw std::runtime_error("File is not a valid .dds file. Reason (file too small)");
-	uint32_t magicNumber;
-	Utility::DDSHeader header;
-	file.read(reinterpret_cast<char*>(&magicNumber), sizeof(uint32_t));
-	if (magicNumber != DDSMagicNumber)
-		throw std::runtime_error("File is not a valid .dds file. Reason (file too small)");
-	file.read(reinterpret_cast<char*>(&header), sizeof(Utility::DDSHeader));
-	if (header.size != 124u)
-		throw std::runtime_error("File is not a valid .dds file. Reason (invalid header.size)");
-	if (header.pixelFormat.size != 32)
-		throw std::runtime_error("File is not a valid .dds file. Reason (invalid pixelFormat.size)");
-	if ((header.pixelFormat.fourCC == DDSPixelFormat::FourCC::DX10) && (fileSize <= 148))
-		throw std::runtime_error("File is not a valid .dds file. Reason (file too small for DX10)");
-	DDSHeaderDXT10 extHeader;
-	if ((header.pixelFormat.fourCC == DDSPixelFormat::FourCC::DX10))
-		file.read(reinterpret_cast<char*>(&extHeader), sizeof(Utility::DDSHeaderDXT10));
-	fileSize -= file.tellg();
-	std::vector<std::byte> buffer(fileSize / sizeof(uint8_t));
-	file.read(reinterpret_cast<char*>(buffer.data()), fileSize );
-	file.close();
-	return buffer;
-}
-Utility::TextureInfo Utility::DDSReader::readDDSFileHeader(const std::filesystem::path& filename, bool strict)
+constexpr size_t DDSHeaderOffset = sizeof(uint32_t);
+constexpr size_t DDSExtHeaderOffset = DDSHeaderOffset + sizeof(Utility::DDSHeader);
+
+static Utility::TextureInfo dds_parse_info(const Utility::DDSHeader& header, const Utility::DDSHeaderDXT10& extHeader, const std::filesystem::path& filename, bool strict)
 {
+	using namespace Utility;
 	Utility::TextureInfo ret{};
-
-	std::ifstream file(filename, std::ios::binary);
-	if (!(file.is_open())) {
-		throw std::runtime_error("Could not open file: \"" + filename.string() + "\"");
-	}
-	Utility::DDSHeader header;
-	auto fileSize = std::filesystem::file_size(filename);
-	if (fileSize < 128)
-		throw std::runtime_error("File is not a valid .dds file. Reason (file too small)");
-	uint32_t magicNumber;
-	file.read(reinterpret_cast<char*>(&magicNumber), sizeof(uint32_t));
-
-	if (magicNumber != DDSMagicNumber)
-		throw std::runtime_error("File is not a valid .dds file. Reason (file too small)");
-
-	file.read(reinterpret_cast<char*>(&header), sizeof(Utility::DDSHeader));
-	if (header.size != 124u)
-		throw std::runtime_error("File is not a valid .dds file. Reason (invalid header.size)");
-	if (header.pixelFormat.size != 32)
-		throw std::runtime_error("File is not a valid .dds file. Reason (invalid pixelFormat.size)");
-	if ((header.pixelFormat.fourCC == DDSPixelFormat::FourCC::DX10) && (fileSize <= 148))
-		throw std::runtime_error("File is not a valid .dds file. Reason (file too small for DX10)");
-
-	DDSHeaderDXT10 extHeader{};
-	if((header.pixelFormat.fourCC == DDSPixelFormat::FourCC::DX10))
-		file.read(reinterpret_cast<char*>(&extHeader), sizeof(Utility::DDSHeaderDXT10));
-	file.close();
 	ret.width = header.width;
 	ret.height = header.height;
 	bool isCubeMap = false;
@@ -474,16 +421,15 @@ Utility::TextureInfo Utility::DDSReader::readDDSFileHeader(const std::filesystem
 		ret.cube =  true;
 	return ret;
 }
-std::vector<vulkan::InitialImageData> Utility::DDSReader::parseImage(const Utility::TextureInfo& info, const std::vector<std::byte>& data, uint32_t startMipLevel) {
-	//TODO could directly read from file into vulkan buffer ?
-	std::vector<vulkan::InitialImageData> initalData;
-	std::vector<uint32_t> levelSizes(info.mipLevels);
+
+//Offsets of the mips from startMipLevel on relative to the start of their array layer, and the byte size of a whole layer
+static std::pair<std::array<uint32_t, 16>, size_t> dds_mip_layout(const Utility::TextureInfo& info, uint32_t startMipLevel)
+{
 	size_t totalSize = 0;
-	startMipLevel = Math::min(startMipLevel, info.mipLevels);
 	std::array<uint32_t, 16> mipOffsets{};
+	auto [blockWidth, blockHeight] = vulkan::format_to_block_size(info.format);
+	auto blockStride = vulkan::format_block_size(info.format);
 	for (uint32_t mipLevel = 0; mipLevel < info.mipLevels; mipLevel++) {
-		auto [blockWidth, blockHeight] = vulkan::format_to_block_size(info.format);
-		auto blockStride = vulkan::format_block_size(info.format);
 		uint32_t mipWidth = Math::max(1ul, info.width >> mipLevel);
 		uint32_t mipHeight = Math::max(1ul, info.height >> mipLevel);
 		uint32_t mipSize = Math::max(1ul, (mipWidth + blockWidth - 1) / blockWidth) *
@@ -493,8 +439,14 @@ std::vector<vulkan::InitialImageData> Utility::DDSReader::parseImage(const Utili
 		totalSize += mipSize;
 		//std::cout << "Level (" << mipLevel << "): " << mipSize << " Bytes\t\tTotal: " << totalSize << " Bytes \n";
 	}
-	//std::cout << "Mipoffset: " << mipOffset << '\n';
-	const std::byte* ptr = data.data();
+	return { mipOffsets, totalSize };
+}
+
+static std::vector<vulkan::InitialImageData> dds_image_data(const Utility::TextureInfo& info, const std::byte* ptr, uint32_t startMipLevel)
+{
+	std::vector<vulkan::InitialImageData> initalData;
+	startMipLevel = Math::min(startMipLevel, info.mipLevels);
+	auto [mipOffsets, totalSize] = dds_mip_layout(info, startMipLevel);
 	initalData.reserve(info.arrayLayers);
 	for (size_t arrayLayer = 0; arrayLayer < info.arrayLayers; arrayLayer++) {
 		vulkan::InitialImageData initialImageData{
@@ -505,7 +457,65 @@ std::vector<vulkan::InitialImageData> Utility::DDSReader::parseImage(const Utili
 		initalData.push_back(initialImageData);
 	}
 	return initalData;
-	//ret.mipLevels = ret.mipLevels - startMipLevel;
-	//ret.width = Math::max(1u, ret.width >> startMipLevel);
-	//ret.height = Math::max(1u, ret.height >> startMipLevel);
-}
\ No newline at end of file
+}
+
+Utility::DDSView::DDSView(const std::filesystem::path& filename, bool strict) :
+	m_file(filename)
+{
+	auto fileSize = m_file.size();
+	if (fileSize < 128)
+		throw std::runtime_error("File is not a valid .dds file. Reason (file too small)");
+	uint32_t magicNumber;
+	std::memcpy(&magicNumber, m_file.data(), sizeof(uint32_t));
+	if (magicNumber != Utility::DDSMagicNumber)
+		throw std::runtime_error("File is not a valid .dds file. Reason (invalid magic number)");
+	std::memcpy(&m_header, m_file.data() + DDSHeaderOffset, sizeof(Utility::DDSHeader));
+	if (m_header.size != 124u)
+		throw std::runtime_error("File is not a valid .dds file. Reason (invalid header.size)");
+	if (m_header.pixelFormat.size != 32)
+		throw std::runtime_error("File is not a valid .dds file. Reason (invalid pixelFormat.size)");
+	m_dataOffset = DDSExtHeaderOffset;
+	if (m_header.pixelFormat.fourCC == DDSPixelFormat::FourCC::DX10) {
+		if (fileSize <= 148)
+			throw std::runtime_error("File is not a valid .dds file. Reason (file too small for DX10)");
+		std::memcpy(&m_extHeader, m_file.data() + DDSExtHeaderOffset, sizeof(Utility::DDSHeaderDXT10));
+		m_hasExtHeader = true;
+		m_dataOffset += sizeof(Utility::DDSHeaderDXT10);
+	}
+	m_info = dds_parse_info(m_header, m_extHeader, filename, strict);
+}
+
+std::span<const std::byte> Utility::DDSView::get_data() const
+{
+	return m_file.span().subspan(m_dataOffset);
+}
+
+std::vector<vulkan::InitialImageData> Utility::DDSView::get_image_data(uint32_t startMipLevel) const
+{
+	startMipLevel = Math::min(startMipLevel, m_info.mipLevels);
+	auto [mipOffsets, layerSize] = dds_mip_layout(m_info, startMipLevel);
+	auto data = get_data();
+	if (data.size() < layerSize * m_info.arrayLayers)
+		throw std::runtime_error("File is not a valid .dds file. Reason (file too small for image data)");
+	//Only the tail of each layer gets uploaded, read it ahead instead of faulting it in page by page during the staging copy
+	if (startMipLevel < m_info.mipLevels)
+		for (size_t arrayLayer = 0; arrayLayer < m_info.arrayLayers; arrayLayer++)
+			m_file.prefetch(m_dataOffset + layerSize * arrayLayer + mipOffsets[0], layerSize - mipOffsets[0]);
+	return dds_image_data(m_info, data.data(), startMipLevel);
+}
+
+std::vector<std::byte> Utility::DDSReader::readDDSFileInMemory(const std::filesystem::path& filename)
+{
+	DDSView view(filename);
+	auto data = view.get_data();
+	return std::vector<std::byte>(data.begin(), data.end());
+}
+
+Utility::TextureInfo Utility::DDSReader::readDDSFileHeader(const std::filesystem::path& filename, bool strict)
+{
+	return DDSView(filename, strict).get_info();
+}
+
+std::vector<vulkan::InitialImageData> Utility::DDSReader::parseImage(const Utility::TextureInfo& info, const std::vector<std::byte>& data, uint32_t startMipLevel) {
+	return dds_image_data(info, data.data(), startMipLevel);
+}
@@ -0,0 +1,67 @@
+#include "Utility/JobSystem.h"
+
+static thread_local const Utility::JobSystem* jobsystem_owner{ nullptr };
+static thread_local uint32_t jobsystem_thread_index{ 0 };
+
+Utility::JobSystem::JobSystem(uint32_t threadCount)
+{
+	m_threads.reserve(threadCount);
+	for (uint32_t i{ 0 }; i < threadCount; ++i)
+		m_threads.emplace_back(&JobSystem::worker_loop, this, i + 1);
+}
+
+Utility::JobSystem::~JobSystem()
+{
+	{
+		std::scoped_lock lock{ m_mutex };
+		m_shutdown = true;
+	}
+	m_condition.notify_all();
+	for (auto& thread : m_threads)
+		thread.join();
+}
+
+uint32_t Utility::JobSystem::default_thread_count() noexcept
+{
+	//Leave one core for the calling thread, which participates in parallel_for anyways
+	auto concurrency = std::thread::hardware_concurrency();
+	return concurrency > 1 ? concurrency - 1 : 1;
+}
+
+Utility::JobSystem& Utility::JobSystem::get()
+{
+	static JobSystem s_jobSystem{};
+	return s_jobSystem;
+}
+
+void Utility::JobSystem::enqueue(std::function<void()> job)
+{
+	{
+		std::scoped_lock lock{ m_mutex };
+		m_jobs.push_back(std::move(job));
+	}
+	m_condition.notify_one();
+}
+
+uint32_t Utility::JobSystem::get_thread_index() const noexcept
+{
+	return jobsystem_owner == this ? jobsystem_thread_index : 0;
+}
+
+void Utility::JobSystem::worker_loop(uint32_t index)
+{
+	jobsystem_owner = this;
+	jobsystem_thread_index = index;
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock lock{ m_mutex };
+			m_condition.wait(lock, [this]() { return m_shutdown || !m_jobs.empty(); });
+			if (m_jobs.empty())
+				return;
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+		job();
+	}
+}
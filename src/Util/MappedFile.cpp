@@ -0,0 +1,109 @@
+#include "Utility/MappedFile.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Utility::MappedFile::MappedFile(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+	auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Could not open file: \"" + path.string() + "\"");
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		throw std::runtime_error("Could not read size of file: \"" + path.string() + "\"");
+	}
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+	if (m_size) {
+		if (auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)) {
+			m_data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			//The view keeps the mapping object alive
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	auto file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+		throw std::runtime_error("Could not open file: \"" + path.string() + "\"");
+	struct stat fileStat;
+	if (::fstat(file, &fileStat)) {
+		::close(file);
+		throw std::runtime_error("Could not read size of file: \"" + path.string() + "\"");
+	}
+	m_size = static_cast<size_t>(fileStat.st_size);
+	if (m_size) {
+		auto ptr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (ptr != MAP_FAILED)
+			m_data = static_cast<const std::byte*>(ptr);
+	}
+	//The mapping keeps its own reference to the file
+	::close(file);
+#endif
+	if (m_size && !m_data)
+		throw std::runtime_error("Could not map file: \"" + path.string() + "\"");
+}
+
+Utility::MappedFile::MappedFile(MappedFile&& other) noexcept :
+	m_data(std::exchange(other.m_data, nullptr)),
+	m_size(std::exchange(other.m_size, 0))
+{
+}
+
+Utility::MappedFile& Utility::MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other) {
+		unmap();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+	}
+	return *this;
+}
+
+Utility::MappedFile::~MappedFile()
+{
+	unmap();
+}
+
+void Utility::MappedFile::prefetch(size_t offset, size_t size) const
+{
+	if (!m_data || offset >= m_size)
+		return;
+	size = std::min(size, m_size - offset);
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range{
+		.VirtualAddress {const_cast<std::byte*>(m_data + offset)},
+		.NumberOfBytes {size},
+	};
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	//madvise requires a page aligned start
+	const auto pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+	const auto alignedOffset = offset - offset % pageSize;
+	::madvise(const_cast<std::byte*>(m_data + alignedOffset), size + (offset - alignedOffset), MADV_WILLNEED);
+#endif
+}
+
+void Utility::MappedFile::unmap()
+{
+	if (!m_data)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+#else
+	::munmap(const_cast<std::byte*>(m_data), m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
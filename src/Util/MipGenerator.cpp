@@ -0,0 +1,297 @@
+#include "Utility/MipGenerator.h"
+#include "Utility/JobSystem.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#define MIP_SSE
+#include <xmmintrin.h>
+#endif
+
+//Kernel radii in destination texels
+static constexpr float mipKaiserRadius{ 3.f };
+static constexpr float mipKaiserAlpha{ 4.f };
+static constexpr float mipLanczosRadius{ 3.f };
+static constexpr uint32_t mipCoverageIterations{ 16 };
+
+//Taps of one destination texel along one axis, padded to the same count for all texels with zero weights
+struct MipKernel {
+	uint32_t tapCount{ 0 };
+	std::vector<uint32_t> indices;
+	std::vector<float> weights;
+};
+
+static float mip_sinc(float x)
+{
+	if (std::abs(x) < 1e-5f)
+		return 1.f;
+	const auto px = std::numbers::pi_v<float> * x;
+	return std::sin(px) / px;
+}
+
+//Modified Bessel function of the first kind, power series converges quickly for the small arguments of the window
+static float mip_bessel_i0(float x)
+{
+	float sum{ 1.f };
+	float term{ 1.f };
+	const auto halfSquared = x * x * 0.25f;
+	for (uint32_t k{ 1 }; k < 32 && term > sum * 1e-8f; k++) {
+		term *= halfSquared / static_cast<float>(k * k);
+		sum += term;
+	}
+	return sum;
+}
+
+static float mip_evaluate(Utility::MipFilter filter, float t)
+{
+	switch (filter) {
+	case Utility::MipFilter::Kaiser: {
+		const auto x = t / mipKaiserRadius;
+		if (std::abs(x) >= 1.f)
+			return 0.f;
+		return mip_sinc(t) * mip_bessel_i0(mipKaiserAlpha * std::sqrt(1.f - x * x)) / mip_bessel_i0(mipKaiserAlpha);
+	}
+	case Utility::MipFilter::Lanczos:
+		if (std::abs(t) >= mipLanczosRadius)
+			return 0.f;
+		return mip_sinc(t) * mip_sinc(t / mipLanczosRadius);
+	default:
+		return std::abs(t) <= 0.5f ? 1.f : 0.f;
+	}
+}
+
+static uint32_t mip_address(int32_t index, uint32_t size, bool wrap)
+{
+	if (wrap)
+		return static_cast<uint32_t>(((index % static_cast<int32_t>(size)) + static_cast<int32_t>(size)) % static_cast<int32_t>(size));
+	return static_cast<uint32_t>(std::clamp(index, 0, static_cast<int32_t>(size) - 1));
+}
+
+static MipKernel mip_create_kernel(Utility::MipFilter filter, uint32_t sourceSize, uint32_t destinationSize, bool wrap)
+{
+	//Non power of two sizes give fractional scales, e.g. 5 -> 2 texels averages 2.5 source texels per destination texel
+	const auto scale = static_cast<float>(sourceSize) / static_cast<float>(destinationSize);
+	const auto radius = filter == Utility::MipFilter::Box ? 0.5f :
+		(filter == Utility::MipFilter::Kaiser ? mipKaiserRadius : mipLanczosRadius);
+	const auto support = radius * scale;
+	MipKernel kernel;
+	kernel.tapCount = static_cast<uint32_t>(std::ceil(support * 2.f)) + 1;
+	kernel.indices.resize(static_cast<size_t>(destinationSize) * kernel.tapCount, 0);
+	kernel.weights.resize(static_cast<size_t>(destinationSize) * kernel.tapCount, 0.f);
+	for (uint32_t destination{ 0 }; destination < destinationSize; destination++) {
+		const auto center = (static_cast<float>(destination) + 0.5f) * scale;
+		const auto first = static_cast<int32_t>(std::floor(center - support));
+		auto* indices = &kernel.indices[static_cast<size_t>(destination) * kernel.tapCount];
+		auto* weights = &kernel.weights[static_cast<size_t>(destination) * kernel.tapCount];
+		float sum{ 0 };
+		for (uint32_t tap{ 0 }; tap < kernel.tapCount; tap++) {
+			const auto source = first + static_cast<int32_t>(tap);
+			float weight;
+			if (filter == Utility::MipFilter::Box) {
+				//Exact overlap of the source texel with the destination footprint
+				const auto low = std::max(static_cast<float>(source), center - support);
+				const auto high = std::min(static_cast<float>(source) + 1.f, center + support);
+				weight = std::max(0.f, high - low);
+			}
+			else {
+				weight = mip_evaluate(filter, (static_cast<float>(source) + 0.5f - center) / scale);
+			}
+			indices[tap] = mip_address(source, sourceSize, wrap);
+			weights[tap] = weight;
+			sum += weight;
+		}
+		for (uint32_t tap{ 0 }; tap < kernel.tapCount; tap++)
+			weights[tap] /= sum;
+	}
+	return kernel;
+}
+
+//Source and destination rows of width * 4 floats
+static void mip_filter_row(const float* source, float* destination, uint32_t destinationWidth, const MipKernel& kernel)
+{
+	for (uint32_t x{ 0 }; x < destinationWidth; x++) {
+		const auto* indices = &kernel.indices[static_cast<size_t>(x) * kernel.tapCount];
+		const auto* weights = &kernel.weights[static_cast<size_t>(x) * kernel.tapCount];
+#ifdef MIP_SSE
+		auto sum = _mm_setzero_ps();
+		for (uint32_t tap{ 0 }; tap < kernel.tapCount; tap++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source + static_cast<size_t>(indices[tap]) * 4), _mm_set1_ps(weights[tap])));
+		_mm_storeu_ps(destination + static_cast<size_t>(x) * 4, sum);
+#else
+		std::array<float, 4> sum{};
+		for (uint32_t tap{ 0 }; tap < kernel.tapCount; tap++)
+			for (size_t c{ 0 }; c < 4; c++)
+				sum[c] += source[static_cast<size_t>(indices[tap]) * 4 + c] * weights[tap];
+		std::copy(sum.begin(), sum.end(), destination + static_cast<size_t>(x) * 4);
+#endif
+	}
+}
+
+//Weighted sum of whole rows, size floats each
+static void mip_filter_column(const float* source, size_t rowStride, float* destination, size_t size, const uint32_t* indices, const float* weights, uint32_t tapCount)
+{
+	std::fill(destination, destination + size, 0.f);
+	for (uint32_t tap{ 0 }; tap < tapCount; tap++) {
+		if (weights[tap] == 0.f)
+			continue;
+		const auto* row = source + indices[tap] * rowStride;
+		size_t i{ 0 };
+#ifdef MIP_SSE
+		const auto weight = _mm_set1_ps(weights[tap]);
+		for (; i + 4 <= size; i += 4)
+			_mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i), _mm_mul_ps(_mm_loadu_ps(row + i), weight)));
+#endif
+		for (; i < size; i++)
+			destination[i] += row[i] * weights[tap];
+	}
+}
+
+static std::vector<float> mip_downsample(const std::vector<float>& source, uint32_t width, uint32_t height, uint32_t nextWidth, uint32_t nextHeight, const Utility::MipGenerator::Settings& settings)
+{
+	auto& jobSystem = Utility::JobSystem::get();
+	const auto horizontal = mip_create_kernel(settings.filter, width, nextWidth, settings.wrap);
+	const auto vertical = mip_create_kernel(settings.filter, height, nextHeight, settings.wrap);
+	const size_t sourceStride = static_cast<size_t>(width) * 4;
+	const size_t stride = static_cast<size_t>(nextWidth) * 4;
+	std::vector<float> intermediate(stride * height);
+	jobSystem.parallel_for(height, [&](size_t y) {
+		mip_filter_row(source.data() + y * sourceStride, intermediate.data() + y * stride, nextWidth, horizontal);
+	}, 8);
+	std::vector<float> destination(stride * nextHeight);
+	jobSystem.parallel_for(nextHeight, [&](size_t y) {
+		mip_filter_column(intermediate.data(), stride, destination.data() + y * stride, stride,
+			&vertical.indices[y * vertical.tapCount], &vertical.weights[y * vertical.tapCount], vertical.tapCount);
+	}, 8);
+	return destination;
+}
+
+static float mip_srgb_to_linear(float value)
+{
+	return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float mip_linear_to_srgb(float value)
+{
+	return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+}
+
+static float mip_coverage(const std::vector<float>& texels, float cutoff, float scale)
+{
+	size_t covered{ 0 };
+	for (size_t i{ 3 }; i < texels.size(); i += 4)
+		covered += std::min(1.f, texels[i] * scale) > cutoff;
+	return static_cast<float>(covered) / static_cast<float>(texels.size() / 4);
+}
+
+//Bisection for the alpha scale that restores the coverage, coverage grows monotonically with the scale
+static float mip_coverage_scale(const std::vector<float>& texels, float cutoff, float targetCoverage)
+{
+	float low{ 0.f };
+	float high{ 1.f / std::max(cutoff, 1e-3f) };
+	//Scaling by 1 / cutoff makes every texel with alpha above 0 pass, more can't help
+	for (uint32_t iteration{ 0 }; iteration < mipCoverageIterations; iteration++) {
+		const auto mid = (low + high) * 0.5f;
+		if (mip_coverage(texels, cutoff, mid) < targetCoverage)
+			low = mid;
+		else
+			high = mid;
+	}
+	return high;
+}
+
+template<typename Texel, typename Load, typename Store>
+static std::vector<Utility::MipGenerator::Level<Texel>> mip_generate(std::span<const Texel> rgba, uint32_t width, uint32_t height, const Utility::MipGenerator::Settings& settings, Load&& load, Store&& store)
+{
+	if (rgba.size() < static_cast<size_t>(width) * height * 4)
+		throw std::runtime_error("MipGenerator: Image data smaller than width * height texels");
+	std::vector<Utility::MipGenerator::Level<Texel>> levels;
+	if (!width || !height)
+		return levels;
+	auto& jobSystem = Utility::JobSystem::get();
+	const auto levelCount = Utility::MipGenerator::level_count(width, height);
+	levels.reserve(levelCount);
+	levels.push_back({ width, height, std::vector<Texel>(rgba.begin(), rgba.begin() + static_cast<size_t>(width) * height * 4) });
+	std::vector<float> current(static_cast<size_t>(width) * height * 4);
+	jobSystem.parallel_for(height, [&](size_t y) {
+		load(rgba.data() + y * width * 4, current.data() + y * width * 4, width);
+	}, 8);
+	for (uint32_t level{ 1 }; level < levelCount; level++) {
+		const auto nextWidth = std::max(1u, width >> 1);
+		const auto nextHeight = std::max(1u, height >> 1);
+		current = mip_downsample(current, width, height, nextWidth, nextHeight, settings);
+		width = nextWidth;
+		height = nextHeight;
+		auto& output = levels.emplace_back(Utility::MipGenerator::Level<Texel>{ width, height, std::vector<Texel>(static_cast<size_t>(width) * height * 4) });
+		const auto alphaScale = store.alpha_scale(current);
+		jobSystem.parallel_for(height, [&](size_t y) {
+			store(current.data() + y * width * 4, output.texels.data() + y * width * 4, width, alphaScale);
+		}, 8);
+	}
+	return levels;
+}
+
+uint32_t Utility::MipGenerator::level_count(uint32_t width, uint32_t height)
+{
+	return static_cast<uint32_t>(std::bit_width(std::max(width, height)));
+}
+
+std::vector<Utility::MipGenerator::Level<uint8_t>> Utility::MipGenerator::generate(std::span<const uint8_t> rgba, uint32_t width, uint32_t height, const Settings& settings)
+{
+	std::array<float, 256> toLinear;
+	for (size_t i{ 0 }; i < toLinear.size(); i++)
+		toLinear[i] = settings.sRGB ? mip_srgb_to_linear(static_cast<float>(i) / 255.f) : static_cast<float>(i) / 255.f;
+	const auto coverage = settings.preserveAlphaCoverage ? alpha_coverage(rgba.first(std::min(rgba.size(), static_cast<size_t>(width) * height * 4)), settings.alphaCutoff) : 0.f;
+	struct Store {
+		const Settings& settings;
+		float coverage;
+		float alpha_scale(const std::vector<float>& texels) const {
+			return settings.preserveAlphaCoverage ? mip_coverage_scale(texels, settings.alphaCutoff, coverage) : 1.f;
+		}
+		void operator()(const float* source, uint8_t* destination, uint32_t width, float alphaScale) const {
+			for (size_t i{ 0 }; i < static_cast<size_t>(width) * 4; i += 4) {
+				for (size_t c{ 0 }; c < 3; c++) {
+					const auto value = std::clamp(source[i + c], 0.f, 1.f);
+					destination[i + c] = static_cast<uint8_t>(std::lround((settings.sRGB ? mip_linear_to_srgb(value) : value) * 255.f));
+				}
+				destination[i + 3] = static_cast<uint8_t>(std::lround(std::clamp(source[i + 3] * alphaScale, 0.f, 1.f) * 255.f));
+			}
+		}
+	};
+	return mip_generate<uint8_t>(rgba, width, height, settings, [&toLinear](const uint8_t* source, float* destination, uint32_t width) {
+		for (size_t i{ 0 }; i < static_cast<size_t>(width) * 4; i += 4) {
+			for (size_t c{ 0 }; c < 3; c++)
+				destination[i + c] = toLinear[source[i + c]];
+			destination[i + 3] = static_cast<float>(source[i + 3]) * (1.f / 255.f);
+		}
+	}, Store{ settings, coverage });
+}
+
+std::vector<Utility::MipGenerator::Level<float>> Utility::MipGenerator::generate_hdr(std::span<const float> rgba, uint32_t width, uint32_t height, const Settings& settings)
+{
+	struct Store {
+		float alpha_scale(const std::vector<float>&) const {
+			return 1.f;
+		}
+		void operator()(const float* source, float* destination, uint32_t width, float) const {
+			//Negative lobes of the sharper filters can undershoot around bright texels
+			for (size_t i{ 0 }; i < static_cast<size_t>(width) * 4; i++)
+				destination[i] = std::max(source[i], 0.f);
+		}
+	};
+	return mip_generate<float>(rgba, width, height, settings, [](const float* source, float* destination, uint32_t width) {
+		std::copy(source, source + static_cast<size_t>(width) * 4, destination);
+	}, Store{});
+}
+
+float Utility::MipGenerator::alpha_coverage(std::span<const uint8_t> rgba, float cutoff, float scale)
+{
+	if (rgba.size() < 4)
+		return 0.f;
+	size_t covered{ 0 };
+	for (size_t i{ 3 }; i < rgba.size(); i += 4)
+		covered += std::min(1.f, static_cast<float>(rgba[i]) * (1.f / 255.f) * scale) > cutoff;
+	return static_cast<float>(covered) / static_cast<float>(rgba.size() / 4);
+}
@@ -0,0 +1,302 @@
+#include "Utility/OffsetAllocator.h"
+#include <bit>
+#include <cassert>
+
+//Bins hold 8 linearly spaced sizes per power of two, sizes below 8 are exact
+static constexpr uint32_t offsetMantissaBits{ 3 };
+static constexpr uint32_t offsetMantissaValue{ 1u << offsetMantissaBits };
+static constexpr uint32_t offsetMantissaMask{ offsetMantissaValue - 1 };
+
+//First set bit at or above index, invalidOffset if there is none
+static uint32_t offset_lowest_bit_after(uint32_t mask, uint32_t index)
+{
+	if (index >= 32)
+		return Utility::OffsetAllocator::invalidOffset;
+	const auto masked = mask & (~0u << index);
+	return masked ? static_cast<uint32_t>(std::countr_zero(masked)) : Utility::OffsetAllocator::invalidOffset;
+}
+
+uint32_t Utility::OffsetAllocator::size_to_bin_round_up(uint32_t size)
+{
+	if (size < offsetMantissaValue)
+		return size;
+	const auto highestBit = 31 - static_cast<uint32_t>(std::countl_zero(size));
+	const auto mantissaStart = highestBit - offsetMantissaBits;
+	const auto exponent = mantissaStart + 1;
+	auto mantissa = (size >> mantissaStart) & offsetMantissaMask;
+	//A mantissa overflow carries into the exponent, which is the next size class
+	if (size & ((1u << mantissaStart) - 1))
+		mantissa++;
+	return (exponent << offsetMantissaBits) + mantissa;
+}
+
+uint32_t Utility::OffsetAllocator::size_to_bin_round_down(uint32_t size)
+{
+	if (size < offsetMantissaValue)
+		return size;
+	const auto highestBit = 31 - static_cast<uint32_t>(std::countl_zero(size));
+	const auto mantissaStart = highestBit - offsetMantissaBits;
+	const auto exponent = mantissaStart + 1;
+	const auto mantissa = (size >> mantissaStart) & offsetMantissaMask;
+	return (exponent << offsetMantissaBits) | mantissa;
+}
+
+uint32_t Utility::OffsetAllocator::bin_to_size(uint32_t bin)
+{
+	const auto exponent = bin >> offsetMantissaBits;
+	const auto mantissa = bin & offsetMantissaMask;
+	if (!exponent)
+		return mantissa;
+	return (mantissa | offsetMantissaValue) << (exponent - 1);
+}
+
+Utility::OffsetAllocator::OffsetAllocator(uint32_t size) :
+	m_size(size)
+{
+	reset();
+}
+
+void Utility::OffsetAllocator::reset()
+{
+	m_freeSize = 0;
+	m_freeRegions = 0;
+	m_allocations = 0;
+	m_topMask = 0;
+	m_leafMasks.fill(0);
+	m_binHeads.fill(invalidOffset);
+	m_nodes.clear();
+	m_unusedNodes.clear();
+	if (m_size)
+		insert_free(create_node(0, m_size));
+}
+
+Utility::OffsetAllocator::Allocation Utility::OffsetAllocator::allocate(uint32_t size)
+{
+	size = size ? size : 1;
+	if (size > m_freeSize)
+		return {};
+	//Rounding up guarantees that every region in the selected bin is large enough
+	const auto minBin = size_to_bin_round_up(size);
+	auto topBin = minBin >> offsetMantissaBits;
+	auto leafBin = invalidOffset;
+	if (topBin < m_leafMasks.size())
+		leafBin = offset_lowest_bit_after(m_leafMasks[topBin], minBin & offsetMantissaMask);
+	if (leafBin == invalidOffset)
+		topBin = offset_lowest_bit_after(m_topMask, topBin + 1);
+	auto nodeIndex = invalidOffset;
+	if (topBin != invalidOffset) {
+		if (leafBin == invalidOffset)
+			leafBin = static_cast<uint32_t>(std::countr_zero(m_leafMasks[topBin]));
+		nodeIndex = m_binHeads[(topBin << offsetMantissaBits) | leafBin];
+	}
+	else {
+		//Regions in the bin below may still fit, only searched when nothing else is left, e.g. for the last region of an arena
+		for (auto node = m_binHeads[size_to_bin_round_down(size)]; node != invalidOffset; node = m_nodes[node].binNext) {
+			if (m_nodes[node].size >= size) {
+				nodeIndex = node;
+				break;
+			}
+		}
+		if (nodeIndex == invalidOffset)
+			return {};
+	}
+	assert(nodeIndex != invalidOffset);
+	remove_free(nodeIndex);
+	m_nodes[nodeIndex].used = true;
+	m_allocations++;
+
+	if (const auto remainder = m_nodes[nodeIndex].size - size; remainder) {
+		m_nodes[nodeIndex].size = size;
+		const auto split = create_node(m_nodes[nodeIndex].offset + size, remainder);
+		auto& node = m_nodes[nodeIndex];
+		auto& splitNode = m_nodes[split];
+		splitNode.neighborPrev = nodeIndex;
+		splitNode.neighborNext = node.neighborNext;
+		if (node.neighborNext != invalidOffset)
+			m_nodes[node.neighborNext].neighborPrev = split;
+		node.neighborNext = split;
+		insert_free(split);
+	}
+	return Allocation{
+		.offset {m_nodes[nodeIndex].offset},
+		.node {nodeIndex},
+	};
+}
+
+void Utility::OffsetAllocator::free(Allocation allocation)
+{
+	if (!allocation.valid())
+		return;
+	assert(allocation.node < m_nodes.size());
+	assert(m_nodes[allocation.node].used);
+	const auto nodeIndex = allocation.node;
+	m_nodes[nodeIndex].used = false;
+	m_allocations--;
+
+	if (const auto prev = m_nodes[nodeIndex].neighborPrev; prev != invalidOffset && !m_nodes[prev].used) {
+		remove_free(prev);
+		auto& node = m_nodes[nodeIndex];
+		node.offset = m_nodes[prev].offset;
+		node.size += m_nodes[prev].size;
+		node.neighborPrev = m_nodes[prev].neighborPrev;
+		if (node.neighborPrev != invalidOffset)
+			m_nodes[node.neighborPrev].neighborNext = nodeIndex;
+		release_node(prev);
+	}
+	if (const auto next = m_nodes[nodeIndex].neighborNext; next != invalidOffset && !m_nodes[next].used) {
+		remove_free(next);
+		auto& node = m_nodes[nodeIndex];
+		node.size += m_nodes[next].size;
+		node.neighborNext = m_nodes[next].neighborNext;
+		if (node.neighborNext != invalidOffset)
+			m_nodes[node.neighborNext].neighborPrev = nodeIndex;
+		release_node(next);
+	}
+	insert_free(nodeIndex);
+}
+
+uint32_t Utility::OffsetAllocator::get_allocation_size(Allocation allocation) const
+{
+	if (!allocation.valid())
+		return 0;
+	assert(allocation.node < m_nodes.size());
+	return m_nodes[allocation.node].size;
+}
+
+Utility::OffsetAllocator::Statistics Utility::OffsetAllocator::get_statistics() const
+{
+	Statistics statistics{
+		.freeSize {m_freeSize},
+		.freeRegions {m_freeRegions},
+		.allocations {m_allocations},
+	};
+	//Only the highest non empty bin can contain the largest region
+	if (m_topMask) {
+		const auto topBin = 31 - static_cast<uint32_t>(std::countl_zero(m_topMask));
+		const auto leafBin = 31 - static_cast<uint32_t>(std::countl_zero(static_cast<uint32_t>(m_leafMasks[topBin])));
+		for (auto node = m_binHeads[(topBin << offsetMantissaBits) | leafBin]; node != invalidOffset; node = m_nodes[node].binNext)
+			statistics.largestFreeRegion = std::max(statistics.largestFreeRegion, m_nodes[node].size);
+	}
+	return statistics;
+}
+
+std::vector<Utility::OffsetAllocator::Move> Utility::OffsetAllocator::defragment()
+{
+	std::vector<Move> moves;
+	if (!m_size)
+		return moves;
+	auto nodeIndex = invalidOffset;
+	for (uint32_t i{ 0 }; i < m_nodes.size(); ++i) {
+		if (m_nodes[i].offset == 0 && m_nodes[i].size && m_nodes[i].neighborPrev == invalidOffset) {
+			nodeIndex = i;
+			break;
+		}
+	}
+	assert(nodeIndex != invalidOffset);
+	uint32_t cursor{ 0 };
+	auto lastUsed = invalidOffset;
+	while (nodeIndex != invalidOffset) {
+		const auto next = m_nodes[nodeIndex].neighborNext;
+		if (m_nodes[nodeIndex].used) {
+			auto& node = m_nodes[nodeIndex];
+			if (node.offset != cursor) {
+				moves.push_back(Move{
+					.allocation {
+						.offset {cursor},
+						.node {nodeIndex},
+					},
+					.sourceOffset {node.offset},
+					.size {node.size},
+				});
+				node.offset = cursor;
+			}
+			node.neighborPrev = lastUsed;
+			if (lastUsed != invalidOffset)
+				m_nodes[lastUsed].neighborNext = nodeIndex;
+			cursor += node.size;
+			lastUsed = nodeIndex;
+		}
+		else {
+			remove_free(nodeIndex);
+			release_node(nodeIndex);
+		}
+		nodeIndex = next;
+	}
+	if (lastUsed != invalidOffset)
+		m_nodes[lastUsed].neighborNext = invalidOffset;
+	if (cursor < m_size) {
+		const auto tail = create_node(cursor, m_size - cursor);
+		m_nodes[tail].neighborPrev = lastUsed;
+		if (lastUsed != invalidOffset)
+			m_nodes[lastUsed].neighborNext = tail;
+		insert_free(tail);
+	}
+	return moves;
+}
+
+uint32_t Utility::OffsetAllocator::create_node(uint32_t offset, uint32_t size)
+{
+	uint32_t index;
+	if (!m_unusedNodes.empty()) {
+		index = m_unusedNodes.back();
+		m_unusedNodes.pop_back();
+		m_nodes[index] = Node{};
+	}
+	else {
+		index = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+	m_nodes[index].offset = offset;
+	m_nodes[index].size = size;
+	return index;
+}
+
+void Utility::OffsetAllocator::release_node(uint32_t node)
+{
+	m_nodes[node] = Node{};
+	m_unusedNodes.push_back(node);
+}
+
+void Utility::OffsetAllocator::insert_free(uint32_t nodeIndex)
+{
+	auto& node = m_nodes[nodeIndex];
+	const auto bin = size_to_bin_round_down(node.size);
+	const auto topBin = bin >> offsetMantissaBits;
+	const auto leafBin = bin & offsetMantissaMask;
+	if (m_binHeads[bin] == invalidOffset) {
+		m_leafMasks[topBin] |= static_cast<uint8_t>(1u << leafBin);
+		m_topMask |= 1u << topBin;
+	}
+	else {
+		m_nodes[m_binHeads[bin]].binPrev = nodeIndex;
+	}
+	node.binPrev = invalidOffset;
+	node.binNext = m_binHeads[bin];
+	m_binHeads[bin] = nodeIndex;
+	m_freeSize += node.size;
+	m_freeRegions++;
+}
+
+void Utility::OffsetAllocator::remove_free(uint32_t nodeIndex)
+{
+	auto& node = m_nodes[nodeIndex];
+	if (node.binPrev != invalidOffset) {
+		m_nodes[node.binPrev].binNext = node.binNext;
+	}
+	else {
+		const auto bin = size_to_bin_round_down(node.size);
+		m_binHeads[bin] = node.binNext;
+		if (node.binNext == invalidOffset) {
+			const auto topBin = bin >> offsetMantissaBits;
+			m_leafMasks[topBin] &= static_cast<uint8_t>(~(1u << (bin & offsetMantissaMask)));
+			if (!m_leafMasks[topBin])
+				m_topMask &= ~(1u << topBin);
+		}
+	}
+	if (node.binNext != invalidOffset)
+		m_nodes[node.binNext].binPrev = node.binPrev;
+	node.binPrev = invalidOffset;
+	node.binNext = invalidOffset;
+	m_freeSize -= node.size;
+	m_freeRegions--;
+}
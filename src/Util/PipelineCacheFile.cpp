@@ -0,0 +1,88 @@
+#include "Utility/PipelineCacheFile.h"
+#include "Utility/StreamHasher.h"
+#include "Utility/MappedFile.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+//Layout of VkPipelineCacheHeaderVersionOne, without depending on the Vulkan headers
+struct PipelineCacheVulkanHeader {
+	uint32_t headerSize;
+	uint32_t headerVersion;
+	uint32_t vendorID;
+	uint32_t deviceID;
+	std::array<uint8_t, 16> pipelineCacheUUID;
+};
+static_assert(sizeof(PipelineCacheVulkanHeader) == 32);
+//VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+static constexpr uint32_t pipelineCacheVulkanHeaderVersionOne = 1;
+
+Utility::PipelineCacheFile::Contents Utility::PipelineCacheFile::read(const std::filesystem::path& path, const Identity& identity)
+{
+	std::error_code ec;
+	if (!std::filesystem::exists(path, ec))
+		return { .status {Status::Missing} };
+	MappedFile file;
+	try {
+		file = MappedFile(path);
+	}
+	catch (const std::runtime_error&) {
+		return { .status {Status::Missing} };
+	}
+	Header header;
+	if (file.size() < sizeof(Header))
+		return { .status {Status::Invalid} };
+	std::memcpy(&header, file.data(), sizeof(Header));
+	if (header.magic != magic || header.version != version || header.dataSize != file.size() - sizeof(Header))
+		return { .status {Status::Invalid} };
+	if (header.identity != identity)
+		return { .status {Status::Mismatch} };
+	const auto data = file.span().subspan(sizeof(Header));
+	if (header.checksum != checksum(data) || !is_valid_vulkan_data(data, identity))
+		return { .status {Status::Corrupt} };
+	return { .status {Status::Loaded}, .data {data.begin(), data.end()} };
+}
+
+void Utility::PipelineCacheFile::write(const std::filesystem::path& path, const Identity& identity, std::span<const std::byte> data)
+{
+	const Header header{
+		.magic {magic},
+		.version {version},
+		.identity {identity},
+		.reserved {0},
+		.dataSize {data.size()},
+		.checksum {checksum(data)},
+	};
+	auto temporary = path;
+	temporary += ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary);
+		if (!file.is_open())
+			throw std::runtime_error("Could not open file: \"" + temporary.string() + "\"");
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		if (!file)
+			throw std::runtime_error("Could not write file: \"" + temporary.string() + "\"");
+	}
+	std::filesystem::rename(temporary, path);
+}
+
+bool Utility::PipelineCacheFile::is_valid_vulkan_data(std::span<const std::byte> data, const Identity& identity)
+{
+	PipelineCacheVulkanHeader header;
+	if (data.size() < sizeof(PipelineCacheVulkanHeader))
+		return false;
+	std::memcpy(&header, data.data(), sizeof(PipelineCacheVulkanHeader));
+	return header.headerSize >= sizeof(PipelineCacheVulkanHeader) && header.headerSize <= data.size() &&
+		header.headerVersion == pipelineCacheVulkanHeaderVersionOne &&
+		header.vendorID == identity.vendorID && header.deviceID == identity.deviceID &&
+		header.pipelineCacheUUID == identity.pipelineCacheUUID;
+}
+
+uint64_t Utility::PipelineCacheFile::checksum(std::span<const std::byte> data)
+{
+	StreamHasher hasher;
+	hasher.update(data.data(), data.size());
+	return hasher.finish();
+}
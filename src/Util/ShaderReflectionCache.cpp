@@ -0,0 +1,203 @@
+#include "Utility/ShaderReflectionCache.h"
+#include "Utility/BinaryStream.h"
+#include "Utility/MappedFile.h"
+#include "Utility/StreamHasher.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+struct ShaderReflectionCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t reserved;
+	uint64_t dataSize;
+	//StreamHasher of the data
+	uint64_t checksum;
+};
+
+static uint64_t reflection_cache_hash(std::span<const std::byte> data)
+{
+	Utility::StreamHasher hasher;
+	hasher.update(data.data(), data.size());
+	return hasher.finish();
+}
+
+Utility::ShaderReflectionCache::ShaderReflectionCache(const std::filesystem::path& path) :
+	m_path(path)
+{
+	std::error_code ec;
+	if (!std::filesystem::exists(m_path, ec))
+		return;
+	try {
+		MappedFile file(m_path);
+		if (auto entries = deserialize(file.span()))
+			m_entries = std::move(*entries);
+	}
+	catch (const std::runtime_error&) {
+	}
+}
+
+Utility::ShaderReflection Utility::ShaderReflectionCache::get(std::span<const uint32_t> code, uint64_t key, const Reflector& reflect)
+{
+	{
+		std::scoped_lock lock(m_mutex);
+		if (auto it = m_entries.find(key); it != m_entries.end()) {
+			m_statistics.hits++;
+			return it->second;
+		}
+		m_statistics.misses++;
+	}
+	auto reflection = reflect(code);
+	insert(key, reflection);
+	return reflection;
+}
+
+Utility::ShaderReflection Utility::ShaderReflectionCache::get(std::span<const uint32_t> code, const Reflector& reflect)
+{
+	return get(code, compute_key(code), reflect);
+}
+
+std::optional<Utility::ShaderReflection> Utility::ShaderReflectionCache::find(uint64_t key) const
+{
+	std::scoped_lock lock(m_mutex);
+	if (auto it = m_entries.find(key); it != m_entries.end())
+		return it->second;
+	return std::nullopt;
+}
+
+void Utility::ShaderReflectionCache::insert(uint64_t key, ShaderReflection reflection)
+{
+	std::scoped_lock lock(m_mutex);
+	if (auto [it, inserted] = m_entries.try_emplace(key, std::move(reflection)); inserted)
+		m_dirty = true;
+}
+
+void Utility::ShaderReflectionCache::save()
+{
+	std::scoped_lock lock(m_mutex);
+	if (!m_dirty)
+		return;
+	const auto data = serialize(m_entries);
+	auto temporary = m_path;
+	temporary += ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary);
+		if (!file.is_open())
+			throw std::runtime_error("Could not open file: \"" + temporary.string() + "\"");
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		if (!file)
+			throw std::runtime_error("Could not write file: \"" + temporary.string() + "\"");
+	}
+	std::filesystem::rename(temporary, m_path);
+	m_dirty = false;
+}
+
+Utility::ShaderReflectionCache::Statistics Utility::ShaderReflectionCache::get_statistics() const
+{
+	std::scoped_lock lock(m_mutex);
+	return m_statistics;
+}
+
+size_t Utility::ShaderReflectionCache::size() const
+{
+	std::scoped_lock lock(m_mutex);
+	return m_entries.size();
+}
+
+const std::filesystem::path& Utility::ShaderReflectionCache::get_path() const noexcept
+{
+	return m_path;
+}
+
+uint64_t Utility::ShaderReflectionCache::compute_key(std::span<const uint32_t> code)
+{
+	return reflection_cache_hash(std::as_bytes(code));
+}
+
+std::vector<std::byte> Utility::ShaderReflectionCache::serialize(const std::unordered_map<uint64_t, ShaderReflection>& entries)
+{
+	//Sorted by key, the same entries always give the same file
+	std::vector<uint64_t> keys;
+	keys.reserve(entries.size());
+	for (const auto& [key, reflection] : entries)
+		keys.push_back(key);
+	std::sort(keys.begin(), keys.end());
+	Utility::BinaryWriter body;
+	for (auto key : keys) {
+		const auto& reflection = entries.at(key);
+		body.write(key);
+		body.write(reflection.stage);
+		body.write(reflection.pushConstantSize);
+		body.write(reflection.workgroupSize);
+		body.write(static_cast<uint32_t>(reflection.bindings.size()));
+		for (const auto& binding : reflection.bindings) {
+			body.write(binding.set);
+			body.write(binding.binding);
+			body.write(binding.descriptorType);
+			body.write(binding.count);
+		}
+		body.write(static_cast<uint32_t>(reflection.specializationConstants.size()));
+		for (const auto& constant : reflection.specializationConstants) {
+			body.write(constant.name);
+			body.write(constant.id);
+			body.write(constant.type);
+		}
+	}
+	const ShaderReflectionCacheHeader header{
+		.magic {magic},
+		.version {version},
+		.entryCount {static_cast<uint32_t>(keys.size())},
+		.reserved {0},
+		.dataSize {body.get_data().size()},
+		.checksum {reflection_cache_hash(body.get_data())},
+	};
+	Utility::BinaryWriter file;
+	file.reserve(sizeof(header) + body.get_data().size());
+	file.write(header);
+	file.write_bytes(body.get_data());
+	return file.take_data();
+}
+
+std::optional<std::unordered_map<uint64_t, Utility::ShaderReflection>> Utility::ShaderReflectionCache::deserialize(std::span<const std::byte> data)
+{
+	ShaderReflectionCacheHeader header;
+	if (!Utility::BinaryReader(data).read(header))
+		return std::nullopt;
+	const auto body = data.subspan(sizeof(header));
+	if (header.magic != magic || header.version != version || header.dataSize != body.size() || header.checksum != reflection_cache_hash(body))
+		return std::nullopt;
+	//Key, stage, push constant size, workgroup size and the two counts
+	constexpr size_t minEntrySize = sizeof(uint64_t) + 7 * sizeof(uint32_t);
+	if (header.entryCount > body.size() / minEntrySize)
+		return std::nullopt;
+	Utility::BinaryReader reader(body);
+	std::unordered_map<uint64_t, ShaderReflection> entries;
+	entries.reserve(header.entryCount);
+	for (uint32_t entry = 0; entry < header.entryCount; entry++) {
+		uint64_t key;
+		ShaderReflection reflection;
+		uint32_t bindingCount;
+		if (!reader.read(key) || !reader.read(reflection.stage) || !reader.read(reflection.pushConstantSize) ||
+			!reader.read(reflection.workgroupSize) || !reader.read_count(bindingCount, sizeof(ShaderReflection::Binding)))
+			return std::nullopt;
+		reflection.bindings.resize(bindingCount);
+		for (auto& binding : reflection.bindings)
+			if (!reader.read(binding.set) || !reader.read(binding.binding) || !reader.read(binding.descriptorType) || !reader.read(binding.count))
+				return std::nullopt;
+		uint32_t constantCount;
+		//Name length, id and type
+		if (!reader.read_count(constantCount, 3 * sizeof(uint32_t)))
+			return std::nullopt;
+		reflection.specializationConstants.resize(constantCount);
+		for (auto& constant : reflection.specializationConstants)
+			if (!reader.read(constant.name) || !reader.read(constant.id) || !reader.read(constant.type))
+				return std::nullopt;
+		if (!entries.try_emplace(key, std::move(reflection)).second)
+			return std::nullopt;
+	}
+	if (!reader.done())
+		return std::nullopt;
+	return entries;
+}
@@ -0,0 +1,88 @@
+#include "Utility/StreamHasher.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+//Round and merge structure of XXH64, Collet 2014
+static constexpr uint64_t streamPrime1{ 0x9E3779B185EBCA87ull };
+static constexpr uint64_t streamPrime2{ 0xC2B2AE3D27D4EB4Full };
+static constexpr uint64_t streamPrime3{ 0x165667B19E3779F9ull };
+static constexpr uint64_t streamPrime4{ 0x85EBCA77C2B2AE63ull };
+static constexpr uint64_t streamPrime5{ 0x27D4EB2F165667C5ull };
+
+static uint64_t stream_read64(const std::byte* data)
+{
+	uint64_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static uint64_t stream_round(uint64_t lane, uint64_t word)
+{
+	return std::rotl(lane + word * streamPrime2, 31) * streamPrime1;
+}
+
+static uint64_t stream_merge(uint64_t hash, uint64_t lane)
+{
+	return (hash ^ stream_round(0, lane)) * streamPrime1 + streamPrime4;
+}
+
+Utility::StreamHasher::StreamHasher(uint64_t seed) :
+	m_lanes({ seed + streamPrime1 + streamPrime2, seed + streamPrime2, seed, seed - streamPrime1 }),
+	m_seed(seed)
+{
+}
+
+void Utility::StreamHasher::update(const void* data, size_t size)
+{
+	auto bytes = static_cast<const std::byte*>(data);
+	m_totalSize += size;
+	if (m_pendingSize) {
+		const auto count = std::min(size, m_pending.size() - m_pendingSize);
+		std::memcpy(m_pending.data() + m_pendingSize, bytes, count);
+		m_pendingSize += count;
+		bytes += count;
+		size -= count;
+		if (m_pendingSize < m_pending.size())
+			return;
+		consume(m_pending.data());
+		m_pendingSize = 0;
+	}
+	for (; size >= m_pending.size(); size -= m_pending.size(), bytes += m_pending.size())
+		consume(bytes);
+	if (size) {
+		std::memcpy(m_pending.data(), bytes, size);
+		m_pendingSize = size;
+	}
+}
+
+uint64_t Utility::StreamHasher::finish() const
+{
+	uint64_t hash;
+	if (m_totalSize >= m_pending.size()) {
+		hash = std::rotl(m_lanes[0], 1) + std::rotl(m_lanes[1], 7) + std::rotl(m_lanes[2], 12) + std::rotl(m_lanes[3], 18);
+		for (auto lane : m_lanes)
+			hash = stream_merge(hash, lane);
+	}
+	else {
+		hash = m_seed + streamPrime5;
+	}
+	hash += m_totalSize;
+	size_t offset{ 0 };
+	for (; offset + 8 <= m_pendingSize; offset += 8)
+		hash = std::rotl(hash ^ stream_round(0, stream_read64(m_pending.data() + offset)), 27) * streamPrime1 + streamPrime4;
+	for (; offset < m_pendingSize; ++offset)
+		hash = std::rotl(hash ^ (static_cast<uint64_t>(m_pending[offset]) * streamPrime5), 11) * streamPrime1;
+	hash ^= hash >> 33;
+	hash *= streamPrime2;
+	hash ^= hash >> 29;
+	hash *= streamPrime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+void Utility::StreamHasher::consume(const std::byte* stripe)
+{
+	for (size_t i{ 0 }; i < m_lanes.size(); ++i)
+		m_lanes[i] = stream_round(m_lanes[i], stream_read64(stripe + i * sizeof(uint64_t)));
+}
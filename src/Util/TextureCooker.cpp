@@ -0,0 +1,109 @@
+#include "Utility/TextureCooker.h"
+#include "stb_image.h"
+#include <cassert>
+#include <fstream>
+#include <stdexcept>
+
+Utility::BlockFormat Utility::TextureCooker::select_format(const Settings& settings)
+{
+	switch (settings.usage) {
+	case TextureUsage::Color:
+		return settings.highQuality ? BlockFormat::BC7 : BlockFormat::BC1;
+	case TextureUsage::ColorAlpha:
+		return settings.highQuality ? BlockFormat::BC7 : BlockFormat::BC3;
+	case TextureUsage::Mask:
+		return BlockFormat::BC4;
+	case TextureUsage::Normal:
+		return BlockFormat::BC5;
+	case TextureUsage::HDR:
+	default:
+		return BlockFormat::BC6H;
+	}
+}
+
+Utility::MipGenerator::Settings Utility::TextureCooker::get_mip_settings(const Settings& settings)
+{
+	const bool color = settings.usage == TextureUsage::Color || settings.usage == TextureUsage::ColorAlpha;
+	return {
+		.filter = settings.mipFilter,
+		.sRGB = color && settings.sRGB,
+		.wrap = false,
+		.preserveAlphaCoverage = settings.usage == TextureUsage::ColorAlpha && settings.preserveAlphaCoverage,
+		.alphaCutoff = settings.alphaCutoff,
+	};
+}
+
+void Utility::TextureCooker::cook(const std::filesystem::path& source, const std::filesystem::path& destination, const Settings& settings)
+{
+	const auto format = select_format(settings);
+	int width, height, channels;
+	std::vector<std::vector<std::byte>> compressed;
+	if (format == BlockFormat::BC6H) {
+		auto* texels = stbi_loadf(source.string().c_str(), &width, &height, &channels, 4);
+		if (!texels)
+			throw std::runtime_error("Could not load image: \"" + source.string() + "\"");
+		const std::span<const float> image{ texels, static_cast<size_t>(width) * height * 4 };
+		if (settings.generateMips) {
+			for (const auto& level : MipGenerator::generate_hdr(image, width, height, get_mip_settings(settings)))
+				compressed.push_back(BlockCompressor::compress_hdr(level.texels, level.width, level.height));
+		}
+		else {
+			compressed.push_back(BlockCompressor::compress_hdr(image, width, height));
+		}
+		stbi_image_free(texels);
+	}
+	else {
+		auto* texels = stbi_load(source.string().c_str(), &width, &height, &channels, 4);
+		if (!texels)
+			throw std::runtime_error("Could not load image: \"" + source.string() + "\"");
+		const std::span<const uint8_t> image{ texels, static_cast<size_t>(width) * height * 4 };
+		if (settings.generateMips) {
+			for (const auto& level : MipGenerator::generate(image, width, height, get_mip_settings(settings)))
+				compressed.push_back(BlockCompressor::compress(format, level.texels, level.width, level.height));
+		}
+		else {
+			compressed.push_back(BlockCompressor::compress(format, image, width, height));
+		}
+		stbi_image_free(texels);
+	}
+	write_dds(destination, format, settings.sRGB, width, height, compressed);
+}
+
+void Utility::TextureCooker::write_dds(const std::filesystem::path& destination, BlockFormat format, bool sRGB, uint32_t width, uint32_t height, std::span<const std::vector<std::byte>> mips)
+{
+	assert(!mips.empty());
+	DDSHeader header{
+		.size = 124u,
+		.flags = DDSHeader::Flags::CAPS | DDSHeader::Flags::HEIGHT | DDSHeader::Flags::WIDTH | DDSHeader::Flags::PIXELFORMAT |
+			DDSHeader::Flags::MIPMAPCOUNT | DDSHeader::Flags::LINEARSIZE,
+		.height = height,
+		.width = width,
+		.linearSize = static_cast<uint32_t>(mips.front().size()),
+		.depth = 1,
+		.mipMapCount = static_cast<uint32_t>(mips.size()),
+		.reserved {},
+		.pixelFormat {
+			.size = 32,
+			.flags = DDSPixelFormat::Flags::DDPF_FOURCC,
+			.fourCC = DDSPixelFormat::FourCC::DX10,
+		},
+		.caps = mips.size() > 1 ? DDSHeader::Caps::TEXTURE | DDSHeader::Caps::COMPLEX | DDSHeader::Caps::MIPMAP : DDSHeader::Caps::TEXTURE,
+	};
+	DDSHeaderDXT10 extHeader{
+		.format = BlockCompressor::get_dxgi_format(format, sRGB),
+		.resourceDimension = DDSHeaderDXT10::RESOURCE_DIMENSION::TEXTURE2D,
+		.miscFlag = DDSHeaderDXT10::MiscFlags::UNKNOWN,
+		.arraySize = 1,
+		.miscFlags2 = DDSHeaderDXT10::MiscFlags2::DDS_ALPHA_MODE_UNKNOWN,
+	};
+	std::ofstream file(destination, std::ios::binary);
+	if (!file.is_open())
+		throw std::runtime_error("Could not open file: \"" + destination.string() + "\"");
+	file.write(reinterpret_cast<const char*>(&DDSMagicNumber), sizeof(DDSMagicNumber));
+	file.write(reinterpret_cast<const char*>(&header), sizeof(DDSHeader));
+	file.write(reinterpret_cast<const char*>(&extHeader), sizeof(DDSHeaderDXT10));
+	for (const auto& mip : mips)
+		file.write(reinterpret_cast<const char*>(mip.data()), mip.size());
+	if (!file)
+		throw std::runtime_error("Could not write file: \"" + destination.string() + "\"");
+}
@@ -10,10 +10,11 @@
 #include "Utility/Exceptions.h"
 #include "QueryPool.hpp"
 
-vulkan::CommandBuffer::CommandBuffer(LogicalDevice& parent, VkCommandBuffer handle, CommandBufferType type, uint32_t threadIdx) :
+vulkan::CommandBuffer::CommandBuffer(LogicalDevice& parent, VkCommandBuffer handle, CommandBufferType type, uint32_t threadIdx, bool secondary) :
 	VulkanObject(parent, handle),
 	m_threadIdx(threadIdx),
-	m_type(type)
+	m_type(type),
+	m_isSecondary(secondary)
 {
 	assert(m_handle);
 	if constexpr (debug) {
@@ -568,6 +569,13 @@ void vulkan::CommandBuffer::clear_depth_image(const Image& image, VkImageLayout
 	vkCmdClearDepthStencilImage(m_handle, image.get_handle(), layout, clearColor, 1, &range);
 }
 
+void vulkan::CommandBuffer::execute_commands(std::span<const VkCommandBuffer> commandBuffers)
+{
+	assert(!m_isSecondary);
+	if (!commandBuffers.empty())
+		vkCmdExecuteCommands(m_handle, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+}
+
 bool vulkan::CommandBuffer::swapchain_touched() const noexcept
 {
 	return m_swapchainTouched;
@@ -636,3 +644,7 @@ void vulkan::CommandBuffer::end_region()
 vulkan::CommandBufferType vulkan::CommandBuffer::get_type() const noexcept {
 	return m_type;
 }
+
+bool vulkan::CommandBuffer::is_secondary() const noexcept {
+	return m_isSecondary;
+}
@@ -4,6 +4,7 @@
 #include <stdexcept>
 
 #include "Utility/Exceptions.h"
+#include "Utility/JobSystem.h"
 
 #include "Allocator.h"
 #include "Pipeline.h"
@@ -37,6 +38,7 @@ vulkan::LogicalDevice::LogicalDevice(const vulkan::Instance& parentInstance,
 	m_transfer(transferFamilyQueueIndex == ~0 ? graphicsFamilyQueueIndex : transferFamilyQueueIndex),
 	m_fenceManager(*this),
 	m_semaphoreManager(*this),
+	m_eventManager(*this),
 	m_shaderStorage(new ShaderStorage(*this)),
 	m_pipelineStorage2(new PipelineStorage2(* this)),
 	m_bindlessPool(*this),
@@ -106,6 +108,8 @@ vulkan::LogicalDevice::LogicalDevice(const vulkan::Instance& parentInstance,
 
 vulkan::LogicalDevice::~LogicalDevice()
 {
+	//The pipeline cache is saved before the storage is destroyed, it may not miss pipelines still compiling
+	m_pipelineStorage2->wait_for_compiles();
 	wait_no_lock();
 	//OPTICK_SHUTDOWN();
 
@@ -257,7 +261,7 @@ void vulkan::LogicalDevice::submit_queue(CommandBufferType type, FenceHandle* fe
 	auto& submissions = get_current_submissions(type);
 	if (submissions.empty()) {
 		if (fence || semaphoreCount)
-			submit_empty(type, fence, semaphoreCount, semaphores);
+			submit_empty(type, fence, semaphoreCount, semaphores, semaphoreValues);
 		return;
 	}
 	//Split commands into pre and post swapchain commands
@@ -649,11 +653,12 @@ vulkan::LogicalDevice::FrameResource& vulkan::LogicalDevice::previous_frame()
 const vulkan::Extensions& vulkan::LogicalDevice::get_supported_extensions() const noexcept {
 	return r_physicalDevice.get_extensions();
 }
+//Threads outside of the job system share index 0 with the main thread
 uint32_t vulkan::LogicalDevice::get_thread_index() const noexcept {
-	return 0;
+	return Utility::JobSystem::get().get_thread_index();
 }
 uint32_t vulkan::LogicalDevice::get_thread_count() const noexcept {
-	return 1;
+	return Utility::JobSystem::get().get_thread_count() + 1;
 }
 const vulkan::PhysicalDevice& vulkan::LogicalDevice::get_physical_device() const noexcept
 {
@@ -760,6 +765,17 @@ VkPipelineCache vulkan::LogicalDevice::get_pipeline_cache() const noexcept {
 		return VK_NULL_HANDLE;
 }
 
+VkPipelineCache vulkan::LogicalDevice::get_thread_pipeline_cache() const noexcept {
+	if (m_pipelineCache)
+		return m_pipelineCache->get_thread_cache(get_thread_index());
+	else
+		return VK_NULL_HANDLE;
+}
+
+bool vulkan::LogicalDevice::is_pipeline_cache_warm() const noexcept {
+	return m_pipelineCache && m_pipelineCache->is_warm();
+}
+
 vulkan::LogicalDevice::ImageBuffer vulkan::LogicalDevice::create_staging_buffer(const ImageInfo& info, InitialImageData* initialData, uint32_t baseMipLevel)
 {
 	uint32_t copyLevels;
@@ -1653,6 +1669,80 @@ vulkan::ImageHandle vulkan::LogicalDevice::create_sparse_image(const ImageInfo&
 	}
 }
 
+//Aliased images are only used by a single queue, concurrent sharing isn't supported
+static VkImageCreateInfo device_aliased_image_create_info(const vulkan::ImageInfo& info)
+{
+	assert(!info.concurrent_queue());
+	assert(!info.generate_mips());
+	assert(!(info.flags & (VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT)));
+	return VkImageCreateInfo{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.flags = info.flags | VK_IMAGE_CREATE_ALIAS_BIT,
+		.imageType = info.type,
+		.format = info.format,
+		.extent {
+			.width = info.width,
+			.height = info.height,
+			.depth = info.depth
+		},
+		.mipLevels = info.mipLevels,
+		.arrayLayers = info.arrayLayers,
+		.samples = info.samples,
+		.tiling = VK_IMAGE_TILING_OPTIMAL,
+		.usage = info.usage,
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		.queueFamilyIndexCount = 0,
+		.pQueueFamilyIndices = nullptr,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+	};
+}
+
+VkMemoryRequirements vulkan::LogicalDevice::get_image_memory_requirements(const ImageInfo& info) const
+{
+	auto createInfo = device_aliased_image_create_info(info);
+	VkDeviceImageMemoryRequirements imageRequirements{
+		.sType = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS,
+		.pNext = nullptr,
+		.pCreateInfo = &createInfo,
+		.planeAspect = static_cast<VkImageAspectFlagBits>(0),
+	};
+	VkMemoryRequirements2 requirements{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+		.pNext = nullptr,
+	};
+	vkGetDeviceImageMemoryRequirements(m_device, &imageRequirements, &requirements);
+	return requirements.memoryRequirements;
+}
+
+vulkan::AllocationHandle vulkan::LogicalDevice::allocate_memory(const VkMemoryRequirements& requirements)
+{
+	VmaAllocationCreateInfo allocCreateInfo{
+		.usage = VMA_MEMORY_USAGE_GPU_ONLY,
+	};
+	VmaAllocation allocation = VK_NULL_HANDLE;
+	if (auto result = vmaAllocateMemory(m_vmaAllocator->get_handle(), &requirements, &allocCreateInfo, &allocation, nullptr); result != VK_SUCCESS) {
+		throw Utility::VulkanException(result);
+	}
+	return m_allocationPool->emplace(*this, allocation);
+}
+
+vulkan::ImageHandle vulkan::LogicalDevice::create_aliased_image(const ImageInfo& info, const AllocationHandle& memory, VkDeviceSize offset)
+{
+	auto createInfo = device_aliased_image_create_info(info);
+	validate_image_create_info(*this, createInfo);
+	VkImage image = VK_NULL_HANDLE;
+	if (auto result = vmaCreateAliasingImage2(m_vmaAllocator->get_handle(), memory->get_handle(), offset, &createInfo, &image); result != VK_SUCCESS) {
+		throw Utility::VulkanException(result);
+	}
+	auto tmp = info;
+	tmp.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	std::vector<AllocationHandle> allocs{ memory };
+	auto handle(m_imagePool->emplace(*this, image, tmp, allocs));
+	handle->set_stage_flags(Image::possible_stages_from_image_usage(createInfo.usage));
+	handle->set_access_flags(Image::possible_access_from_image_usage(createInfo.usage));
+	return handle;
+}
+
 void vulkan::LogicalDevice::downsize_sparse_image(Image& image, uint32_t targetMipLevel)
 {
 	//Always keep mipTail resident
@@ -1704,6 +1794,32 @@ VkSemaphore vulkan::LogicalDevice::request_semaphore()
 	return semaphore;
 }
 
+VkEvent vulkan::LogicalDevice::request_event()
+{
+	auto event = m_eventManager.request_event();
+	frame().recycle_event(event);
+	return event;
+}
+
+VkSemaphore vulkan::LogicalDevice::create_timeline_semaphore(uint64_t initialValue)
+{
+	VkSemaphoreTypeCreateInfo typeCreateInfo{
+		.sType {VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO},
+		.pNext {nullptr},
+		.semaphoreType {VK_SEMAPHORE_TYPE_TIMELINE},
+		.initialValue {initialValue},
+	};
+	VkSemaphoreCreateInfo createInfo{
+		.sType {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO},
+		.pNext {&typeCreateInfo},
+		.flags {0},
+	};
+	VkSemaphore semaphore{ VK_NULL_HANDLE };
+	if (auto result = vkCreateSemaphore(m_device, &createInfo, m_allocator, &semaphore); result != VK_SUCCESS)
+		throw Utility::VulkanException(result);
+	return semaphore;
+}
+
 vulkan::CommandBufferHandle vulkan::LogicalDevice::request_command_buffer(CommandBufferType type)
 {
 	auto cmd = get_pool(type).request_command_buffer();
@@ -1718,6 +1834,34 @@ vulkan::CommandBufferHandle vulkan::LogicalDevice::request_command_buffer(Comman
 	return m_commandBufferPool.emplace(*this, cmd, type, get_thread_index());
 }
 
+vulkan::CommandBuffer vulkan::LogicalDevice::request_secondary_command_buffer(CommandBufferType type, const RenderingCreateInfo* rendering)
+{
+	auto cmd = get_pool(type).request_secondary_command_buffer();
+	VkCommandBufferInheritanceRenderingInfo renderingInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+		.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+	};
+	if (rendering) {
+		renderingInfo.viewMask = rendering->viewMask;
+		renderingInfo.colorAttachmentCount = rendering->colorAttachmentCount;
+		renderingInfo.pColorAttachmentFormats = rendering->colorAttachmentFormats.data();
+		renderingInfo.depthAttachmentFormat = rendering->depthAttachmentFormat;
+		renderingInfo.stencilAttachmentFormat = rendering->stencilAttachmentFormat;
+	}
+	VkCommandBufferInheritanceInfo inheritanceInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+		.pNext = rendering ? &renderingInfo : nullptr,
+	};
+	VkCommandBufferBeginInfo beginInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = static_cast<VkCommandBufferUsageFlags>(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | (rendering ? VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT : 0)),
+		.pInheritanceInfo = &inheritanceInfo,
+	};
+	if (auto result = vkBeginCommandBuffer(cmd, &beginInfo); result != VK_SUCCESS)
+		throw Utility::VulkanException(result);
+	return CommandBuffer{ *this, cmd, type, get_thread_index(), true };
+}
+
 vulkan::Image* vulkan::LogicalDevice::request_render_target(uint32_t width, uint32_t height, VkFormat format, uint32_t index, VkImageUsageFlags usage, VkImageLayout initialLayout, VkSampleCountFlagBits sampleCount, uint32_t arrayLayers)
 {
 	assert(m_attachmentAllocator);
@@ -1890,6 +2034,11 @@ void vulkan::LogicalDevice::FrameResource::recycle_semaphore(VkSemaphore sempaho
 	recycledSemaphores.push_back(sempahore);
 }
 
+void vulkan::LogicalDevice::FrameResource::recycle_event(VkEvent event)
+{
+	recycledEvents.push_back(event);
+}
+
 std::vector<vulkan::CommandBufferHandle>& vulkan::LogicalDevice::FrameResource::get_submissions(CommandBufferType type) noexcept
 {
 	switch (type) {
@@ -2074,6 +2223,11 @@ void vulkan::LogicalDevice::FrameResource::delete_resources()
 	
 	recycledSemaphores.clear();
 
+	for (auto event : recycledEvents)
+		r_device.m_eventManager.recycle_event(event);
+
+	recycledEvents.clear();
+
 	for (auto buffer : deletedBuffer) {
 		vkDestroyBuffer(r_device.get_device(), buffer, r_device.get_allocator());
 	}
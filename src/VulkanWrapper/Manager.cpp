@@ -97,3 +97,45 @@ void vulkan::SemaphoreManager::clear()
 		r_device.destroy_semaphore(semaphore);
 	m_semaphores.clear();
 }
+
+vulkan::EventManager::~EventManager() noexcept
+{
+	clear();
+}
+
+VkEvent vulkan::EventManager::request_event()
+{
+	if (m_events.empty()) {
+		VkEvent event = VK_NULL_HANDLE;
+		VkEventCreateInfo eventCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_EVENT_CREATE_INFO,
+			.flags = 0
+		};
+		if (auto result = vkCreateEvent(r_device.get_device(), &eventCreateInfo, r_device.get_allocator(), &event); result != VK_SUCCESS) {
+			throw Utility::VulkanException(result);
+		}
+		return event;
+	}
+	else {
+		auto event = m_events.back();
+		m_events.pop_back();
+		return event;
+	}
+}
+
+void vulkan::EventManager::recycle_event(VkEvent event)
+{
+	if (event == VK_NULL_HANDLE)
+		return;
+	if (auto result = vkResetEvent(r_device.get_device(), event); result != VK_SUCCESS) {
+		throw Utility::VulkanException(result);
+	}
+	m_events.push_back(event);
+}
+
+void vulkan::EventManager::clear()
+{
+	for (auto event : m_events)
+		vkDestroyEvent(r_device.get_device(), event, r_device.get_allocator());
+	m_events.clear();
+}
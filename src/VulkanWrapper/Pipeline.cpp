@@ -5,6 +5,9 @@
 #include "DescriptorSet.h"
 #include "RayTracePipeline.h"
 #include "Utility/Exceptions.h"
+#include "Utility/JobSystem.h"
+#include "Utility/PipelineCacheFile.h"
+#include <chrono>
 
 vulkan::PipelineLayout2::PipelineLayout2(LogicalDevice& device, const std::vector<VkDescriptorSetLayout>& sets) :
 	VulkanObject(device)
@@ -32,76 +35,150 @@ vulkan::PipelineLayout2::~PipelineLayout2()
 		vkDestroyPipelineLayout(r_device.get_device(), m_handle, r_device.get_allocator());
 }
 
+static Utility::PipelineCacheFile::Identity pipeline_cache_identity(const VkPhysicalDeviceProperties& properties)
+{
+	Utility::PipelineCacheFile::Identity identity{
+		.vendorID {properties.vendorID},
+		.deviceID {properties.deviceID},
+		.driverVersion {properties.driverVersion},
+	};
+	std::copy(std::begin(properties.pipelineCacheUUID), std::end(properties.pipelineCacheUUID), identity.pipelineCacheUUID.begin());
+	return identity;
+}
+
+static constexpr const char* pipeline_cache_status_name(Utility::PipelineCacheFile::Status status)
+{
+	switch (status) {
+	case Utility::PipelineCacheFile::Status::Loaded:
+		return "loaded";
+	case Utility::PipelineCacheFile::Status::Missing:
+		return "missing";
+	case Utility::PipelineCacheFile::Status::Invalid:
+		return "invalid";
+	case Utility::PipelineCacheFile::Status::Mismatch:
+		return "from another device or driver";
+	case Utility::PipelineCacheFile::Status::Corrupt:
+		return "corrupt";
+	}
+	return "unknown";
+}
+
 vulkan::PipelineCache::PipelineCache(LogicalDevice& device, const std::string& path) :
 	VulkanObject(device),
 	m_path(path)
 {
-	size_t size = 0;
-	std::vector<std::byte> data;
-	std::ifstream in(m_path, std::ios::binary);
-	if (in.is_open()) {
-		in.ignore(std::numeric_limits<std::streamsize>::max());
-		std::streamsize length = in.gcount();
-		if (length > 0) {
-			in.clear();   //  Since ignore will have set eof.
-			in.seekg(0, std::ios_base::beg);
-			data.resize(length);
-			in.read(reinterpret_cast<char*>(data.data()), length);
-			in.close();
-			size = length;
-		}
-		else {
-			size = 0;
-		}
-	}
+	const auto start = std::chrono::steady_clock::now();
+	const auto contents = Utility::PipelineCacheFile::read(m_path, pipeline_cache_identity(r_device.get_physical_device_properties()));
+	m_warm = contents.status == Utility::PipelineCacheFile::Status::Loaded;
+	if (!m_warm && contents.status != Utility::PipelineCacheFile::Status::Missing)
+		Utility::log_warning().format("PipelineCache: \"{}\" is {}, starting cold", m_path, pipeline_cache_status_name(contents.status));
+	//Every thread cache starts with the full data, a warm compile hits no matter which worker picks it up
 	VkPipelineCacheCreateInfo createInfo{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
 		.pNext = nullptr,
 		.flags = 0,
-		.initialDataSize = size,
-		.pInitialData = data.data(),
+		.initialDataSize = contents.data.size(),
+		.pInitialData = contents.data.data(),
 	};
-	if (auto result = vkCreatePipelineCache(r_device.get_device(), &createInfo, r_device.get_allocator(), &m_handle); result != VK_SUCCESS) {
-		throw Utility::VulkanException(result);
+	m_threadCaches.resize(r_device.get_thread_count(), VK_NULL_HANDLE);
+	for (auto& cache : m_threadCaches) {
+		if (auto result = vkCreatePipelineCache(r_device.get_device(), &createInfo, r_device.get_allocator(), &cache); result != VK_SUCCESS) {
+			for (auto created : m_threadCaches)
+				if (created != VK_NULL_HANDLE)
+					vkDestroyPipelineCache(r_device.get_device(), created, r_device.get_allocator());
+			throw Utility::VulkanException(result);
+		}
 	}
+	m_handle = m_threadCaches.front();
+	Utility::log().format("PipelineCache: {} start with {} KiB in {:.2f} ms", m_warm ? "Warm" : "Cold", contents.data.size() >> 10,
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
 }
 
 vulkan::PipelineCache::~PipelineCache() noexcept
 {
-	size_t dataSize;
-	VkResult result;
+	try {
+		save();
+	}
+	catch (const std::exception& e) {
+		Utility::log_warning().format("PipelineCache: Couldn't save \"{}\": {}", m_path, e.what());
+	}
+	for (auto cache : m_threadCaches)
+		vkDestroyPipelineCache(r_device.get_device(), cache, r_device.get_allocator());
+}
+
+VkPipelineCache vulkan::PipelineCache::get_thread_cache(uint32_t threadIndex) const noexcept
+{
+	assert(threadIndex < m_threadCaches.size());
+	return m_threadCaches[threadIndex];
+}
+
+bool vulkan::PipelineCache::is_warm() const noexcept
+{
+	return m_warm;
+}
+
+void vulkan::PipelineCache::save()
+{
+	if (m_threadCaches.size() > 1) {
+		if (auto result = vkMergePipelineCaches(r_device.get_device(), m_handle, static_cast<uint32_t>(m_threadCaches.size() - 1), m_threadCaches.data() + 1);
+			result != VK_SUCCESS) {
+			throw Utility::VulkanException(result);
+		}
+	}
+	const auto data = get_data();
+	Utility::PipelineCacheFile::write(m_path, pipeline_cache_identity(r_device.get_physical_device_properties()), data);
+}
+
+std::vector<std::byte> vulkan::PipelineCache::get_data() const
+{
 	std::vector<std::byte> data;
+	VkResult result;
 	do {
-		vkGetPipelineCacheData(r_device.get_device(), m_handle, &dataSize, nullptr);
+		size_t dataSize = 0;
+		if (result = vkGetPipelineCacheData(r_device.get_device(), m_handle, &dataSize, nullptr); result != VK_SUCCESS)
+			throw Utility::VulkanException(result);
 		data.resize(dataSize);
 		result = vkGetPipelineCacheData(r_device.get_device(), m_handle, &dataSize, data.data());
-		if (result == VK_ERROR_OUT_OF_HOST_MEMORY) {
-			vkDestroyPipelineCache(r_device.get_device(), m_handle, r_device.get_allocator());
-			return;
-		}
-		else if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY) {
-			vkDestroyPipelineCache(r_device.get_device(), m_handle, r_device.get_allocator());
-			return;
-		}
-	} while (result != VK_SUCCESS);
-	std::ofstream out(m_path, std::ios::binary);
-	if (out.is_open()) {
-		out.write(reinterpret_cast<char*>(data.data()), dataSize);
-		out.close();
-	}
-	vkDestroyPipelineCache(r_device.get_device(), m_handle, r_device.get_allocator());
+		if (result != VK_SUCCESS && result != VK_INCOMPLETE)
+			throw Utility::VulkanException(result);
+		data.resize(dataSize);
+	} while (result == VK_INCOMPLETE);
+	return data;
 }
 
 vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const GraphicsPipelineConfig& config) :
+	Pipeline2(parent, config.pipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS, config.dynamicState)
+{
+	compile(config, parent.get_thread_pipeline_cache());
+}
+
+vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const ComputePipelineConfig& config) :
+	Pipeline2(parent, config.pipelineLayout, VK_PIPELINE_BIND_POINT_COMPUTE)
+{
+	compile(config, parent.get_thread_pipeline_cache());
+}
+
+vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const RaytracingPipelineConfig& config) :
+	Pipeline2(parent, config.pipelineLayout, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR)
+{
+	compile(config, parent.get_thread_pipeline_cache());
+}
+
+vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, VkPipelineLayout layout, VkPipelineBindPoint type, const DynamicGraphicsPipelineState& dynamicState) :
 	VulkanObject(parent),
-	m_layout(config.pipelineLayout),
-	m_type(VK_PIPELINE_BIND_POINT_GRAPHICS),
-	m_initialDynamicState(config.dynamicState)
+	m_layout(layout),
+	m_type(type),
+	m_initialDynamicState(dynamicState)
 {
+}
+
+void vulkan::Pipeline2::compile(const GraphicsPipelineConfig& config, VkPipelineCache cache)
+{
+	assert(m_handle == VK_NULL_HANDLE);
 
 	std::vector<VkPipelineShaderStageCreateInfo> shaders;
 	for (uint32_t i = 0; i < config.shaderCount; i++)
-		shaders.push_back(parent.get_shader_storage().get_instance(config.shaderInstances[i])->get_stage_info());
+		shaders.push_back(r_device.get_shader_storage().get_instance(config.shaderInstances[i])->get_stage_info());
 
 	for (auto shader1 = shaders.begin(); shader1 != shaders.end(); ++shader1)
 		for (auto shader2 = shader1 + 1; shader2 != shaders.end(); ++shader2)
@@ -313,18 +390,16 @@ vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const GraphicsPipelineConfig
 		.basePipelineIndex = -1
 	};
 
-	if (auto result = vkCreateGraphicsPipelines(parent.get_device(), parent.get_pipeline_cache(), 1, &graphicsPipelineCreateInfo, parent.get_allocator(), &m_handle);
+	if (auto result = vkCreateGraphicsPipelines(r_device.get_device(), cache, 1, &graphicsPipelineCreateInfo, r_device.get_allocator(), &m_handle);
 		result != VK_SUCCESS && result != VK_PIPELINE_COMPILE_REQUIRED_EXT) {
 		throw Utility::VulkanException(result);
 	}
 }
 
 
-vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const ComputePipelineConfig& config) : 
-	VulkanObject(parent),
-	m_layout(config.pipelineLayout),
-	m_type(VK_PIPELINE_BIND_POINT_COMPUTE)
+void vulkan::Pipeline2::compile(const ComputePipelineConfig& config, VkPipelineCache cache)
 {
+	assert(m_handle == VK_NULL_HANDLE);
 
 	assert(m_layout != VK_NULL_HANDLE);
 	assert(config.shaderInstance != invalidShaderId);
@@ -332,7 +407,7 @@ vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const ComputePipelineConfig&
 		.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
 		.pNext = nullptr,
 		.flags = 0, // |VK_PIPELINE_CREATE_DISPATCH_BASE_BIT 
-		.stage = parent.get_shader_storage().get_instance(config.shaderInstance)->get_stage_info(),
+		.stage = r_device.get_shader_storage().get_instance(config.shaderInstance)->get_stage_info(),
 		.layout = m_layout,
 		.basePipelineHandle = VK_NULL_HANDLE,
 		.basePipelineIndex = -1
@@ -350,25 +425,22 @@ vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const ComputePipelineConfig&
 		VK_PIPELINE_CREATE_INDIRECT_BINDABLE_BIT_NV)));
 	assert(createInfo.stage.stage == VK_SHADER_STAGE_COMPUTE_BIT);
 	
-	if (auto result = vkCreateComputePipelines(parent.get_device(), parent.get_pipeline_cache(), 1, &createInfo, parent.get_allocator(), &m_handle);
+	if (auto result = vkCreateComputePipelines(r_device.get_device(), cache, 1, &createInfo, r_device.get_allocator(), &m_handle);
 		result != VK_SUCCESS && result != VK_PIPELINE_COMPILE_REQUIRED_EXT) {
 		throw Utility::VulkanException(result);
 	}
 	
 }
 
-vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const RaytracingPipelineConfig& config) :
-	VulkanObject(parent),
-	m_layout(config.pipelineLayout),
-	m_type(VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR),
-	m_initialDynamicState()
+void vulkan::Pipeline2::compile(const RaytracingPipelineConfig& config, VkPipelineCache cache)
 {
-	const auto& rtFeatures = parent.get_physical_device().get_ray_tracing_pipeline_features();
+	assert(m_handle == VK_NULL_HANDLE);
+	const auto& rtFeatures = r_device.get_physical_device().get_ray_tracing_pipeline_features();
 	if (!rtFeatures.rayTracingPipeline) {
 		Utility::log().location().message("Requested ray tracing pipeline on not supported hardware");
 		throw Utility::FeatureNotSupportedException{};
 	}
-	const auto& rtProperties = parent.get_physical_device().get_ray_tracing_pipeline_properties();
+	const auto& rtProperties = r_device.get_physical_device().get_ray_tracing_pipeline_properties();
 
 
 	std::vector<VkPipelineShaderStageCreateInfo> stageCreateInfos;
@@ -383,7 +455,7 @@ vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const RaytracingPipelineConf
 		assert(group.intersectionShader == invalidShaderId);
 
 		if (!stageMap.contains(group.generalShader)) {
-			auto* instance = parent.get_shader_storage().get_instance(group.generalShader);
+			auto* instance = r_device.get_shader_storage().get_instance(group.generalShader);
 			assert(instance);
 			stageMap.emplace(group.generalShader, static_cast<uint32_t>(stageCreateInfos.size()));
 			const auto& info = stageCreateInfos.emplace_back(instance->get_stage_info());
@@ -410,7 +482,7 @@ vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const RaytracingPipelineConf
 		assert(group.generalShader == invalidShaderId);
 
 		if (!stageMap.contains(group.closestHitShader)) {
-			auto* instance = parent.get_shader_storage().get_instance(group.closestHitShader);
+			auto* instance = r_device.get_shader_storage().get_instance(group.closestHitShader);
 			assert(instance);
 			stageMap.emplace(group.closestHitShader, static_cast<uint32_t>(stageCreateInfos.size()));
 			const auto& info = stageCreateInfos.emplace_back(instance->get_stage_info());
@@ -421,7 +493,7 @@ vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const RaytracingPipelineConf
 			}
 		}
 		if (!stageMap.contains(group.anyHitShader)) {
-			auto* instance = parent.get_shader_storage().get_instance(group.anyHitShader);
+			auto* instance = r_device.get_shader_storage().get_instance(group.anyHitShader);
 			assert(instance);
 			stageMap.emplace(group.anyHitShader, static_cast<uint32_t>(stageCreateInfos.size()));
 			const auto& info = stageCreateInfos.emplace_back(instance->get_stage_info());
@@ -432,7 +504,7 @@ vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const RaytracingPipelineConf
 			}
 		}
 		if (!stageMap.contains(group.intersectionShader)) {
-			auto* instance = parent.get_shader_storage().get_instance(group.intersectionShader);
+			auto* instance = r_device.get_shader_storage().get_instance(group.intersectionShader);
 			assert(instance);
 			stageMap.emplace(group.intersectionShader, static_cast<uint32_t>(stageCreateInfos.size()));
 			const auto& info = stageCreateInfos.emplace_back(instance->get_stage_info());
@@ -464,7 +536,7 @@ vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const RaytracingPipelineConf
 		assert(group.intersectionShader == invalidShaderId);
 
 		if (!stageMap.contains(group.generalShader)) {
-			auto* instance = parent.get_shader_storage().get_instance(group.generalShader);
+			auto* instance = r_device.get_shader_storage().get_instance(group.generalShader);
 			assert(instance);
 			stageMap.emplace(group.generalShader, static_cast<uint32_t>(stageCreateInfos.size()));
 			const auto& info = stageCreateInfos.emplace_back(instance->get_stage_info());
@@ -494,7 +566,7 @@ vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const RaytracingPipelineConf
 		assert(group.intersectionShader == invalidShaderId);
 
 		if (!stageMap.contains(group.generalShader)) {
-			auto* instance = parent.get_shader_storage().get_instance(group.generalShader);
+			auto* instance = r_device.get_shader_storage().get_instance(group.generalShader);
 			assert(instance);
 			stageMap.emplace(group.generalShader, static_cast<uint32_t>(stageCreateInfos.size()));
 			const auto& info = stageCreateInfos.emplace_back(instance->get_stage_info());
@@ -542,7 +614,7 @@ vulkan::Pipeline2::Pipeline2(LogicalDevice& parent, const RaytracingPipelineConf
 		createInfo.maxPipelineRayRecursionDepth = rtProperties.maxRayRecursionDepth;
 	}
 	
-	if (auto result = vkCreateRayTracingPipelinesKHR(parent.get_device(), VK_NULL_HANDLE, parent.get_pipeline_cache(), 1, &createInfo, parent.get_allocator(), &m_handle);
+	if (auto result = vkCreateRayTracingPipelinesKHR(r_device.get_device(), VK_NULL_HANDLE, cache, 1, &createInfo, r_device.get_allocator(), &m_handle);
 		result != VK_SUCCESS && result != VK_PIPELINE_COMPILE_REQUIRED_EXT && result != VK_OPERATION_DEFERRED_KHR && result != VK_OPERATION_NOT_DEFERRED_KHR) {
 		throw Utility::VulkanException(result);
 	}
@@ -565,6 +637,7 @@ vulkan::PipelineStorage2::PipelineStorage2(LogicalDevice& device) :
 
 vulkan::PipelineStorage2::~PipelineStorage2()
 {
+	wait_for_compiles();
 	m_pipelines.for_each([this](Pipeline2& pipeline)
 	{
 		vkDestroyPipeline(r_device.get_device(), pipeline, r_device.get_allocator());
@@ -595,6 +668,105 @@ vulkan::PipelineId vulkan::PipelineStorage2::add_pipeline(const RaytracingPipeli
 	return static_cast<vulkan::PipelineId>(m_pipelines.emplace_intrusive(r_device, config));
 }
 
+vulkan::PipelineFuture vulkan::PipelineStorage2::compile_pipeline(const GraphicsPipelineConfig& config)
+{
+	return compile_pipeline(config, hash(config), VK_PIPELINE_BIND_POINT_GRAPHICS, config.dynamicState);
+}
+
+vulkan::PipelineFuture vulkan::PipelineStorage2::compile_pipeline(const RaytracingPipelineConfig& config)
+{
+	return compile_pipeline(config, hash(config), VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, {});
+}
+
+template<typename Config>
+vulkan::PipelineFuture vulkan::PipelineStorage2::compile_pipeline(const Config& config, Utility::HashValue hash, VkPipelineBindPoint type, const DynamicGraphicsPipelineState& dynamicState)
+{
+	if (auto it = m_compiles.find(hash); it != m_compiles.end())
+		return it->second;
+	const auto id = static_cast<PipelineId>(m_pipelines.emplace_intrusive(r_device, config.pipelineLayout, type, dynamicState));
+	//Buckets never move their elements, the pointer stays valid while other pipelines are added
+	auto* pipeline = m_pipelines.get_ptr(id);
+	auto compile = [this, pipeline, config]() {
+		pipeline->compile(config, r_device.get_thread_pipeline_cache());
+	};
+	return m_compiles.emplace(hash, PipelineFuture{ id, Utility::JobSystem::get().submit(std::move(compile)).share() }).first->second;
+}
+
+void vulkan::PipelineStorage2::wait_for_compiles()
+{
+	for (const auto& [hash, future] : m_compiles)
+		if (future.valid())
+			future.wait();
+}
+
+Utility::HashValue vulkan::PipelineStorage2::hash(const GraphicsPipelineConfig& config)
+{
+	//Only the used part of the arrays, the rest is allowed to be left uninitialized
+	Utility::Hasher hasher;
+	hasher(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	hasher(config.dynamicState);
+	hasher(config.state);
+	hasher(config.renderingCreateInfo.colorAttachmentCount);
+	hasher(config.renderingCreateInfo.viewMask);
+	for (uint32_t i = 0; i < config.renderingCreateInfo.colorAttachmentCount; i++)
+		hasher(config.renderingCreateInfo.colorAttachmentFormats[i]);
+	hasher(config.renderingCreateInfo.depthAttachmentFormat);
+	hasher(config.renderingCreateInfo.stencilAttachmentFormat);
+	hasher(config.vertexInputCount);
+	for (uint32_t i = 0; i < config.vertexInputCount; i++)
+		hasher(config.vertexInputFormats[i]);
+	hasher(config.shaderCount);
+	for (uint32_t i = 0; i < config.shaderCount; i++)
+		hasher(config.shaderInstances[i]);
+	return hasher(config.pipelineLayout);
+}
+
+Utility::HashValue vulkan::PipelineStorage2::hash(const RaytracingPipelineConfig& config)
+{
+	Utility::Hasher hasher;
+	hasher(VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
+	for (const auto* groups : { &config.rgenGroups, &config.hitGroups, &config.missGroups, &config.callableGroups }) {
+		hasher(static_cast<uint32_t>(groups->size()));
+		for (const auto& group : *groups)
+			hasher(group);
+	}
+	hasher(config.recursionDepth);
+	return hasher(config.pipelineLayout);
+}
+
+vulkan::PipelineFuture::PipelineFuture(PipelineId id, std::shared_future<void> future) :
+	m_id(id),
+	m_future(std::move(future))
+{
+}
+
+vulkan::PipelineId vulkan::PipelineFuture::get_id() const noexcept
+{
+	return m_id;
+}
+
+bool vulkan::PipelineFuture::valid() const noexcept
+{
+	return m_id != invalidPipelineId;
+}
+
+bool vulkan::PipelineFuture::ready() const
+{
+	return m_future.valid() && m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+vulkan::PipelineId vulkan::PipelineFuture::get() const
+{
+	assert(m_future.valid());
+	m_future.get();
+	return m_id;
+}
+
+vulkan::PipelineId vulkan::PipelineFuture::get_or(PipelineId placeholder) const
+{
+	return ready() ? m_id : placeholder;
+}
+
 vulkan::PipelineBind::PipelineBind(VkCommandBuffer cmd, VkPipelineLayout layout, VkPipelineBindPoint bindPoint) :
 	m_cmd(cmd),
 	m_layout(layout),
@@ -731,11 +903,22 @@ void vulkan::GraphicsPipelineBind::set_viewport_with_count(uint32_t count, VkVie
 
 void vulkan::GraphicsPipelineBind::bind_vertex_buffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets)
 {
+	assert(firstBinding + bindingCount <= MAX_VERTEX_BINDINGS);
+	if (std::equal(buffers, buffers + bindingCount, m_vertexBuffers.begin() + firstBinding) &&
+		std::equal(offsets, offsets + bindingCount, m_vertexOffsets.begin() + firstBinding))
+		return;
+	std::copy(buffers, buffers + bindingCount, m_vertexBuffers.begin() + firstBinding);
+	std::copy(offsets, offsets + bindingCount, m_vertexOffsets.begin() + firstBinding);
 	vkCmdBindVertexBuffers(m_cmd, firstBinding, bindingCount, buffers, offsets);
 }
 
 void vulkan::GraphicsPipelineBind::bind_index_buffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
 {
+	if (buffer == m_indexBuffer && offset == m_indexOffset && indexType == m_indexType)
+		return;
+	m_indexBuffer = buffer;
+	m_indexOffset = offset;
+	m_indexType = indexType;
 	vkCmdBindIndexBuffer(m_cmd, buffer, offset, indexType);
 }
 
@@ -778,6 +961,7 @@ void vulkan::RaytracingPipelineBind::trace_rays(const VkStridedDeviceAddressRegi
 
 void vulkan::RaytracingPipelineBind::trace_rays(const vulkan::RTPipeline& pipeline, uint32_t width, uint32_t height, uint32_t depth)
 {
+	assert(pipeline.ready());
 	assert(pipeline.rgen_region());
 	assert(pipeline.miss_region());
 	assert(pipeline.hit_region());
@@ -789,6 +973,7 @@ void vulkan::RaytracingPipelineBind::trace_rays(const vulkan::RTPipeline& pipeli
 
 void vulkan::RaytracingPipelineBind::trace_rays(const RTPipeline& pipeline, VkDeviceAddress address)
 {
+	assert(pipeline.ready());
 	assert(pipeline.rgen_region());
 	assert(pipeline.miss_region());
 	assert(pipeline.hit_region());
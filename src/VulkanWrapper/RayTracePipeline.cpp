@@ -5,15 +5,31 @@
 
 vulkan::RTPipeline::RTPipeline(vulkan::LogicalDevice& device, const vulkan::RaytracingPipelineConfig& config) :
 	r_device(device),
-	m_config(),
-	m_rtPipeline(create_pipeline(config)),
-	m_sbt(create_sbt(config))
+	m_config(config),
+	m_rtPipeline(device.get_pipeline_storage().compile_pipeline(config))
 {
 }
 
 vulkan::RTPipeline::operator vulkan::PipelineId() const
 {
-	return m_rtPipeline;
+	return m_rtPipeline.get_id();
+}
+
+bool vulkan::RTPipeline::update()
+{
+	if (m_sbt)
+		return true;
+	if (!m_rtPipeline.ready())
+		return false;
+	//Rethrows compile errors
+	m_rtPipeline.get();
+	m_sbt.emplace(create_sbt(m_config));
+	return true;
+}
+
+bool vulkan::RTPipeline::ready() const noexcept
+{
+	return m_sbt.has_value();
 }
 
 const VkStridedDeviceAddressRegionKHR* vulkan::RTPipeline::rgen_region() const
@@ -33,14 +49,9 @@ const VkStridedDeviceAddressRegionKHR* vulkan::RTPipeline::callable_region() con
 	return &m_callableRegion;
 }
 
-vulkan::PipelineId vulkan::RTPipeline::create_pipeline(const vulkan::RaytracingPipelineConfig& rayConfig)
-{
-	return r_device.get_pipeline_storage().add_pipeline(rayConfig);
-}
-
 vulkan::BufferHandle vulkan::RTPipeline::create_sbt(const vulkan::RaytracingPipelineConfig& rayConfig)
 {
-	auto* pipeline = r_device.get_pipeline_storage().get_pipeline(m_rtPipeline);
+	auto* pipeline = r_device.get_pipeline_storage().get_pipeline(m_rtPipeline.get_id());
 
 	const auto& rtProperties = r_device.get_physical_device().get_ray_tracing_pipeline_properties();
 	auto handleSize{ rtProperties.shaderGroupHandleSize };
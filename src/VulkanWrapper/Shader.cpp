@@ -17,15 +17,24 @@
 #pragma clang diagnostic pop
 #endif
 #include "Utility/Exceptions.h"
+#include <algorithm>
+#include <tuple>
 
 vulkan::Shader::Shader(LogicalDevice& parent, const std::vector<uint32_t>& shaderCode) :
 	VulkanObject(parent, create_module(parent, shaderCode))
 {
-	Utility::VectorHash<uint32_t> hasher;
-	m_hashValue = hasher(shaderCode);
+	m_hashValue = Utility::ShaderReflectionCache::compute_key(shaderCode);
 	parse_shader( shaderCode);
 }
 
+vulkan::Shader::Shader(LogicalDevice& parent, std::span<const uint32_t> shaderCode, Utility::HashValue hash, const Utility::ShaderReflection& reflection) :
+	VulkanObject(parent, create_module(parent, shaderCode)),
+	m_hashValue(hash),
+	m_reflection(reflection)
+{
+	apply_reflection();
+}
+
 vulkan::Shader::~Shader()
 {
 	if(m_handle != VK_NULL_HANDLE)
@@ -129,122 +138,92 @@ static vulkan::Shader::SpecializationConstantId::Type convertType(spirv_cross::S
 }
 
 void vulkan::Shader::parse_shader(const std::vector<uint32_t>& shaderCode)
+{
+	m_reflection = reflect(shaderCode);
+	apply_reflection();
+}
+
+Utility::ShaderReflection vulkan::Shader::reflect(std::span<const uint32_t> shaderCode)
 {
 	using namespace spirv_cross;
-	//bool usesBinding = false;
-	Compiler comp(shaderCode); 
-	m_stage = convert_spriv_execution_model(comp.get_execution_model());
-	if (m_stage == vulkan::ShaderStage::Size)
+	Compiler comp(shaderCode.data(), shaderCode.size());
+	const auto stage = convert_spriv_execution_model(comp.get_execution_model());
+	if (stage == vulkan::ShaderStage::Size)
 		throw std::runtime_error("Unsupported Shadertype");
-	ShaderResources resources = comp.get_shader_resources();
-	
-	if (m_stage == vulkan::ShaderStage::Compute) {
+	Utility::ShaderReflection reflection{
+		.stage {static_cast<uint32_t>(stage)},
+	};
+	auto add_constant = [&](const std::string& name, const spirv_cross::SpecializationConstant& spec) {
+		const auto& constant = comp.get_constant(spec.id);
+		const auto& type = comp.get_type(constant.constant_type);
+		reflection.specializationConstants.push_back({
+			.name {name},
+			.id {spec.constant_id},
+			.type {static_cast<uint32_t>(convertType(type.basetype))},
+		});
+	};
+	if (stage == vulkan::ShaderStage::Compute) {
 		spirv_cross::SpecializationConstant x, y, z;
 		comp.get_work_group_size_specialization_constants(x, y, z);
-		if (x.constant_id != 0 && x.id != 0) {
-			const auto& constant = comp.get_constant(x.id);
-			const auto& type = comp.get_type(constant.constant_type);
-			m_specilizationConstants.emplace("local_size_x", SpecializationConstantId{ convertType(type.basetype), x.constant_id });
-		}
-		if (y.constant_id != 0 && y.id != 0) {
-			const auto& constant = comp.get_constant(y.id);
-			const auto& type = comp.get_type(constant.constant_type);
-			m_specilizationConstants.emplace("local_size_y", SpecializationConstantId{ convertType(type.basetype), y.constant_id });
-		}
-		if (z.constant_id != 0 && z.id != 0) {
-			const auto& constant = comp.get_constant(z.id);
-			const auto& type = comp.get_type(constant.constant_type);
-			m_specilizationConstants.emplace("local_size_z", SpecializationConstantId{ convertType(type.basetype), z.constant_id });
-		}
+		if (x.constant_id != 0 && x.id != 0)
+			add_constant("local_size_x", x);
+		if (y.constant_id != 0 && y.id != 0)
+			add_constant("local_size_y", y);
+		if (z.constant_id != 0 && z.id != 0)
+			add_constant("local_size_z", z);
+		for (uint32_t i = 0; i < reflection.workgroupSize.size(); i++)
+			reflection.workgroupSize[i] = comp.get_execution_mode_argument(spv::ExecutionModeLocalSize, i);
 	}
-	auto specs = comp.get_specialization_constants();
-	for (auto& spec : specs) {
+	for (const auto& spec : comp.get_specialization_constants()) {
 		const auto& name = comp.get_name(spec.id);
-		if (!name.empty()) {
-			const auto& constant = comp.get_constant(spec.id);
-			const auto& type = comp.get_type(constant.constant_type);
-			m_specilizationConstants.emplace(name, SpecializationConstantId{ convertType(type.basetype), spec.constant_id });
-		}
+		if (!name.empty())
+			add_constant(name, spec);
 	}
-	//auto specs = comp.get_specialization_constants();
-	//for (auto spec : specs) {
 
-	//	const auto& val = comp.get_constant(spec.id);
-	//	comp.set_execution_mode()
-	//		auto t = val.constant_type;
-	//	comp.get_name(spec.id);
-	//}
-	//for (auto& uniformBuffer : resources.uniform_buffers) {
-	//	auto [set, binding, type] = get_values(uniformBuffer, comp);
-	//	m_layout.used.set(set);
-	//	m_layout.descriptors[set].descriptors[binding].type = DescriptorType::UniformBuffer;
-	//	array_info(m_layout.descriptors, type, set, binding);
-	//}
-	//for (auto& sampledImage : resources.sampled_images) {
-	//	auto [set, binding, type] = get_values(sampledImage, comp);
-	//	m_layout.used.set(set);
-	//	if (type.image.dim == spv::DimBuffer) {
-	//		m_layout.descriptors[set].descriptors[binding].type = DescriptorType::UniformTexelBuffer;
-	//	}
-	//	else {
-	//		m_layout.descriptors[set].descriptors[binding].type = DescriptorType::CombinedImageSampler;
-	//	}
-	//	array_info(m_layout.descriptors, type, set, binding);
-	//}
-	//for (auto& subpassInput : resources.subpass_inputs) {
-	//	auto [set, binding, type] = get_values(subpassInput, comp);
-	//	m_layout.used.set(set);
-	//	m_layout.descriptors[set].descriptors[binding].type = DescriptorType::InputAttachment;
-	//	array_info(m_layout.descriptors, type, set, binding);
-	//}
-	//for (auto& separateImage : resources.separate_images) {
-	//	auto [set, binding, type] = get_values(separateImage, comp);
-	//	m_layout.used.set(set);
-	//	if (type.image.dim == spv::DimBuffer) {
-	//		m_layout.descriptors[set].descriptors[binding].type = DescriptorType::UniformTexelBuffer;
-	//	}
-	//	else {
-	//		m_layout.descriptors[set].descriptors[binding].type = DescriptorType::SampledImage;
-	//	}
-	//	array_info(m_layout.descriptors, type, set, binding);
-	//}
-	//for (auto& separateSampler : resources.separate_samplers) {
-	//	auto [set, binding, type] = get_values(separateSampler, comp);
-	//	m_layout.used.set(set); 
-	//	m_layout.descriptors[set].descriptors[binding].type = DescriptorType::Sampler;
-	//	array_info(m_layout.descriptors, type, set, binding);
-	//}
-	//for (auto& storageImage : resources.storage_images) {
-	//	auto [set, binding, type] = get_values(storageImage, comp);
-	//	m_layout.used.set(set);
-	//	m_layout.descriptors[set].descriptors[binding].type = DescriptorType::StorageImage;
-	//	array_info(m_layout.descriptors, type, set, binding);
-	//}
-	//for (auto& storageImage : resources.storage_buffers) {
-	//	auto [set, binding, type] = get_values(storageImage, comp);
-	//	m_layout.used.set(set); 
-	//	m_layout.descriptors[set].descriptors[binding].type = DescriptorType::StorageBuffer;
-	//	array_info(m_layout.descriptors, type, set, binding);
-	//}
-	//for (auto& attrib : resources.stage_inputs) {
-	//	if (m_stage == vulkan::ShaderStage::Vertex) {
-	//		auto& type = comp.get_type(attrib.type_id);
-	//		auto location = comp.get_decoration(attrib.id, spv::DecorationLocation);
-	//		assert(type.vecsize <= 255);
-	//		m_layout.attributeElementCounts[location] = static_cast<uint8_t>(type.vecsize);
-	//		m_layout.inputs.set(location);
-	//	}
-	//}
-	//for (auto& attrib : resources.stage_outputs) {
-	//	if (m_stage == vulkan::ShaderStage::Fragment) {
-	//		auto location = comp.get_decoration(attrib.id, spv::DecorationLocation);
-	//		m_layout.outputs.set(location);
-	//	}
-	//}
-	//if (!resources.push_constant_buffers.empty()) {
-	//	m_layout.pushConstantRange.stageFlags |= static_cast<VkShaderStageFlagBits>(1u << static_cast<uint32_t>(m_stage));
-	//	m_layout.pushConstantRange.size =  static_cast<uint32_t>(comp.get_declared_struct_size(comp.get_type(resources.push_constant_buffers.front().base_type_id)));
-	//}
+	ShaderResources resources = comp.get_shader_resources();
+	//Images with DimBuffer are texel buffers
+	auto add_bindings = [&](const SmallVector<Resource>& list, VkDescriptorType descriptorType, VkDescriptorType texelBufferType = VK_DESCRIPTOR_TYPE_MAX_ENUM) {
+		for (const auto& resource : list) {
+			const auto& type = comp.get_type(resource.type_id);
+			const bool texelBuffer = texelBufferType != VK_DESCRIPTOR_TYPE_MAX_ENUM && type.image.dim == spv::DimBuffer;
+			reflection.bindings.push_back({
+				.set {comp.get_decoration(resource.id, spv::DecorationDescriptorSet)},
+				.binding {comp.get_decoration(resource.id, spv::DecorationBinding)},
+				.descriptorType {static_cast<uint32_t>(texelBuffer ? texelBufferType : descriptorType)},
+				.count {type.array.empty() ? 1u : type.array.front()},
+			});
+		}
+	};
+	add_bindings(resources.uniform_buffers, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+	add_bindings(resources.storage_buffers, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+	add_bindings(resources.sampled_images, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+	add_bindings(resources.separate_images, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER);
+	add_bindings(resources.storage_images, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER);
+	add_bindings(resources.separate_samplers, VK_DESCRIPTOR_TYPE_SAMPLER);
+	add_bindings(resources.subpass_inputs, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT);
+	add_bindings(resources.acceleration_structures, VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR);
+	std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const auto& lhs, const auto& rhs) {
+		return std::tie(lhs.set, lhs.binding) < std::tie(rhs.set, rhs.binding);
+	});
+	if (!resources.push_constant_buffers.empty())
+		reflection.pushConstantSize = static_cast<uint32_t>(comp.get_declared_struct_size(comp.get_type(resources.push_constant_buffers.front().base_type_id)));
+	return reflection;
+}
+
+const Utility::ShaderReflection& vulkan::Shader::get_reflection() const noexcept
+{
+	return m_reflection;
+}
+
+void vulkan::Shader::apply_reflection()
+{
+	//Entries of the reflection cache are only as good as the file they were read from
+	if (m_reflection.stage >= NUM_SHADER_STAGES)
+		throw std::runtime_error("Unsupported Shadertype");
+	m_stage = static_cast<ShaderStage>(m_reflection.stage);
+	m_specilizationConstants.clear();
+	for (const auto& constant : m_reflection.specializationConstants)
+		m_specilizationConstants.emplace(constant.name, SpecializationConstantId{ static_cast<SpecializationConstantId::Type>(constant.type), constant.id });
 }
 
 VkPipelineShaderStageCreateInfo vulkan::Shader::get_create_info()
@@ -272,7 +251,7 @@ vulkan::Shader::SpecializationConstantId vulkan::Shader::get_specialization_cons
 	return it->second;
 }
 
-VkShaderModule vulkan::Shader::create_module(LogicalDevice& device, const std::vector<uint32_t>& shaderCode)
+VkShaderModule vulkan::Shader::create_module(LogicalDevice& device, std::span<const uint32_t> shaderCode)
 {
 	VkShaderModule module{VK_NULL_HANDLE};
 	VkShaderModuleCreateInfo createInfo{
@@ -329,6 +308,7 @@ vulkan::ShaderStorage::ShaderStorage(LogicalDevice& device) :
 vulkan::ShaderId vulkan::ShaderStorage::add_instance(ShaderId shaderId) 
 {
 	auto* shader = get_shader(shaderId);
+	std::unique_lock lock(m_instanceMutex);
 	return static_cast<ShaderId>(m_instanceStorage.emplace_intrusive(shader->get_handle()
 		,static_cast<VkShaderStageFlagBits>(1ull << static_cast<uint32_t>(shader->get_stage()))));
 }
@@ -338,6 +318,11 @@ vulkan::ShaderId vulkan::ShaderStorage::add_shader(const std::vector<uint32_t>&
 	return static_cast<ShaderId>(m_shaderStorage.emplace_intrusive(r_device, shaderCode));
 }
 
+vulkan::ShaderId vulkan::ShaderStorage::add_shader(std::span<const uint32_t> shaderCode, Utility::HashValue hash, const Utility::ShaderReflection& reflection)
+{
+	return static_cast<ShaderId>(m_shaderStorage.emplace_intrusive(r_device, shaderCode, hash, reflection));
+}
+
 vulkan::Shader* vulkan::ShaderStorage::get_shader(ShaderId shaderId)
 {
 	return m_shaderStorage.get_ptr(shaderId);
@@ -345,11 +330,13 @@ vulkan::Shader* vulkan::ShaderStorage::get_shader(ShaderId shaderId)
 
 vulkan::ShaderInstance* vulkan::ShaderStorage::get_instance(ShaderId instanceId)
 {
+	std::shared_lock lock(m_instanceMutex);
 	return m_instanceStorage.get_ptr(instanceId);
 }
 
 void vulkan::ShaderStorage::clear()
 {
+	std::unique_lock lock(m_instanceMutex);
 	m_instanceStorage.clear();
 	m_shaderStorage.clear();
 }
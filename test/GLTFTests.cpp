@@ -0,0 +1,447 @@
+#include <gtest/gtest.h>
+#include "GLTFReader/GLTFPrimitiveDecoder.hpp"
+#include "GLTFReader/GLTFImporter.hpp"
+#include "Renderer/SceneAssetCache.h"
+#include "tiny_gltf.h"
+#include <chrono>
+#include <cstring>
+namespace nyan {
+    //Appends the values as a tightly packed buffer view with one accessor
+    template<typename T>
+    static int add_accessor(tinygltf::Model& model, const std::vector<T>& values, int componentType, int type, size_t count, bool normalized = false) {
+        tinygltf::Buffer buffer;
+        buffer.data.resize(values.size() * sizeof(T));
+        std::memcpy(buffer.data.data(), values.data(), buffer.data.size());
+        model.buffers.push_back(std::move(buffer));
+        tinygltf::BufferView bufferView;
+        bufferView.buffer = static_cast<int>(model.buffers.size() - 1);
+        bufferView.byteLength = model.buffers.back().data.size();
+        model.bufferViews.push_back(bufferView);
+        tinygltf::Accessor accessor;
+        accessor.bufferView = static_cast<int>(model.bufferViews.size() - 1);
+        accessor.byteOffset = 0;
+        accessor.componentType = componentType;
+        accessor.type = type;
+        accessor.count = count;
+        accessor.normalized = normalized;
+        model.accessors.push_back(accessor);
+        return static_cast<int>(model.accessors.size() - 1);
+    }
+    static tinygltf::Primitive add_grid_primitive(tinygltf::Model& model, uint32_t width, uint32_t height, float offset) {
+        std::vector<float> positions, normals, tangents, uvs;
+        std::vector<uint32_t> indices;
+        for (uint32_t y = 0; y <= height; y++) {
+            for (uint32_t x = 0; x <= width; x++) {
+                positions.insert(positions.end(), { static_cast<float>(x) + offset, 0.f, static_cast<float>(y) });
+                normals.insert(normals.end(), { 0.f, 1.f, 0.f });
+                tangents.insert(tangents.end(), { 1.f, 0.f, 0.f, 1.f });
+                uvs.insert(uvs.end(), { static_cast<float>(x) / width, static_cast<float>(y) / height });
+            }
+        }
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                uint32_t v0 = y * (width + 1) + x;
+                uint32_t v2 = v0 + width + 1;
+                indices.insert(indices.end(), { v0, v2, v0 + 1, v0 + 1, v2, v2 + 1 });
+            }
+        }
+        const size_t vertexCount = positions.size() / 3;
+        tinygltf::Primitive primitive;
+        primitive.mode = TINYGLTF_MODE_TRIANGLES;
+        primitive.attributes["POSITION"] = add_accessor(model, positions, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3, vertexCount);
+        primitive.attributes["NORMAL"] = add_accessor(model, normals, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3, vertexCount);
+        primitive.attributes["TANGENT"] = add_accessor(model, tangents, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC4, vertexCount);
+        primitive.attributes["TEXCOORD_0"] = add_accessor(model, uvs, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC2, vertexCount);
+        primitive.indices = add_accessor(model, indices, TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, TINYGLTF_TYPE_SCALAR, indices.size());
+        return primitive;
+    }
+    TEST(GLTFDecoder, Indices) {
+        tinygltf::Model model;
+        std::vector<uint8_t> bytes{ 0, 1, 2, 255 };
+        std::vector<uint16_t> shorts{ 0, 1, 2, 65535 };
+        std::vector<uint32_t> ints{ 0, 1, 2, 100000 };
+        auto byteAccessor = add_accessor(model, bytes, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, TINYGLTF_TYPE_SCALAR, bytes.size());
+        auto shortAccessor = add_accessor(model, shorts, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, TINYGLTF_TYPE_SCALAR, shorts.size());
+        auto intAccessor = add_accessor(model, ints, TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, TINYGLTF_TYPE_SCALAR, ints.size());
+        std::vector<uint32_t> indices;
+        GLTFPrimitiveDecoder::decode_indices(model, model.accessors[byteAccessor], indices);
+        EXPECT_EQ(indices, (std::vector<uint32_t>{ 0, 1, 2, 255 }));
+        GLTFPrimitiveDecoder::decode_indices(model, model.accessors[shortAccessor], indices);
+        EXPECT_EQ(indices, (std::vector<uint32_t>{ 0, 1, 2, 65535 }));
+        GLTFPrimitiveDecoder::decode_indices(model, model.accessors[intAccessor], indices);
+        EXPECT_EQ(indices, ints);
+    }
+    TEST(GLTFDecoder, Interleaved) {
+        //Position, normal and uv interleaved with a 32 byte stride, the accessors start at an offset into the view
+        struct Vertex {
+            float position[3];
+            float normal[3];
+            float uv[2];
+        };
+        std::vector<Vertex> vertices;
+        for (int i = 0; i < 100; i++)
+            vertices.push_back(Vertex{ { i * 1.f, i * 2.f, i * 3.f }, { 0.f, 0.f, 1.f }, { i * 0.01f, 1.f - i * 0.01f } });
+        tinygltf::Model model;
+        tinygltf::Buffer buffer;
+        buffer.data.resize(vertices.size() * sizeof(Vertex));
+        std::memcpy(buffer.data.data(), vertices.data(), buffer.data.size());
+        model.buffers.push_back(std::move(buffer));
+        tinygltf::BufferView bufferView;
+        bufferView.buffer = 0;
+        bufferView.byteLength = model.buffers[0].data.size();
+        bufferView.byteStride = sizeof(Vertex);
+        model.bufferViews.push_back(bufferView);
+        for (auto [offset, type] : { std::pair{ offsetof(Vertex, position), TINYGLTF_TYPE_VEC3 }, std::pair{ offsetof(Vertex, normal), TINYGLTF_TYPE_VEC3 }, std::pair{ offsetof(Vertex, uv), TINYGLTF_TYPE_VEC2 } }) {
+            tinygltf::Accessor accessor;
+            accessor.bufferView = 0;
+            accessor.byteOffset = offset;
+            accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+            accessor.type = type;
+            accessor.count = vertices.size();
+            accessor.normalized = false;
+            model.accessors.push_back(accessor);
+        }
+        std::vector<Math::vec3> positions;
+        std::vector<Math::hvec3> normals;
+        std::vector<Math::hvec2> uvs;
+        GLTFPrimitiveDecoder::decode_positions(model, model.accessors[0], positions);
+        GLTFPrimitiveDecoder::decode_normals(model, model.accessors[1], normals);
+        GLTFPrimitiveDecoder::decode_uvs(model, model.accessors[2], uvs);
+        ASSERT_EQ(positions.size(), vertices.size());
+        ASSERT_EQ(normals.size(), vertices.size());
+        ASSERT_EQ(uvs.size(), vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            for (size_t j = 0; j < 3; j++) {
+                EXPECT_EQ(positions[i][j], vertices[i].position[j]);
+                EXPECT_EQ(static_cast<float>(normals[i][j]), vertices[i].normal[j]);
+            }
+            for (size_t j = 0; j < 2; j++)
+                EXPECT_NEAR(static_cast<float>(uvs[i][j]), vertices[i].uv[j], 1e-3f);
+        }
+    }
+    TEST(GLTFDecoder, ComponentTypes) {
+        tinygltf::Model model;
+        std::vector<double> doublePositions{ 1.0, -2.0, 3.5 };
+        std::vector<int16_t> shortNormals{ 0, -32768, 32767 };
+        std::vector<int8_t> byteTangents{ 127, 0, -127, -128 };
+        std::vector<uint8_t> byteUvs{ 255, 0 };
+        std::vector<uint16_t> shortUvs{ 3, 7 };
+        auto positionAccessor = add_accessor(model, doublePositions, TINYGLTF_COMPONENT_TYPE_DOUBLE, TINYGLTF_TYPE_VEC3, 1);
+        auto normalAccessor = add_accessor(model, shortNormals, TINYGLTF_COMPONENT_TYPE_SHORT, TINYGLTF_TYPE_VEC3, 1, true);
+        auto tangentAccessor = add_accessor(model, byteTangents, TINYGLTF_COMPONENT_TYPE_BYTE, TINYGLTF_TYPE_VEC4, 1, true);
+        auto normalizedUvAccessor = add_accessor(model, byteUvs, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, TINYGLTF_TYPE_VEC2, 1, true);
+        auto uvAccessor = add_accessor(model, shortUvs, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, TINYGLTF_TYPE_VEC2, 1, false);
+        std::vector<Math::vec3> positions;
+        std::vector<Math::hvec3> normals;
+        std::vector<Math::hvec4> tangents;
+        std::vector<Math::hvec2> uvs;
+        GLTFPrimitiveDecoder::decode_positions(model, model.accessors[positionAccessor], positions);
+        EXPECT_EQ(positions[0], (Math::vec3{ 1.f, -2.f, 3.5f }));
+        GLTFPrimitiveDecoder::decode_normals(model, model.accessors[normalAccessor], normals);
+        EXPECT_EQ(static_cast<float>(normals[0][0]), 0.f);
+        EXPECT_EQ(static_cast<float>(normals[0][1]), -1.f);
+        EXPECT_EQ(static_cast<float>(normals[0][2]), 1.f);
+        GLTFPrimitiveDecoder::decode_tangents(model, model.accessors[tangentAccessor], tangents);
+        EXPECT_EQ(static_cast<float>(tangents[0][0]), 1.f);
+        EXPECT_EQ(static_cast<float>(tangents[0][2]), -1.f);
+        EXPECT_EQ(static_cast<float>(tangents[0][3]), -1.f);
+        GLTFPrimitiveDecoder::decode_uvs(model, model.accessors[normalizedUvAccessor], uvs);
+        EXPECT_EQ(static_cast<float>(uvs[0][0]), 1.f);
+        EXPECT_EQ(static_cast<float>(uvs[0][1]), 0.f);
+        GLTFPrimitiveDecoder::decode_uvs(model, model.accessors[uvAccessor], uvs);
+        EXPECT_EQ(static_cast<float>(uvs[0][0]), 3.f);
+        EXPECT_EQ(static_cast<float>(uvs[0][1]), 7.f);
+    }
+    TEST(GLTFDecoder, MeshOrder) {
+        tinygltf::Model model;
+        for (int meshIdx = 0; meshIdx < 8; meshIdx++) {
+            tinygltf::Mesh mesh;
+            if (meshIdx % 2)
+                mesh.name = "Named_" + std::to_string(meshIdx);
+            for (int primitiveIdx = 0; primitiveIdx <= meshIdx % 3; primitiveIdx++)
+                mesh.primitives.push_back(add_grid_primitive(model, 4 + meshIdx, 4 + primitiveIdx, meshIdx * 100.f));
+            model.meshes.push_back(std::move(mesh));
+        }
+        auto primitives = GLTFPrimitiveDecoder::decode_meshes(model);
+        size_t i = 0;
+        for (size_t meshIdx = 0; meshIdx < model.meshes.size(); meshIdx++) {
+            for (size_t primitiveIdx = 0; primitiveIdx < model.meshes[meshIdx].primitives.size(); primitiveIdx++, i++) {
+                ASSERT_LT(i, primitives.size());
+                const auto& primitive = primitives[i];
+                EXPECT_EQ(primitive.meshIdx, meshIdx);
+                EXPECT_EQ(primitive.primitiveIdx, primitiveIdx);
+                std::string meshName = (meshIdx % 2) ? "Named_" + std::to_string(meshIdx) : "Mesh_" + std::to_string(meshIdx);
+                EXPECT_EQ(primitive.mesh.name, meshName + "_Primitive_" + std::to_string(primitiveIdx));
+                auto reference = GLTFPrimitiveDecoder::decode_primitive(model, model.meshes[meshIdx].primitives[primitiveIdx], primitive.mesh.name);
+                EXPECT_EQ(primitive.mesh.indices, reference.indices);
+                ASSERT_EQ(primitive.mesh.positions.size(), (5 + meshIdx) * (5 + primitiveIdx));
+                EXPECT_EQ(primitive.mesh.positions[0][0], meshIdx * 100.f);
+                EXPECT_EQ(primitive.mesh.normals.size(), primitive.mesh.positions.size());
+                EXPECT_EQ(primitive.mesh.tangents.size(), primitive.mesh.positions.size());
+                EXPECT_EQ(primitive.mesh.uvs0.size(), primitive.mesh.positions.size());
+            }
+        }
+        EXPECT_EQ(i, primitives.size());
+    }
+    TEST(GLTFDecoder, LargeModelPerf) {
+        tinygltf::Model model;
+        for (int meshIdx = 0; meshIdx < 32; meshIdx++) {
+            tinygltf::Mesh mesh;
+            for (int primitiveIdx = 0; primitiveIdx < 2; primitiveIdx++)
+                mesh.primitives.push_back(add_grid_primitive(model, 127, 127, static_cast<float>(meshIdx)));
+            model.meshes.push_back(std::move(mesh));
+        }
+        auto start = std::chrono::steady_clock::now();
+        auto primitives = GLTFPrimitiveDecoder::decode_meshes(model);
+        auto end = std::chrono::steady_clock::now();
+        size_t vertexCount = 0;
+        for (const auto& primitive : primitives)
+            vertexCount += primitive.mesh.positions.size();
+        //std::cout << "Decoding " << primitives.size() << " primitives with " << vertexCount << " vertices took: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms\n";
+        EXPECT_EQ(primitives.size(), 64);
+        EXPECT_EQ(vertexCount, 64 * 128 * 128);
+    }
+    TEST(GLTFImporter, Materials) {
+        tinygltf::Model model;
+        tinygltf::Image file;
+        file.uri = "albedo.png";
+        model.images.push_back(file);
+        tinygltf::Image embedded;
+        embedded.name = "embedded";
+        embedded.width = 2;
+        embedded.height = 2;
+        embedded.component = 4;
+        embedded.bits = 8;
+        embedded.image.resize(16, 255);
+        model.images.push_back(embedded);
+        for (int source : { 0, -1, 1 }) {
+            tinygltf::Texture texture;
+            texture.source = source;
+            model.textures.push_back(texture);
+        }
+        tinygltf::Material opaque;
+        opaque.name = "Opaque";
+        opaque.pbrMetallicRoughness.baseColorTexture.index = 0;
+        opaque.normalTexture.index = 2;
+        model.materials.push_back(opaque);
+        tinygltf::Material masked;
+        masked.alphaMode = "MASK";
+        masked.doubleSided = true;
+        model.materials.push_back(masked);
+        tinygltf::Mesh mesh;
+        for (int material : { 0, 1, -1 }) {
+            auto primitive = add_grid_primitive(model, 4, 4, 0.f);
+            primitive.material = material;
+            mesh.primitives.push_back(primitive);
+        }
+        model.meshes.push_back(std::move(mesh));
+
+        auto asset = GLTFImporter::import_model(model, "textures");
+        ASSERT_EQ(asset.textures.size(), 2);
+        EXPECT_FALSE(asset.textures[0].is_embedded());
+        EXPECT_EQ(asset.textures[0].name, "albedo.png");
+        EXPECT_EQ(asset.textures[0].file, std::filesystem::path("textures") / "albedo.png");
+        EXPECT_TRUE(asset.textures[1].is_embedded());
+        EXPECT_EQ(asset.textures[1].name, "embedded");
+        EXPECT_EQ(asset.textures[1].data.size(), 16);
+        ASSERT_EQ(asset.materials.size(), 2);
+        EXPECT_EQ(asset.materials[0].name, "Opaque");
+        EXPECT_EQ(asset.materials[0].albedoTex, "albedo.png");
+        EXPECT_EQ(asset.materials[0].normalTex, "embedded");
+        EXPECT_EQ(asset.materials[0].emissiveTex, "");
+        EXPECT_EQ(asset.materials[1].name, "Material_1");
+        EXPECT_EQ(asset.materials[1].alphaMode, AlphaMode::AlphaTest);
+        EXPECT_TRUE(asset.materials[1].doubleSided);
+        ASSERT_EQ(asset.primitives.size(), 3);
+        EXPECT_EQ(asset.primitives[0].material, 0);
+        EXPECT_EQ(asset.primitives[0].mesh.type, Mesh::RenderType::Opaque);
+        EXPECT_EQ(asset.primitives[1].material, 1);
+        EXPECT_EQ(asset.primitives[1].mesh.type, Mesh::RenderType::AlphaTest);
+        EXPECT_EQ(asset.primitives[2].material, -1);
+        EXPECT_EQ(asset.primitives[2].mesh.materialBinding, shaders::INVALID_BINDING);
+        ASSERT_EQ(asset.meshes.size(), 1);
+        EXPECT_EQ(asset.meshes[0].name, "Mesh_0");
+        EXPECT_EQ(asset.meshes[0].primitives, (std::vector<uint32_t>{ 0, 1, 2 }));
+    }
+    TEST(GLTFImporter, Hierarchy) {
+        tinygltf::Model model;
+        tinygltf::Mesh mesh;
+        mesh.name = "Grid";
+        mesh.primitives.push_back(add_grid_primitive(model, 4, 4, 0.f));
+        model.meshes.push_back(std::move(mesh));
+        tinygltf::Light light;
+        light.type = "point";
+        light.color = { 1.0, 0.5, 0.25 };
+        light.intensity = 10.0;
+        model.lights.push_back(light);
+
+        tinygltf::Node root;
+        root.name = "Root";
+        root.translation = { 1.0, 2.0, 3.0 };
+        root.scale = { 2.0, 2.0, 2.0 };
+        root.children = { 1, 2 };
+        model.nodes.push_back(root);
+        tinygltf::Node meshNode;
+        meshNode.mesh = 0;
+        meshNode.matrix = { 3.0, 0.0, 0.0, 0.0,
+                            0.0, 3.0, 0.0, 0.0,
+                            0.0, 0.0, 3.0, 0.0,
+                            4.0, 5.0, 6.0, 1.0 };
+        model.nodes.push_back(meshNode);
+        tinygltf::Node lightNode;
+        tinygltf::Value::Object lightExtension{ { "light", tinygltf::Value(0) } };
+        lightNode.extensions["KHR_lights_punctual"] = tinygltf::Value(lightExtension);
+        model.nodes.push_back(lightNode);
+        tinygltf::Scene scene;
+        scene.name = "Scene";
+        scene.nodes = { 0 };
+        model.scenes.push_back(scene);
+
+        auto asset = GLTFImporter::import_model(model);
+        ASSERT_EQ(asset.scenes.size(), 1);
+        EXPECT_EQ(asset.scenes[0].name, "Scene");
+        EXPECT_EQ(asset.scenes[0].nodes, (std::vector<uint32_t>{ 0 }));
+        ASSERT_EQ(asset.nodes.size(), 3);
+        EXPECT_EQ(asset.nodes[0].name, "Root");
+        EXPECT_EQ(asset.nodes[0].children, (std::vector<uint32_t>{ 1, 2 }));
+        EXPECT_EQ(asset.nodes[0].mesh, -1);
+        EXPECT_EQ(asset.nodes[0].transform.position[2], 3.f);
+        EXPECT_EQ(asset.nodes[0].transform.scale[0], 2.f);
+        EXPECT_FALSE(asset.nodes[0].light);
+        EXPECT_EQ(asset.nodes[1].mesh, 0);
+        EXPECT_FLOAT_EQ(asset.nodes[1].transform.position[0], 4.f);
+        EXPECT_FLOAT_EQ(asset.nodes[1].transform.scale[1], 3.f);
+        EXPECT_NEAR(asset.nodes[1].transform.orientation[2], 0.f, 1e-5f);
+        ASSERT_TRUE(asset.nodes[2].light);
+        EXPECT_FLOAT_EQ(asset.nodes[2].light->color[1], 0.5f);
+        EXPECT_FLOAT_EQ(asset.nodes[2].light->intensity, 10.f);
+        EXPECT_FLOAT_EQ(asset.nodes[2].light->attenuation, 1e8f);
+        EXPECT_EQ(asset.meshes[0].name, "Grid");
+    }
+    TEST(GLTFImporter, Lods) {
+        tinygltf::Model model;
+        tinygltf::Mesh mesh;
+        mesh.primitives.push_back(add_grid_primitive(model, 64, 64, 0.f));
+        mesh.primitives.push_back(add_grid_primitive(model, 8, 8, 0.f));
+        model.meshes.push_back(std::move(mesh));
+        auto asset = GLTFImporter::import_model(model);
+        ASSERT_EQ(asset.primitives.size(), 2);
+        const auto& detailed = asset.primitives[0];
+        ASSERT_FALSE(detailed.lods.empty());
+        ASSERT_EQ(detailed.lods.size(), detailed.lodErrors.size());
+        size_t previousIndexCount = detailed.mesh.index_count();
+        for (const auto& lod : detailed.lods) {
+            EXPECT_LT(lod.index_count(), previousIndexCount);
+            previousIndexCount = lod.index_count();
+        }
+        EXPECT_TRUE(asset.primitives[1].lods.empty());
+        EXPECT_TRUE(detailed.mesh.uses_short_indices());
+        EXPECT_GT(asset.quantizationStatistics.sourceBytes, asset.quantizationStatistics.quantizedBytes);
+        EXPECT_GT(asset.quantizationStatistics.ratio, 0.f);
+        EXPECT_LT(asset.quantizationStatistics.ratio, 1.f);
+    }
+    static tinygltf::Model create_cache_test_model() {
+        tinygltf::Model model;
+        tinygltf::Image file;
+        file.uri = "albedo.png";
+        model.images.push_back(file);
+        tinygltf::Texture texture;
+        texture.source = 0;
+        model.textures.push_back(texture);
+        tinygltf::Material material;
+        material.name = "Material";
+        material.pbrMetallicRoughness.baseColorTexture.index = 0;
+        model.materials.push_back(material);
+        tinygltf::Mesh mesh;
+        mesh.name = "Grid";
+        mesh.primitives.push_back(add_grid_primitive(model, 64, 64, 0.f));
+        mesh.primitives.back().material = 0;
+        model.meshes.push_back(std::move(mesh));
+        tinygltf::Light light;
+        light.type = "point";
+        light.color = { 1.0, 0.5, 0.25 };
+        model.lights.push_back(light);
+        tinygltf::Node meshNode;
+        meshNode.mesh = 0;
+        meshNode.translation = { 1.0, 2.0, 3.0 };
+        model.nodes.push_back(meshNode);
+        tinygltf::Node lightNode;
+        tinygltf::Value::Object lightExtension{ { "light", tinygltf::Value(0) } };
+        lightNode.extensions["KHR_lights_punctual"] = tinygltf::Value(lightExtension);
+        model.nodes.push_back(lightNode);
+        tinygltf::Scene scene;
+        scene.nodes = { 0, 1 };
+        model.scenes.push_back(scene);
+        return model;
+    }
+    TEST(SceneAssetCache, Serialization) {
+        const auto asset = GLTFImporter::import_model(create_cache_test_model(), "textures", "cached.glb");
+        ASSERT_FALSE(asset.primitives[0].lods.empty());
+        const auto data = SceneAssetCache::serialize(asset, 42);
+        auto loaded = SceneAssetCache::deserialize(data, 42);
+        ASSERT_TRUE(loaded);
+        EXPECT_EQ(SceneAssetCache::serialize(*loaded, 42), data);
+        EXPECT_EQ(loaded->name, "cached.glb");
+        EXPECT_EQ(loaded->textures[0].file, std::filesystem::path("textures") / "albedo.png");
+        EXPECT_EQ(loaded->materials[0].albedoTex, "albedo.png");
+        EXPECT_EQ(loaded->primitives[0].mesh.positions.size(), asset.primitives[0].mesh.positions.size());
+        EXPECT_EQ(loaded->primitives[0].lods.size(), asset.primitives[0].lods.size());
+        EXPECT_EQ(loaded->primitives[0].lodErrors, asset.primitives[0].lodErrors);
+        ASSERT_TRUE(loaded->nodes[1].light);
+        EXPECT_FLOAT_EQ(loaded->nodes[1].light->color[1], 0.5f);
+        EXPECT_FLOAT_EQ(loaded->nodes[0].transform.position[2], 3.f);
+        //Other sources, truncated and corrupted files miss
+        EXPECT_FALSE(SceneAssetCache::deserialize(data, 43));
+        for (size_t size : { size_t{ 0 }, size_t{ 8 }, data.size() / 2, data.size() - 1 })
+            EXPECT_FALSE(SceneAssetCache::deserialize(std::span(data).first(size), 42)) << size;
+        auto corrupt = data;
+        corrupt[corrupt.size() / 2] ^= std::byte{ 1 };
+        EXPECT_FALSE(SceneAssetCache::deserialize(corrupt, 42));
+    }
+    TEST(SceneAssetCache, ImportFile) {
+        const auto directory = std::filesystem::temp_directory_path() / "nyan_scene_cache_tests";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        auto model = create_cache_test_model();
+        //The image file doesn't exist, only the geometry matters here
+        model.images.clear();
+        model.textures.clear();
+        model.materials[0].pbrMetallicRoughness.baseColorTexture.index = -1;
+        const auto path = directory / "scene.glb";
+        tinygltf::TinyGLTF writer;
+        ASSERT_TRUE(writer.WriteGltfSceneToFile(&model, path.string(), false, true, false, true));
+        const auto cacheDirectory = directory / "cache";
+        auto imported = GLTFImporter::import_file(path, cacheDirectory);
+        ASSERT_TRUE(imported);
+        ASSERT_EQ(std::distance(std::filesystem::directory_iterator(cacheDirectory), std::filesystem::directory_iterator{}), 1);
+        const auto cacheFile = std::filesystem::directory_iterator(cacheDirectory)->path();
+        const auto cachedTime = std::filesystem::last_write_time(cacheFile);
+        //Served from the cache, nothing is written again
+        auto cached = GLTFImporter::import_file(path, cacheDirectory);
+        ASSERT_TRUE(cached);
+        EXPECT_EQ(std::filesystem::last_write_time(cacheFile), cachedTime);
+        EXPECT_EQ(SceneAssetCache::serialize(*cached, 0), SceneAssetCache::serialize(*imported, 0));
+        //An edited source gets its own entry
+        model.nodes[0].translation = { 4.0, 2.0, 3.0 };
+        ASSERT_TRUE(writer.WriteGltfSceneToFile(&model, path.string(), false, true, false, true));
+        auto edited = GLTFImporter::import_file(path, cacheDirectory);
+        ASSERT_TRUE(edited);
+        EXPECT_FLOAT_EQ(edited->nodes[0].transform.position[0], 4.f);
+        EXPECT_EQ(std::distance(std::filesystem::directory_iterator(cacheDirectory), std::filesystem::directory_iterator{}), 2);
+        std::filesystem::remove_all(directory);
+    }
+    TEST(GLTFImporter, ImportPerf) {
+        tinygltf::Model model;
+        for (int meshIdx = 0; meshIdx < 16; meshIdx++) {
+            tinygltf::Mesh mesh;
+            mesh.primitives.push_back(add_grid_primitive(model, 63, 63, static_cast<float>(meshIdx)));
+            model.meshes.push_back(std::move(mesh));
+        }
+        auto start = std::chrono::steady_clock::now();
+        auto asset = GLTFImporter::import_model(model);
+        auto end = std::chrono::steady_clock::now();
+        //std::cout << "Importing " << asset.primitives.size() << " primitives took: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms\n";
+        EXPECT_EQ(asset.primitives.size(), 16);
+        EXPECT_EQ(asset.meshes.size(), 16);
+    }
+}
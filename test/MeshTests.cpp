@@ -0,0 +1,839 @@
+#include <gtest/gtest.h>
+#include "Renderer/Bounds.h"
+#include "Renderer/MeshOptimizer.h"
+#include "Renderer/MeshletBuilder.h"
+#include "Renderer/MeshSimplifier.h"
+#include "Renderer/MeshQuantizer.h"
+#include "Renderer/MeshGeometryCache.h"
+#include "Renderer/TangentGenerator.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <random>
+namespace nyan {
+    static nyan::Mesh generate_grid(uint32_t width, uint32_t height) {
+        nyan::Mesh mesh{ .name {"Grid"} };
+        for (uint32_t y = 0; y <= height; y++) {
+            for (uint32_t x = 0; x <= width; x++) {
+                mesh.positions.emplace_back(static_cast<float>(x), 0.f, static_cast<float>(y));
+                mesh.uvs0.emplace_back(static_cast<float>(x) / width, static_cast<float>(y) / height);
+                mesh.normals.emplace_back(0.f, 1.f, 0.f);
+                mesh.tangents.emplace_back(1.f, 0.f, 0.f, 1.f);
+            }
+        }
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                uint32_t v0 = y * (width + 1) + x;
+                uint32_t v1 = v0 + 1;
+                uint32_t v2 = v0 + width + 1;
+                uint32_t v3 = v2 + 1;
+                mesh.indices.insert(mesh.indices.end(), { v0, v2, v1, v1, v2, v3 });
+            }
+        }
+        return mesh;
+    }
+    static void shuffle_triangles(nyan::Mesh& mesh, uint32_t seed = 0) {
+        std::vector<std::array<uint32_t, 3>> triangles(mesh.indices.size() / 3);
+        for (size_t i = 0; i < triangles.size(); i++)
+            triangles[i] = { mesh.indices[i * 3], mesh.indices[i * 3 + 1], mesh.indices[i * 3 + 2] };
+        std::shuffle(triangles.begin(), triangles.end(), std::default_random_engine{ seed });
+        for (size_t i = 0; i < triangles.size(); i++)
+            std::copy(triangles[i].begin(), triangles[i].end(), mesh.indices.begin() + i * 3);
+    }
+    //Triangles as sorted, rotation normalized position triples, independent of index and vertex order
+    static std::vector<std::array<float, 9>> canonical_triangles(const nyan::Mesh& mesh) {
+        std::vector<std::array<float, 9>> triangles;
+        for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+            std::array<std::array<float, 3>, 3> corners;
+            for (size_t j = 0; j < 3; j++) {
+                const auto& p = mesh.positions[mesh.indices[i + j]];
+                corners[j] = { p[0], p[1], p[2] };
+            }
+            auto first = std::min_element(corners.begin(), corners.end()) - corners.begin();
+            std::array<float, 9> triangle;
+            for (size_t j = 0; j < 3; j++)
+                std::copy(corners[(first + j) % 3].begin(), corners[(first + j) % 3].end(), triangle.begin() + j * 3);
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+    TEST(MeshOptimizer, VertexCacheGrid) {
+        auto mesh = generate_grid(64, 64);
+        shuffle_triangles(mesh);
+        auto reference = canonical_triangles(mesh);
+        auto before = MeshOptimizer::analyze_vertex_cache(mesh.indices, mesh.positions.size());
+        MeshOptimizer::optimize_vertex_cache(mesh.indices, mesh.positions.size());
+        auto after = MeshOptimizer::analyze_vertex_cache(mesh.indices, mesh.positions.size());
+        EXPECT_EQ(before.triangleCount, 64u * 64u * 2u);
+        EXPECT_EQ(before.vertexCount, 65u * 65u);
+        EXPECT_GT(before.acmr, 2.f);
+        EXPECT_LT(after.acmr, 1.f);
+        EXPECT_LT(after.atvr, 2.f);
+        EXPECT_EQ(canonical_triangles(mesh), reference);
+    }
+    TEST(MeshOptimizer, OverdrawKeepsTriangles) {
+        auto mesh = generate_grid(32, 32);
+        shuffle_triangles(mesh, 1);
+        auto reference = canonical_triangles(mesh);
+        MeshOptimizer::optimize_vertex_cache(mesh.indices, mesh.positions.size());
+        auto cache = MeshOptimizer::analyze_vertex_cache(mesh.indices, mesh.positions.size());
+        MeshOptimizer::optimize_overdraw(mesh.indices, mesh.positions, 16, 1.05f);
+        auto overdraw = MeshOptimizer::analyze_vertex_cache(mesh.indices, mesh.positions.size());
+        EXPECT_EQ(canonical_triangles(mesh), reference);
+        EXPECT_LT(overdraw.acmr, cache.acmr * 1.25f);
+    }
+    TEST(MeshOptimizer, VertexFetch) {
+        auto mesh = generate_grid(16, 16);
+        shuffle_triangles(mesh, 2);
+        //Unreferenced vertex which has to be dropped
+        mesh.positions.emplace_back(-1.f, -1.f, -1.f);
+        mesh.uvs0.emplace_back(0.f, 0.f);
+        mesh.normals.emplace_back(0.f, 1.f, 0.f);
+        mesh.tangents.emplace_back(1.f, 0.f, 0.f, 1.f);
+        auto reference = canonical_triangles(mesh);
+        auto vertexCount = MeshOptimizer::optimize_vertex_fetch(mesh);
+        EXPECT_EQ(vertexCount, 17u * 17u);
+        EXPECT_EQ(mesh.positions.size(), vertexCount);
+        EXPECT_EQ(mesh.uvs0.size(), vertexCount);
+        EXPECT_EQ(mesh.normals.size(), vertexCount);
+        EXPECT_EQ(mesh.tangents.size(), vertexCount);
+        EXPECT_EQ(canonical_triangles(mesh), reference);
+        uint32_t next = 0;
+        for (auto index : mesh.indices) {
+            EXPECT_LE(index, next);
+            if (index == next)
+                next++;
+        }
+        for (size_t i = 0; i < mesh.positions.size(); i++) {
+            EXPECT_FLOAT_EQ(mesh.uvs0[i][0], static_cast<float>(Math::half(mesh.positions[i][0] / 16.f)));
+            EXPECT_FLOAT_EQ(mesh.uvs0[i][1], static_cast<float>(Math::half(mesh.positions[i][2] / 16.f)));
+        }
+    }
+    TEST(MeshOptimizer, Statistics) {
+        std::vector<nyan::Mesh> meshes;
+        for (uint32_t i = 0; i < 8; i++) {
+            meshes.push_back(generate_grid(16 + i, 16));
+            shuffle_triangles(meshes.back(), i);
+        }
+        auto sequential = meshes;
+        auto statistics = MeshOptimizer::optimize(meshes);
+        ASSERT_EQ(statistics.size(), meshes.size());
+        for (size_t i = 0; i < meshes.size(); i++) {
+            MeshOptimizer::optimize(sequential[i]);
+            EXPECT_EQ(meshes[i].indices, sequential[i].indices);
+            EXPECT_LT(statistics[i].cacheAfter.acmr, statistics[i].cacheBefore.acmr);
+            EXPECT_LE(statistics[i].fetchAfter.bytesFetched, statistics[i].fetchBefore.bytesFetched);
+            EXPECT_GE(statistics[i].fetchAfter.overfetch, 1.f);
+        }
+    }
+    TEST(MeshOptimizer, LargeMeshPerf) {
+        auto mesh = generate_grid(512, 512);
+        shuffle_triangles(mesh, 3);
+        auto start = std::chrono::steady_clock::now();
+        auto statistics = MeshOptimizer::optimize(mesh);
+        auto end = std::chrono::steady_clock::now();
+        //std::cout << "Optimizing " << statistics.cacheBefore.triangleCount << " triangles took: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms\n";
+        //std::cout << "ACMR " << statistics.cacheBefore.acmr << " -> " << statistics.cacheAfter.acmr << ", ATVR " << statistics.cacheBefore.atvr << " -> " << statistics.cacheAfter.atvr << "\n";
+        //std::cout << "Overfetch " << statistics.fetchBefore.overfetch << " -> " << statistics.fetchAfter.overfetch << "\n";
+        EXPECT_LT(statistics.cacheAfter.acmr, statistics.cacheBefore.acmr);
+        EXPECT_LT(statistics.fetchAfter.overfetch, statistics.fetchBefore.overfetch);
+    }
+    //Hemisphere of radius 1, rings from the pole to the equator, outward facing counter clockwise triangles
+    static nyan::Mesh generate_hemisphere(uint32_t rings, uint32_t segments) {
+        nyan::Mesh mesh{ .name {"Hemisphere"} };
+        for (uint32_t ring = 0; ring <= rings; ring++) {
+            float theta = 0.5f * 3.14159265f * ring / rings;
+            for (uint32_t segment = 0; segment <= segments; segment++) {
+                float phi = 2.f * 3.14159265f * segment / segments;
+                mesh.positions.emplace_back(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            }
+        }
+        for (uint32_t ring = 0; ring < rings; ring++) {
+            for (uint32_t segment = 0; segment < segments; segment++) {
+                uint32_t v0 = ring * (segments + 1) + segment;
+                uint32_t v1 = v0 + 1;
+                uint32_t v2 = v0 + segments + 1;
+                uint32_t v3 = v2 + 1;
+                mesh.indices.insert(mesh.indices.end(), { v0, v1, v2, v1, v3, v2 });
+            }
+        }
+        return mesh;
+    }
+    //Reassembles the mesh triangles from the meshlet data
+    static std::vector<uint32_t> meshlet_indices(const MeshletData& data) {
+        std::vector<uint32_t> indices;
+        for (const auto& meshlet : data.meshlets)
+            for (uint32_t i = 0; i < meshlet.triangleCount * 3; i++)
+                indices.push_back(data.vertices[meshlet.vertexOffset + data.triangles[meshlet.triangleOffset + i]]);
+        return indices;
+    }
+    TEST(Meshlet, Limits) {
+        auto mesh = generate_grid(48, 48);
+        shuffle_triangles(mesh, 4);
+        auto reference = canonical_triangles(mesh);
+        auto data = MeshletBuilder::build(mesh);
+        ASSERT_EQ(data.meshlets.size(), data.bounds.size());
+        size_t triangleCount = 0;
+        for (const auto& meshlet : data.meshlets) {
+            EXPECT_LE(meshlet.vertexCount, shaders::MESHLET_MAX_VERTICES);
+            EXPECT_LE(meshlet.triangleCount, shaders::MESHLET_MAX_TRIANGLES);
+            EXPECT_GT(meshlet.triangleCount, 0u);
+            EXPECT_EQ(meshlet.triangleOffset % 4, 0u);
+            for (uint32_t i = 0; i < meshlet.triangleCount * 3; i++)
+                EXPECT_LT(data.triangles[meshlet.triangleOffset + i], meshlet.vertexCount);
+            triangleCount += meshlet.triangleCount;
+        }
+        EXPECT_EQ(triangleCount, 48u * 48u * 2u);
+        //A regular grid should fill meshlets reasonably well
+        EXPECT_LT(data.meshlets.size(), (triangleCount / shaders::MESHLET_MAX_TRIANGLES) * 2);
+        auto rebuilt = mesh;
+        rebuilt.indices = meshlet_indices(data);
+        EXPECT_EQ(canonical_triangles(rebuilt), reference);
+    }
+    TEST(Meshlet, SmallLimits) {
+        auto mesh = generate_grid(20, 20);
+        MeshletBuilder::Settings settings{ .maxVertices {16}, .maxTriangles {8} };
+        auto data = MeshletBuilder::build(mesh, settings);
+        for (const auto& meshlet : data.meshlets) {
+            EXPECT_LE(meshlet.vertexCount, 16u);
+            EXPECT_LE(meshlet.triangleCount, 8u);
+        }
+        auto rebuilt = mesh;
+        rebuilt.indices = meshlet_indices(data);
+        EXPECT_EQ(canonical_triangles(rebuilt), canonical_triangles(mesh));
+    }
+    TEST(Meshlet, FullVertexLimit) {
+        //Local index 255 is a regular vertex, not the end of the meshlet
+        auto mesh = generate_grid(48, 48);
+        MeshletBuilder::Settings settings{ .maxVertices {256}, .maxTriangles {512} };
+        auto data = MeshletBuilder::build(mesh, settings);
+        bool full = false;
+        for (const auto& meshlet : data.meshlets) {
+            EXPECT_LE(meshlet.vertexCount, 256u);
+            full |= meshlet.vertexCount == 256;
+            std::vector<uint32_t> vertices(data.vertices.begin() + meshlet.vertexOffset, data.vertices.begin() + meshlet.vertexOffset + meshlet.vertexCount);
+            std::sort(vertices.begin(), vertices.end());
+            EXPECT_EQ(std::adjacent_find(vertices.begin(), vertices.end()), vertices.end());
+        }
+        EXPECT_TRUE(full);
+        auto rebuilt = mesh;
+        rebuilt.indices = meshlet_indices(data);
+        EXPECT_EQ(canonical_triangles(rebuilt), canonical_triangles(mesh));
+    }
+    TEST(Meshlet, BoundingSpheres) {
+        auto mesh = generate_hemisphere(32, 64);
+        auto data = MeshletBuilder::build(mesh);
+        for (size_t i = 0; i < data.meshlets.size(); i++) {
+            const auto& meshlet = data.meshlets[i];
+            const auto& bounds = data.bounds[i];
+            for (uint32_t j = 0; j < meshlet.vertexCount; j++) {
+                const auto& position = mesh.positions[data.vertices[meshlet.vertexOffset + j]];
+                EXPECT_LE((position - bounds.center).L2_norm(), bounds.radius * 1.0001f + 1e-6f);
+            }
+        }
+    }
+    TEST(Meshlet, ConeCullingConservative) {
+        auto mesh = generate_hemisphere(32, 64);
+        auto data = MeshletBuilder::build(mesh);
+        std::mt19937 generator{ 5 };
+        std::uniform_real_distribution<float> distribution{ -4.f, 4.f };
+        size_t culled = 0;
+        for (uint32_t sample = 0; sample < 64; sample++) {
+            Math::vec3 camera{ distribution(generator), distribution(generator), distribution(generator) };
+            for (size_t i = 0; i < data.meshlets.size(); i++) {
+                if (MeshletCuller::cone_visible(data.bounds[i], camera))
+                    continue;
+                culled++;
+                const auto& meshlet = data.meshlets[i];
+                for (uint32_t j = 0; j < meshlet.triangleCount; j++) {
+                    const auto& p0 = mesh.positions[data.vertices[meshlet.vertexOffset + data.triangles[meshlet.triangleOffset + j * 3]]];
+                    const auto& p1 = mesh.positions[data.vertices[meshlet.vertexOffset + data.triangles[meshlet.triangleOffset + j * 3 + 1]]];
+                    const auto& p2 = mesh.positions[data.vertices[meshlet.vertexOffset + data.triangles[meshlet.triangleOffset + j * 3 + 2]]];
+                    auto normal = (p1 - p0).cross(p2 - p0);
+                    EXPECT_LE(normal.dot(camera - p0), 1e-5f);
+                }
+            }
+        }
+        //Cameras below the hemisphere have to see most of it from behind
+        EXPECT_GT(culled, 0u);
+        //Looking straight down on the hemisphere nothing may be culled
+        for (const auto& bounds : data.bounds)
+            EXPECT_TRUE(MeshletCuller::cone_visible(bounds, Math::vec3{ 0.f, 100.f, 0.f }) || bounds.coneAxis[1] < 0.f);
+    }
+    TEST(Meshlet, FrustumCulling) {
+        //View space, looking down -z
+        auto proj = Math::Mat<float, 4, 4, true>::perspectiveFovXLH(0.1f, 100.f, 90.f, 1.f);
+        auto frustum = MeshletCuller::extract_frustum(proj);
+        shaders::MeshletBounds bounds{ .center {Math::vec3{ 0.f, 0.f, -5.f }}, .radius {1.f}, .coneApex {}, .coneCutoff {2.f}, .coneAxis {}, .pad {} };
+        EXPECT_TRUE(MeshletCuller::frustum_visible(bounds, frustum));
+        bounds.center = Math::vec3{ 0.f, 0.f, 5.f };
+        EXPECT_FALSE(MeshletCuller::frustum_visible(bounds, frustum));
+        bounds.center = Math::vec3{ 0.f, 0.f, -200.f };
+        EXPECT_FALSE(MeshletCuller::frustum_visible(bounds, frustum));
+        bounds.center = Math::vec3{ 50.f, 0.f, -5.f };
+        EXPECT_FALSE(MeshletCuller::frustum_visible(bounds, frustum));
+        bounds.center = Math::vec3{ 0.f, -50.f, -5.f };
+        EXPECT_FALSE(MeshletCuller::frustum_visible(bounds, frustum));
+        //Right plane is x = 5 at this depth, sphere center is ~0.71 outside of it
+        bounds.center = Math::vec3{ 6.f, 0.f, -5.f };
+        EXPECT_TRUE(MeshletCuller::frustum_visible(bounds, frustum));
+        bounds.radius = 0.5f;
+        EXPECT_FALSE(MeshletCuller::frustum_visible(bounds, frustum));
+        //Infinite inverse depth projection has no far plane
+        frustum = MeshletCuller::extract_frustum(Math::Mat<float, 4, 4, true>::perspectiveInverseDepthFovXLH(0.1f, 90.f, 1.f));
+        bounds.center = Math::vec3{ 0.f, 0.f, -10000.f };
+        EXPECT_TRUE(MeshletCuller::frustum_visible(bounds, frustum));
+        bounds.center = Math::vec3{ 0.f, 0.f, 5.f };
+        EXPECT_FALSE(MeshletCuller::frustum_visible(bounds, frustum));
+    }
+    TEST(Meshlet, LargeMeshPerf) {
+        //~1M triangles
+        auto mesh = generate_grid(708, 708);
+        MeshOptimizer::optimize_vertex_cache(mesh.indices, mesh.positions.size());
+        auto start = std::chrono::steady_clock::now();
+        auto data = MeshletBuilder::build(mesh);
+        auto end = std::chrono::steady_clock::now();
+        //std::cout << "Building " << data.meshlets.size() << " meshlets from " << mesh.indices.size() / 3 << " triangles took: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms\n";
+        Math::vec3 camera{ 354.f, 50.f, 800.f };
+        auto view = Math::Mat<float, 4, 4, true>::first_person(camera, Math::vec3{ 0.f, 0.f, 1.f }, Math::vec3{ 0.f, 1.f, 0.f }, Math::vec3{ 1.f, 0.f, 0.f });
+        auto proj = Math::Mat<float, 4, 4, true>::perspectiveFovXLH(0.1f, 1000.f, 90.f, 16.f / 9.f);
+        auto frustum = MeshletCuller::extract_frustum(proj * view);
+        start = std::chrono::steady_clock::now();
+        auto visible = MeshletCuller::cull(data, frustum, camera);
+        end = std::chrono::steady_clock::now();
+        //std::cout << "Culling " << data.meshlets.size() << " meshlets took: " << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "us, " << visible.size() << " visible\n";
+        EXPECT_GT(visible.size(), 0u);
+        EXPECT_LT(visible.size(), data.meshlets.size());
+    }
+    static void displace_grid(nyan::Mesh& mesh, float amplitude, float frequency) {
+        for (auto& position : mesh.positions)
+            position[1] = amplitude * std::sin(position[0] * frequency) * std::cos(position[2] * frequency);
+    }
+    static size_t count_flipped(const nyan::Mesh& mesh, const Math::vec3& center) {
+        size_t flipped = 0;
+        for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+            const auto& p0 = mesh.positions[mesh.indices[i]];
+            const auto& p1 = mesh.positions[mesh.indices[i + 1]];
+            const auto& p2 = mesh.positions[mesh.indices[i + 2]];
+            auto normal = (p1 - p0).cross(p2 - p0);
+            if (normal.dot((p0 + p1 + p2) * (1.f / 3.f) - center) <= 0.f)
+                flipped++;
+        }
+        return flipped;
+    }
+    TEST(Simplifier, FlatGrid) {
+        auto mesh = generate_grid(32, 32);
+        auto result = MeshSimplifier::simplify(mesh, mesh.indices.size() / 10);
+        EXPECT_LE(result.indices.size(), mesh.indices.size() / 10);
+        EXPECT_GT(result.indices.size(), 0u);
+        EXPECT_LT(result.error, 1e-3f);
+        auto simplified = mesh;
+        simplified.indices = result.indices;
+        auto distance = MeshSimplifier::measure_distance(mesh, simplified);
+        EXPECT_LT(distance.hausdorff, 1e-3f);
+        //Corners of the open border have to stay in place
+        for (auto corner : { 0u, 32u, 33u * 32u, 33u * 33u - 1u })
+            EXPECT_NE(std::find(result.indices.begin(), result.indices.end(), corner), result.indices.end());
+    }
+    TEST(Simplifier, Hemisphere) {
+        auto mesh = generate_hemisphere(64, 128);
+        auto triangleCount = mesh.indices.size() / 3;
+        auto result = MeshSimplifier::simplify(mesh, mesh.indices.size() / 4);
+        EXPECT_LE(result.indices.size(), mesh.indices.size() / 4);
+        EXPECT_GT(result.indices.size(), mesh.indices.size() / 8);
+        EXPECT_GT(result.error, 0.f);
+        auto simplified = mesh;
+        simplified.indices = result.indices;
+        EXPECT_EQ(count_flipped(simplified, Math::vec3{ 0.f }), 0u);
+        auto distance = MeshSimplifier::measure_distance(mesh, simplified);
+        EXPECT_LT(distance.hausdorff, 0.02f);
+        EXPECT_LE(distance.mean, distance.hausdorff);
+        //Open border at the equator stays on the equator
+        for (auto index : result.indices)
+            if (mesh.positions[index][1] < 1e-4f)
+                EXPECT_NEAR(Math::vec3(mesh.positions[index][0], 0.f, mesh.positions[index][2]).L2_norm(), 1.f, 1e-4f);
+        EXPECT_GT(triangleCount, 0u);
+    }
+    TEST(Simplifier, UvSeam) {
+        //Left and right half of the grid use separate uv charts which share the positions of the middle column
+        auto mesh = generate_grid(32, 32);
+        std::vector<bool> right(mesh.positions.size(), false);
+        for (uint32_t y = 0; y <= 32; y++) {
+            uint32_t seam = y * 33 + 16;
+            mesh.positions.push_back(mesh.positions[seam]);
+            mesh.uvs0.emplace_back(static_cast<float>(mesh.uvs0[seam][0]) + 0.25f, static_cast<float>(mesh.uvs0[seam][1]));
+            mesh.normals.push_back(mesh.normals[seam]);
+            mesh.tangents.push_back(mesh.tangents[seam]);
+            right.push_back(true);
+        }
+        for (uint32_t vertex = 0; vertex < 33 * 33; vertex++) {
+            if (vertex % 33 > 16) {
+                mesh.uvs0[vertex] = Math::hvec2(static_cast<float>(mesh.uvs0[vertex][0]) + 0.25f, static_cast<float>(mesh.uvs0[vertex][1]));
+                right[vertex] = true;
+            }
+        }
+        for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+            bool rightTriangle = false;
+            for (size_t j = 0; j < 3; j++)
+                rightTriangle |= mesh.indices[i + j] % 33 > 16 && mesh.indices[i + j] < 33 * 33;
+            if (rightTriangle)
+                for (size_t j = 0; j < 3; j++)
+                    if (mesh.indices[i + j] % 33 == 16)
+                        mesh.indices[i + j] = 33 * 33 + mesh.indices[i + j] / 33;
+        }
+        auto result = MeshSimplifier::simplify(mesh, mesh.indices.size() / 8);
+        EXPECT_LT(result.indices.size(), mesh.indices.size() / 2);
+        std::vector<std::array<float, 2>> leftSeam, rightSeam;
+        for (size_t i = 0; i < result.indices.size(); i += 3) {
+            for (size_t j = 0; j < 3; j++) {
+                auto index = result.indices[i + j];
+                EXPECT_EQ(right[index], right[result.indices[i]]);
+                //Seam vertices never leave the middle column
+                if (mesh.positions[index][0] == 16.f)
+                    (right[index] ? rightSeam : leftSeam).push_back({ mesh.positions[index][0], mesh.positions[index][2] });
+                else
+                    EXPECT_EQ(right[index], mesh.positions[index][0] > 16.f);
+            }
+        }
+        std::sort(leftSeam.begin(), leftSeam.end());
+        leftSeam.erase(std::unique(leftSeam.begin(), leftSeam.end()), leftSeam.end());
+        std::sort(rightSeam.begin(), rightSeam.end());
+        rightSeam.erase(std::unique(rightSeam.begin(), rightSeam.end()), rightSeam.end());
+        EXPECT_EQ(leftSeam, rightSeam);
+    }
+    TEST(Simplifier, LodChain) {
+        auto mesh = generate_hemisphere(64, 128);
+        auto lods = MeshSimplifier::generate_lods(mesh);
+        ASSERT_EQ(lods.size(), 3u);
+        size_t previousCount = mesh.indices.size();
+        float previousError = 0.f;
+        float previousDistance = 0.f;
+        for (const auto& lod : lods) {
+            EXPECT_LT(lod.mesh.indices.size(), previousCount);
+            EXPECT_GE(lod.error, previousError);
+            EXPECT_LT(lod.mesh.positions.size(), mesh.positions.size());
+            auto distance = MeshSimplifier::measure_distance(mesh, lod.mesh);
+            //std::cout << lod.mesh.name << ": " << lod.mesh.indices.size() / 3 << " triangles, error " << lod.error << ", hausdorff " << distance.hausdorff << ", mean " << distance.mean << "\n";
+            EXPECT_GE(distance.hausdorff, previousDistance * 0.5f);
+            EXPECT_LT(distance.hausdorff, 0.1f);
+            EXPECT_EQ(count_flipped(lod.mesh, Math::vec3{ 0.f }), 0u);
+            previousCount = lod.mesh.indices.size();
+            previousError = lod.error;
+            previousDistance = distance.hausdorff;
+        }
+        EXPECT_LE(lods[0].mesh.indices.size(), mesh.indices.size() / 2);
+        EXPECT_LE(lods[2].mesh.indices.size(), mesh.indices.size() / 8);
+    }
+    TEST(Simplifier, LodSelection) {
+        PerspectiveCamera camera{ .fovX {90.f} };
+        std::array<float, 4> errors{ 0.f, 0.01f, 0.05f, 0.2f };
+        //At 90 degrees and 1000 pixels, one unit at distance 500 is one pixel
+        EXPECT_NEAR(LodSelector::projected_error(1.f, 500.f, camera, 1000.f), 1.f, 1e-4f);
+        EXPECT_EQ(LodSelector::select(errors, 1.f, camera, 1000.f), 0u);
+        EXPECT_EQ(LodSelector::select(errors, 6.f, camera, 1000.f), 1u);
+        EXPECT_EQ(LodSelector::select(errors, 30.f, camera, 1000.f), 2u);
+        EXPECT_EQ(LodSelector::select(errors, 200.f, camera, 1000.f), 3u);
+        EXPECT_EQ(LodSelector::select(errors, 200.f, camera, 1000.f, 0.1f), 1u);
+        uint32_t previous = 0;
+        for (float distance = 0.f; distance < 1000.f; distance += 1.f) {
+            auto lod = LodSelector::select(errors, distance, camera, 1920.f);
+            EXPECT_GE(lod, previous);
+            previous = lod;
+        }
+    }
+    TEST(Simplifier, LargeMeshPerf) {
+        auto mesh = generate_grid(512, 512);
+        displace_grid(mesh, 8.f, 0.05f);
+        auto start = std::chrono::steady_clock::now();
+        auto result = MeshSimplifier::simplify(mesh, mesh.indices.size() / 10);
+        auto end = std::chrono::steady_clock::now();
+        //std::cout << "Simplifying " << mesh.indices.size() / 3 << " to " << result.indices.size() / 3 << " triangles took: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms\n";
+        auto simplified = mesh;
+        simplified.indices = result.indices;
+        start = std::chrono::steady_clock::now();
+        auto distance = MeshSimplifier::measure_distance(mesh, simplified);
+        end = std::chrono::steady_clock::now();
+        //std::cout << "Error " << result.error << ", hausdorff " << distance.hausdorff << ", mean " << distance.mean << ", measuring took: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms\n";
+        EXPECT_LE(result.indices.size(), mesh.indices.size() / 10);
+        EXPECT_LT(distance.hausdorff, 1.f);
+    }
+    //Uniformly distributed unit vectors on the sphere plus the axis and diagonal directions
+    static std::vector<Math::vec3> fibonacci_sphere(uint32_t count) {
+        std::vector<Math::vec3> directions;
+        const float goldenAngle = 3.14159265f * (3.f - std::sqrt(5.f));
+        for (uint32_t i = 0; i < count; i++) {
+            float z = 1.f - 2.f * (i + 0.5f) / count;
+            float r = std::sqrt(1.f - z * z);
+            directions.emplace_back(r * std::cos(goldenAngle * i), r * std::sin(goldenAngle * i), z);
+        }
+        for (float x : { -1.f, 0.f, 1.f })
+            for (float y : { -1.f, 0.f, 1.f })
+                for (float z : { -1.f, 0.f, 1.f })
+                    if (x != 0.f || y != 0.f || z != 0.f) {
+                        Math::vec3 direction{ x, y, z };
+                        directions.push_back(direction * (1.f / direction.L2_norm()));
+                    }
+        return directions;
+    }
+    //Via the cross product, acos is too imprecise close to 1
+    static float angle_degrees(const Math::vec3& a, const Math::vec3& b) {
+        return std::atan2(a.cross(b).L2_norm(), a.dot(b)) * 180.f / 3.14159265f;
+    }
+    TEST(Quantizer, NormalRoundTrip) {
+        float maxAngle = 0.f;
+        for (const auto& direction : fibonacci_sphere(10000)) {
+            auto decoded = MeshQuantizer::decode_normal(MeshQuantizer::encode_normal(direction));
+            maxAngle = std::max(maxAngle, angle_degrees(decoded, direction));
+            EXPECT_NEAR(decoded.L2_norm(), 1.f, 1e-5f);
+        }
+        EXPECT_LT(maxAngle, 0.01f);
+    }
+    TEST(Quantizer, TangentRoundTrip) {
+        float maxAngle = 0.f;
+        float sign = 1.f;
+        for (const auto& direction : fibonacci_sphere(10000)) {
+            sign = -sign;
+            auto decoded = MeshQuantizer::decode_tangent(MeshQuantizer::encode_tangent(Math::vec4{ direction[0], direction[1], direction[2], sign }));
+            maxAngle = std::max(maxAngle, angle_degrees(Math::vec3{ decoded }, direction));
+            EXPECT_EQ(decoded[3], sign);
+        }
+        //10 bit components
+        EXPECT_LT(maxAngle, 0.25f);
+    }
+    TEST(Quantizer, PositionRoundTrip) {
+        auto mesh = generate_grid(64, 64);
+        displace_grid(mesh, 8.f, 0.2f);
+        for (auto& position : mesh.positions)
+            position = position + Math::vec3{ 1000.f, -250.f, 30.f };
+        auto quantized = MeshQuantizer::quantize(mesh);
+        EXPECT_TRUE(quantized.uses_short_indices());
+        auto dequantized = MeshQuantizer::dequantize(quantized);
+        EXPECT_EQ(dequantized.indices, mesh.indices);
+        ASSERT_EQ(dequantized.positions.size(), mesh.positions.size());
+        for (size_t i = 0; i < mesh.positions.size(); i++) {
+            for (size_t axis = 0; axis < 3; axis++) {
+                //Half a quantization step, with some slack for float rounding at the offset
+                float tolerance = quantized.positionScale[axis] / 32767.f * 0.5f + 1e-4f;
+                EXPECT_NEAR(dequantized.positions[i][axis], mesh.positions[i][axis], tolerance);
+            }
+        }
+    }
+    TEST(Quantizer, IndexWidth) {
+        auto mesh = generate_grid(255, 255);
+        auto quantized = MeshQuantizer::quantize(mesh);
+        EXPECT_TRUE(quantized.uses_short_indices());
+        EXPECT_EQ(MeshQuantizer::dequantize(quantized).indices, mesh.indices);
+        mesh = generate_grid(300, 300);
+        quantized = MeshQuantizer::quantize(mesh);
+        EXPECT_FALSE(quantized.uses_short_indices());
+        EXPECT_EQ(quantized.indices, mesh.indices);
+    }
+    TEST(Quantizer, SizeStatistics) {
+        auto mesh = generate_grid(64, 64);
+        auto quantized = MeshQuantizer::quantize(mesh);
+        auto statistics = MeshQuantizer::analyze(mesh, quantized);
+        //std::cout << "Quantized " << statistics.sourceBytes << " to " << statistics.quantizedBytes << " bytes, ratio " << statistics.ratio << "\n";
+        EXPECT_EQ(MeshQuantizer::vertex_byte_size(mesh), mesh.positions.size() * 30);
+        EXPECT_EQ(MeshQuantizer::vertex_byte_size(quantized), mesh.positions.size() * 20);
+        EXPECT_EQ(MeshQuantizer::index_byte_size(quantized), mesh.indices.size() * 2);
+        EXPECT_LT(statistics.ratio, 0.65f);
+    }
+    //Hemisphere with u along the segments and v along the rings, the parametrization is orthogonal
+    static nyan::Mesh generate_uv_hemisphere(uint32_t rings, uint32_t segments) {
+        auto mesh = generate_hemisphere(rings, segments);
+        for (uint32_t ring = 0; ring <= rings; ring++) {
+            for (uint32_t segment = 0; segment <= segments; segment++) {
+                mesh.uvs0.emplace_back(static_cast<float>(segment) / segments, static_cast<float>(ring) / rings);
+                mesh.normals.emplace_back(mesh.positions[ring * (segments + 1) + segment]);
+            }
+        }
+        return mesh;
+    }
+    static Math::vec3 tangent_bitangent(const nyan::Mesh& mesh, uint32_t vertex) {
+        Math::vec4 tangent{ mesh.tangents[vertex] };
+        return Math::vec3{ mesh.normals[vertex] }.cross(Math::vec3{ tangent }) * tangent[3];
+    }
+    TEST(TangentGenerator, Grid) {
+        auto mesh = generate_grid(16, 16);
+        mesh.tangents.clear();
+        auto statistics = TangentGenerator::generate(mesh);
+        EXPECT_EQ(statistics.degenerateTriangles, 0);
+        EXPECT_EQ(statistics.splitVertices, 0);
+        ASSERT_EQ(mesh.tangents.size(), mesh.positions.size());
+        for (uint32_t i = 0; i < mesh.tangents.size(); i++) {
+            Math::vec4 tangent{ mesh.tangents[i] };
+            EXPECT_NEAR(tangent[0], 1.f, 1e-3f);
+            EXPECT_NEAR(tangent[1], 0.f, 1e-3f);
+            EXPECT_NEAR(tangent[2], 0.f, 1e-3f);
+            //dP/dv is +z
+            EXPECT_NEAR(tangent_bitangent(mesh, i)[2], 1.f, 1e-3f);
+        }
+    }
+    TEST(TangentGenerator, HemisphereReference) {
+        const uint32_t rings = 32, segments = 64;
+        auto mesh = generate_uv_hemisphere(rings, segments);
+        TangentGenerator::generate(mesh);
+        ASSERT_EQ(mesh.tangents.size(), mesh.positions.size());
+        float maxTangentAngle = 0.f;
+        float maxBitangentAngle = 0.f;
+        //dP/du and dP/dv vanish or flip at the pole, at the uv seam only one side contributes
+        for (uint32_t ring = 2; ring <= rings; ring++) {
+            float theta = 0.5f * 3.14159265f * ring / rings;
+            for (uint32_t segment = 1; segment < segments; segment++) {
+                float phi = 2.f * 3.14159265f * segment / segments;
+                uint32_t vertex = ring * (segments + 1) + segment;
+                Math::vec3 referenceTangent{ -std::sin(phi), 0.f, std::cos(phi) };
+                Math::vec3 referenceBitangent{ std::cos(theta) * std::cos(phi), -std::sin(theta), std::cos(theta) * std::sin(phi) };
+                maxTangentAngle = std::max(maxTangentAngle, angle_degrees(Math::vec3{ Math::vec4{ mesh.tangents[vertex] } }, referenceTangent));
+                maxBitangentAngle = std::max(maxBitangentAngle, angle_degrees(tangent_bitangent(mesh, vertex), referenceBitangent));
+            }
+        }
+        EXPECT_LT(maxTangentAngle, 0.25f);
+        EXPECT_LT(maxBitangentAngle, 0.25f);
+    }
+    TEST(TangentGenerator, MirroredSeam) {
+        //u mirrored at x = 4, the center column is shared by triangles of both orientations
+        auto mesh = generate_grid(8, 8);
+        mesh.tangents.clear();
+        for (size_t i = 0; i < mesh.positions.size(); i++)
+            mesh.uvs0[i][0] = std::abs(mesh.positions[i][0] - 4.f) / 4.f;
+        auto statistics = TangentGenerator::generate(mesh);
+        EXPECT_EQ(statistics.splitVertices, 9);
+        ASSERT_EQ(mesh.positions.size(), 9 * 9 + 9);
+        ASSERT_EQ(mesh.tangents.size(), mesh.positions.size());
+        ASSERT_EQ(mesh.normals.size(), mesh.positions.size());
+        for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+            float centerX = 0.f;
+            for (size_t j = 0; j < 3; j++)
+                centerX += mesh.positions[mesh.indices[i + j]][0] / 3.f;
+            float expected = centerX < 4.f ? -1.f : 1.f;
+            for (size_t j = 0; j < 3; j++) {
+                auto vertex = mesh.indices[i + j];
+                Math::vec4 tangent{ mesh.tangents[vertex] };
+                EXPECT_NEAR(tangent[0], expected, 1e-3f);
+                EXPECT_NEAR(tangent_bitangent(mesh, vertex)[2], 1.f, 1e-3f);
+            }
+        }
+    }
+    TEST(TangentGenerator, Welding) {
+        //The same surface without shared vertices has to end up with the same tangents
+        auto indexed = generate_uv_hemisphere(16, 32);
+        nyan::Mesh unindexed{ .name {"Unindexed"} };
+        for (auto index : indexed.indices) {
+            unindexed.indices.push_back(static_cast<uint32_t>(unindexed.positions.size()));
+            unindexed.positions.push_back(indexed.positions[index]);
+            unindexed.normals.push_back(indexed.normals[index]);
+            unindexed.uvs0.push_back(indexed.uvs0[index]);
+        }
+        TangentGenerator::generate(indexed);
+        TangentGenerator::generate(unindexed);
+        ASSERT_EQ(unindexed.tangents.size(), unindexed.positions.size());
+        for (size_t i = 0; i < indexed.indices.size(); i++) {
+            Math::vec4 expected{ indexed.tangents[indexed.indices[i]] };
+            Math::vec4 tangent{ unindexed.tangents[unindexed.indices[i]] };
+            for (size_t j = 0; j < 4; j++)
+                EXPECT_NEAR(tangent[j], expected[j], 1e-3f);
+        }
+    }
+    TEST(TangentGenerator, Fallback) {
+        //Without uvs and for triangles without uv area the tangents are only orthogonal to the normal
+        auto mesh = generate_uv_hemisphere(8, 16);
+        auto statistics = TangentGenerator::generate(mesh);
+        auto degenerateTriangles = statistics.degenerateTriangles;
+        //Second triangle of the first quad at the pole gets its own vertices with a single uv
+        for (size_t i = 3; i < 6; i++) {
+            mesh.positions.push_back(mesh.positions[mesh.indices[i]]);
+            mesh.normals.push_back(mesh.normals[mesh.indices[i]]);
+            mesh.uvs0.push_back(mesh.uvs0[mesh.indices[3]]);
+            mesh.indices[i] = static_cast<uint32_t>(mesh.positions.size() - 1);
+        }
+        statistics = TangentGenerator::generate(mesh);
+        EXPECT_EQ(statistics.degenerateTriangles, degenerateTriangles + 1);
+        mesh.uvs0.clear();
+        statistics = TangentGenerator::generate(mesh);
+        EXPECT_EQ(statistics.degenerateTriangles, mesh.indices.size() / 3);
+        ASSERT_EQ(mesh.tangents.size(), mesh.positions.size());
+        for (size_t i = 0; i < mesh.tangents.size(); i++) {
+            Math::vec4 tangent{ mesh.tangents[i] };
+            EXPECT_NEAR(Math::vec3{ tangent }.L2_norm(), 1.f, 1e-3f);
+            EXPECT_NEAR(Math::vec3{ tangent }.dot(Math::vec3{ mesh.normals[i] }), 0.f, 2e-3f);
+            EXPECT_EQ(std::abs(tangent[3]), 1.f);
+        }
+    }
+    TEST(TangentGenerator, MillionTrianglePerf) {
+        auto mesh = generate_grid(708, 708);
+        mesh.tangents.clear();
+        auto start = std::chrono::steady_clock::now();
+        TangentGenerator::generate(mesh);
+        auto end = std::chrono::steady_clock::now();
+        //std::cout << "Generating tangents for " << mesh.indices.size() / 3 << " triangles took: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() * 1e6 / (mesh.indices.size() / 3) << "ms per million triangles\n";
+        EXPECT_EQ(mesh.tangents.size(), mesh.positions.size());
+    }
+    class CountingUploadBackend : public MeshUploadBackend {
+    public:
+        MeshGeometryID upload_geometry(const QuantizedMesh& mesh) override {
+            uploads.push_back(mesh.name);
+            return static_cast<MeshGeometryID>(uploads.size() - 1);
+        }
+        std::vector<std::string> uploads;
+    };
+    TEST(MeshGeometryCache, StreamingHash) {
+        std::vector<uint8_t> data(1000);
+        for (size_t i = 0; i < data.size(); i++)
+            data[i] = static_cast<uint8_t>(i * 7 + 3);
+        Utility::StreamHasher whole;
+        whole.update(data.data(), data.size());
+        for (size_t split : { 1, 7, 31, 32, 33, 100 }) {
+            Utility::StreamHasher pieces;
+            for (size_t offset = 0; offset < data.size(); offset += split)
+                pieces.update(data.data() + offset, std::min(split, data.size() - offset));
+            EXPECT_EQ(pieces.finish(), whole.finish());
+        }
+        for (size_t size : { 0, 1, 8, 31, 32, 999 }) {
+            Utility::StreamHasher prefix;
+            prefix.update(data.data(), size);
+            EXPECT_NE(prefix.finish(), whole.finish());
+        }
+        data[500] ^= 1;
+        Utility::StreamHasher changed;
+        changed.update(data.data(), data.size());
+        EXPECT_NE(changed.finish(), whole.finish());
+    }
+    TEST(MeshGeometryCache, Deduplication) {
+        CountingUploadBackend backend;
+        MeshGeometryCache cache{ backend };
+        auto quantized = MeshQuantizer::quantize(generate_grid(16, 16));
+        auto bytes = MeshQuantizer::index_byte_size(quantized) + MeshQuantizer::vertex_byte_size(quantized);
+        quantized.name = "First";
+        auto first = cache.acquire(quantized);
+        EXPECT_FALSE(first.shared);
+        //Name and material don't matter
+        quantized.name = "Second";
+        quantized.material = "OtherMaterial";
+        quantized.materialBinding = 7;
+        auto second = cache.acquire(quantized);
+        EXPECT_TRUE(second.shared);
+        EXPECT_EQ(second.geometry, first.geometry);
+        EXPECT_EQ(backend.uploads, (std::vector<std::string>{ "First" }));
+        EXPECT_EQ(cache.get_statistics().uploads, 1);
+        EXPECT_EQ(cache.get_statistics().sharedMeshes, 1);
+        EXPECT_EQ(cache.get_statistics().uploadedBytes, bytes);
+        EXPECT_EQ(cache.get_statistics().savedBytes, bytes);
+    }
+    TEST(MeshGeometryCache, DistinctGeometry) {
+        CountingUploadBackend backend;
+        MeshGeometryCache cache{ backend };
+        auto base = MeshQuantizer::quantize(generate_grid(16, 16));
+        cache.acquire(base);
+        auto changedIndex = base;
+        std::swap(changedIndex.shortIndices[0], changedIndex.shortIndices[1]);
+        auto changedUv = base;
+        changedUv.uvs0.back()[0] = Math::half{ 0.25f };
+        auto changedTangent = base;
+        changedTangent.tangents[3].data ^= 1;
+        auto changedScale = base;
+        changedScale.positionScale[1] *= 2.f;
+        auto changedType = base;
+        changedType.type = Mesh::RenderType::AlphaTest;
+        //Same bytes, split differently across the streams
+        auto moved = base;
+        moved.uvs0.pop_back();
+        moved.normals.push_back(Math::sn16vec2{});
+        for (const auto* mesh : { &changedIndex, &changedUv, &changedTangent, &changedScale, &changedType, &moved })
+            EXPECT_FALSE(cache.acquire(*mesh).shared);
+        EXPECT_EQ(backend.uploads.size(), 7);
+        EXPECT_EQ(cache.get_statistics().savedBytes, 0);
+    }
+    TEST(Bounds, BoxReduction) {
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> dist(-100.f, 100.f);
+        for (size_t count : { 0, 1, 3, 4, 5, 7, 8, 9, 13, 100003 }) {
+            std::vector<Math::vec3> positions;
+            for (size_t i = 0; i < count; i++)
+                positions.emplace_back(dist(rng), dist(rng), dist(rng));
+            BoundingBox reference;
+            for (const auto& position : positions) {
+                for (size_t axis = 0; axis < 3; axis++) {
+                    reference.min[axis] = std::min(reference.min[axis], position[axis]);
+                    reference.max[axis] = std::max(reference.max[axis], position[axis]);
+                }
+            }
+            auto box = BoundsCalculator::compute_box(positions);
+            EXPECT_EQ(box.valid(), count != 0);
+            for (size_t axis = 0; axis < 3; axis++) {
+                EXPECT_EQ(box.min[axis], reference.min[axis]);
+                EXPECT_EQ(box.max[axis], reference.max[axis]);
+            }
+        }
+    }
+    TEST(Bounds, SphereTightness) {
+        std::mt19937 rng(5);
+        std::normal_distribution<float> dist;
+        //Points on a sphere, the optimum is the sphere itself
+        std::vector<Math::vec3> positions;
+        for (size_t i = 0; i < 10000; i++) {
+            Math::vec3 direction{ dist(rng), dist(rng), dist(rng) };
+            positions.push_back(direction.normalize() * 2.f + Math::vec3{ 5.f, -3.f, 1.f });
+        }
+        auto sphere = BoundsCalculator::compute_sphere(positions);
+        EXPECT_GE(sphere.radius, 2.f * (1.f - 1e-5f));
+        EXPECT_LE(sphere.radius, 2.f * 1.05f);
+        for (const auto& position : positions)
+            EXPECT_LE((position - sphere.center).L2_norm(), sphere.radius * (1.f + 1e-5f));
+        //Cube corners, the optimum is half the space diagonal
+        std::vector<Math::vec3> corners;
+        for (uint32_t i = 0; i < 8; i++)
+            corners.emplace_back(static_cast<float>(i & 1), static_cast<float>((i >> 1) & 1), static_cast<float>((i >> 2) & 1));
+        auto cube = BoundsCalculator::compute_sphere(corners);
+        EXPECT_NEAR(cube.radius, std::sqrt(3.f) * 0.5f, 1e-5f);
+        EXPECT_TRUE(BoundsCalculator::compute_sphere(std::vector<Math::vec3>{}).valid() == false);
+    }
+    TEST(Bounds, Submeshes) {
+        auto mesh = generate_grid(8, 4);
+        const auto half = static_cast<uint32_t>(mesh.indices.size() / 2);
+        mesh.submeshes.push_back(Submesh{ .firstIndex {0}, .indexCount {half} });
+        mesh.submeshes.push_back(Submesh{ .firstIndex {half}, .indexCount {half} });
+        BoundsCalculator::compute(mesh);
+        EXPECT_EQ(mesh.bounds.box.min[0], 0.f);
+        EXPECT_EQ(mesh.bounds.box.max[0], 8.f);
+        EXPECT_EQ(mesh.bounds.box.max[2], 4.f);
+        EXPECT_EQ(mesh.submeshes[0].bounds.box.min[2], 0.f);
+        EXPECT_EQ(mesh.submeshes[0].bounds.box.max[2], 2.f);
+        EXPECT_EQ(mesh.submeshes[1].bounds.box.min[2], 2.f);
+        EXPECT_EQ(mesh.submeshes[1].bounds.box.max[2], 4.f);
+        for (const auto& submesh : mesh.submeshes) {
+            EXPECT_TRUE(submesh.bounds.valid());
+            EXPECT_LT(submesh.bounds.sphere.radius, mesh.bounds.sphere.radius);
+        }
+        //The bounds survive quantization
+        auto quantized = MeshQuantizer::quantize(mesh);
+        EXPECT_EQ(quantized.bounds.box.max[0], 8.f);
+        EXPECT_EQ(quantized.bounds.sphere.radius, mesh.bounds.sphere.radius);
+    }
+    TEST(Bounds, Transform) {
+        auto mesh = generate_grid(4, 2);
+        BoundsCalculator::compute(mesh);
+        //Rotation by 90 degrees around y, uniform scale 2, translation
+        Math::Mat<float, 3, 4, false> transform{
+            0.f, 0.f, 2.f, 10.f,
+            0.f, 2.f, 0.f, -1.f,
+            -2.f, 0.f, 0.f, 3.f };
+        auto world = BoundsCalculator::transform(mesh.bounds, transform);
+        ASSERT_TRUE(world.valid());
+        EXPECT_NEAR(world.sphere.radius, mesh.bounds.sphere.radius * 2.f, 1e-5f);
+        for (const auto& position : mesh.positions) {
+            Math::vec3 p{ 2.f * position[2] + 10.f, 2.f * position[1] - 1.f, -2.f * position[0] + 3.f };
+            for (size_t axis = 0; axis < 3; axis++) {
+                EXPECT_GE(p[axis], world.box.min[axis] - 1e-4f);
+                EXPECT_LE(p[axis], world.box.max[axis] + 1e-4f);
+            }
+            EXPECT_LE((p - world.sphere.center).L2_norm(), world.sphere.radius * (1.f + 1e-5f));
+        }
+        //Axis aligned rotation keeps the box exact
+        EXPECT_NEAR(world.box.min[0], 10.f, 1e-5f);
+        EXPECT_NEAR(world.box.max[0], 14.f, 1e-5f);
+        EXPECT_NEAR(world.box.min[2], -5.f, 1e-5f);
+        EXPECT_NEAR(world.box.max[2], 3.f, 1e-5f);
+    }
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include "Utility/PipelineCacheFile.h"
+#include "Utility/StreamHasher.h"
+#include <cstring>
+#include <fstream>
+namespace Utility {
+    static PipelineCacheFile::Identity test_identity() {
+        PipelineCacheFile::Identity identity{
+            .vendorID {0x10de},
+            .deviceID {0x2684},
+            .driverVersion {0x8a4f0000},
+        };
+        for (uint8_t i = 0; i < identity.pipelineCacheUUID.size(); i++)
+            identity.pipelineCacheUUID[i] = i;
+        return identity;
+    }
+    //Data as vkGetPipelineCacheData would return it, a VkPipelineCacheHeaderVersionOne followed by the payload
+    static std::vector<std::byte> vulkan_data(const PipelineCacheFile::Identity& identity, size_t payloadSize) {
+        std::vector<std::byte> data(32 + payloadSize);
+        const uint32_t header[4]{ 32, 1, identity.vendorID, identity.deviceID };
+        std::memcpy(data.data(), header, sizeof(header));
+        std::memcpy(data.data() + sizeof(header), identity.pipelineCacheUUID.data(), identity.pipelineCacheUUID.size());
+        for (size_t i = 0; i < payloadSize; i++)
+            data[32 + i] = static_cast<std::byte>(i * 7);
+        return data;
+    }
+    static std::filesystem::path cache_path(const std::string& name) {
+        auto directory = std::filesystem::temp_directory_path() / "nyan_pipeline_cache_tests";
+        std::filesystem::create_directories(directory);
+        auto path = directory / name;
+        std::filesystem::remove(path);
+        return path;
+    }
+    static std::vector<char> read_bytes(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    }
+    static void write_bytes(const std::filesystem::path& path, const std::vector<char>& bytes) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), bytes.size());
+    }
+    TEST(PipelineCacheFile, Roundtrip) {
+        const auto identity = test_identity();
+        const auto data = vulkan_data(identity, 1000);
+        const auto path = cache_path("roundtrip.cache");
+        PipelineCacheFile::write(path, identity, data);
+        EXPECT_FALSE(std::filesystem::exists(std::filesystem::path(path) += ".tmp"));
+        auto contents = PipelineCacheFile::read(path, identity);
+        EXPECT_EQ(contents.status, PipelineCacheFile::Status::Loaded);
+        EXPECT_EQ(contents.data, data);
+        //Overwriting replaces the previous contents
+        const auto smaller = vulkan_data(identity, 10);
+        PipelineCacheFile::write(path, identity, smaller);
+        contents = PipelineCacheFile::read(path, identity);
+        EXPECT_EQ(contents.status, PipelineCacheFile::Status::Loaded);
+        EXPECT_EQ(contents.data, smaller);
+    }
+    TEST(PipelineCacheFile, Missing) {
+        const auto path = cache_path("missing.cache");
+        auto contents = PipelineCacheFile::read(path, test_identity());
+        EXPECT_EQ(contents.status, PipelineCacheFile::Status::Missing);
+        EXPECT_TRUE(contents.data.empty());
+    }
+    TEST(PipelineCacheFile, Invalid) {
+        const auto identity = test_identity();
+        const auto path = cache_path("invalid.cache");
+        PipelineCacheFile::write(path, identity, vulkan_data(identity, 100));
+        auto bytes = read_bytes(path);
+        //Truncated
+        write_bytes(path, { bytes.begin(), bytes.end() - 1 });
+        EXPECT_EQ(PipelineCacheFile::read(path, identity).status, PipelineCacheFile::Status::Invalid);
+        write_bytes(path, { bytes.begin(), bytes.begin() + 4 });
+        EXPECT_EQ(PipelineCacheFile::read(path, identity).status, PipelineCacheFile::Status::Invalid);
+        write_bytes(path, {});
+        EXPECT_EQ(PipelineCacheFile::read(path, identity).status, PipelineCacheFile::Status::Invalid);
+        //Wrong magic
+        auto wrongMagic = bytes;
+        wrongMagic[0] ^= 0xFF;
+        write_bytes(path, wrongMagic);
+        EXPECT_EQ(PipelineCacheFile::read(path, identity).status, PipelineCacheFile::Status::Invalid);
+        //Other version
+        auto wrongVersion = bytes;
+        wrongVersion[4] += 1;
+        write_bytes(path, wrongVersion);
+        EXPECT_EQ(PipelineCacheFile::read(path, identity).status, PipelineCacheFile::Status::Invalid);
+    }
+    TEST(PipelineCacheFile, Mismatch) {
+        const auto identity = test_identity();
+        const auto path = cache_path("mismatch.cache");
+        PipelineCacheFile::write(path, identity, vulkan_data(identity, 100));
+        auto driverUpdate = identity;
+        driverUpdate.driverVersion++;
+        EXPECT_EQ(PipelineCacheFile::read(path, driverUpdate).status, PipelineCacheFile::Status::Mismatch);
+        auto otherDevice = identity;
+        otherDevice.pipelineCacheUUID[15] ^= 1;
+        auto contents = PipelineCacheFile::read(path, otherDevice);
+        EXPECT_EQ(contents.status, PipelineCacheFile::Status::Mismatch);
+        EXPECT_TRUE(contents.data.empty());
+    }
+    TEST(PipelineCacheFile, Corrupt) {
+        const auto identity = test_identity();
+        const auto path = cache_path("corrupt.cache");
+        PipelineCacheFile::write(path, identity, vulkan_data(identity, 100));
+        auto bytes = read_bytes(path);
+        bytes.back() ^= 0x1;
+        write_bytes(path, bytes);
+        EXPECT_EQ(PipelineCacheFile::read(path, identity).status, PipelineCacheFile::Status::Corrupt);
+        //Matching checksum, but the data itself belongs to another device
+        auto otherDevice = identity;
+        otherDevice.deviceID++;
+        PipelineCacheFile::write(path, identity, vulkan_data(otherDevice, 100));
+        EXPECT_EQ(PipelineCacheFile::read(path, identity).status, PipelineCacheFile::Status::Corrupt);
+    }
+    TEST(PipelineCacheFile, VulkanHeader) {
+        const auto identity = test_identity();
+        auto data = vulkan_data(identity, 16);
+        EXPECT_TRUE(PipelineCacheFile::is_valid_vulkan_data(data, identity));
+        EXPECT_FALSE(PipelineCacheFile::is_valid_vulkan_data(std::span(data).first(31), identity));
+        auto wrongSize = data;
+        wrongSize[0] = static_cast<std::byte>(16);
+        EXPECT_FALSE(PipelineCacheFile::is_valid_vulkan_data(wrongSize, identity));
+        auto wrongVersion = data;
+        wrongVersion[4] = static_cast<std::byte>(2);
+        EXPECT_FALSE(PipelineCacheFile::is_valid_vulkan_data(wrongVersion, identity));
+        auto otherVendor = identity;
+        otherVendor.vendorID = 0x1002;
+        EXPECT_FALSE(PipelineCacheFile::is_valid_vulkan_data(data, otherVendor));
+    }
+    TEST(PipelineCacheFile, Checksum) {
+        EXPECT_EQ(PipelineCacheFile::checksum({}), StreamHasher{}.finish());
+        const std::byte a[]{ std::byte{'a'} };
+        StreamHasher hasher;
+        hasher.update(a, sizeof(a));
+        EXPECT_EQ(PipelineCacheFile::checksum(a), hasher.finish());
+        const std::byte b[]{ std::byte{'b'} };
+        EXPECT_NE(PipelineCacheFile::checksum(a), PipelineCacheFile::checksum(b));
+    }
+}
@@ -0,0 +1,683 @@
+#include <gtest/gtest.h>
+#include "Renderer/RenderGraphCompiler.h"
+#include "Renderer/RenderGraphExporter.h"
+#include "Renderer/TransientMemoryPacker.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <random>
+namespace nyan {
+    using Access = RenderGraphDescription::Access;
+    static uint32_t add_resource(RenderGraphDescription& description, const std::string& name, bool exported = false) {
+        description.resources.push_back({ .name {name}, .exported {exported} });
+        return static_cast<uint32_t>(description.resources.size() - 1);
+    }
+    static uint32_t add_pass(RenderGraphDescription& description, const std::string& name, std::vector<Access> accesses, float cost = 1.f) {
+        description.passes.push_back({ .name {name}, .accesses {std::move(accesses)}, .cost {cost} });
+        return static_cast<uint32_t>(description.passes.size() - 1);
+    }
+    //Every dependency executes before its dependent and no culled pass is executed
+    static void expect_valid(const RenderGraphDescription& description, const RenderGraphPlan& plan) {
+        ASSERT_EQ(plan.get_pass_count(), description.passes.size());
+        for (uint32_t pass = 0; pass < description.passes.size(); pass++) {
+            if (plan.is_culled(pass)) {
+                EXPECT_TRUE(plan.get_dependencies(pass).empty());
+                continue;
+            }
+            EXPECT_EQ(plan.get_order()[plan.get_position(pass)], pass);
+            for (auto dependency : plan.get_dependencies(pass)) {
+                ASSERT_FALSE(plan.is_culled(dependency));
+                EXPECT_LT(plan.get_position(dependency), plan.get_position(pass));
+            }
+        }
+    }
+    //Deferred frame like the one set up by the RenderManager, plus a debug view nobody reads
+    struct DeferredFrame {
+        RenderGraphDescription description;
+        uint32_t albedo, normal, depth, diffuse, specular, debug, swapchain;
+        uint32_t gbufferPass, lightingPass, debugPass, forwardPass, compositePass, imguiPass;
+        DeferredFrame() {
+            albedo = add_resource(description, "albedo");
+            normal = add_resource(description, "normal");
+            depth = add_resource(description, "depth");
+            diffuse = add_resource(description, "diffuse");
+            specular = add_resource(description, "specular");
+            debug = add_resource(description, "debug");
+            swapchain = add_resource(description, "swapchain", true);
+            gbufferPass = add_pass(description, "GBuffer", { {albedo, Access::Type::Write}, {normal, Access::Type::Write}, {depth, Access::Type::Write} }, 4.f);
+            lightingPass = add_pass(description, "Lighting", { {albedo, Access::Type::Read}, {normal, Access::Type::Read}, {depth, Access::Type::Read},
+                {diffuse, Access::Type::ReadWrite}, {specular, Access::Type::ReadWrite} }, 2.f);
+            debugPass = add_pass(description, "Debug", { {normal, Access::Type::Read}, {debug, Access::Type::Write} });
+            forwardPass = add_pass(description, "Forward", { {depth, Access::Type::ReadWrite}, {diffuse, Access::Type::ReadWrite}, {specular, Access::Type::ReadWrite} });
+            compositePass = add_pass(description, "Composite", { {diffuse, Access::Type::Read}, {specular, Access::Type::Read}, {swapchain, Access::Type::Write} });
+            imguiPass = add_pass(description, "Imgui", { {swapchain, Access::Type::ReadWrite} });
+        }
+    };
+    TEST(RenderGraphCompiler, DeferredFrame) {
+        DeferredFrame frame;
+        const auto plan = RenderGraphCompiler::compile(frame.description);
+        expect_valid(frame.description, plan);
+        EXPECT_TRUE(plan.is_culled(frame.debugPass));
+        EXPECT_EQ(plan.get_order(), (std::vector<uint32_t>{ frame.gbufferPass, frame.lightingPass, frame.forwardPass, frame.compositePass, frame.imguiPass }));
+        EXPECT_FALSE(plan.get_lifetime(frame.debug).used());
+        EXPECT_EQ(plan.get_lifetime(frame.albedo).first, 0);
+        EXPECT_EQ(plan.get_lifetime(frame.albedo).last, 1);
+        EXPECT_EQ(plan.get_lifetime(frame.diffuse).first, 1);
+        EXPECT_EQ(plan.get_lifetime(frame.diffuse).last, 3);
+        EXPECT_EQ(plan.get_lifetime(frame.swapchain).last, 4);
+
+        //Exporting the debug view or disabling culling keeps the pass
+        frame.description.resources[frame.debug].exported = true;
+        EXPECT_FALSE(RenderGraphCompiler::compile(frame.description).is_culled(frame.debugPass));
+        frame.description.resources[frame.debug].exported = false;
+        EXPECT_FALSE(RenderGraphCompiler::compile(frame.description, { .cullPasses {false} }).is_culled(frame.debugPass));
+        frame.description.passes[frame.debugPass].sideEffects = true;
+        EXPECT_FALSE(RenderGraphCompiler::compile(frame.description).is_culled(frame.debugPass));
+    }
+    TEST(RenderGraphCompiler, CullingFollowsProducers) {
+        RenderGraphDescription description;
+        const auto history = add_resource(description, "history");
+        const auto scratch = add_resource(description, "scratch");
+        const auto overwritten = add_resource(description, "overwritten");
+        const auto output = add_resource(description, "output", true);
+        //Reads last frame's history before this frame writes it, which keeps the writer alive
+        const auto resolve = add_pass(description, "Resolve", { {history, Access::Type::Read}, {output, Access::Type::ReadWrite} });
+        const auto scratchPass = add_pass(description, "Scratch", { {scratch, Access::Type::Write} });
+        const auto historyPass = add_pass(description, "History", { {scratch, Access::Type::Read}, {history, Access::Type::Write} });
+        //Fully overwritten before anyone reads it, so the first writer is dead
+        const auto deadWrite = add_pass(description, "DeadWrite", { {overwritten, Access::Type::Write} });
+        const auto clear = add_pass(description, "Clear", { {overwritten, Access::Type::Write} });
+        const auto consume = add_pass(description, "Consume", { {overwritten, Access::Type::Read}, {output, Access::Type::ReadWrite} });
+        //Without writes the effects of a pass are unknown
+        const auto readback = add_pass(description, "Readback", { {output, Access::Type::Read} });
+        const auto plan = RenderGraphCompiler::compile(description);
+        expect_valid(description, plan);
+        EXPECT_FALSE(plan.is_culled(resolve));
+        EXPECT_FALSE(plan.is_culled(scratchPass));
+        EXPECT_FALSE(plan.is_culled(historyPass));
+        EXPECT_TRUE(plan.is_culled(deadWrite));
+        EXPECT_FALSE(plan.is_culled(clear));
+        EXPECT_FALSE(plan.is_culled(consume));
+        EXPECT_FALSE(plan.is_culled(readback));
+        //The history write has to wait for the read of the previous contents
+        EXPECT_LT(plan.get_position(resolve), plan.get_position(historyPass));
+        EXPECT_LT(plan.get_position(consume), plan.get_position(readback));
+    }
+    TEST(RenderGraphCompiler, CriticalPathFirst) {
+        RenderGraphDescription description;
+        const auto small = add_resource(description, "small");
+        const auto probes = add_resource(description, "probes");
+        const auto traced = add_resource(description, "traced");
+        const auto output = add_resource(description, "output", true);
+        const auto smallPass = add_pass(description, "Small", { {small, Access::Type::Write} });
+        //Declared later, but the chain behind it is longer and should start first
+        const auto tracePass = add_pass(description, "Trace", { {traced, Access::Type::Write} }, 8.f);
+        const auto probePass = add_pass(description, "Probes", { {traced, Access::Type::Read}, {probes, Access::Type::Write} }, 4.f);
+        const auto combine = add_pass(description, "Combine", { {small, Access::Type::Read}, {probes, Access::Type::Read}, {output, Access::Type::Write} });
+        const auto plan = RenderGraphCompiler::compile(description);
+        expect_valid(description, plan);
+        EXPECT_EQ(plan.get_order(), (std::vector<uint32_t>{ tracePass, probePass, smallPass, combine }));
+
+        //Equally long paths keep the declaration order
+        description.passes[smallPass].cost = 2.f;
+        description.passes[tracePass].cost = 1.f;
+        description.passes[probePass].cost = 1.f;
+        EXPECT_EQ(RenderGraphCompiler::compile(description).get_order(), (std::vector<uint32_t>{ smallPass, tracePass, probePass, combine }));
+    }
+    TEST(RenderGraphCompiler, ResourceUseOrder) {
+        RenderGraphDescription description;
+        const auto image = add_resource(description, "image");
+        const auto first = add_resource(description, "first", true);
+        const auto second = add_resource(description, "second", true);
+        const auto producer = add_pass(description, "Producer", { {image, Access::Type::Write} });
+        const auto cheapRead = add_pass(description, "CheapRead", { {image, Access::Type::Read}, {first, Access::Type::Write} });
+        const auto expensiveRead = add_pass(description, "ExpensiveRead", { {image, Access::Type::Read}, {second, Access::Type::Write} }, 10.f);
+        const auto reordered = RenderGraphCompiler::compile(description);
+        expect_valid(description, reordered);
+        EXPECT_EQ(reordered.get_order(), (std::vector<uint32_t>{ producer, expensiveRead, cheapRead }));
+        const auto ordered = RenderGraphCompiler::compile(description, { .orderResourceUses {true} });
+        expect_valid(description, ordered);
+        EXPECT_EQ(ordered.get_order(), (std::vector<uint32_t>{ producer, cheapRead, expensiveRead }));
+
+        description.passes[cheapRead].accesses.push_back({ 12345, Access::Type::Read });
+        EXPECT_THROW(RenderGraphCompiler::compile(description), std::out_of_range);
+    }
+    TEST(RenderGraphCompiler, NullBackend) {
+        DeferredFrame frame;
+        const auto plan = RenderGraphCompiler::compile(frame.description);
+        NullRenderGraphBackend backend;
+        backend.execute(plan);
+        EXPECT_EQ(backend.get_executed_passes(), plan.get_order());
+        backend.execute(plan);
+        EXPECT_EQ(backend.get_executed_passes().size(), plan.get_order().size());
+    }
+    //Transitions the Rendergraph records: between consecutive users of a resource and from the last use of the previous frame to the first one
+    static std::vector<RenderGraphBarrierSchedule::Transition> resource_transitions(const RenderGraphDescription& description, const RenderGraphPlan& plan) {
+        std::vector<RenderGraphBarrierSchedule::Transition> transitions;
+        for (uint32_t resource = 0; resource < description.resources.size(); resource++) {
+            std::vector<uint32_t> users;
+            for (auto pass : plan.get_order()) {
+                const auto& accesses = description.passes[pass].accesses;
+                if (std::any_of(accesses.begin(), accesses.end(), [resource](const Access& access) { return access.resource == resource; }))
+                    users.push_back(pass);
+            }
+            for (size_t i = 1; i < users.size(); i++)
+                transitions.push_back({ users[i - 1], users[i] });
+            if (users.size() > 1 && !description.resources[resource].exported)
+                transitions.push_back({ users.back(), users.front() });
+        }
+        return transitions;
+    }
+    TEST(RenderGraphCompiler, BarrierSchedule) {
+        DeferredFrame frame;
+        frame.description.resources[frame.debug].exported = true;
+        const auto plan = RenderGraphCompiler::compile(frame.description);
+        expect_valid(frame.description, plan);
+        ASSERT_EQ(plan.get_order(), (std::vector<uint32_t>{ frame.gbufferPass, frame.lightingPass, frame.forwardPass, frame.compositePass, frame.debugPass, frame.imguiPass }));
+        const auto transitions = resource_transitions(frame.description, plan);
+        const auto schedule = RenderGraphCompiler::schedule_barriers(plan, transitions);
+
+        for (uint32_t transition = 0; transition < transitions.size(); transition++) {
+            const auto [producer, consumer] = transitions[transition];
+            if (schedule.get_type(transition) == RenderGraphBarrierSchedule::Type::Barrier) {
+                EXPECT_EQ(schedule.get_event(transition), RenderGraphPlan::invalidIndex);
+                const auto& barriers = schedule.get_barriers(consumer);
+                EXPECT_NE(std::find(barriers.begin(), barriers.end(), transition), barriers.end());
+                continue;
+            }
+            //Only split if something runs between producer and consumer
+            EXPECT_LT(plan.get_position(producer) + 1, plan.get_position(consumer));
+            const auto event = schedule.get_event(transition);
+            ASSERT_LT(event, schedule.get_events().size());
+            EXPECT_EQ(schedule.get_events()[event].producer, producer);
+            EXPECT_EQ(schedule.get_events()[event].consumer, consumer);
+            const auto& sets = schedule.get_sets(producer);
+            const auto& waits = schedule.get_waits(consumer);
+            EXPECT_NE(std::find(sets.begin(), sets.end(), event), sets.end());
+            EXPECT_NE(std::find(waits.begin(), waits.end(), event), waits.end());
+        }
+        //Lighting -> Debug for the normals, Composite -> Imgui for the swapchain
+        ASSERT_EQ(schedule.get_events().size(), 2);
+        EXPECT_EQ(schedule.get_sets(frame.lightingPass).size(), 1);
+        EXPECT_EQ(schedule.get_waits(frame.debugPass).size(), 1);
+        EXPECT_EQ(schedule.get_sets(frame.compositePass).size(), 1);
+        EXPECT_EQ(schedule.get_waits(frame.imguiPass).size(), 1);
+        //Forward can start without waiting for the normals to be readable by Debug
+        EXPECT_TRUE(schedule.get_barriers(frame.debugPass).empty());
+        EXPECT_TRUE(schedule.get_barriers(frame.imguiPass).empty());
+
+        NullRenderGraphBackend backend;
+        backend.set_barrier_schedule(&schedule);
+        backend.execute(plan);
+        //One barrier per producer with outgoing transitions before, one per consumer with incoming transitions from the previous pass or frame now
+        std::vector<bool> producers(plan.get_pass_count());
+        for (const auto& transition : transitions)
+            producers[transition.producer] = true;
+        const auto postBarriers = std::count(producers.begin(), producers.end(), true);
+        EXPECT_EQ(postBarriers, 5);
+        EXPECT_EQ(backend.get_barrier_counts().pipelineBarriers, 4);
+        EXPECT_EQ(backend.get_barrier_counts().eventSets, 2);
+        EXPECT_EQ(backend.get_barrier_counts().eventWaits, 2);
+
+        //Events don't cross submissions, the swapchain transition becomes a barrier of the second batch
+        frame.description.passes[frame.compositePass].externalWait = true;
+        frame.description.passes[frame.debugPass].externalWait = true;
+        frame.description.passes[frame.imguiPass].externalWait = true;
+        const auto splitPlan = RenderGraphCompiler::compile(frame.description);
+        ASSERT_EQ(splitPlan.get_batches().size(), 2);
+        const auto splitTransitions = resource_transitions(frame.description, splitPlan);
+        const auto splitSchedule = RenderGraphCompiler::schedule_barriers(splitPlan, splitTransitions);
+        for (const auto& event : splitSchedule.get_events())
+            EXPECT_EQ(splitPlan.get_batch(event.producer), splitPlan.get_batch(event.consumer));
+        backend.set_barrier_schedule(&splitSchedule);
+        backend.execute(splitPlan);
+        EXPECT_EQ(backend.get_barrier_counts().eventSets, splitSchedule.get_events().size());
+    }
+    TEST(RenderGraphCompiler, Export) {
+        DeferredFrame frame;
+        frame.description.resources[frame.debug].name = "debug \"view\"";
+        const auto plan = RenderGraphCompiler::compile(frame.description);
+        const auto schedule = RenderGraphCompiler::schedule_barriers(plan, resource_transitions(frame.description, plan));
+        RenderGraphExporter::Stats stats;
+        stats.passes.resize(frame.description.passes.size());
+        for (uint32_t pass = 0; pass < frame.description.passes.size(); pass++) {
+            stats.passes[pass].barriers = static_cast<uint32_t>(schedule.get_barriers(pass).size());
+            stats.passes[pass].eventWaits = static_cast<uint32_t>(schedule.get_waits(pass).size());
+            stats.passes[pass].eventSets = static_cast<uint32_t>(schedule.get_sets(pass).size());
+        }
+        stats.passes[frame.gbufferPass].cpuTime = 0.25f;
+        stats.passes[frame.gbufferPass].gpuTime = 1.5f;
+        //Only the G-buffer entries, the rest is written as defaults
+        stats.resources.resize(frame.depth + 1);
+        stats.resources[frame.depth] = { .transientSize {8 << 20}, .heap {0}, .offset {4096} };
+
+        const auto json = RenderGraphExporter::to_json(frame.description, plan, stats);
+        EXPECT_EQ(json, RenderGraphExporter::to_json(frame.description, plan, stats));
+        EXPECT_NE(json.find("{\"index\": 0, \"name\": \"GBuffer\", \"queue\": \"Graphics\", \"culled\": false, \"position\": 0, \"batch\": 0, "
+            "\"dependencies\": [], \"accesses\": [{\"resource\": 0, \"type\": \"Write\"}, {\"resource\": 1, \"type\": \"Write\"}, {\"resource\": 2, \"type\": \"Write\"}], "
+            "\"cost\": 4.000, \"cpuTimeMs\": 0.250, \"gpuTimeMs\": 1.500, \"barriers\": 3, \"eventWaits\": 0, \"eventSets\": 0},\n"), std::string::npos) << json;
+        EXPECT_NE(json.find("\"name\": \"Debug\", \"queue\": \"Graphics\", \"culled\": true, \"position\": null, \"batch\": null"), std::string::npos);
+        EXPECT_NE(json.find("{\"index\": 2, \"name\": \"depth\", \"exported\": false, \"first\": 0, \"last\": 2, \"transientSize\": 8388608, \"heap\": 0, \"offset\": 4096},\n"), std::string::npos);
+        EXPECT_NE(json.find("\"name\": \"debug \\\"view\\\"\", \"exported\": false, \"first\": null, \"last\": null, \"transientSize\": 0, \"heap\": null"), std::string::npos);
+        EXPECT_NE(json.find("{\"index\": 0, \"queue\": \"Graphics\", \"begin\": 0, \"end\": 5, \"waits\": [], \"signals\": false}\n"), std::string::npos);
+        //One line per pass, resource and batch, so diffs between builds stay local
+        EXPECT_EQ(std::count(json.begin(), json.end(), '\n'), 3 + 3 * 2 + frame.description.passes.size() + frame.description.resources.size() + plan.get_batches().size());
+
+        const auto dot = RenderGraphExporter::to_dot(frame.description, plan, stats);
+        EXPECT_NE(dot.find("subgraph cluster_batch0 {"), std::string::npos);
+        EXPECT_NE(dot.find("\t\tpass0 [shape=box, label=\"GBuffer\\nGraphics | cpu 0.250 ms | gpu 1.500 ms\\nbarriers 3 | waits 0 | sets 0\"];"), std::string::npos) << dot;
+        EXPECT_NE(dot.find("\tpass2 [shape=box, label=\"Debug\\nGraphics | cpu null ms | gpu null ms\\nbarriers 0 | waits 0 | sets 0\", style=dashed];"), std::string::npos) << dot;
+        EXPECT_NE(dot.find("resource2 [shape=ellipse, label=\"depth\\n[0, 2]\\n8.000 MiB transient\"];"), std::string::npos) << dot;
+        EXPECT_NE(dot.find("resource6 [shape=ellipse, label=\"swapchain\\n[3, 4]\", peripheries=2];"), std::string::npos) << dot;
+        EXPECT_NE(dot.find("pass0 -> resource0;"), std::string::npos);
+        EXPECT_NE(dot.find("resource0 -> pass1;"), std::string::npos);
+        EXPECT_NE(dot.find("resource3 -> pass1;\n\tpass1 -> resource3;"), std::string::npos);
+    }
+    TEST(RenderGraphCompiler, CompileThroughput) {
+        //Random layered graph, far larger than any real frame
+        constexpr uint32_t passCount = 2000;
+        constexpr uint32_t resourceCount = 3000;
+        std::mt19937 rng(11);
+        RenderGraphDescription description;
+        for (uint32_t i = 0; i < resourceCount; i++)
+            add_resource(description, "resource" + std::to_string(i), i % 97 == 0);
+        std::uniform_int_distribution<uint32_t> resourceDistribution(0, resourceCount - 1);
+        std::uniform_int_distribution<uint32_t> typeDistribution(0, 2);
+        std::uniform_real_distribution<float> costDistribution(0.1f, 4.f);
+        for (uint32_t i = 0; i < passCount; i++) {
+            std::vector<Access> accesses;
+            for (uint32_t j = 0; j < 6; j++)
+                accesses.push_back({ resourceDistribution(rng), static_cast<Access::Type>(typeDistribution(rng)) });
+            add_pass(description, "pass" + std::to_string(i), std::move(accesses), costDistribution(rng));
+        }
+        NullRenderGraphBackend backend;
+        constexpr int iterations = 20;
+        auto start = std::chrono::steady_clock::now();
+        RenderGraphPlan plan;
+        for (int i = 0; i < iterations; i++) {
+            plan = RenderGraphCompiler::compile(description, { .orderResourceUses {true} });
+            backend.execute(plan);
+        }
+        auto end = std::chrono::steady_clock::now();
+        [[maybe_unused]] const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / iterations;
+        //std::cout << "Compiled " << passCount << " passes in " << microseconds << "us, " << plan.get_order().size() << " survived culling\n";
+        expect_valid(description, plan);
+        EXPECT_EQ(backend.get_executed_passes(), plan.get_order());
+    }
+    //Batches cover the execution order in sequence and every cross-queue dependency is covered by a wait
+    static void expect_valid_batches(const RenderGraphDescription& description, const RenderGraphPlan& plan) {
+        const auto& batches = plan.get_batches();
+        uint32_t position = 0;
+        for (uint32_t batch = 0; batch < batches.size(); batch++) {
+            ASSERT_EQ(batches[batch].begin, position);
+            ASSERT_LT(batches[batch].begin, batches[batch].end);
+            position = batches[batch].end;
+            for (auto wait : batches[batch].waits) {
+                EXPECT_LT(wait, batch);
+                EXPECT_NE(batches[wait].queue, batches[batch].queue);
+                EXPECT_TRUE(batches[wait].signals);
+            }
+            for (auto i = batches[batch].begin; i < batches[batch].end; i++) {
+                const auto pass = plan.get_order()[i];
+                EXPECT_EQ(plan.get_batch(pass), batch);
+                EXPECT_EQ(plan.get_queue(pass), batches[batch].queue);
+                if (!description.passes[pass].asyncCompute)
+                    EXPECT_EQ(description.passes[pass].queue, plan.get_queue(pass));
+                for (auto dependency : plan.get_dependencies(pass)) {
+                    const auto producer = plan.get_batch(dependency);
+                    if (batches[producer].queue == batches[batch].queue) {
+                        EXPECT_LE(producer, batch);
+                        continue;
+                    }
+                    const auto& waits = batches[batch].waits;
+                    EXPECT_TRUE(std::any_of(waits.begin(), waits.end(), [&](uint32_t wait) { return batches[wait].queue == batches[producer].queue && wait >= producer; }))
+                        << description.passes[pass].name << " doesn't wait for " << description.passes[dependency].name;
+                }
+            }
+        }
+        EXPECT_EQ(position, plan.get_order().size());
+    }
+    TEST(RenderGraphCompiler, Batching) {
+        DeferredFrame frame;
+        auto plan = RenderGraphCompiler::compile(frame.description);
+        expect_valid_batches(frame.description, plan);
+        ASSERT_EQ(plan.get_batches().size(), 1);
+        EXPECT_TRUE(plan.get_batches()[0].waits.empty());
+        EXPECT_EQ(plan.get_batch(frame.debugPass), RenderGraphPlan::invalidIndex);
+
+        //Only the passes touching the swapchain wait for its acquisition
+        frame.description.passes[frame.compositePass].externalWait = true;
+        frame.description.passes[frame.imguiPass].externalWait = true;
+        plan = RenderGraphCompiler::compile(frame.description);
+        expect_valid_batches(frame.description, plan);
+        ASSERT_EQ(plan.get_batches().size(), 2);
+        EXPECT_EQ(plan.get_batch(frame.forwardPass), 0);
+        EXPECT_EQ(plan.get_batch(frame.compositePass), 1);
+        EXPECT_EQ(plan.get_batch(frame.imguiPass), 1);
+
+        //Ambient occlusion on the compute queue splits the graphics work only around its wait and signal
+        RenderGraphDescription description;
+        const auto depth = add_resource(description, "depth");
+        const auto ao = add_resource(description, "ao");
+        const auto shadow = add_resource(description, "shadow");
+        const auto lit = add_resource(description, "lit", true);
+        const auto depthPass = add_pass(description, "Depth", { {depth, Access::Type::Write} });
+        const auto aoPass = add_pass(description, "AO", { {depth, Access::Type::Read}, {ao, Access::Type::Write} }, 2.f);
+        description.passes[aoPass].queue = RenderGraphDescription::Queue::Compute;
+        const auto shadowPass = add_pass(description, "Shadow", { {shadow, Access::Type::Write} });
+        const auto cascadePass = add_pass(description, "Cascades", { {shadow, Access::Type::ReadWrite} });
+        const auto lightingPass = add_pass(description, "Lighting", { {ao, Access::Type::Read}, {shadow, Access::Type::Read}, {lit, Access::Type::Write} });
+        const auto postPass = add_pass(description, "Post", { {lit, Access::Type::ReadWrite} });
+        plan = RenderGraphCompiler::compile(description);
+        expect_valid(description, plan);
+        expect_valid_batches(description, plan);
+        EXPECT_EQ(plan.get_order(), (std::vector<uint32_t>{ depthPass, aoPass, shadowPass, cascadePass, lightingPass, postPass }));
+        ASSERT_EQ(plan.get_batches().size(), 4);
+        EXPECT_EQ(plan.get_batch(depthPass), 0);
+        EXPECT_EQ(plan.get_batch(aoPass), 1);
+        EXPECT_EQ(plan.get_batch(shadowPass), 2);
+        EXPECT_EQ(plan.get_batch(cascadePass), 2);
+        EXPECT_EQ(plan.get_batch(lightingPass), 3);
+        EXPECT_EQ(plan.get_batch(postPass), 3);
+        EXPECT_TRUE(plan.get_batches()[0].signals);
+        EXPECT_EQ(plan.get_batches()[1].waits, (std::vector<uint32_t>{ 0 }));
+        EXPECT_TRUE(plan.get_batches()[2].waits.empty());
+        EXPECT_EQ(plan.get_batches()[3].waits, (std::vector<uint32_t>{ 1 }));
+        EXPECT_FALSE(plan.get_batches()[3].signals);
+
+        NullRenderGraphBackend backend;
+        backend.execute(plan);
+        EXPECT_EQ(backend.get_executed_passes(), plan.get_order());
+        EXPECT_EQ(backend.get_submitted_batches(), (std::vector<uint32_t>{ 0, 1, 2, 3 }));
+    }
+    TEST(RenderGraphCompiler, SubmitOverhead) {
+        //Random graph with a third of the passes on the compute queue, one submit per pass before batching
+        constexpr uint32_t passCount = 500;
+        constexpr uint32_t resourceCount = 600;
+        std::mt19937 rng(5);
+        RenderGraphDescription description;
+        for (uint32_t i = 0; i < resourceCount; i++)
+            add_resource(description, "resource" + std::to_string(i), i % 31 == 0);
+        std::uniform_int_distribution<uint32_t> resourceDistribution(0, resourceCount - 1);
+        std::uniform_int_distribution<uint32_t> typeDistribution(0, 2);
+        for (uint32_t i = 0; i < passCount; i++) {
+            std::vector<Access> accesses;
+            for (uint32_t j = 0; j < 3; j++)
+                accesses.push_back({ resourceDistribution(rng), static_cast<Access::Type>(typeDistribution(rng)) });
+            add_pass(description, "pass" + std::to_string(i), std::move(accesses));
+            if (rng() % 3 == 0)
+                description.passes.back().queue = RenderGraphDescription::Queue::Compute;
+        }
+        auto start = std::chrono::steady_clock::now();
+        const auto plan = RenderGraphCompiler::compile(description, { .orderResourceUses {true} });
+        auto end = std::chrono::steady_clock::now();
+        [[maybe_unused]] const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        expect_valid(description, plan);
+        expect_valid_batches(description, plan);
+        NullRenderGraphBackend backend;
+        backend.execute(plan);
+        EXPECT_EQ(backend.get_executed_passes(), plan.get_order());
+        EXPECT_EQ(backend.get_submitted_batches().size(), plan.get_batches().size());
+        //std::cout << plan.get_order().size() << " passes in " << plan.get_batches().size() << " submits, compiled in " << microseconds << "us\n";
+        EXPECT_LT(plan.get_batches().size(), plan.get_order().size());
+    }
+    TEST(RenderGraphCompiler, AsyncComputeScheduling) {
+        //DDGI probe update, border copy and relocation don't depend on the G-Buffer and overlap it on the compute queue
+        RenderGraphDescription description;
+        const auto depth = add_resource(description, "depth");
+        const auto albedo = add_resource(description, "albedo");
+        const auto irradiance = add_resource(description, "irradiance");
+        const auto offsets = add_resource(description, "offsets");
+        const auto lit = add_resource(description, "lit");
+        const auto swapchain = add_resource(description, "swapchain", true);
+        const auto gbufferPass = add_pass(description, "GBuffer", { {depth, Access::Type::Write}, {albedo, Access::Type::Write} }, 4.f);
+        const auto probePass = add_pass(description, "ProbeUpdate", { {irradiance, Access::Type::ReadWrite} }, 2.f);
+        const auto borderPass = add_pass(description, "BorderCopy", { {irradiance, Access::Type::ReadWrite} }, 0.5f);
+        const auto relocationPass = add_pass(description, "Relocation", { {irradiance, Access::Type::Read}, {offsets, Access::Type::ReadWrite} }, 0.5f);
+        const auto lightingPass = add_pass(description, "Lighting", { {depth, Access::Type::Read}, {albedo, Access::Type::Read},
+            {irradiance, Access::Type::Read}, {offsets, Access::Type::Read}, {lit, Access::Type::Write} }, 2.f);
+        //Consumes the lighting directly, moving it only adds two cross-queue waits
+        const auto blurPass = add_pass(description, "Blur", { {lit, Access::Type::ReadWrite} }, 1.f);
+        const auto compositePass = add_pass(description, "Composite", { {lit, Access::Type::Read}, {swapchain, Access::Type::Write} }, 1.f);
+        for (auto pass : { probePass, borderPass, relocationPass, blurPass })
+            description.passes[pass].asyncCompute = true;
+
+        auto plan = RenderGraphCompiler::compile(description);
+        expect_valid_batches(description, plan);
+        for (uint32_t pass = 0; pass < description.passes.size(); pass++)
+            EXPECT_EQ(plan.get_queue(pass), RenderGraphDescription::Queue::Graphics);
+        EXPECT_FLOAT_EQ(plan.get_estimated_time(), 11.f);
+        EXPECT_EQ(plan.get_batches().size(), 1);
+
+        const RenderGraphCompiler::Settings settings{ .scheduleAsyncCompute {true}, .queueSyncCost {0.1f} };
+        plan = RenderGraphCompiler::compile(description, settings);
+        expect_valid(description, plan);
+        expect_valid_batches(description, plan);
+        EXPECT_EQ(plan.get_queue(probePass), RenderGraphDescription::Queue::Compute);
+        EXPECT_EQ(plan.get_queue(borderPass), RenderGraphDescription::Queue::Compute);
+        EXPECT_EQ(plan.get_queue(relocationPass), RenderGraphDescription::Queue::Compute);
+        EXPECT_EQ(plan.get_queue(blurPass), RenderGraphDescription::Queue::Graphics);
+        EXPECT_EQ(plan.get_queue(gbufferPass), RenderGraphDescription::Queue::Graphics);
+        EXPECT_EQ(plan.get_queue(lightingPass), RenderGraphDescription::Queue::Graphics);
+        EXPECT_EQ(plan.get_queue(compositePass), RenderGraphDescription::Queue::Graphics);
+        //The probe work finishes at 3 + 0.1 for the wait, before the G-Buffer at 4
+        EXPECT_FLOAT_EQ(plan.get_estimated_time(), 8.f);
+        EXPECT_EQ(plan.get_batch(lightingPass), plan.get_batch(compositePass));
+        EXPECT_EQ(plan.get_batches()[plan.get_batch(lightingPass)].waits, (std::vector<uint32_t>{ plan.get_batch(relocationPass) }));
+
+        //Once the G-Buffer gets cheap, the probe chain is the critical path and waiting for it costs more than it saves
+        description.passes[gbufferPass].cost = 0.05f;
+        plan = RenderGraphCompiler::compile(description, settings);
+        expect_valid_batches(description, plan);
+        for (uint32_t pass = 0; pass < description.passes.size(); pass++)
+            EXPECT_EQ(plan.get_queue(pass), RenderGraphDescription::Queue::Graphics);
+        EXPECT_FLOAT_EQ(plan.get_estimated_time(), 7.05f);
+    }
+    TEST(RenderGraphCompiler, PlanCache) {
+        DeferredFrame frame;
+        const auto hash = RenderGraphCompiler::hash(frame.description, RenderGraphCompiler::compile(frame.description));
+        EXPECT_EQ(RenderGraphCompiler::hash(frame.description, RenderGraphCompiler::compile(frame.description)), hash);
+        //Costs which don't change the order don't change the plan
+        frame.description.passes[frame.lightingPass].cost = 3.f;
+        EXPECT_EQ(RenderGraphCompiler::hash(frame.description, RenderGraphCompiler::compile(frame.description)), hash);
+        frame.description.resources[frame.debug].exported = true;
+        const auto debugHash = RenderGraphCompiler::hash(frame.description, RenderGraphCompiler::compile(frame.description));
+        EXPECT_NE(debugHash, hash);
+        frame.description.passes[frame.forwardPass].queue = RenderGraphDescription::Queue::Compute;
+        EXPECT_NE(RenderGraphCompiler::hash(frame.description, RenderGraphCompiler::compile(frame.description)), debugHash);
+        frame.description.passes[frame.forwardPass].queue = RenderGraphDescription::Queue::Graphics;
+
+        //Toggling the debug view back and forth only compiles each variant once
+        RenderGraphPlanCache<RenderGraphPlan> cache(2);
+        for (int frameIndex = 0; frameIndex < 10; frameIndex++) {
+            frame.description.resources[frame.debug].exported = frameIndex % 2;
+            auto plan = RenderGraphCompiler::compile(frame.description);
+            const auto key = RenderGraphCompiler::hash(frame.description, plan);
+            const auto* cached = cache.find(key);
+            if (!cached)
+                cached = &cache.insert(key, std::move(plan));
+            EXPECT_EQ(cached->is_culled(frame.debugPass), frameIndex % 2 == 0);
+        }
+        EXPECT_EQ(cache.get_misses(), 2);
+        EXPECT_EQ(cache.get_hits(), 8);
+        EXPECT_EQ(cache.size(), 2);
+
+        //The least recently used plan is evicted first
+        ASSERT_NE(cache.find(hash), nullptr);
+        cache.insert(1, RenderGraphPlan{});
+        EXPECT_EQ(cache.size(), 2);
+        EXPECT_EQ(cache.find(debugHash), nullptr);
+        EXPECT_NE(cache.find(hash), nullptr);
+        EXPECT_NE(cache.find(1), nullptr);
+    }
+    static bool lifetimes_overlap(const RenderGraphPlan::Lifetime& lhs, const RenderGraphPlan::Lifetime& rhs) {
+        return lhs.first <= rhs.last && rhs.first <= lhs.last;
+    }
+    //No two resources alive at the same time share memory and every shared range is reported as alias
+    static void expect_valid(std::span<const TransientMemoryPacker::Resource> resources, const TransientMemoryPacker::Packing& packing) {
+        ASSERT_EQ(packing.placements.size(), resources.size());
+        for (uint32_t i = 0; i < resources.size(); i++) {
+            const auto& placement = packing.placements[i];
+            if (!resources[i].lifetime.used()) {
+                EXPECT_FALSE(placement.placed());
+                continue;
+            }
+            ASSERT_TRUE(placement.placed());
+            const auto& heap = packing.heaps[placement.heap];
+            EXPECT_EQ(heap.memoryTypeBits, resources[i].memoryTypeBits);
+            EXPECT_EQ(placement.size, resources[i].size);
+            EXPECT_EQ(placement.offset % resources[i].alignment, 0);
+            EXPECT_EQ(heap.alignment % resources[i].alignment, 0);
+            EXPECT_LE(placement.offset + resources[i].size, heap.size);
+            for (uint32_t j = i + 1; j < resources.size(); j++) {
+                const auto& other = packing.placements[j];
+                if (!other.placed() || other.heap != placement.heap)
+                    continue;
+                const bool sharesMemory = placement.offset < other.offset + resources[j].size && other.offset < placement.offset + resources[i].size;
+                if (sharesMemory)
+                    EXPECT_FALSE(lifetimes_overlap(resources[i].lifetime, resources[j].lifetime)) << i << " and " << j << " are alive at the same time";
+                const auto& aliases = packing.aliases[i];
+                EXPECT_EQ(sharesMemory, std::find(aliases.begin(), aliases.end(), j) != aliases.end());
+            }
+        }
+    }
+    TEST(TransientMemoryPacker, DisjointLifetimesShareMemory) {
+        constexpr uint64_t mebibyte = 1 << 20;
+        const std::vector<TransientMemoryPacker::Resource> resources{
+            { .lifetime {0, 1}, .size {8 * mebibyte}, .alignment {65536} },
+            { .lifetime {2, 3}, .size {8 * mebibyte}, .alignment {65536} },
+            { .lifetime {1, 2}, .size {4 * mebibyte}, .alignment {65536} },
+            { .lifetime {3, 3}, .size {2 * mebibyte}, .alignment {65536} },
+            { .lifetime {}, .size {64 * mebibyte}, .alignment {65536} },
+        };
+        const auto packing = TransientMemoryPacker::pack(resources);
+        expect_valid(resources, packing);
+        ASSERT_EQ(packing.heaps.size(), 1);
+        EXPECT_EQ(packing.placements[0].offset, packing.placements[1].offset);
+        EXPECT_EQ(packing.aliases[0], (std::vector<uint32_t>{ 1 }));
+        EXPECT_EQ(packing.aliases[2], (std::vector<uint32_t>{ 3 }));
+        EXPECT_FALSE(packing.placements[4].placed());
+        EXPECT_EQ(packing.get_size(), 12 * mebibyte);
+        EXPECT_EQ(packing.unaliasedSize, 22 * mebibyte);
+    }
+    TEST(TransientMemoryPacker, AlignmentAndMemoryTypes) {
+        const std::vector<TransientMemoryPacker::Resource> resources{
+            { .lifetime {0, 0}, .size {1000}, .alignment {256}, .memoryTypeBits {0b01} },
+            { .lifetime {0, 0}, .size {1000}, .alignment {4096}, .memoryTypeBits {0b01} },
+            { .lifetime {1, 1}, .size {1000}, .alignment {256}, .memoryTypeBits {0b10} },
+            { .lifetime {0, 1}, .size {100}, .alignment {1024}, .memoryTypeBits {0b01} },
+        };
+        const auto packing = TransientMemoryPacker::pack(resources);
+        expect_valid(resources, packing);
+        ASSERT_EQ(packing.heaps.size(), 2);
+        EXPECT_NE(packing.placements[0].heap, packing.placements[2].heap);
+        EXPECT_EQ(packing.heaps[packing.placements[0].heap].alignment, 4096);
+        EXPECT_TRUE(packing.aliases[2].empty());
+    }
+    TEST(TransientMemoryPacker, RandomLifetimes) {
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<uint32_t> positionDistribution(0, 63);
+        std::uniform_int_distribution<uint64_t> sizeDistribution(1, 1 << 24);
+        std::uniform_int_distribution<uint32_t> alignmentDistribution(0, 16);
+        std::vector<TransientMemoryPacker::Resource> resources(500);
+        for (auto& resource : resources) {
+            auto first = positionDistribution(rng);
+            auto last = positionDistribution(rng);
+            resource.lifetime = { std::min(first, last), std::max(first, last) };
+            resource.size = sizeDistribution(rng);
+            resource.alignment = 1ull << alignmentDistribution(rng);
+            resource.memoryTypeBits = 1u << (rng() % 2);
+        }
+        auto start = std::chrono::steady_clock::now();
+        const auto packing = TransientMemoryPacker::pack(resources);
+        auto end = std::chrono::steady_clock::now();
+        [[maybe_unused]] const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        //std::cout << "Packed " << resources.size() << " resources in " << microseconds << "us\n";
+        expect_valid(resources, packing);
+        //Memory alive at the busiest position is a lower bound for any packing
+        uint64_t peak{ 0 };
+        for (uint32_t position = 0; position < 64; position++) {
+            uint64_t alive{ 0 };
+            for (const auto& resource : resources)
+                if (resource.lifetime.first <= position && position <= resource.lifetime.last)
+                    alive += resource.size;
+            peak = std::max(peak, alive);
+        }
+        EXPECT_LE(packing.get_size(), packing.unaliasedSize);
+        //Alignment padding aside, first fit stays close to the optimum
+        EXPECT_LT(packing.get_size(), peak * 2);
+    }
+    //Memory requirements of optimally tiled render targets, padded to the usual 64KiB
+    static TransientMemoryPacker::Resource render_target(const RenderGraphPlan& plan, uint32_t resource, uint32_t width, uint32_t height, uint32_t texelSize) {
+        constexpr uint64_t alignment = 65536;
+        const uint64_t size = (static_cast<uint64_t>(width) * height * texelSize + alignment - 1) / alignment * alignment;
+        return { .lifetime {plan.get_lifetime(resource)}, .size {size}, .alignment {alignment} };
+    }
+    TEST(TransientMemoryPacker, RealPassSetups) {
+        constexpr uint32_t width = 1920;
+        constexpr uint32_t height = 1080;
+        //Frame of the GLTF and DDGI samples, the lighting targets are written by compute without clear and persist
+        RenderGraphDescription description;
+        const auto albedo = add_resource(description, "gbuffer_albedo");
+        const auto normal = add_resource(description, "gbuffer_normal");
+        const auto pbr = add_resource(description, "gbuffer_pbr");
+        const auto depth = add_resource(description, "gbuffer_depth");
+        const auto diffuse = add_resource(description, "lighting_diffuse");
+        const auto specular = add_resource(description, "lightingspecular");
+        const auto irradiance = add_resource(description, "DDGI_Irradiance_0");
+        const auto swapchain = add_resource(description, "swapchain", true);
+        add_pass(description, "DDGI-Pass", { {irradiance, Access::Type::ReadWrite} });
+        add_pass(description, "Deferred-Pass", { {depth, Access::Type::Write}, {albedo, Access::Type::Write}, {normal, Access::Type::Write}, {pbr, Access::Type::Write} });
+        add_pass(description, "Deferred-Lighting-Pass", { {albedo, Access::Type::Read}, {normal, Access::Type::Read}, {pbr, Access::Type::Read}, {depth, Access::Type::Read},
+            {diffuse, Access::Type::ReadWrite}, {specular, Access::Type::ReadWrite}, {irradiance, Access::Type::Read} });
+        add_pass(description, "Forward-Pass", { {depth, Access::Type::ReadWrite}, {specular, Access::Type::ReadWrite}, {diffuse, Access::Type::ReadWrite}, {irradiance, Access::Type::Read} });
+        const auto compositePass = add_pass(description, "Composite-Pass", { {diffuse, Access::Type::Read}, {specular, Access::Type::Read}, {swapchain, Access::Type::Write} });
+        add_pass(description, "Imgui-Pass", { {swapchain, Access::Type::ReadWrite} });
+        auto plan = RenderGraphCompiler::compile(description, { .orderResourceUses {true} });
+        std::vector<TransientMemoryPacker::Resource> resources{
+            render_target(plan, albedo, width, height, 4),
+            render_target(plan, normal, width, height, 4),
+            render_target(plan, pbr, width, height, 4),
+            render_target(plan, depth, width, height, 8),
+        };
+        auto packing = TransientMemoryPacker::pack(resources);
+        expect_valid(resources, packing);
+        //The G-buffer is consumed by a single pass, all of it is alive at once
+        EXPECT_EQ(packing.get_size(), packing.unaliasedSize);
+        //std::cout << "Deferred frame: " << packing.get_size() / (1 << 20) << " MiB transient, " << packing.unaliasedSize / (1 << 20) << " MiB without aliasing\n";
+
+        //Same frame with a bloom chain between lighting and composite, every level is cleared and dead after the next one
+        const auto brightPass = add_resource(description, "bloom_bright");
+        std::vector<uint32_t> bloomLevels;
+        for (uint32_t level = 0; level < 5; level++)
+            bloomLevels.push_back(add_resource(description, "bloom_" + std::to_string(level)));
+        const auto bloom = add_resource(description, "bloom");
+        description.passes.insert(description.passes.begin() + compositePass, RenderGraphDescription::Pass{ .name {"Bloom-Bright-Pass"},
+            .accesses { {diffuse, Access::Type::Read}, {specular, Access::Type::Read}, {brightPass, Access::Type::Write} } });
+        auto previous = brightPass;
+        for (uint32_t level = 0; level < bloomLevels.size(); level++) {
+            description.passes.insert(description.passes.begin() + compositePass + 1 + level, RenderGraphDescription::Pass{ .name {"Bloom-Downsample-Pass"},
+                .accesses { {previous, Access::Type::Read}, {bloomLevels[level], Access::Type::Write} } });
+            previous = bloomLevels[level];
+        }
+        description.passes.insert(description.passes.begin() + compositePass + 1 + static_cast<uint32_t>(bloomLevels.size()), RenderGraphDescription::Pass{ .name {"Bloom-Combine-Pass"},
+            .accesses { {bloomLevels[1], Access::Type::Read}, {previous, Access::Type::Read}, {bloom, Access::Type::Write} } });
+        //Composite-Pass moved behind the inserted passes
+        description.passes[compositePass + 2 + bloomLevels.size()].accesses.push_back({ bloom, Access::Type::Read });
+        plan = RenderGraphCompiler::compile(description, { .orderResourceUses {true} });
+        expect_valid(description, plan);
+        resources.push_back(render_target(plan, brightPass, width / 2, height / 2, 8));
+        for (uint32_t level = 0; level < bloomLevels.size(); level++)
+            resources.push_back(render_target(plan, bloomLevels[level], width >> (level + 2), height >> (level + 2), 8));
+        resources.push_back(render_target(plan, bloom, width / 2, height / 2, 8));
+        for (uint32_t i = 0; i < 4; i++)
+            resources[i].lifetime = plan.get_lifetime(std::array{ albedo, normal, pbr, depth }[i]);
+        packing = TransientMemoryPacker::pack(resources);
+        expect_valid(resources, packing);
+        //The bloom targets live in memory of the G-buffer, which is dead by then
+        EXPECT_EQ(packing.heaps.size(), 1);
+        EXPECT_LT(packing.get_size(), packing.unaliasedSize);
+        EXPECT_FALSE(packing.aliases[4].empty());
+        //std::cout << "Deferred frame with bloom: " << packing.get_size() / (1 << 20) << " MiB transient, " << packing.unaliasedSize / (1 << 20) << " MiB without aliasing\n";
+    }
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "Utility/JobSystem.h"
+#include "Utility/ShaderReflectionCache.h"
+#include <atomic>
+#include <fstream>
+namespace Utility {
+    static ShaderReflection test_reflection(uint32_t seed) {
+        return ShaderReflection{
+            .stage {5},
+            .pushConstantSize {16 * seed},
+            .workgroupSize {8, 8, 1},
+            .bindings {
+                { .set {0}, .binding {0}, .descriptorType {7}, .count {1} },
+                { .set {0}, .binding {seed}, .descriptorType {1}, .count {0} },
+            },
+            .specializationConstants {
+                { .name {"local_size_x"}, .id {0}, .type {5} },
+                { .name {"samples_" + std::to_string(seed)}, .id {seed + 1}, .type {11} },
+            },
+        };
+    }
+    static std::vector<uint32_t> test_code(uint32_t seed, size_t size = 64) {
+        std::vector<uint32_t> code(size);
+        code[0] = 0x07230203;
+        for (size_t i = 1; i < size; i++)
+            code[i] = static_cast<uint32_t>(i * 31 + seed);
+        return code;
+    }
+    static std::filesystem::path reflection_cache_path(const std::string& name) {
+        auto directory = std::filesystem::temp_directory_path() / "nyan_shader_reflection_tests";
+        std::filesystem::create_directories(directory);
+        auto path = directory / name;
+        std::filesystem::remove(path);
+        return path;
+    }
+    TEST(ShaderReflectionCache, Serialization) {
+        std::unordered_map<uint64_t, ShaderReflection> entries;
+        for (uint32_t i = 0; i < 5; i++)
+            entries.emplace(1000 + i, test_reflection(i));
+        entries.emplace(7, ShaderReflection{});
+        const auto data = ShaderReflectionCache::serialize(entries);
+        auto loaded = ShaderReflectionCache::deserialize(data);
+        ASSERT_TRUE(loaded);
+        EXPECT_EQ(*loaded, entries);
+        //Independent of the insertion order
+        std::unordered_map<uint64_t, ShaderReflection> reversed;
+        for (uint32_t i = 5; i-- > 0;)
+            reversed.emplace(1000 + i, test_reflection(i));
+        reversed.emplace(7, ShaderReflection{});
+        EXPECT_EQ(ShaderReflectionCache::serialize(reversed), data);
+        //Every truncation is rejected
+        for (size_t size = 0; size < data.size(); size++)
+            EXPECT_FALSE(ShaderReflectionCache::deserialize(std::span(data).first(size))) << size;
+        auto corrupt = data;
+        corrupt.back() ^= std::byte{ 1 };
+        EXPECT_FALSE(ShaderReflectionCache::deserialize(corrupt));
+        auto otherVersion = data;
+        otherVersion[4] ^= std::byte{ 1 };
+        EXPECT_FALSE(ShaderReflectionCache::deserialize(otherVersion));
+    }
+    TEST(ShaderReflectionCache, ReflectOnMiss) {
+        const auto path = reflection_cache_path("miss.cache");
+        const auto code = test_code(0);
+        const auto otherCode = test_code(1);
+        uint32_t reflections = 0;
+        auto reflect = [&](std::span<const uint32_t> reflected) {
+            reflections++;
+            return test_reflection(reflected[1]);
+        };
+        ShaderReflectionCache cache(path);
+        EXPECT_EQ(cache.size(), 0);
+        EXPECT_EQ(cache.get(code, reflect), test_reflection(code[1]));
+        EXPECT_EQ(cache.get(code, reflect), test_reflection(code[1]));
+        EXPECT_EQ(reflections, 1);
+        EXPECT_EQ(cache.get(otherCode, reflect), test_reflection(otherCode[1]));
+        EXPECT_EQ(reflections, 2);
+        EXPECT_EQ(cache.get_statistics().hits, 1);
+        EXPECT_EQ(cache.get_statistics().misses, 2);
+        EXPECT_EQ(cache.find(ShaderReflectionCache::compute_key(code)), test_reflection(code[1]));
+        EXPECT_FALSE(cache.find(ShaderReflectionCache::compute_key(test_code(2))));
+        //Failed reflections aren't cached
+        auto failing = [](std::span<const uint32_t>) -> ShaderReflection {
+            throw std::runtime_error("Unsupported Shadertype");
+        };
+        EXPECT_THROW(cache.get(test_code(3), failing), std::runtime_error);
+        EXPECT_EQ(cache.size(), 2);
+    }
+    TEST(ShaderReflectionCache, Persistence) {
+        const auto path = reflection_cache_path("persistence.cache");
+        const auto code = test_code(0, 1000);
+        uint32_t reflections = 0;
+        auto reflect = [&](std::span<const uint32_t>) {
+            reflections++;
+            return test_reflection(3);
+        };
+        {
+            ShaderReflectionCache cache(path);
+            cache.get(code, reflect);
+            cache.save();
+        }
+        EXPECT_TRUE(std::filesystem::exists(path));
+        EXPECT_FALSE(std::filesystem::exists(std::filesystem::path(path) += ".tmp"));
+        {
+            //Warm start, nothing is reflected and nothing written
+            ShaderReflectionCache cache(path);
+            EXPECT_EQ(cache.size(), 1);
+            EXPECT_EQ(cache.get(code, reflect), test_reflection(3));
+            EXPECT_EQ(reflections, 1);
+            std::filesystem::remove(path);
+            cache.save();
+            EXPECT_FALSE(std::filesystem::exists(path));
+            std::ofstream(path, std::ios::binary).write("x", 1);
+        }
+        {
+            //An unusable file starts cold
+            ShaderReflectionCache cache(path);
+            EXPECT_EQ(cache.size(), 0);
+            cache.get(code, reflect);
+            EXPECT_EQ(reflections, 2);
+        }
+        //Changed code hashes to a new key
+        auto changed = code;
+        changed.back() ^= 1;
+        EXPECT_NE(ShaderReflectionCache::compute_key(changed), ShaderReflectionCache::compute_key(code));
+    }
+    TEST(ShaderReflectionCache, Parallel) {
+        const auto path = reflection_cache_path("parallel.cache");
+        ShaderReflectionCache cache(path);
+        JobSystem jobs(4);
+        constexpr size_t shaderCount = 64;
+        std::vector<std::vector<uint32_t>> codes;
+        for (uint32_t i = 0; i < shaderCount; i++)
+            codes.push_back(test_code(i % (shaderCount / 2)));
+        std::atomic<uint32_t> reflections{ 0 };
+        std::vector<ShaderReflection> results(shaderCount);
+        jobs.parallel_for(shaderCount, [&](size_t i) {
+            results[i] = cache.get(codes[i], [&](std::span<const uint32_t> code) {
+                reflections++;
+                return test_reflection(code[1]);
+            });
+        });
+        for (size_t i = 0; i < shaderCount; i++)
+            EXPECT_EQ(results[i], test_reflection(codes[i][1]));
+        EXPECT_EQ(cache.size(), shaderCount / 2);
+        //Duplicates racing each other may both reflect, but never more often than requested
+        EXPECT_GE(reflections.load(), shaderCount / 2);
+        EXPECT_LE(reflections.load(), shaderCount);
+        const auto statistics = cache.get_statistics();
+        EXPECT_EQ(statistics.hits + statistics.misses, shaderCount);
+    }
+}
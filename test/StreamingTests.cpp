@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "Renderer/AssetStreamer.h"
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <thread>
+namespace nyan {
+    class BytePayload : public AssetPayload {
+    public:
+        size_t upload_size() const override {
+            return data.size();
+        }
+        std::vector<std::byte> data;
+    };
+    static std::unique_ptr<AssetPayload> decode_bytes(const std::filesystem::path&, std::span<const std::byte> data) {
+        auto payload = std::make_unique<BytePayload>();
+        payload->data.assign(data.begin(), data.end());
+        return payload;
+    }
+    //Records uploads in order instead of touching a device
+    class RecordingUploadSink : public AssetUploadSink {
+    public:
+        void upload(AssetRequestId id, AssetPayload& payload) override {
+            ids.push_back(id);
+            contents.push_back(static_cast<BytePayload&>(payload).data);
+        }
+        std::vector<AssetRequestId> ids;
+        std::vector<std::vector<std::byte>> contents;
+    };
+    static std::filesystem::path write_test_file(const std::string& name, size_t size, uint8_t value) {
+        auto directory = std::filesystem::temp_directory_path() / "nyan_streaming_tests";
+        std::filesystem::create_directories(directory);
+        auto path = directory / name;
+        std::ofstream file(path, std::ios::binary);
+        std::vector<char> data(size, static_cast<char>(value));
+        file.write(data.data(), data.size());
+        return path;
+    }
+    TEST(AssetStreamer, LoadAndCommit) {
+        AssetStreamer streamer;
+        std::vector<AssetRequestId> ids;
+        for (uint8_t i = 0; i < 16; i++)
+            ids.push_back(streamer.request({ .path {write_test_file("load" + std::to_string(i), 1000 + i, i)}, .decoder {decode_bytes} }));
+        streamer.wait_idle();
+        for (auto id : ids)
+            EXPECT_EQ(streamer.get_state(id), AssetStreamer::State::Ready);
+        RecordingUploadSink sink;
+        auto statistics = streamer.commit(sink);
+        EXPECT_EQ(statistics.committedAssets, ids.size());
+        EXPECT_EQ(statistics.deferredAssets, 0);
+        ASSERT_EQ(sink.ids.size(), ids.size());
+        for (size_t i = 0; i < sink.ids.size(); i++) {
+            auto index = std::find(ids.begin(), ids.end(), sink.ids[i]) - ids.begin();
+            ASSERT_EQ(sink.contents[i].size(), 1000 + index);
+            EXPECT_EQ(sink.contents[i].front(), std::byte(index));
+            EXPECT_EQ(streamer.get_state(sink.ids[i]), AssetStreamer::State::Committed);
+        }
+        EXPECT_EQ(streamer.get_state(12345), AssetStreamer::State::Unknown);
+    }
+    TEST(AssetStreamer, NoWorkers) {
+        //Decoding runs inline on the IO thread when the pool has no workers
+        Utility::JobSystem jobs(0);
+        AssetStreamer streamer({}, jobs);
+        auto id = streamer.request({ .path {write_test_file("noworkers", 100, 3)}, .decoder {decode_bytes} });
+        streamer.wait_idle();
+        EXPECT_EQ(streamer.get_state(id), AssetStreamer::State::Ready);
+        auto future = jobs.submit([]() { return 42; });
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+        EXPECT_EQ(future.get(), 42);
+    }
+    TEST(AssetStreamer, PriorityAndBudget) {
+        //Room for two assets per frame
+        AssetStreamer streamer({ .ioThreadCount {1}, .frameByteBudget {250}, .frameTimeBudget {std::chrono::seconds(10)} });
+        std::vector<AssetRequestId> ids;
+        for (uint32_t i = 0; i < 6; i++)
+            ids.push_back(streamer.request({ .path {write_test_file("priority" + std::to_string(i), 100, 0)}, .decoder {decode_bytes}, .position {Math::vec3{ static_cast<float>(i), 0.f, 0.f }} }));
+        streamer.wait_idle();
+        RecordingUploadSink sink;
+        auto statistics = streamer.commit(sink);
+        EXPECT_EQ(statistics.committedAssets, 2);
+        EXPECT_EQ(statistics.committedBytes, 200);
+        EXPECT_EQ(statistics.deferredAssets, 4);
+        EXPECT_EQ(sink.ids, (std::vector<AssetRequestId>{ ids[0], ids[1] }));
+        //Moving the camera reorders the remaining assets
+        streamer.set_camera_position(Math::vec3{ 10.f, 0.f, 0.f });
+        streamer.commit(sink);
+        EXPECT_EQ(sink.ids, (std::vector<AssetRequestId>{ ids[0], ids[1], ids[5], ids[4] }));
+        //Back at the origin the closest remaining assets come first
+        streamer.set_camera_position(Math::vec3{ 0.f, 0.f, 0.f });
+        streamer.commit(sink);
+        EXPECT_EQ(sink.ids, (std::vector<AssetRequestId>{ ids[0], ids[1], ids[5], ids[4], ids[2], ids[3] }));
+        //Assets larger than the budget still go through one per frame
+        auto large = streamer.request({ .path {write_test_file("large", 1000, 0)}, .decoder {decode_bytes} });
+        streamer.wait_idle();
+        EXPECT_EQ(streamer.commit(sink).committedAssets, 1);
+        EXPECT_EQ(sink.ids.back(), large);
+    }
+    TEST(AssetStreamer, Cancel) {
+        AssetStreamer streamer({ .ioThreadCount {1} });
+        std::promise<void> gate;
+        auto gateFuture = gate.get_future().share();
+        auto blocked = streamer.request({ .path {write_test_file("blocked", 10, 0)}, .decoder {[gateFuture](const std::filesystem::path& path, std::span<const std::byte> data) {
+            gateFuture.wait();
+            return decode_bytes(path, data);
+        }} });
+        std::vector<AssetRequestId> ids;
+        for (uint32_t i = 0; i < 8; i++)
+            ids.push_back(streamer.request({ .path {write_test_file("cancel" + std::to_string(i), 10, 0)}, .decoder {decode_bytes} }));
+        //Cancelled in whatever stage they currently are
+        for (uint32_t i = 0; i < 8; i += 2)
+            EXPECT_TRUE(streamer.cancel(ids[i]));
+        EXPECT_TRUE(streamer.cancel(blocked));
+        gate.set_value();
+        streamer.wait_idle();
+        RecordingUploadSink sink;
+        streamer.commit(sink);
+        EXPECT_EQ(sink.ids.size(), 4);
+        for (uint32_t i = 0; i < 8; i++) {
+            const bool cancelled = (i % 2) == 0;
+            EXPECT_EQ(std::find(sink.ids.begin(), sink.ids.end(), ids[i]) != sink.ids.end(), !cancelled);
+            EXPECT_EQ(streamer.get_state(ids[i]), cancelled ? AssetStreamer::State::Cancelled : AssetStreamer::State::Committed);
+        }
+        EXPECT_EQ(streamer.get_state(blocked), AssetStreamer::State::Cancelled);
+        EXPECT_FALSE(streamer.cancel(ids[1]));
+        EXPECT_FALSE(streamer.cancel(ids[0]));
+    }
+    TEST(AssetStreamer, ForgetsObservedRequests) {
+        AssetStreamer streamer({ .ioThreadCount {1} });
+        std::promise<void> gate;
+        auto gateFuture = gate.get_future().share();
+        auto decoding = streamer.request({ .path {write_test_file("forget0", 10, 0)}, .decoder {[gateFuture](const std::filesystem::path& path, std::span<const std::byte> data) {
+            gateFuture.wait();
+            return decode_bytes(path, data);
+        }} });
+        auto committed = streamer.request({ .path {write_test_file("forget1", 10, 1)}, .decoder {decode_bytes} });
+        //Observed while the decode job still holds it
+        while (streamer.get_state(decoding) != AssetStreamer::State::Decoding)
+            std::this_thread::yield();
+        EXPECT_TRUE(streamer.cancel(decoding));
+        EXPECT_EQ(streamer.get_state(decoding), AssetStreamer::State::Cancelled);
+        gate.set_value();
+        streamer.wait_idle();
+        EXPECT_EQ(streamer.get_state(decoding), AssetStreamer::State::Unknown);
+        RecordingUploadSink sink;
+        streamer.commit(sink);
+        EXPECT_EQ(sink.ids, std::vector<AssetRequestId>{ committed });
+        EXPECT_EQ(streamer.get_state(committed), AssetStreamer::State::Committed);
+        EXPECT_EQ(streamer.get_state(committed), AssetStreamer::State::Unknown);
+        EXPECT_FALSE(streamer.cancel(committed));
+    }
+    TEST(AssetStreamer, Failures) {
+        AssetStreamer streamer;
+        auto missing = streamer.request({ .path {std::filesystem::temp_directory_path() / "nyan_streaming_tests" / "missing"}, .decoder {decode_bytes} });
+        auto throwing = streamer.request({ .path {write_test_file("throwing", 10, 0)}, .decoder {[](const std::filesystem::path&, std::span<const std::byte>) -> std::unique_ptr<AssetPayload> {
+            throw std::runtime_error("corrupt");
+        }} });
+        auto empty = streamer.request({ .path {write_test_file("empty", 10, 0)}, .decoder {[](const std::filesystem::path&, std::span<const std::byte>) -> std::unique_ptr<AssetPayload> {
+            return nullptr;
+        }} });
+        auto texture = streamer.request({ .path {write_test_file("texture.png", 64, 7)}, .decoder {StreamedTexture::decode} });
+        streamer.wait_idle();
+        EXPECT_EQ(streamer.get_state(missing), AssetStreamer::State::Failed);
+        EXPECT_EQ(streamer.get_state(throwing), AssetStreamer::State::Failed);
+        EXPECT_EQ(streamer.get_state(empty), AssetStreamer::State::Failed);
+        EXPECT_EQ(streamer.get_state(texture), AssetStreamer::State::Failed);
+        RecordingUploadSink sink;
+        EXPECT_EQ(streamer.commit(sink).committedAssets, 0);
+    }
+}
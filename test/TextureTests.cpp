@@ -0,0 +1,427 @@
+#include <gtest/gtest.h>
+#include "Renderer/TextureCache.h"
+#include "Utility/BlockCompressor.h"
+#include "Utility/JobSystem.h"
+#include "Utility/MappedFile.h"
+#include "Utility/MipGenerator.h"
+#include "Utility/TextureCooker.h"
+#include "stb_image_write.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <random>
+namespace Utility {
+    //Smooth gradients with a bit of noise and a few hard edges, roughly like albedo textures
+    static std::vector<uint8_t> create_test_image(uint32_t width, uint32_t height) {
+        std::vector<uint8_t> texels(static_cast<size_t>(width) * height * 4);
+        std::mt19937 rng(3);
+        std::uniform_int_distribution<int> noise(-4, 4);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                const auto fx = static_cast<float>(x) / width;
+                const auto fy = static_cast<float>(y) / height;
+                const bool edge = ((x / 37) + (y / 23)) % 5 == 0;
+                std::array<float, 4> color{
+                    255.f * fx,
+                    255.f * (0.5f + 0.5f * std::sin(fx * 9.f + fy * 4.f)),
+                    edge ? 230.f : 255.f * fy * fy,
+                    255.f * (0.5f + 0.5f * std::cos(fy * 7.f)),
+                };
+                for (size_t c = 0; c < 4; c++)
+                    texels[(static_cast<size_t>(y) * width + x) * 4 + c] = static_cast<uint8_t>(std::clamp(color[c] + noise(rng), 0.f, 255.f));
+            }
+        }
+        return texels;
+    }
+    static double psnr(const std::vector<uint8_t>& reference, const std::vector<uint8_t>& decoded, size_t firstChannel, size_t channels) {
+        double error = 0;
+        size_t count = 0;
+        for (size_t i = 0; i < reference.size(); i += 4) {
+            for (size_t c = firstChannel; c < firstChannel + channels; c++) {
+                const double difference = static_cast<double>(reference[i + c]) - decoded[i + c];
+                error += difference * difference;
+                count++;
+            }
+        }
+        if (error == 0)
+            return 100.0;
+        return 10.0 * std::log10(255.0 * 255.0 / (error / count));
+    }
+    TEST(BlockCompressor, SolidBlocks) {
+        BlockCompressor::Block block;
+        for (size_t i = 0; i < 16; i++) {
+            block[i * 4 + 0] = 201;
+            block[i * 4 + 1] = 77;
+            block[i * 4 + 2] = 14;
+            block[i * 4 + 3] = 133;
+        }
+        std::array<std::byte, 16> compressed;
+        BlockCompressor::Block decoded;
+        for (auto format : { BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 }) {
+            BlockCompressor::compress_block(format, block, compressed.data());
+            BlockCompressor::decompress_block(format, compressed.data(), decoded);
+            EXPECT_EQ(decoded[0], 201);
+            if (format != BlockFormat::BC4)
+                EXPECT_EQ(decoded[1], 77);
+            //Mode 6 shares the lowest bit of all channels of an endpoint
+            if (format == BlockFormat::BC7) {
+                EXPECT_NEAR(decoded[2], 14, 1);
+                EXPECT_NEAR(decoded[3], 133, 1);
+            }
+        }
+        for (auto format : { BlockFormat::BC1, BlockFormat::BC3 }) {
+            BlockCompressor::compress_block(format, block, compressed.data());
+            BlockCompressor::decompress_block(format, compressed.data(), decoded);
+            for (size_t i = 0; i < 16; i++) {
+                //565 endpoints
+                EXPECT_NEAR(decoded[i * 4 + 0], 201, 4);
+                EXPECT_NEAR(decoded[i * 4 + 1], 77, 2);
+                EXPECT_NEAR(decoded[i * 4 + 2], 14, 4);
+                EXPECT_EQ(decoded[i * 4 + 3], format == BlockFormat::BC3 ? 133 : 255);
+            }
+        }
+    }
+    TEST(BlockCompressor, Quality) {
+        constexpr uint32_t width = 256;
+        constexpr uint32_t height = 192;
+        const auto image = create_test_image(width, height);
+        std::array<double, 6> quality{};
+        for (auto format : { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 }) {
+            const auto compressed = BlockCompressor::compress(format, image, width, height);
+            ASSERT_EQ(compressed.size(), BlockCompressor::compressed_size(format, width, height));
+            const auto decoded = BlockCompressor::decompress(format, compressed, width, height);
+            switch (format) {
+            case BlockFormat::BC1:
+            case BlockFormat::BC3:
+                quality[static_cast<size_t>(format)] = psnr(image, decoded, 0, 3);
+                if (format == BlockFormat::BC3)
+                    EXPECT_GT(psnr(image, decoded, 3, 1), 40.0);
+                break;
+            case BlockFormat::BC4:
+                quality[static_cast<size_t>(format)] = psnr(image, decoded, 0, 1);
+                break;
+            case BlockFormat::BC5:
+                quality[static_cast<size_t>(format)] = psnr(image, decoded, 0, 2);
+                break;
+            default:
+                quality[static_cast<size_t>(format)] = psnr(image, decoded, 0, 4);
+                break;
+            }
+        }
+        //std::cout << "PSNR BC1: " << quality[0] << "dB BC3: " << quality[1] << "dB BC4: " << quality[2] << "dB BC5: " << quality[3] << "dB BC7: " << quality[5] << "dB\n";
+        EXPECT_GT(quality[static_cast<size_t>(BlockFormat::BC1)], 36.0);
+        EXPECT_EQ(quality[static_cast<size_t>(BlockFormat::BC1)], quality[static_cast<size_t>(BlockFormat::BC3)]);
+        EXPECT_GT(quality[static_cast<size_t>(BlockFormat::BC4)], 42.0);
+        EXPECT_GT(quality[static_cast<size_t>(BlockFormat::BC5)], 42.0);
+        EXPECT_GT(quality[static_cast<size_t>(BlockFormat::BC7)], 38.0);
+    }
+    TEST(BlockCompressor, HDR) {
+        constexpr uint32_t width = 64;
+        constexpr uint32_t height = 64;
+        std::vector<float> image(width * height * 4);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                auto* texel = &image[(y * width + x) * 4];
+                //Several orders of magnitude, like skies with a sun
+                texel[0] = std::exp2(static_cast<float>(x) / width * 12.f - 4.f);
+                texel[1] = 0.25f + static_cast<float>(y) / height;
+                texel[2] = texel[0] * 0.5f + texel[1];
+                texel[3] = 1.f;
+            }
+        }
+        const auto compressed = BlockCompressor::compress_hdr(image, width, height);
+        ASSERT_EQ(compressed.size(), BlockCompressor::compressed_size(BlockFormat::BC6H, width, height));
+        const auto decoded = BlockCompressor::decompress_hdr(compressed, width, height);
+        double relativeError = 0;
+        for (size_t i = 0; i < image.size(); i += 4)
+            for (size_t c = 0; c < 3; c++)
+                relativeError += std::abs(decoded[i + c] - image[i + c]) / image[i + c];
+        relativeError /= width * height * 3;
+        EXPECT_LT(relativeError, 0.02);
+        EXPECT_EQ(decoded[3], 1.f);
+    }
+    TEST(BlockCompressor, PartialBlocks) {
+        constexpr uint32_t width = 13;
+        constexpr uint32_t height = 6;
+        const auto image = create_test_image(width, height);
+        for (auto format : { BlockFormat::BC1, BlockFormat::BC4, BlockFormat::BC7 }) {
+            const auto compressed = BlockCompressor::compress(format, image, width, height);
+            EXPECT_EQ(compressed.size(), 4 * 2 * BlockCompressor::block_size(format));
+            const auto decoded = BlockCompressor::decompress(format, compressed, width, height);
+            ASSERT_EQ(decoded.size(), image.size());
+            EXPECT_GT(psnr(image, decoded, 0, 1), 20.0);
+        }
+        EXPECT_TRUE(BlockCompressor::compress(BlockFormat::BC1, {}, 0, 0).empty());
+        EXPECT_THROW(BlockCompressor::compress(BlockFormat::BC1, image, width, height + 1), std::runtime_error);
+    }
+    TEST(BlockCompressor, Throughput) {
+        constexpr uint32_t width = 1024;
+        constexpr uint32_t height = 1024;
+        const auto image = create_test_image(width, height);
+        std::vector<float> hdrImage(image.begin(), image.end());
+        constexpr std::array<const char*, 6> names{ "BC1", "BC3", "BC4", "BC5", "BC6H", "BC7" };
+        for (auto format : { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC6H, BlockFormat::BC7 }) {
+            auto start = std::chrono::steady_clock::now();
+            const auto compressed = format == BlockFormat::BC6H ? BlockCompressor::compress_hdr(hdrImage, width, height) :
+                BlockCompressor::compress(format, image, width, height);
+            auto end = std::chrono::steady_clock::now();
+            [[maybe_unused]] const auto megapixelsPerSecond = static_cast<double>(width) * height / std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+            //std::cout << names[static_cast<size_t>(format)] << " compression: " << megapixelsPerSecond << " Mpix/s\n";
+            EXPECT_EQ(compressed.size(), BlockCompressor::compressed_size(format, width, height));
+        }
+    }
+    TEST(TextureCooker, CookPNG) {
+        constexpr uint32_t width = 64;
+        constexpr uint32_t height = 32;
+        const auto image = create_test_image(width, height);
+        auto directory = std::filesystem::temp_directory_path() / "nyan_texture_tests";
+        std::filesystem::create_directories(directory);
+        const auto source = directory / "albedo.png";
+        const auto destination = directory / "albedo.dds";
+        ASSERT_TRUE(stbi_write_png(source.string().c_str(), width, height, 4, image.data(), width * 4));
+        TextureCooker::cook(source, destination, { .usage {TextureUsage::ColorAlpha} });
+
+        //Same validation as the DDSReader
+        MappedFile file(destination);
+        constexpr size_t dataOffset = sizeof(uint32_t) + sizeof(DDSHeader) + sizeof(DDSHeaderDXT10);
+        size_t chainSize = 0;
+        for (uint32_t level = 0; level < MipGenerator::level_count(width, height); level++)
+            chainSize += BlockCompressor::compressed_size(BlockFormat::BC3, std::max(1u, width >> level), std::max(1u, height >> level));
+        ASSERT_EQ(file.size(), dataOffset + chainSize);
+        uint32_t magicNumber;
+        DDSHeader header;
+        DDSHeaderDXT10 extHeader;
+        std::memcpy(&magicNumber, file.data(), sizeof(uint32_t));
+        std::memcpy(&header, file.data() + sizeof(uint32_t), sizeof(DDSHeader));
+        std::memcpy(&extHeader, file.data() + sizeof(uint32_t) + sizeof(DDSHeader), sizeof(DDSHeaderDXT10));
+        EXPECT_EQ(magicNumber, DDSMagicNumber);
+        EXPECT_EQ(header.size, 124);
+        EXPECT_EQ(header.pixelFormat.size, 32);
+        EXPECT_EQ(header.pixelFormat.fourCC, DDSPixelFormat::FourCC::DX10);
+        EXPECT_EQ(header.width, width);
+        EXPECT_EQ(header.height, height);
+        EXPECT_EQ(header.depth, 1);
+        EXPECT_EQ(header.mipMapCount, MipGenerator::level_count(width, height));
+        EXPECT_EQ(extHeader.format, DXGI_FORMAT::DXGI_FORMAT_BC3_UNORM_SRGB);
+        EXPECT_EQ(extHeader.resourceDimension, DDSHeaderDXT10::RESOURCE_DIMENSION::TEXTURE2D);
+        EXPECT_EQ(extHeader.arraySize, 1);
+        const auto decoded = BlockCompressor::decompress(BlockFormat::BC3, file.span().subspan(dataOffset), width, height);
+        EXPECT_GT(psnr(image, decoded, 0, 4), 30.0);
+
+        TextureCooker::cook(source, destination, { .usage {TextureUsage::Mask}, .generateMips {false} });
+        EXPECT_EQ(std::filesystem::file_size(destination), dataOffset + BlockCompressor::compressed_size(BlockFormat::BC4, width, height));
+
+        EXPECT_THROW(TextureCooker::cook(directory / "missing.png", destination, {}), std::runtime_error);
+    }
+    TEST(MipGenerator, LevelSizes) {
+        EXPECT_EQ(MipGenerator::level_count(1, 1), 1);
+        EXPECT_EQ(MipGenerator::level_count(256, 256), 9);
+        EXPECT_EQ(MipGenerator::level_count(300, 17), 9);
+        constexpr uint32_t width = 37;
+        constexpr uint32_t height = 5;
+        const auto image = create_test_image(width, height);
+        const auto levels = MipGenerator::generate(image, width, height, {});
+        ASSERT_EQ(levels.size(), 6);
+        EXPECT_EQ(levels[0].texels, image);
+        //Same rounding as Vulkan mip extents
+        for (uint32_t level = 0; level < levels.size(); level++) {
+            EXPECT_EQ(levels[level].width, std::max(1u, width >> level));
+            EXPECT_EQ(levels[level].height, std::max(1u, height >> level));
+            EXPECT_EQ(levels[level].texels.size(), static_cast<size_t>(levels[level].width) * levels[level].height * 4);
+        }
+        EXPECT_THROW(MipGenerator::generate(image, width, height + 1, {}), std::runtime_error);
+    }
+    TEST(MipGenerator, ConstantImage) {
+        constexpr uint32_t width = 24;
+        constexpr uint32_t height = 9;
+        std::vector<uint8_t> image(width * height * 4);
+        for (size_t i = 0; i < image.size(); i += 4) {
+            image[i + 0] = 17;
+            image[i + 1] = 128;
+            image[i + 2] = 250;
+            image[i + 3] = 99;
+        }
+        for (auto filter : { MipFilter::Box, MipFilter::Kaiser, MipFilter::Lanczos }) {
+            for (bool wrap : { false, true }) {
+                const auto levels = MipGenerator::generate(image, width, height, { .filter {filter}, .wrap {wrap} });
+                for (const auto& level : levels)
+                    for (size_t i = 0; i < level.texels.size(); i++)
+                        EXPECT_EQ(level.texels[i], image[i % 4]);
+            }
+        }
+    }
+    TEST(MipGenerator, LinearFiltering) {
+        //Checkerboard of black and white, half the light of white is 188 in sRGB and not 128
+        constexpr uint32_t size = 16;
+        std::vector<uint8_t> image(size * size * 4);
+        for (uint32_t y = 0; y < size; y++)
+            for (uint32_t x = 0; x < size; x++)
+                for (size_t c = 0; c < 4; c++)
+                    image[(y * size + x) * 4 + c] = c == 3 ? 255 : ((x + y) % 2 ? 255 : 0);
+        const auto sRGB = MipGenerator::generate(image, size, size, { .filter {MipFilter::Box} });
+        const auto unorm = MipGenerator::generate(image, size, size, { .filter {MipFilter::Box}, .sRGB {false} });
+        for (size_t i = 0; i < sRGB[1].texels.size(); i += 4) {
+            EXPECT_NEAR(sRGB[1].texels[i], 188, 1);
+            EXPECT_NEAR(unorm[1].texels[i], 128, 1);
+            EXPECT_EQ(sRGB[1].texels[i + 3], 255);
+        }
+        std::vector<float> hdrImage(image.begin(), image.end());
+        const auto hdr = MipGenerator::generate_hdr(hdrImage, size, size, { .filter {MipFilter::Kaiser} });
+        EXPECT_NEAR(hdr.back().texels[0], 127.5f, 1e-3f);
+    }
+    TEST(MipGenerator, Wrap) {
+        //Bright first column, wrapping bleeds it into the last column of the next level
+        constexpr uint32_t width = 16;
+        constexpr uint32_t height = 4;
+        std::vector<uint8_t> image(width * height * 4, 0);
+        for (uint32_t y = 0; y < height; y++)
+            image[y * width * 4] = 255;
+        const auto clamped = MipGenerator::generate(image, width, height, { .filter {MipFilter::Lanczos}, .sRGB {false} });
+        const auto wrapped = MipGenerator::generate(image, width, height, { .filter {MipFilter::Lanczos}, .sRGB {false}, .wrap {true} });
+        const size_t last = (clamped[1].width - 1) * 4;
+        EXPECT_EQ(clamped[1].texels[last], 0);
+        EXPECT_GT(wrapped[1].texels[last], 0);
+    }
+    TEST(MipGenerator, AlphaCoverage) {
+        //Scattered opaque texels like leaves and grass blades, filtering alone blurs them below the cutoff
+        constexpr uint32_t size = 64;
+        std::vector<uint8_t> image(size * size * 4, 255);
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<int> distribution(0, 99);
+        for (size_t i = 3; i < image.size(); i += 4)
+            image[i] = distribution(rng) < 30 ? 255 : static_cast<uint8_t>(distribution(rng) / 4);
+        const float coverage = MipGenerator::alpha_coverage(image, 0.5f);
+        EXPECT_NEAR(coverage, 0.3f, 0.03f);
+        const auto plain = MipGenerator::generate(image, size, size, { .filter {MipFilter::Box} });
+        const auto preserved = MipGenerator::generate(image, size, size, { .filter {MipFilter::Box}, .preserveAlphaCoverage {true} });
+        EXPECT_LT(MipGenerator::alpha_coverage(plain[2].texels, 0.5f), coverage - 0.1f);
+        for (size_t level = 1; level < 4; level++)
+            EXPECT_NEAR(MipGenerator::alpha_coverage(preserved[level].texels, 0.5f), coverage, 0.05f);
+    }
+    TEST(MipGenerator, Throughput) {
+        constexpr uint32_t width = 1024;
+        constexpr uint32_t height = 1024;
+        const auto image = create_test_image(width, height);
+        constexpr std::array<const char*, 3> names{ "Box", "Kaiser", "Lanczos" };
+        for (auto filter : { MipFilter::Box, MipFilter::Kaiser, MipFilter::Lanczos }) {
+            auto start = std::chrono::steady_clock::now();
+            const auto levels = MipGenerator::generate(image, width, height, { .filter {filter} });
+            auto end = std::chrono::steady_clock::now();
+            [[maybe_unused]] const auto megapixelsPerSecond = static_cast<double>(width) * height / std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+            //std::cout << names[static_cast<size_t>(filter)] << " mip generation: " << megapixelsPerSecond << " Mpix/s\n";
+            EXPECT_EQ(levels.size(), 11);
+        }
+    }
+    TEST(TextureCache, HitsAndInvalidation) {
+        auto directory = std::filesystem::temp_directory_path() / "nyan_texture_cache_tests";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        const auto source = directory / "albedo.png";
+        auto image = create_test_image(32, 32);
+        ASSERT_TRUE(stbi_write_png(source.string().c_str(), 32, 32, 4, image.data(), 32 * 4));
+
+        nyan::TextureCache cache(directory / "cache", 1ull << 20);
+        const auto cooked = cache.acquire(source, {}).get_path();
+        EXPECT_EQ(cooked.extension(), ".dds");
+        EXPECT_TRUE(std::filesystem::exists(cooked));
+        EXPECT_EQ(cache.acquire(source, {}).get_path(), cooked);
+        //Different settings are a different entry
+        const auto mask = cache.acquire(source, { .usage {TextureUsage::Mask} }).get_path();
+        EXPECT_NE(mask, cooked);
+        EXPECT_EQ(cache.get_statistics().hits, 1);
+        EXPECT_EQ(cache.get_statistics().misses, 2);
+        EXPECT_EQ(cache.get_size(), std::filesystem::file_size(cooked) + std::filesystem::file_size(mask));
+
+        //Editing the source changes the key
+        image[0] ^= 0xFF;
+        ASSERT_TRUE(stbi_write_png(source.string().c_str(), 32, 32, 4, image.data(), 32 * 4));
+        EXPECT_NE(cache.acquire(source, {}).get_path(), cooked);
+        EXPECT_EQ(cache.get_statistics().misses, 3);
+
+        //Entries persist across instances, leftovers of interrupted cooks are removed
+        std::ofstream(directory / "cache" / "0123.1.tmp") << "partial";
+        nyan::TextureCache reopened(directory / "cache", 1ull << 20);
+        EXPECT_EQ(reopened.get_size(), cache.get_size());
+        reopened.acquire(source, {});
+        EXPECT_EQ(reopened.get_statistics().hits, 1);
+        EXPECT_FALSE(std::filesystem::exists(directory / "cache" / "0123.1.tmp"));
+
+        EXPECT_THROW(cache.acquire(directory / "missing.png", {}), std::runtime_error);
+        std::filesystem::remove_all(directory);
+    }
+    TEST(TextureCache, LeastRecentlyUsedEviction) {
+        auto directory = std::filesystem::temp_directory_path() / "nyan_texture_cache_lru_tests";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        std::vector<std::filesystem::path> sources;
+        for (uint32_t i = 0; i < 3; i++) {
+            auto image = create_test_image(64, 64);
+            image[0] = static_cast<uint8_t>(i);
+            sources.push_back(directory / ("texture" + std::to_string(i) + ".png"));
+            ASSERT_TRUE(stbi_write_png(sources.back().string().c_str(), 64, 64, 4, image.data(), 64 * 4));
+        }
+        std::vector<std::filesystem::path> cooked;
+        {
+            nyan::TextureCache unbounded(directory / "cache", ~0ull);
+            for (const auto& source : sources)
+                cooked.push_back(unbounded.acquire(source, {}).get_path());
+        }
+        //Previous launches used them in order
+        for (size_t i = 0; i < cooked.size(); i++)
+            std::filesystem::last_write_time(cooked[i], std::filesystem::file_time_type::clock::now() - std::chrono::hours(cooked.size() - i));
+        const auto entrySize = std::filesystem::file_size(cooked[0]);
+        //Room for two entries, touching the first makes the second the least recently used
+        nyan::TextureCache cache(directory / "cache", entrySize * 2);
+        EXPECT_EQ(cache.get_statistics().evictions, 1);
+        EXPECT_FALSE(std::filesystem::exists(cooked[0]));
+        cache.acquire(sources[1], {});
+        cache.acquire(sources[0], {});
+        EXPECT_EQ(cache.get_statistics().evictions, 2);
+        EXPECT_TRUE(std::filesystem::exists(cooked[0]));
+        EXPECT_TRUE(std::filesystem::exists(cooked[1]));
+        EXPECT_FALSE(std::filesystem::exists(cooked[2]));
+        EXPECT_LE(cache.get_size(), entrySize * 2);
+        std::filesystem::remove_all(directory);
+    }
+    TEST(TextureCache, LeasedEntriesSurviveTrim) {
+        auto directory = std::filesystem::temp_directory_path() / "nyan_texture_cache_lease_tests";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        constexpr uint32_t sourceCount = 8;
+        std::vector<std::filesystem::path> sources;
+        for (uint32_t i = 0; i < sourceCount; i++) {
+            auto image = create_test_image(32, 32);
+            image[0] = static_cast<uint8_t>(i);
+            sources.push_back(directory / ("texture" + std::to_string(i) + ".png"));
+            ASSERT_TRUE(stbi_write_png(sources.back().string().c_str(), 32, 32, 4, image.data(), 32 * 4));
+        }
+        //Every other entry is above the budget, only leases keep them around
+        nyan::TextureCache cache(directory / "cache", 1);
+        {
+            auto first = cache.acquire(sources[0], {});
+            auto second = cache.acquire(sources[1], {});
+            cache.trim();
+            EXPECT_TRUE(std::filesystem::exists(first.get_path()));
+            EXPECT_TRUE(std::filesystem::exists(second.get_path()));
+            const auto firstPath = first.get_path();
+            first = nyan::TextureCache::Lease{};
+            EXPECT_FALSE(std::filesystem::exists(firstPath));
+            EXPECT_TRUE(std::filesystem::exists(second.get_path()));
+        }
+        JobSystem jobs(4);
+        std::atomic<uint32_t> mapped{ 0 };
+        jobs.parallel_for(64, [&](size_t i) {
+            auto lease = cache.acquire(sources[i % sourceCount], {});
+            cache.trim();
+            MappedFile file(lease.get_path());
+            if (file.size())
+                mapped++;
+        });
+        EXPECT_EQ(mapped.load(), 64);
+        //Without leases the cache shrinks back to the most recent entry
+        EXPECT_EQ(std::distance(std::filesystem::directory_iterator(directory / "cache"), std::filesystem::directory_iterator{}), 1);
+        std::filesystem::remove_all(directory);
+    }
+}
@@ -2,7 +2,11 @@
 #include "Util"
 #include <array>
 #include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <list>
+#include <numeric>
 #include <random>
 namespace Utility {
     TEST(Utility, bitwidth) {
@@ -451,4 +455,212 @@ namespace Utility {
             //std::cout << "List push back took: " << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "microseconds\n";
         }
     }
+    TEST(Utility, OffsetAllocatorBins) {
+        for (uint32_t size{ 1 }; size < 1000000; size++) {
+            auto up = OffsetAllocator::size_to_bin_round_up(size);
+            auto down = OffsetAllocator::size_to_bin_round_down(size);
+            EXPECT_GE(OffsetAllocator::bin_to_size(up), size);
+            EXPECT_LE(OffsetAllocator::bin_to_size(down), size);
+            EXPECT_LE(down, up);
+            EXPECT_LE(up - down, 1);
+        }
+        for (uint32_t bin{ 0 }; bin < OffsetAllocator::size_to_bin_round_down(~0u); bin++) {
+            EXPECT_EQ(OffsetAllocator::size_to_bin_round_up(OffsetAllocator::bin_to_size(bin)), bin);
+            EXPECT_EQ(OffsetAllocator::size_to_bin_round_down(OffsetAllocator::bin_to_size(bin)), bin);
+        }
+    }
+    TEST(Utility, OffsetAllocatorMerge) {
+        OffsetAllocator allocator(1024);
+        std::vector<OffsetAllocator::Allocation> allocations;
+        for (uint32_t i{ 0 }; i < 16; i++) {
+            allocations.push_back(allocator.allocate(64));
+            ASSERT_TRUE(allocations.back().valid());
+            EXPECT_EQ(allocations.back().offset, i * 64);
+        }
+        EXPECT_FALSE(allocator.allocate(1).valid());
+        EXPECT_EQ(allocator.get_statistics().freeSize, 0);
+        //Every other block free, no region larger than a single block
+        for (uint32_t i{ 0 }; i < 16; i += 2)
+            allocator.free(allocations[i]);
+        auto statistics = allocator.get_statistics();
+        EXPECT_EQ(statistics.freeSize, 512);
+        EXPECT_EQ(statistics.freeRegions, 8);
+        EXPECT_EQ(statistics.largestFreeRegion, 64);
+        EXPECT_FALSE(allocator.allocate(65).valid());
+        //Freeing the rest merges everything back into one region
+        for (uint32_t i{ 1 }; i < 16; i += 2)
+            allocator.free(allocations[i]);
+        statistics = allocator.get_statistics();
+        EXPECT_EQ(statistics.freeSize, 1024);
+        EXPECT_EQ(statistics.freeRegions, 1);
+        EXPECT_EQ(statistics.largestFreeRegion, 1024);
+        EXPECT_EQ(statistics.allocations, 0);
+        auto full = allocator.allocate(1024);
+        EXPECT_TRUE(full.valid());
+        EXPECT_EQ(full.offset, 0);
+    }
+    TEST(Utility, OffsetAllocatorFragmentation) {
+        constexpr uint32_t size{ 1 << 24 };
+        OffsetAllocator allocator(size);
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<uint32_t> sizes(1, 1 << 14);
+        std::vector<OffsetAllocator::Allocation> allocations;
+        while (true) {
+            auto allocation = allocator.allocate(sizes(rng));
+            if (!allocation.valid())
+                break;
+            allocations.push_back(allocation);
+        }
+        //Random half freed, live allocations must not overlap
+        std::shuffle(allocations.begin(), allocations.end(), rng);
+        for (size_t i{ 0 }; i < allocations.size() / 2; i++)
+            allocator.free(allocations[i]);
+        allocations.erase(allocations.begin(), allocations.begin() + allocations.size() / 2);
+        std::sort(allocations.begin(), allocations.end(), [](const auto& lhs, const auto& rhs) { return lhs.offset < rhs.offset; });
+        uint64_t used{ 0 };
+        for (size_t i{ 0 }; i < allocations.size(); i++) {
+            used += allocator.get_allocation_size(allocations[i]);
+            if (i)
+                EXPECT_LE(allocations[i - 1].offset + allocator.get_allocation_size(allocations[i - 1]), allocations[i].offset);
+        }
+        auto statistics = allocator.get_statistics();
+        EXPECT_EQ(statistics.freeSize + used, size);
+        EXPECT_EQ(statistics.allocations, allocations.size());
+        EXPECT_GT(statistics.freeRegions, 1);
+        EXPECT_LT(statistics.largestFreeRegion, statistics.freeSize);
+
+        //Compaction leaves one region, data only ever moves towards offset 0
+        auto moves = allocator.defragment();
+        for (const auto& move : moves) {
+            EXPECT_LT(move.allocation.offset, move.sourceOffset);
+            for (auto& allocation : allocations)
+                if (allocation.node == move.allocation.node)
+                    allocation = move.allocation;
+        }
+        uint32_t cursor{ 0 };
+        for (const auto& allocation : allocations) {
+            EXPECT_EQ(allocation.offset, cursor);
+            cursor += allocator.get_allocation_size(allocation);
+        }
+        statistics = allocator.get_statistics();
+        EXPECT_EQ(statistics.freeRegions, 1);
+        EXPECT_EQ(statistics.largestFreeRegion, statistics.freeSize);
+        EXPECT_EQ(statistics.freeSize, size - cursor);
+        EXPECT_TRUE(allocator.allocate(statistics.freeSize).valid());
+        for (const auto& allocation : allocations)
+            allocator.free(allocation);
+        EXPECT_EQ(allocator.get_statistics().allocations, 1);
+    }
+    TEST(Utility, OffsetAllocatorPerf) {
+        constexpr size_t iters{ 1000000 };
+        OffsetAllocator allocator(1u << 30);
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<uint32_t> sizes(1, 1 << 16);
+        std::vector<OffsetAllocator::Allocation> allocations;
+        allocations.reserve(iters);
+        size_t failed{ 0 };
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i{ 0 }; i < iters; i++) {
+            if (!allocations.empty() && (rng() & 1)) {
+                auto idx = rng() % allocations.size();
+                allocator.free(allocations[idx]);
+                allocations[idx] = allocations.back();
+                allocations.pop_back();
+            }
+            else {
+                auto allocation = allocator.allocate(sizes(rng));
+                if (allocation.valid())
+                    allocations.push_back(allocation);
+                else
+                    failed++;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        //std::cout << "OffsetAllocator " << iters << " random alloc/free took: " << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "microseconds, " << failed << " failed\n";
+        EXPECT_EQ(allocator.get_statistics().allocations, allocations.size());
+        for (const auto& allocation : allocations)
+            allocator.free(allocation);
+        EXPECT_EQ(allocator.get_statistics().freeRegions, 1);
+        EXPECT_EQ(allocator.get_statistics().freeSize, 1u << 30);
+    }
+    static std::filesystem::path write_mapped_test_file(const std::filesystem::path& path, size_t size) {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream file(path, std::ios::binary);
+        std::vector<char> data(size);
+        for (size_t i{ 0 }; i < size; i++)
+            data[i] = static_cast<char>(i * 7 + (i >> 8));
+        file.write(data.data(), data.size());
+        return path;
+    }
+    TEST(Utility, MappedFile) {
+        auto directory = std::filesystem::temp_directory_path() / "nyan_utility_tests";
+        auto path = write_mapped_test_file(directory / "mapped", 100000);
+        MappedFile file(path);
+        ASSERT_EQ(file.size(), 100000);
+        for (size_t i{ 0 }; i < file.size(); i++)
+            ASSERT_EQ(file.data()[i], static_cast<std::byte>(i * 7 + (i >> 8)));
+        file.prefetch(4097, 50000);
+        file.prefetch(99999, 50000);
+        file.prefetch(200000, 1);
+
+        auto data = file.data();
+        MappedFile moved(std::move(file));
+        EXPECT_EQ(file.data(), nullptr);
+        EXPECT_EQ(file.size(), 0);
+        EXPECT_EQ(moved.data(), data);
+        EXPECT_EQ(moved.span().size(), 100000);
+        moved = MappedFile(write_mapped_test_file(directory / "mapped_small", 10));
+        EXPECT_EQ(moved.size(), 10);
+        EXPECT_EQ(moved.data()[9], static_cast<std::byte>(63));
+
+        MappedFile empty(write_mapped_test_file(directory / "mapped_empty", 0));
+        EXPECT_EQ(empty.data(), nullptr);
+        EXPECT_TRUE(empty.span().empty());
+        EXPECT_THROW(MappedFile(directory / "missing"), std::runtime_error);
+    }
+    //Loads a directory of .dds shaped files the way the TextureManager does, skipping the two largest mips
+    //The old path opened every file twice and copied it completely before the staging copy, the mapping only reads the uploaded tail
+    TEST(Utility, MappedFileDDSLoadPerf) {
+        constexpr size_t headerSize{ 128 };
+        constexpr size_t fileCount{ 32 };
+        //BC1 1024x1024 with the full mip chain, 8 byte blocks
+        std::vector<size_t> mipSizes;
+        for (uint32_t size{ 1024 }; size; size >>= 1)
+            mipSizes.push_back(std::max(1u, size / 4) * std::max(1u, size / 4) * 8);
+        const size_t payloadSize = std::accumulate(mipSizes.begin(), mipSizes.end(), size_t{ 0 });
+        const size_t skippedSize = mipSizes[0] + mipSizes[1];
+        auto directory = std::filesystem::temp_directory_path() / "nyan_utility_tests" / "dds";
+        std::vector<std::filesystem::path> paths;
+        for (size_t i{ 0 }; i < fileCount; i++)
+            paths.push_back(write_mapped_test_file(directory / ("texture" + std::to_string(i) + ".dds"), headerSize + payloadSize));
+        std::vector<std::byte> staging(payloadSize - skippedSize);
+        std::array<std::byte, headerSize> header;
+
+        uint64_t copyChecksum{ 0 };
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& path : paths) {
+            {
+                std::ifstream file(path, std::ios::binary);
+                file.read(reinterpret_cast<char*>(header.data()), headerSize);
+            }
+            std::ifstream file(path, std::ios::binary);
+            file.read(reinterpret_cast<char*>(header.data()), headerSize);
+            std::vector<std::byte> data(std::filesystem::file_size(path) - headerSize);
+            file.read(reinterpret_cast<char*>(data.data()), data.size());
+            std::memcpy(staging.data(), data.data() + skippedSize, staging.size());
+            copyChecksum += static_cast<uint64_t>(staging.back()) + static_cast<uint64_t>(header[5]);
+        }
+        auto mid = std::chrono::steady_clock::now();
+        uint64_t mappedChecksum{ 0 };
+        for (const auto& path : paths) {
+            MappedFile file(path);
+            std::memcpy(header.data(), file.data(), headerSize);
+            file.prefetch(headerSize + skippedSize, staging.size());
+            std::memcpy(staging.data(), file.data() + headerSize + skippedSize, staging.size());
+            mappedChecksum += static_cast<uint64_t>(staging.back()) + static_cast<uint64_t>(header[5]);
+        }
+        auto end = std::chrono::steady_clock::now();
+        //std::cout << "DDS load of " << fileCount << " files, read and copy: " << std::chrono::duration_cast<std::chrono::microseconds>(mid - start).count() << "microseconds, mapped: " << std::chrono::duration_cast<std::chrono::microseconds>(end - mid).count() << "microseconds\n";
+        EXPECT_EQ(copyChecksum, mappedChecksum);
+    }
 }
@@ -4,18 +4,53 @@
 # ---------------------------------------------------------------------------
 
 set(TEST_CPP
+    test/GLTFTests.cpp
     test/LinAlgTests.cpp
+    test/MeshTests.cpp
+    test/PipelineCacheTests.cpp
+    test/RenderGraphTests.cpp
+    test/ShaderReflectionCacheTests.cpp
+    test/StreamingTests.cpp
     test/Tester.cpp
+    test/TextureTests.cpp
     test/UtilityTests.cpp
 )
+# Engine sources which are testable without a device
+set(TEST_SRC
+    ${PROJECT_SOURCE_DIR}/src/GLTFReader/GLTFImporter.cpp
+    ${PROJECT_SOURCE_DIR}/src/GLTFReader/GLTFPrimitiveDecoder.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/AssetStreamer.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/Bounds.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/MeshGeometryCache.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/MeshOptimizer.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/MeshletBuilder.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/MeshQuantizer.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/MeshSimplifier.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/RenderGraphCompiler.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/RenderGraphExporter.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/SceneAssetCache.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/TangentGenerator.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/TextureCache.cpp
+    ${PROJECT_SOURCE_DIR}/src/Renderer/TransientMemoryPacker.cpp
+    ${PROJECT_SOURCE_DIR}/src/Util/BlockCompressor.cpp
+    ${PROJECT_SOURCE_DIR}/src/Util/JobSystem.cpp
+    ${PROJECT_SOURCE_DIR}/src/Util/MappedFile.cpp
+    ${PROJECT_SOURCE_DIR}/src/Util/MipGenerator.cpp
+    ${PROJECT_SOURCE_DIR}/src/Util/OffsetAllocator.cpp
+    ${PROJECT_SOURCE_DIR}/src/Util/PipelineCacheFile.cpp
+    ${PROJECT_SOURCE_DIR}/src/Util/ShaderReflectionCache.cpp
+    ${PROJECT_SOURCE_DIR}/src/Util/StreamHasher.cpp
+    ${PROJECT_SOURCE_DIR}/src/Util/TextureCooker.cpp
+)
 
 # ---------------------------------------------------------------------------
 # Tests
 # ---------------------------------------------------------------------------
 enable_testing()
 
-add_executable(tester ${TEST_CPP} ${MATH_SRC})
-target_link_libraries(tester ${GTEST_BOTH_LIBRARIES})
+add_executable(tester ${TEST_CPP} ${MATH_SRC} ${TEST_SRC})
+target_include_directories(tester PRIVATE ${PROJECT_SOURCE_DIR}/shader/include)
+target_link_libraries(tester ${GTEST_BOTH_LIBRARIES} Threads::Threads tinygltf)
 
 if("${CMAKE_CXX_COMPILER_ID}" STREQUAL "MSVC")
     #target_compile_options(Main PUBLIC /WX /std:c++latest) 